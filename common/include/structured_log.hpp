@@ -0,0 +1,398 @@
+#pragma once
+
+// Structured logging shared by the dispatch server and the transcoding engine.
+//
+// Records are JSON lines: {"ts","level","module","msg", ...fields}. Callers
+// never touch the output: log() formats nothing, it moves the record into a
+// bounded lock-free ring (a Vyukov MPSC queue) and a background thread
+// formats, writes and rotates. When the ring is full the record is dropped
+// and counted in dropped(), so a slow disk costs log lines, not latency.
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace distconv {
+namespace logging {
+
+enum class Level : int { Debug = 0, Info = 1, Warn = 2, Error = 3, Off = 4 };
+
+inline const char* level_name(Level level) {
+    switch (level) {
+        case Level::Debug: return "debug";
+        case Level::Info: return "info";
+        case Level::Warn: return "warn";
+        case Level::Error: return "error";
+        case Level::Off: return "off";
+    }
+    return "info";
+}
+
+// debug, info, warn (or warning), error, off; case-insensitive
+inline bool parse_level(std::string text, Level& level) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (text == "debug") level = Level::Debug;
+    else if (text == "info") level = Level::Info;
+    else if (text == "warn" || text == "warning") level = Level::Warn;
+    else if (text == "error") level = Level::Error;
+    else if (text == "off") level = Level::Off;
+    else return false;
+    return true;
+}
+
+// "module=level,module=level", e.g. "scheduler=debug,http=warn"
+inline bool parse_module_levels(const std::string& spec, std::map<std::string, Level, std::less<>>& levels) {
+    std::stringstream stream(spec);
+    std::string entry;
+    while (std::getline(stream, entry, ',')) {
+        if (entry.empty()) continue;
+        auto eq = entry.find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        Level level;
+        if (!parse_level(entry.substr(eq + 1), level)) return false;
+        levels[entry.substr(0, eq)] = level;
+    }
+    return true;
+}
+
+struct LogOptions {
+    std::string path;                          // Empty = stderr
+    uint64_t max_file_bytes = 64ull << 20;     // Rotate past this size; 0 = never
+    int max_files = 5;                         // Rotated files kept as path.1 .. path.N
+    Level level = Level::Info;                 // Threshold for modules without their own
+    std::map<std::string, Level, std::less<>> module_levels;
+};
+
+class Logger {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+    // capacity: ring slots, rounded up to a power of two
+    explicit Logger(LogOptions options = {}, size_t capacity = DEFAULT_CAPACITY)
+        : capacity_(round_up(capacity)), slots_(new Slot[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+        configure(std::move(options));
+        writer_ = std::thread([this]() { run(); });
+    }
+
+    // Writes whatever is still queued
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_one();
+        writer_.join();
+        close_output();
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // Swaps the filters at once and reopens the output. False, with the
+    // output left on stderr, when the log file cannot be opened.
+    bool configure(LogOptions options) {
+        auto filter = std::make_unique<Filter>();
+        filter->level = options.level;
+        filter->module_levels = options.module_levels;
+        filter->lowest = options.level;
+        for (const auto& entry : options.module_levels) filter->lowest = std::min(filter->lowest, entry.second);
+
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        // Readers may still hold the old table; configuring is rare, so it is kept
+        filter_.store(filter.get(), std::memory_order_release);
+        filters_.push_back(std::move(filter));
+
+        close_output();
+        options_ = std::move(options);
+        return open_output();
+    }
+
+    bool enabled(Level level, std::string_view module) const {
+        const Filter* filter = filter_.load(std::memory_order_acquire);
+        if (level < filter->lowest || level == Level::Off) return false;
+        auto it = filter->module_levels.find(module);
+        return level >= (it != filter->module_levels.end() ? it->second : filter->level);
+    }
+
+    // module: a string literal; records keep the pointer
+    void log(Level level, const char* module, std::string message, nlohmann::json fields = nullptr) {
+        if (!enabled(level, module)) return;
+        Record record{std::chrono::system_clock::now(), level, module, std::move(message), std::move(fields)};
+        if (!push(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // The writer only needs a nudge when it has gone to sleep on an empty ring
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_cv_.notify_one();
+        }
+    }
+
+    // Blocks until every record logged so far is written and flushed
+    void flush() {
+        uint64_t target = enqueue_pos_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flush_requested_ = true;
+        wake_cv_.notify_one();
+        flushed_cv_.wait(lock, [&]() { return flushed_pos_ >= target || stopping_; });
+    }
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    struct Record {
+        TimePoint time;
+        Level level = Level::Info;
+        const char* module = "";
+        std::string message;
+        nlohmann::json fields;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};
+        Record record;
+    };
+
+    struct Filter {
+        Level level = Level::Info;
+        Level lowest = Level::Info; // Nothing below this is enabled anywhere
+        std::map<std::string, Level, std::less<>> module_levels;
+    };
+
+    static size_t round_up(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    bool push(Record& record) {
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & (capacity_ - 1)];
+            uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<int64_t>(sequence - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full: the writer has not freed this slot yet
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Writer thread only
+    bool pop(Record& record) {
+        Slot& slot = slots_[dequeue_pos_ & (capacity_ - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) return false;
+        record = std::move(slot.record);
+        slot.record.fields = nullptr;
+        slot.sequence.store(dequeue_pos_ + capacity_, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    bool ring_empty() const {
+        const Slot& slot = slots_[dequeue_pos_ & (capacity_ - 1)];
+        return slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+    void run() {
+        Record record;
+        std::string line;
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(output_mutex_);
+                while (pop(record)) {
+                    line.clear();
+                    format(record, line);
+                    write(line);
+                }
+                if (out_) std::fflush(out_);
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (flushed_pos_ < dequeue_pos_ || flush_requested_) {
+                flushed_pos_ = dequeue_pos_;
+                flush_requested_ = false;
+                flushed_cv_.notify_all();
+            }
+            if (stopping_ && ring_empty()) break;
+            sleeping_.store(true, std::memory_order_seq_cst);
+            // A record pushed before sleeping_ was set is caught here; the
+            // timeout bounds any wakeup missed in between, and covers a
+            // producer that claimed a slot but has not filled it yet
+            if (ring_empty()) {
+                wake_cv_.wait_for(lock, std::chrono::milliseconds(50),
+                                  [&]() { return stopping_ || flush_requested_ || !ring_empty(); });
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    static void append_timestamp(std::string& out, TimePoint time) {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        std::time_t seconds = static_cast<std::time_t>(ms / 1000);
+        std::tm utc{};
+        gmtime_r(&seconds, &utc);
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", utc.tm_year + 1900,
+                      utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, static_cast<int>(ms % 1000));
+        out += buffer;
+    }
+
+    static std::string dump(const nlohmann::json& value) {
+        return value.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    }
+
+    static void format(const Record& record, std::string& line) {
+        line += "{\"ts\":\"";
+        append_timestamp(line, record.time);
+        line += "\",\"level\":\"";
+        line += level_name(record.level);
+        line += "\",\"module\":";
+        line += dump(record.module);
+        line += ",\"msg\":";
+        line += dump(record.message);
+        if (record.fields.is_object()) {
+            for (const auto& [key, value] : record.fields.items()) {
+                line += ',';
+                line += dump(key);
+                line += ':';
+                line += dump(value);
+            }
+        } else if (!record.fields.is_null()) {
+            line += ",\"fields\":";
+            line += dump(record.fields);
+        }
+        line += "}\n";
+    }
+
+    void write(const std::string& line) {
+        if (!out_) return;
+        if (out_ != stderr && options_.max_file_bytes > 0 && file_bytes_ > 0 &&
+            file_bytes_ + line.size() > options_.max_file_bytes) {
+            rotate();
+            if (!out_) return;
+        }
+        std::fwrite(line.data(), 1, line.size(), out_);
+        file_bytes_ += line.size();
+    }
+
+    // path -> path.1 -> ... -> path.N; the oldest falls off the end
+    void rotate() {
+        close_output();
+        const std::string& path = options_.path;
+        if (options_.max_files <= 0) {
+            std::remove(path.c_str());
+        } else {
+            std::remove((path + "." + std::to_string(options_.max_files)).c_str());
+            for (int i = options_.max_files - 1; i >= 1; --i) {
+                std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+            }
+            std::rename(path.c_str(), (path + ".1").c_str());
+        }
+        open_output();
+    }
+
+    bool open_output() {
+        file_bytes_ = 0;
+        if (options_.path.empty()) {
+            out_ = stderr;
+            return true;
+        }
+        out_ = std::fopen(options_.path.c_str(), "a");
+        if (!out_) {
+            out_ = stderr;
+            return false;
+        }
+        long size = std::ftell(out_);
+        if (size > 0) file_bytes_ = static_cast<uint64_t>(size);
+        return true;
+    }
+
+    void close_output() {
+        if (out_ && out_ != stderr) std::fclose(out_);
+        out_ = nullptr;
+    }
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) uint64_t dequeue_pos_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+
+    std::atomic<const Filter*> filter_{nullptr};
+    std::vector<std::unique_ptr<Filter>> filters_;
+
+    // Output state belongs to the writer; configure() takes the lock to swap it
+    std::mutex output_mutex_;
+    LogOptions options_;
+    std::FILE* out_ = nullptr;
+    uint64_t file_bytes_ = 0;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::atomic<bool> sleeping_{false};
+    bool flush_requested_ = false;
+    bool stopping_ = false;
+    uint64_t flushed_pos_ = 0;
+
+    std::thread writer_;
+};
+
+// The process-wide logger. Never destroyed, so static destructors can still
+// log; what is queued at exit is flushed.
+inline Logger& logger() {
+    static Logger* instance = []() {
+        auto* created = new Logger();
+        std::atexit([]() { logger().flush(); });
+        return created;
+    }();
+    return *instance;
+}
+
+inline void debug(const char* module, std::string message, nlohmann::json fields = nullptr) {
+    logger().log(Level::Debug, module, std::move(message), std::move(fields));
+}
+
+inline void info(const char* module, std::string message, nlohmann::json fields = nullptr) {
+    logger().log(Level::Info, module, std::move(message), std::move(fields));
+}
+
+inline void warn(const char* module, std::string message, nlohmann::json fields = nullptr) {
+    logger().log(Level::Warn, module, std::move(message), std::move(fields));
+}
+
+inline void error(const char* module, std::string message, nlohmann::json fields = nullptr) {
+    logger().log(Level::Error, module, std::move(message), std::move(fields));
+}
+
+} // namespace logging
+} // namespace distconv
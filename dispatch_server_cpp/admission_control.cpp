@@ -0,0 +1,122 @@
+#include "admission_control.h"
+#include <algorithm>
+#include <cmath>
+
+namespace distconv {
+namespace DispatchServer {
+
+using namespace Constants;
+
+AdmissionController::AdmissionController(std::shared_ptr<IJobRepository> job_repo, AdmissionPolicy policy,
+                                         std::chrono::milliseconds refresh)
+    : job_repo_(job_repo), refresh_ms_(refresh.count()), policy_(policy) {}
+
+void AdmissionController::set_policy(const AdmissionPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+AdmissionPolicy AdmissionController::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+AdmissionDecision AdmissionController::admit(const std::string& tenant, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AdmissionDecision decision;
+    refresh_locked(now_ms);
+
+    size_t tenant_pending = tenant_pending_[tenant];
+    if (policy_.max_pending > 0 && pending_ >= policy_.max_pending) {
+        decision.limit = "global";
+        if (!policy_.soft_limit) {
+            decision.retry_after_seconds = retry_after_locked(pending_ - policy_.max_pending + 1, drain_rate_);
+        }
+    } else if (policy_.max_pending_per_tenant > 0 && tenant_pending >= policy_.max_pending_per_tenant) {
+        decision.limit = "tenant";
+        if (!policy_.soft_limit) {
+            // The tenant's share of the drain, assuming claims follow queue composition
+            double share = pending_ > 0 ? static_cast<double>(tenant_pending) / pending_ : 1.0;
+            decision.retry_after_seconds = retry_after_locked(
+                tenant_pending - policy_.max_pending_per_tenant + 1, drain_rate_ * share);
+        }
+    }
+
+    if (!decision.limit.empty() && !policy_.soft_limit) {
+        decision.outcome = AdmissionDecision::Outcome::Reject;
+        ++(decision.limit == "global" ? rejected_global_ : rejected_tenant_);
+        return decision;
+    }
+
+    if (!decision.limit.empty()) {
+        decision.outcome = AdmissionDecision::Outcome::Deprioritize;
+        ++deprioritized_;
+    }
+    ++admitted_;
+    ++pending_;
+    ++tenant_pending_[tenant];
+    return decision;
+}
+
+void AdmissionController::refresh_locked(int64_t now_ms) {
+    if (refreshed_at_ >= 0 && now_ms - refreshed_at_ < refresh_ms_) {
+        return;
+    }
+    std::map<std::string, size_t> counts = job_repo_->count_jobs_by_tenant("pending");
+    size_t pending = 0;
+    for (const auto& entry : counts) {
+        pending += entry.second;
+    }
+
+    if (refreshed_at_ >= 0 && now_ms > refreshed_at_) {
+        // pending_ already includes what was admitted since the last refresh
+        double drained = pending_ > pending ? static_cast<double>(pending_ - pending) : 0.0;
+        double sample = drained * 1000.0 / static_cast<double>(now_ms - refreshed_at_);
+        drain_rate_ = drain_measured_ ? ADMISSION_DRAIN_SMOOTHING * sample +
+                                            (1.0 - ADMISSION_DRAIN_SMOOTHING) * drain_rate_
+                                      : sample;
+        drain_measured_ = true;
+    }
+
+    tenant_pending_ = std::move(counts);
+    pending_ = pending;
+    refreshed_at_ = now_ms;
+}
+
+int AdmissionController::retry_after_locked(size_t excess, double drain_per_second) const {
+    int64_t seconds = ADMISSION_DEFAULT_RETRY_AFTER.count();
+    if (drain_measured_ && drain_per_second > 0) {
+        seconds = static_cast<int64_t>(std::ceil(static_cast<double>(excess) / drain_per_second));
+    } else if (drain_measured_) {
+        seconds = ADMISSION_MAX_RETRY_AFTER.count(); // Nothing is draining
+    }
+    return static_cast<int>(std::clamp<int64_t>(seconds, ADMISSION_MIN_RETRY_AFTER.count(),
+                                                ADMISSION_MAX_RETRY_AFTER.count()));
+}
+
+nlohmann::json AdmissionController::metrics(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked(now_ms);
+    nlohmann::json by_tenant = nlohmann::json::object();
+    for (const auto& entry : tenant_pending_) {
+        if (!entry.first.empty() && entry.second > 0) {
+            by_tenant[entry.first] = entry.second;
+        }
+    }
+    return {
+        {"pending", pending_},
+        {"pending_by_tenant", by_tenant},
+        {"drain_rate_per_second", drain_rate_},
+        {"admitted", admitted_},
+        {"deprioritized", deprioritized_},
+        {"rejected", rejected_global_ + rejected_tenant_},
+        {"rejected_global", rejected_global_},
+        {"rejected_tenant", rejected_tenant_},
+        {"limits", {{"max_pending", policy_.max_pending},
+                    {"max_pending_per_tenant", policy_.max_pending_per_tenant},
+                    {"soft_limit", policy_.soft_limit}}}
+    };
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,76 @@
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include "repositories.h"
+#include "dispatch_server_constants.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+struct AdmissionPolicy {
+    size_t max_pending = 0;            // Pending jobs cluster-wide; 0 = unbounded
+    size_t max_pending_per_tenant = 0; // Pending jobs per "tenant"; 0 = unbounded
+    bool soft_limit = false;           // Over a limit: accept at PRIORITY_LOW instead of 429
+};
+
+struct AdmissionDecision {
+    enum class Outcome { Admit, Deprioritize, Reject };
+    Outcome outcome = Outcome::Admit;
+    std::string limit;           // "global" or "tenant" when a limit was hit
+    int retry_after_seconds = 0; // Set for Reject
+};
+
+// Admission control for POST /jobs/.
+//
+// Keeps the pending queue bounded during ingest storms. Pending counts come
+// from the repository, refreshed at most every ADMISSION_COUNT_REFRESH with
+// admissions since then added locally. The drop between refreshes gives a
+// smoothed drain rate, from which a rejected submitter's Retry-After is
+// computed.
+class AdmissionController {
+public:
+    explicit AdmissionController(std::shared_ptr<IJobRepository> job_repo, AdmissionPolicy policy = {},
+                                 std::chrono::milliseconds refresh = Constants::ADMISSION_COUNT_REFRESH);
+
+    void set_policy(const AdmissionPolicy& policy);
+    AdmissionPolicy policy() const;
+
+    // Decides on a new job of the tenant ("" for none) and counts it as
+    // pending unless it is rejected
+    AdmissionDecision admit(const std::string& tenant, int64_t now_ms);
+
+    // Queue depth (total and by tenant), drain rate and decision counters
+    nlohmann::json metrics(int64_t now_ms);
+
+private:
+    // Re-reads the pending counts once refresh_ms_ has passed
+    void refresh_locked(int64_t now_ms);
+    int retry_after_locked(size_t excess, double drain_per_second) const;
+
+    std::shared_ptr<IJobRepository> job_repo_;
+    const int64_t refresh_ms_;
+
+    mutable std::mutex mutex_;
+    AdmissionPolicy policy_;
+    std::map<std::string, size_t> tenant_pending_;
+    size_t pending_ = 0;
+    int64_t refreshed_at_ = -1;
+    double drain_rate_ = 0; // Jobs per second leaving the pending state
+    bool drain_measured_ = false;
+    uint64_t admitted_ = 0;
+    uint64_t deprioritized_ = 0;
+    uint64_t rejected_global_ = 0;
+    uint64_t rejected_tenant_ = 0;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // ADMISSION_CONTROL_H
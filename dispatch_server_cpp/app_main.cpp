@@ -1,8 +1,8 @@
-#include <iostream>
 #include "dispatch_server_core.h" // Include the core logic
+#include "structured_log.hpp"
 
 int main(int argc, char* argv[]) {
-    std::cout << "Dispatch Server Application Starting..." << std::endl;
+    distconv::logging::info("server", "Dispatch Server Application Starting");
     distconv::DispatchServer::DispatchServer server;
     // Pass the address of the server object to run_dispatch_server
     distconv::DispatchServer::run_dispatch_server(argc, argv, &server);
@@ -2,18 +2,22 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <csignal>
+#include <ctime>
+#include <pthread.h>
+#include <sys/wait.h>
 #include "dispatch_server_core.h"
 #include "repositories.h"
 #include "server_config.h"
 #include "memory_message_queue.h"
+#include "socket_handoff.h"
+#include "structured_log.hpp"
 
 // Removing using namespace to avoid ambiguity between namespace DispatchServer and class DispatchServer
 // using namespace distconv::DispatchServer;
 // using namespace distconv;
 
 int main(int argc, char* argv[]) {
-    std::cout << "Modern Dispatch Server Application Starting..." << std::endl;
-    
     // Parse command line arguments
     distconv::DispatchServer::ServerConfig config = distconv::DispatchServer::parse_arguments(argc, argv);
     
@@ -28,6 +32,28 @@ int main(int argc, char* argv[]) {
         std::cout << "  --api-key KEY     API key for authentication" << std::endl;
         std::cout << "  --database PATH   SQLite database path (default: dispatch_server.db)" << std::endl;
         std::cout << "  --port PORT       Server port (default: 8080)" << std::endl;
+        std::cout << "  --max-pending N   Refuse submissions (429) while N jobs are pending (default: unbounded)" << std::endl;
+        std::cout << "  --max-pending-per-tenant N  Same limit per job \"tenant\"" << std::endl;
+        std::cout << "  --soft-admission  Accept jobs over a limit at low priority instead of refusing them" << std::endl;
+        std::cout << "  --small-lane-reserve F  Share of engine slots held for small jobs (default: 0.2)" << std::endl;
+        std::cout << "  --large-lane-reserve F  Share of engine slots held for large jobs (default: 0.2)" << std::endl;
+        std::cout << "  --quarantine-failure-rate F  Quarantine engines failing this share of recent jobs (default: 0.5; >1 disables)" << std::endl;
+        std::cout << "  --progress-stall-timeout S  Fail a job that reported progress and then went quiet for S seconds (default: 300; 0 disables)" << std::endl;
+        std::cout << "  --retry-budget N  Requeue at most N failed jobs per minute (default: 60; 0 = unlimited)" << std::endl;
+        std::cout << "  --io-threads N    Event-loop I/O threads (default: 2; 0 = one thread per connection)" << std::endl;
+        std::cout << "  --compression-level N  gzip/zstd level for responses (default: 6; 0 disables compression)" << std::endl;
+        std::cout << "  --compression-min-bytes N  Send smaller bodies uncompressed (default: 1024)" << std::endl;
+        std::cout << "  --trace-file PATH  Append job spans as OTLP JSON, one export request per line" << std::endl;
+        std::cout << "  --trace-endpoint URL  POST job spans as OTLP JSON (e.g. http://localhost:4318/v1/traces)" << std::endl;
+        std::cout << "  --log-file PATH   Write JSON-lines logs here instead of stderr" << std::endl;
+        std::cout << "  --log-level LEVEL  debug, info, warn, error or off (default: info)" << std::endl;
+        std::cout << "  --log-modules SPEC  Per-module levels, e.g. scheduler=debug,redis=warn" << std::endl;
+        std::cout << "  --log-max-bytes N  Rotate the log file past N bytes (default: 67108864; 0 = never)" << std::endl;
+        std::cout << "  --log-max-files N  Rotated log files kept (default: 5)" << std::endl;
+        std::cout << "  --handoff-socket PATH  Take over / hand over the listening socket here for zero-downtime restarts" << std::endl;
+        std::cout << "  --drain-timeout S  On shutdown, wait up to S seconds for requests in flight (default: 30)" << std::endl;
+        std::cout << "  --state-snapshot PATH  Scheduling state snapshot (default: DATABASE.snapshot)" << std::endl;
+        std::cout << "  --snapshot-interval S  Rewrite the snapshot every S seconds (default: 60; 0 = only at shutdown)" << std::endl;
         std::cout << "  --help            Show this help message" << std::endl;
         return 0;
     }
@@ -37,6 +63,16 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (!config.handoff_socket.empty() && config.io_threads == 0) {
+        std::cerr << "Error: --handoff-socket needs the event loop (--io-threads > 0)" << std::endl;
+        return 1;
+    }
+
+    if (!distconv::logging::logger().configure(config.log)) {
+        std::cerr << "Error: cannot open log file " << config.log.path << std::endl;
+        return 1;
+    }
+
     std::string database_path = config.database_path;
     int port = config.port;
     std::string api_key = config.api_key;
@@ -51,42 +87,95 @@ int main(int argc, char* argv[]) {
 
         // Create server with injected dependencies
         distconv::DispatchServer::DispatchServer server(job_repo, engine_repo, std::move(mq_factory), api_key);
+        server.set_admission_policy({config.max_pending_jobs, config.max_pending_jobs_per_tenant,
+                                     config.soft_admission_limits});
+        server.set_size_lane_policy({{config.small_lane_reserve, 0.0, config.large_lane_reserve}});
+        distconv::DispatchServer::EngineHealthPolicy health_policy;
+        health_policy.max_failure_rate = config.quarantine_failure_rate;
+        server.set_engine_health_policy(health_policy);
+        distconv::DispatchServer::JobTimeoutPolicy timeout_policy;
+        timeout_policy.progress_stall = std::chrono::seconds(config.progress_stall_seconds);
+        server.set_job_timeout_policy(timeout_policy);
+        distconv::DispatchServer::RetryPolicy retry_policy;
+        retry_policy.budget_per_minute = config.retry_budget_per_minute;
+        server.set_retry_policy(retry_policy);
+        if (config.io_threads > 0) {
+            distconv::DispatchServer::EventLoopOptions event_loop;
+            event_loop.io_threads = config.io_threads;
+            server.set_event_loop(event_loop);
+        }
+        server.set_compression({config.compression_level, config.compression_min_bytes});
+        server.set_trace_export({config.trace_file, config.trace_endpoint});
+        server.set_state_snapshot({config.state_snapshot_path.empty()
+                                       ? database_path + distconv::DispatchServer::Constants::SNAPSHOT_SUFFIX
+                                       : config.state_snapshot_path,
+                                   std::chrono::seconds(config.snapshot_interval_seconds)});
         
-        std::cout << "Starting server on port " << port << " with database: " << database_path << std::endl;
-        std::cout << "API key authentication enabled" << std::endl;
-        
-        // Set up graceful shutdown
-        std::atomic<bool> shutdown_requested{false};
+        distconv::logging::info("server", "Starting server", {{"port", port}, {"database", database_path}});
         
-        // Start server in a separate thread
-        std::thread server_thread([&server, port, &shutdown_requested]() {
-            server.start(port, false);
-            
-            // Keep server running until shutdown requested
-            while (!shutdown_requested.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        // Stop signals are taken with sigtimedwait below; block them before any thread starts
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        // A predecessor serving on the handoff path keeps accepting until we confirm
+        distconv::DispatchServer::HandoffTakeover takeover;
+        if (!config.handoff_socket.empty()) {
+            takeover = distconv::DispatchServer::take_listen_socket(config.handoff_socket);
+            if (takeover.listen_fd >= 0) {
+                server.set_listen_socket(takeover.listen_fd);
             }
-            
-            server.stop();
-        });
-        
-        std::cout << "Server started successfully. Press Ctrl+C to stop." << std::endl;
-        
-        // Wait for shutdown signal (in a real app, you'd handle SIGINT/SIGTERM)
-        std::string input;
-        std::getline(std::cin, input);
-        
-        std::cout << "Shutting down server..." << std::endl;
-        shutdown_requested.store(true);
-        
-        if (server_thread.joinable()) {
-            server_thread.join();
         }
-        
-        std::cout << "Server stopped." << std::endl;
+
+        server.start(port, false);
+        if (takeover.listen_fd >= 0) {
+            distconv::DispatchServer::confirm_handoff(takeover);
+            distconv::logging::info("server", "Took over the listening socket", {{"port", server.get_port()}});
+        }
+        distconv::logging::info("server", "Server started");
+
+        std::atomic<bool> handed_off{false};
+        std::unique_ptr<distconv::DispatchServer::HandoffListener> handoff;
+        if (!config.handoff_socket.empty()) {
+            handoff = std::make_unique<distconv::DispatchServer::HandoffListener>(
+                config.handoff_socket, server.listen_socket(), [&handed_off]() { handed_off = true; });
+        }
+
+        // SIGTERM/SIGINT drain and exit; SIGHUP starts a successor, which takes over
+        // through the handoff socket and makes this process drain and exit.
+        const timespec poll_interval{0, 200 * 1000 * 1000};
+        while (!handed_off.load()) {
+            int signal = sigtimedwait(&signals, nullptr, &poll_interval);
+            while (waitpid(-1, nullptr, WNOHANG) > 0) {
+                // Reap successors that failed to start
+            }
+            if (signal == SIGINT || signal == SIGTERM) {
+                break;
+            }
+            if (signal == SIGHUP) {
+                if (!handoff || !handoff->listening()) {
+                    distconv::logging::warn("server", "SIGHUP ignored: no --handoff-socket to restart through");
+                } else if (distconv::DispatchServer::spawn_successor(argv) < 0) {
+                    distconv::logging::error("server", "Could not start a successor");
+                } else {
+                    distconv::logging::info("server", "Started a successor");
+                }
+            }
+        }
+
+        handoff.reset();
+        distconv::logging::info("server", "Shutting down server",
+                                {{"handed_off", handed_off.load()}, {"drain_timeout_seconds", config.drain_timeout_seconds}});
+        server.drain(std::chrono::seconds(config.drain_timeout_seconds));
+        distconv::logging::info("server", "Server stopped");
+        distconv::logging::logger().flush();
         
     } catch (const std::exception& e) {
-        std::cerr << "Fatal error: " << e.what() << std::endl;
+        distconv::logging::error("server", "Fatal error", {{"error", e.what()}});
+        distconv::logging::logger().flush();
         return 1;
     }
     
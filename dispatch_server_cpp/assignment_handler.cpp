@@ -1,10 +1,13 @@
 #include "assignment_handler.h"
+#include "wall_clock.h"
 #include "dispatch_server_core.h"
 #include "repositories.h"
 #include "dispatch_server_constants.h"
 #include <mutex>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <optional>
 
 namespace distconv {
 namespace DispatchServer {
@@ -13,8 +16,24 @@ using namespace Constants;
 
 JobAssignmentHandler::JobAssignmentHandler(std::shared_ptr<AuthMiddleware> auth, 
                                            std::shared_ptr<IJobRepository> job_repo,
-                                           std::shared_ptr<IEngineRepository> engine_repo)
-    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo) {}
+                                           std::shared_ptr<IEngineRepository> engine_repo,
+                                           std::shared_ptr<AssignmentWaiterRegistry> waiters,
+                                           std::shared_ptr<SourceCacheIndex> source_cache,
+                                           std::shared_ptr<SpeculationManager> speculation,
+                                           std::shared_ptr<PreemptionCoordinator> preemption,
+                                           std::shared_ptr<SizeLanes> size_lanes,
+                                           std::shared_ptr<EngineHealth> health,
+                                           std::shared_ptr<MetricsRegistry> metrics)
+    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo), waiters_(waiters),
+      source_cache_(source_cache), speculation_(speculation), preemption_(preemption), size_lanes_(size_lanes),
+      health_(health) {
+    if (metrics) {
+        claim_latency_ = &metrics->histogram("dispatch_assignment_seconds",
+                                             "Time to select and claim work for a polling engine", latency_buckets());
+        queue_wait_ = &metrics->histogram("dispatch_job_queue_wait_seconds",
+                                          "Time from submission to assignment", queue_wait_buckets());
+    }
+}
 
 void JobAssignmentHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
@@ -34,6 +53,16 @@ void JobAssignmentHandler::handle(const httplib::Request& req, httplib::Response
     
     std::string engine_id = request_json["engine_id"];
 
+    // Engines able to run many small inputs in one process say how many they take
+    size_t max_batch = 1;
+    if (request_json.contains("max_batch")) {
+        if (!request_json["max_batch"].is_number_integer() || request_json["max_batch"].get<int64_t>() < 1) {
+            set_error_response(res, "max_batch must be a positive integer", 400);
+            return;
+        }
+        max_batch = std::min<size_t>(request_json["max_batch"].get<int64_t>(), BATCH_MAX_ITEMS);
+    }
+
     // Ensure engine exists and is idle
     nlohmann::json engine = engine_repo_->get_engine(engine_id);
     if (engine.is_null() || engine.empty()) {
@@ -41,30 +70,305 @@ void JobAssignmentHandler::handle(const httplib::Request& req, httplib::Response
         return;
     }
 
-    // Get next pending job (O(1)-ish with SQLite)
-    nlohmann::json job = job_repo_->get_next_pending_job({}); // Empty capable_engines for now
-    if (job.is_null() || job.empty()) {
+    bool deferred = false;
+    if (try_assign(engine_id, engine, max_batch, res, deferred)) {
+        return;
+    }
+
+    auto wait = std::chrono::milliseconds(0);
+    if (waiters_ && req.has_param("wait")) {
+        wait = parse_long_poll_wait(req.get_param_value("wait"), LONG_POLL_MAX_WAIT);
+    }
+    if (wait.count() == 0) {
         res.status = 204; // No Content
         return;
     }
 
+    // Register before re-checking so a job submitted in between is not missed
+    auto waiter = waiters_->register_waiter(engine_capabilities(request_json, engine), engine_id);
+    if (!waiter) {
+        // Registry full: fall back to a plain poll rather than pinning another worker
+        res.status = 204;
+        return;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + wait;
+    deferred = false;
+    bool assigned = try_assign(engine_id, engine, max_batch, res, deferred);
+    while (!assigned) {
+        // A held-back job is released without a notification, so wake up to re-check
+        auto until = deadline;
+        if (deferred) {
+            until = std::min(deadline, std::chrono::steady_clock::now() + source_cache_->locality_wait());
+        }
+        if (!waiters_->wait(waiter, until) && (until == deadline || waiters_->is_closed())) {
+            break;
+        }
+        deferred = false;
+        assigned = try_assign(engine_id, engine, max_batch, res, deferred);
+    }
+    waiters_->unregister_waiter(waiter);
+
+    if (!assigned) {
+        res.status = 204;
+    }
+}
+
+bool JobAssignmentHandler::try_assign(const std::string& engine_id, nlohmann::json& engine, size_t max_batch,
+                                      httplib::Response& res, bool& deferred) {
+    auto started = std::chrono::steady_clock::now();
+    int64_t now_ms = wall_clock_ms();
+    // A quarantined engine sits out; its probe job is a single job, never a batch
+    bool probe = false;
+    if (health_ && !health_->may_assign(engine_id, now_ms, &probe)) {
+        return false;
+    }
+    if (probe) {
+        max_batch = 1;
+    }
+
+    // Engines declaring capacity are bin-packed against the jobs they already run
+    std::optional<Resources> free;
+    if (engine.contains("capacity")) {
+        free = free_capacity(engine, jobs_running_on(*job_repo_, engine_id));
+        if (free->slots < 1) {
+            return false;
+        }
+    }
+
+    nlohmann::json job = select_job(engine_id, engine, free ? &*free : nullptr, deferred);
+    if (job.is_null() || job.empty()) {
+        // Idle capacity goes to speculative copies of stragglers, if any
+        nlohmann::json copy = speculation_ ? speculation_->claim_copy(engine_id, engine, free ? &*free : nullptr) : nullptr;
+        if (copy.is_null()) {
+            return false;
+        }
+        if (health_) {
+            health_->on_claimed(engine_id, copy["job_id"], now_ms);
+        }
+        engine["status"] = "busy";
+        engine["current_job_id"] = copy["job_id"];
+        engine_repo_->save_engine(engine_id, engine);
+        set_json_response(res, copy, 200);
+        if (claim_latency_) {
+            claim_latency_->observe_since(started);
+        }
+        return true;
+    }
+
+    std::vector<nlohmann::json> batch{job};
+    if (max_batch > 1 && size_class_of(job) == SizeClass::Small) {
+        add_batch_items(engine_id, batch, max_batch, free ? &*free : nullptr);
+    }
+
     // Assign job
-    std::string job_id = job["job_id"];
-    job["status"] = "assigned";
-    job["assigned_engine"] = engine_id;
-    job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-        
-    engine["status"] = "busy";
-    engine["current_job_id"] = job_id;
-    engine["updated_at"] = job["updated_at"];
+    if (health_) {
+        health_->on_claimed(engine_id, job["job_id"], now_ms);
+    }
+    std::string batch_id = batch.size() > 1 ? "batch-" + job["job_id"].get<std::string>() + "-" + std::to_string(now_ms) : "";
+    for (auto& item : batch) {
+        std::string job_id = item["job_id"];
+        if (source_cache_) {
+            source_cache_->forget(job_id);
+        }
+        if (preemption_) {
+            preemption_->on_claimed(engine_id, job_id);
+        }
+        if (size_lanes_) {
+            size_lanes_->on_claimed(item);
+        }
+        item.erase("reserved_for");
+        item.erase("reserved_at");
+        item.erase("batch_id");
+        if (!batch_id.empty()) {
+            item["batch_id"] = batch_id;
+        }
+        item["status"] = "assigned";
+        item["assigned_engine"] = engine_id;
+        item["updated_at"] = now_ms;
+        item["assigned_at"] = now_ms;
+        if (queue_wait_ && item.contains("created_at") && item["created_at"].is_number()) {
+            queue_wait_->observe((now_ms - item["created_at"].get<int64_t>()) / 1000.0);
+        }
+        // Atomicity: We should really have a transaction here, but for now we'll do best-effort
+        // or rely on locks inside repositories.
+        job_repo_->save_job(job_id, item);
+    }
 
-    // Atomicity: We should really have a transaction here, but for now we'll do best-effort
-    // or rely on locks inside repositories.
-    job_repo_->save_job(job_id, job);
+    engine["status"] = "busy";
+    engine["current_job_id"] = job["job_id"];
+    engine["updated_at"] = now_ms;
     engine_repo_->save_engine(engine_id, engine);
 
-    set_json_response(res, job, 200);
+    if (batch_id.empty()) {
+        set_json_response(res, batch.front(), 200);
+    } else {
+        set_json_response(res, {{"type", "batch"}, {"batch_id", batch_id}, {"target_codec", job["target_codec"]},
+                                 {"jobs", batch}}, 200);
+    }
+    if (claim_latency_) {
+        claim_latency_->observe_since(started);
+    }
+    return true;
+}
+
+void JobAssignmentHandler::add_batch_items(const std::string& engine_id, std::vector<nlohmann::json>& batch,
+                                           size_t max_batch, const Resources* free) {
+    const nlohmann::json head = batch.front(); // Copied: push_back below may reallocate
+    int64_t now_ms = wall_clock_ms();
+    int64_t reservation_ms = preemption_ ? preemption_->reservation_timeout_ms()
+        : std::chrono::duration_cast<std::chrono::milliseconds>(PREEMPTION_RESERVATION_TIMEOUT).count();
+
+    // The batch shares one slot; its items still draw on the engine's other resources
+    std::optional<Resources> left;
+    if (free) {
+        left = *free;
+        *left -= job_demand(head);
+        left->slots = 0;
+    }
+
+    // Only jobs the same ffmpeg invocation can encode: same codec and settings,
+    // and nothing resuming from a checkpoint or held for another engine
+    auto compatible = [&](const nlohmann::json& job) {
+        return job.value("job_id", "") != head.value("job_id", "") &&
+               job.value("target_codec", "") == head.value("target_codec", "") &&
+               job.value("resource_requirements", nlohmann::json::object()) ==
+                   head.value("resource_requirements", nlohmann::json::object()) &&
+               !job.contains("preemption") && !reserved_for_other(job, engine_id, now_ms, reservation_ms) &&
+               !avoids_engine(job, engine_id, now_ms) &&
+               !(source_cache_ && source_cache_->held_elsewhere(engine_id, job.value("source_url", "")));
+    };
+
+    for (auto& job : job_repo_->get_pending_jobs_by_size_class(size_class_name(SizeClass::Small),
+                                                              SOURCE_LOCALITY_SCAN_LIMIT)) {
+        if (batch.size() >= max_batch) {
+            break;
+        }
+        if (!compatible(job)) {
+            continue;
+        }
+        if (left) {
+            Resources demand = job_demand(job);
+            demand.slots = 0;
+            if (!left->covers(demand)) {
+                continue;
+            }
+            *left -= demand;
+        }
+        batch.push_back(std::move(job));
+    }
+}
+
+nlohmann::json JobAssignmentHandler::select_job(const std::string& engine_id, const nlohmann::json& engine,
+                                                const Resources* free, bool& deferred) {
+    int64_t now_ms = wall_clock_ms();
+    int64_t reservation_ms = preemption_ ? preemption_->reservation_timeout_ms()
+        : std::chrono::duration_cast<std::chrono::milliseconds>(PREEMPTION_RESERVATION_TIMEOUT).count();
+    std::optional<LaneSet> lanes;
+    if (size_lanes_) {
+        lanes = size_lanes_->open_lanes(now_ms);
+    }
+    auto claimable = [&](const nlohmann::json& job) {
+        return !reserved_for_other(job, engine_id, now_ms, reservation_ms) &&
+               !avoids_engine(job, engine_id, now_ms) &&
+               (!free || free->covers(job_demand(job))) && (!lanes || lanes->admits(job));
+    };
+
+    if (preemption_) {
+        // The urgent job this engine suspended its work for comes first
+        std::string reserved = preemption_->reserved_job_for(engine_id);
+        if (!reserved.empty()) {
+            nlohmann::json job = job_repo_->get_job(reserved);
+            if (job.is_object() && job.value("status", "") == "pending") {
+                return job;
+            }
+        }
+    }
+
+    if (!source_cache_ && !free) {
+        // Get next pending job (O(1)-ish with SQLite)
+        nlohmann::json job = job_repo_->get_next_pending_job({}); // Empty capable_engines for now
+        if (job.is_null() || job.empty() || claimable(job)) {
+            return job;
+        }
+        // The head is held for a preempting engine or its lane is held back; look past it
+        for (auto& candidate : candidate_jobs(lanes ? &*lanes : nullptr)) {
+            if (claimable(candidate)) {
+                return candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    // Walk the head of the queue: take the first job this engine may claim, but
+    // swap in a job of the same priority whose source it already has cached.
+    // With declared capacity the band's tightest fit is taken instead of the first.
+    Resources total = engine_capacity(engine);
+    nlohmann::json fallback = nullptr;
+    double fallback_score = 0;
+    for (auto& job : candidate_jobs(lanes ? &*lanes : nullptr)) {
+        if (!fallback.is_null() && job.value("priority", 0) < fallback.value("priority", 0)) {
+            break;
+        }
+        if (!claimable(job)) {
+            continue;
+        }
+        std::string source_url = job.value("source_url", "");
+        if (source_cache_ && source_cache_->engine_holds(engine_id, source_url)) {
+            return job;
+        }
+        bool held_elsewhere = source_cache_ && source_cache_->held_elsewhere(engine_id, source_url);
+        if (!fallback.is_null() && (!free || held_elsewhere)) {
+            continue;
+        }
+        if (held_elsewhere && source_cache_->defer(job.value("job_id", ""))) {
+            deferred = true;
+            continue;
+        }
+        double score = free ? packing_score(job_demand(job), *free, total) : 0;
+        if (fallback.is_null() || score < fallback_score) {
+            fallback = job;
+            fallback_score = score;
+        }
+    }
+    return fallback;
+}
+
+std::vector<nlohmann::json> JobAssignmentHandler::candidate_jobs(const LaneSet* lanes) const {
+    if (!lanes || !lanes->restricted) {
+        return job_repo_->get_pending_jobs(SOURCE_LOCALITY_SCAN_LIMIT);
+    }
+    // Merge the heads of the open lanes so a held-back lane cannot fill the scan window
+    std::vector<nlohmann::json> jobs;
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        if (lanes->open[lane]) {
+            auto head = job_repo_->get_pending_jobs_by_size_class(size_class_name(static_cast<SizeClass>(lane)),
+                                                                  SOURCE_LOCALITY_SCAN_LIMIT);
+            jobs.insert(jobs.end(), head.begin(), head.end());
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), pending_job_precedes);
+    if (jobs.size() > SOURCE_LOCALITY_SCAN_LIMIT) {
+        jobs.resize(SOURCE_LOCALITY_SCAN_LIMIT);
+    }
+    return jobs;
+}
+
+std::vector<std::string> JobAssignmentHandler::engine_capabilities(
+    const nlohmann::json& request_json, const nlohmann::json& engine) const {
+    // Prefer capabilities sent with the poll, then those advertised in the heartbeat
+    for (const auto* source : {&request_json, &engine}) {
+        for (const char* key : {"capabilities", "supported_codecs"}) {
+            if (source->contains(key) && (*source)[key].is_array()) {
+                std::vector<std::string> capabilities;
+                for (const auto& codec : (*source)[key]) {
+                    if (codec.is_string()) capabilities.push_back(codec);
+                }
+                return capabilities;
+            }
+        }
+    }
+    return {};
 }
 
 } // namespace DispatchServer
@@ -4,24 +4,84 @@
 #include "request_handlers.h"
 #include "nlohmann/json.hpp"
 #include "repositories.h"
+#include "assignment_waiters.h"
+#include "source_cache_index.h"
+#include "speculation.h"
+#include "preemption.h"
+#include "resource_packing.h"
+#include "size_lanes.h"
+#include "engine_health.h"
+#include "metrics.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace distconv {
 namespace DispatchServer {
 
 // Handler for POST /assign_job/ - Assign a job to an engine
+// Supports long-polling with ?wait=30s: when no job is pending the request is
+// parked in the waiter registry until a matching job is submitted or requeued.
+// With a source-cache index, jobs whose source is cached on another engine are
+// held back for that engine for SOURCE_LOCALITY_WAIT before anyone may claim them.
+// An engine that finds nothing pending may be handed a speculative copy of a
+// straggler instead (marked "speculative": true). Jobs reserved for an engine
+// that is preempting work for them are skipped by everyone else.
+// An engine that reports "capacity" in its heartbeat may hold several jobs at
+// once: it is offered only jobs whose resource_requirements fit what its
+// running jobs leave free, best fit first within the top priority band.
+// With size-class lanes, jobs of a lane held back by another lane's slot
+// reservation are passed over for the next job of an open lane.
+// An engine polling with "max_batch": N is handed up to N small jobs of the same
+// codec and settings at once, as {"type": "batch", "batch_id", "jobs": [...]};
+// it encodes them in one ffmpeg process and reports each job on its own.
+// With engine health tracking, a quarantined engine gets nothing (204) until its
+// quarantine ends and then a single probe job; jobs that just failed on the
+// polling engine (retry anti-affinity) are passed over.
+// With a metrics registry, every successful claim is timed into
+// dispatch_assignment_seconds and each assigned job's time since submission
+// into dispatch_job_queue_wait_seconds.
 class JobAssignmentHandler : public IRequestHandler {
 public:
     JobAssignmentHandler(std::shared_ptr<AuthMiddleware> auth, 
                          std::shared_ptr<IJobRepository> job_repo,
-                         std::shared_ptr<IEngineRepository> engine_repo);
+                         std::shared_ptr<IEngineRepository> engine_repo,
+                         std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr,
+                         std::shared_ptr<SourceCacheIndex> source_cache = nullptr,
+                         std::shared_ptr<SpeculationManager> speculation = nullptr,
+                         std::shared_ptr<PreemptionCoordinator> preemption = nullptr,
+                         std::shared_ptr<SizeLanes> size_lanes = nullptr,
+                         std::shared_ptr<EngineHealth> health = nullptr,
+                         std::shared_ptr<MetricsRegistry> metrics = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
 
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<AssignmentWaiterRegistry> waiters_;
+    std::shared_ptr<SourceCacheIndex> source_cache_;
+    std::shared_ptr<SpeculationManager> speculation_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
+    std::shared_ptr<SizeLanes> size_lanes_;
+    std::shared_ptr<EngineHealth> health_;
+    Histogram* claim_latency_ = nullptr;
+    Histogram* queue_wait_ = nullptr;
+
+    // Claims the next pending job for the engine; returns false when none is
+    // claimable. Sets deferred when a job was left for an engine caching its source.
+    bool try_assign(const std::string& engine_id, nlohmann::json& engine, size_t max_batch,
+                    httplib::Response& res, bool& deferred);
+    // Fills the batch with pending small jobs compatible with its first job
+    void add_batch_items(const std::string& engine_id, std::vector<nlohmann::json>& batch, size_t max_batch,
+                         const Resources* free);
+    // free is null for engines without declared capacity (one job per poll, no fit checks)
+    nlohmann::json select_job(const std::string& engine_id, const nlohmann::json& engine, const Resources* free,
+                              bool& deferred);
+    // The head of the queue, limited to the open lanes when some lane is held back
+    std::vector<nlohmann::json> candidate_jobs(const LaneSet* lanes) const;
+    std::vector<std::string> engine_capabilities(const nlohmann::json& request_json,
+                                                 const nlohmann::json& engine) const;
 };
 
 } // namespace DispatchServer
@@ -0,0 +1,127 @@
+#include "assignment_waiters.h"
+#include <algorithm>
+#include <cctype>
+
+namespace distconv {
+namespace DispatchServer {
+
+AssignmentWaiterRegistry::AssignmentWaiterRegistry(size_t max_waiters)
+    : max_waiters_(max_waiters) {}
+
+std::shared_ptr<AssignmentWaiterRegistry::Waiter> AssignmentWaiterRegistry::register_waiter(
+    const std::vector<std::string>& capabilities, const std::string& engine_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_ || waiters_.size() >= max_waiters_) {
+        return nullptr;
+    }
+    auto waiter = std::make_shared<Waiter>();
+    waiter->engine_id = engine_id;
+    waiter->capabilities = capabilities;
+    waiters_.push_back(waiter);
+    return waiter;
+}
+
+void AssignmentWaiterRegistry::unregister_waiter(const std::shared_ptr<Waiter>& waiter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    waiters_.remove(waiter);
+}
+
+bool AssignmentWaiterRegistry::wait(const std::shared_ptr<Waiter>& waiter,
+                                    std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiter->cv.wait_until(lock, deadline, [this, &waiter] {
+        return waiter->signaled || closed_;
+    });
+    bool signaled = waiter->signaled;
+    waiter->signaled = false;
+    return signaled;
+}
+
+bool AssignmentWaiterRegistry::notify_job_available(const nlohmann::json& job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<Waiter> chosen;
+    for (auto& waiter : waiters_) {
+        if (waiter->signaled || !can_run(*waiter, job)) continue;
+        if (!preference_ || preference_(waiter->engine_id, job)) {
+            chosen = waiter;
+            break;
+        }
+        if (!chosen) chosen = waiter;
+    }
+    if (!chosen) {
+        return false;
+    }
+    chosen->signaled = true;
+    chosen->cv.notify_one();
+    return true;
+}
+
+void AssignmentWaiterRegistry::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    for (auto& waiter : waiters_) {
+        waiter->cv.notify_one();
+    }
+}
+
+void AssignmentWaiterRegistry::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = false;
+}
+
+bool AssignmentWaiterRegistry::is_closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+void AssignmentWaiterRegistry::set_preference(Preference preference) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    preference_ = std::move(preference);
+}
+
+size_t AssignmentWaiterRegistry::waiter_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waiters_.size();
+}
+
+bool AssignmentWaiterRegistry::can_run(const Waiter& waiter, const nlohmann::json& job) {
+    // Engines that did not advertise capabilities accept any job
+    if (waiter.capabilities.empty()) {
+        return true;
+    }
+    std::string codec = job.value("target_codec", "");
+    if (codec.empty()) {
+        return true;
+    }
+    return std::find(waiter.capabilities.begin(), waiter.capabilities.end(), codec) !=
+           waiter.capabilities.end();
+}
+
+std::chrono::milliseconds parse_long_poll_wait(const std::string& value,
+                                               std::chrono::milliseconds max_wait) {
+    size_t digits = 0;
+    while (digits < value.size() && std::isdigit(static_cast<unsigned char>(value[digits]))) {
+        ++digits;
+    }
+    if (digits == 0 || digits > 9) {
+        return std::chrono::milliseconds(0);
+    }
+
+    long long amount = std::stoll(value.substr(0, digits));
+    std::string unit = value.substr(digits);
+
+    std::chrono::milliseconds wait;
+    if (unit.empty() || unit == "s") {
+        wait = std::chrono::seconds(amount);
+    } else if (unit == "ms") {
+        wait = std::chrono::milliseconds(amount);
+    } else if (unit == "m") {
+        wait = std::chrono::minutes(amount);
+    } else {
+        return std::chrono::milliseconds(0);
+    }
+    return std::min(wait, max_wait);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
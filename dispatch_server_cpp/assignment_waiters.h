@@ -0,0 +1,74 @@
+#ifndef ASSIGNMENT_WAITERS_H
+#define ASSIGNMENT_WAITERS_H
+
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Bounded registry of /assign_job/ long-poll requests parked until a job they
+// can run becomes pending. Each parked request holds an httplib worker thread,
+// so the registry refuses new waiters once it reaches capacity.
+class AssignmentWaiterRegistry {
+public:
+    struct Waiter {
+        std::string engine_id;
+        std::vector<std::string> capabilities;
+        bool signaled = false;
+        std::condition_variable cv;
+    };
+
+    explicit AssignmentWaiterRegistry(size_t max_waiters);
+
+    // Returns nullptr when the registry is full or closed.
+    std::shared_ptr<Waiter> register_waiter(const std::vector<std::string>& capabilities,
+                                            const std::string& engine_id = "");
+    void unregister_waiter(const std::shared_ptr<Waiter>& waiter);
+
+    // Blocks until the waiter is signaled, the deadline passes or the registry
+    // is closed. Returns true only when a job was announced to this waiter.
+    bool wait(const std::shared_ptr<Waiter>& waiter, std::chrono::steady_clock::time_point deadline);
+
+    // Wakes the longest-parked waiter whose capabilities cover the job,
+    // favouring engines the preference hook selects for it.
+    bool notify_job_available(const nlohmann::json& job);
+
+    // Hook consulted by notify_job_available(); used for source-cache locality.
+    using Preference = std::function<bool(const std::string& engine_id, const nlohmann::json& job)>;
+    void set_preference(Preference preference);
+
+    // close() releases every parked request (used on shutdown); open() re-arms.
+    void close();
+    void open();
+    bool is_closed() const;
+
+    size_t waiter_count() const;
+    size_t capacity() const { return max_waiters_; }
+
+private:
+    static bool can_run(const Waiter& waiter, const nlohmann::json& job);
+
+    const size_t max_waiters_;
+    mutable std::mutex mutex_;
+    std::list<std::shared_ptr<Waiter>> waiters_;
+    bool closed_ = false;
+    Preference preference_;
+};
+
+// Parses the ?wait= query value ("30", "30s", "500ms", "1m"). Returns zero for
+// malformed input and clamps the result to max_wait.
+std::chrono::milliseconds parse_long_poll_wait(const std::string& value,
+                                               std::chrono::milliseconds max_wait);
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // ASSIGNMENT_WAITERS_H
@@ -0,0 +1,255 @@
+#include "deadline_monitor.h"
+#include "dispatch_server_constants.h"
+#include "resource_packing.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <limits>
+
+namespace distconv {
+namespace DispatchServer {
+
+bool parse_deadline(const nlohmann::json& value, int64_t& deadline_ms) {
+    if (value.is_number_integer()) {
+        deadline_ms = value.get<int64_t>();
+        return deadline_ms > 0;
+    }
+    if (!value.is_string()) {
+        return false;
+    }
+
+    const std::string text = value.get<std::string>();
+    std::tm tm{};
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour,
+                    &tm.tm_min, &tm.tm_sec, &consumed) != 6 || consumed != 19) {
+        return false;
+    }
+    if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31 || tm.tm_hour > 23 ||
+        tm.tm_min > 59 || tm.tm_sec > 60) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+
+    size_t pos = 19;
+    int64_t fraction_ms = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        int64_t scale = 100;
+        size_t digits = 0;
+        for (++pos; pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])); ++pos, ++digits) {
+            fraction_ms += (text[pos] - '0') * scale;
+            scale /= 10;
+        }
+        if (digits == 0) {
+            return false;
+        }
+    }
+
+    int64_t offset_minutes = 0;
+    if (pos < text.size()) {
+        if (text[pos] == 'Z' && pos + 1 == text.size()) {
+            // UTC
+        } else if ((text[pos] == '+' || text[pos] == '-') && pos + 6 == text.size() && text[pos + 3] == ':') {
+            int hours = 0, minutes = 0;
+            if (std::sscanf(text.c_str() + pos + 1, "%2d:%2d", &hours, &minutes) != 2 || hours > 23 ||
+                minutes > 59) {
+                return false;
+            }
+            offset_minutes = (text[pos] == '+' ? 1 : -1) * (hours * 60 + minutes);
+        } else {
+            return false;
+        }
+    }
+
+    time_t seconds = timegm(&tm);
+    if (seconds < 0) {
+        return false;
+    }
+    deadline_ms = (static_cast<int64_t>(seconds) - offset_minutes * 60) * 1000 + fraction_ms;
+    return deadline_ms > 0;
+}
+
+DeadlineMonitor::DeadlineMonitor(std::shared_ptr<IJobRepository> job_repo,
+                                 std::shared_ptr<IEngineRepository> engine_repo,
+                                 std::shared_ptr<RuntimeEstimator> estimator)
+    : job_repo_(job_repo), engine_repo_(engine_repo), estimator_(estimator) {}
+
+bool DeadlineMonitor::has_deadline(const nlohmann::json& job) {
+    return job.contains("deadline") && job["deadline"].is_number_integer();
+}
+
+int64_t DeadlineMonitor::runtime_of(const nlohmann::json& job) const {
+    int64_t runtime_ms = 0;
+    return estimator_ && estimator_->predict(job, runtime_ms) ? runtime_ms : 0;
+}
+
+std::vector<nlohmann::json> DeadlineMonitor::running_jobs() const {
+    std::vector<nlohmann::json> running = job_repo_->get_jobs_by_status("assigned");
+    for (auto& job : job_repo_->get_jobs_by_status("processing")) {
+        running.push_back(std::move(job));
+    }
+    return running;
+}
+
+std::vector<int64_t> DeadlineMonitor::slot_release_times(int64_t now_ms,
+                                                         const std::vector<nlohmann::json>& running) const {
+    std::vector<int64_t> slots;
+    for (const auto& engine : engine_repo_->get_all_engines()) {
+        slots.insert(slots.end(), engine_slots(engine), now_ms);
+    }
+    if (slots.empty()) {
+        return slots;
+    }
+
+    // Min-heap of release times; each running job holds the earliest free slot
+    for (const auto& job : running) {
+        std::pop_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+        int64_t started = job.value("assigned_at", now_ms);
+        int64_t remaining = std::max<int64_t>(0, runtime_of(job) - (now_ms - started));
+        slots.back() = std::max(slots.back(), now_ms) + remaining;
+        std::push_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+    }
+    return slots;
+}
+
+nlohmann::json DeadlineMonitor::sla(const nlohmann::json& job, int64_t runtime_ms, int64_t finish_ms,
+                                    bool finish_known, int64_t now_ms) {
+    int64_t deadline = job["deadline"].get<int64_t>();
+    nlohmann::json sla = {
+        {"predicted_runtime_ms", runtime_ms > 0 ? nlohmann::json(runtime_ms) : nlohmann::json(nullptr)},
+        {"predicted_finish_at", finish_known ? nlohmann::json(finish_ms) : nlohmann::json(nullptr)},
+        {"slack_ms", finish_known ? nlohmann::json(deadline - finish_ms) : nlohmann::json(nullptr)},
+        {"at_risk", !finish_known || finish_ms > deadline},
+        {"assessed_at", now_ms}
+    };
+    return sla;
+}
+
+void DeadlineMonitor::assess(nlohmann::json& job, int64_t now_ms) {
+    if (!has_deadline(job)) {
+        return;
+    }
+    int64_t runtime = runtime_of(job);
+    job["latest_start"] = job["deadline"].get<int64_t>() - runtime;
+
+    // Only the jobs that will be claimed before this one delay it
+    std::vector<int64_t> slots = slot_release_times(now_ms, running_jobs());
+    int64_t finish = now_ms + runtime;
+    if (!slots.empty()) {
+        std::vector<nlohmann::json> ahead;
+        for (auto& pending : job_repo_->get_jobs_by_status("pending")) {
+            if (pending_job_precedes(pending, job)) {
+                ahead.push_back(std::move(pending));
+            }
+        }
+        std::sort(ahead.begin(), ahead.end(), pending_job_precedes);
+        for (const auto& pending : ahead) {
+            std::pop_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+            slots.back() += runtime_of(pending);
+            std::push_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+        }
+        finish = slots.front() + runtime;
+    }
+    job["sla"] = sla(job, runtime, finish, !slots.empty(), now_ms);
+
+    if (job["sla"]["at_risk"].get<bool>()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++flagged_at_submission_;
+        at_risk_.push_back({{"job_id", job["job_id"]}, {"status", job["status"]}, {"priority", job["priority"]},
+                            {"deadline", job["deadline"]}, {"sla", job["sla"]}});
+    }
+}
+
+void DeadlineMonitor::scan(int64_t now_ms) {
+    const int64_t tolerance_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Constants::DEADLINE_RESCHEDULE_TOLERANCE).count();
+    std::vector<nlohmann::json> running = running_jobs();
+    std::vector<int64_t> slots = slot_release_times(now_ms, running);
+    std::vector<nlohmann::json> at_risk;
+    size_t tracked = 0;
+    size_t overdue = 0;
+    auto note = [&](const nlohmann::json& job, const nlohmann::json& sla) {
+        ++tracked;
+        if (job["deadline"].get<int64_t>() < now_ms) {
+            ++overdue;
+        }
+        if (sla["at_risk"].get<bool>()) {
+            at_risk.push_back({{"job_id", job["job_id"]}, {"status", job["status"]},
+                               {"priority", job.value("priority", 0)}, {"deadline", job["deadline"]}, {"sla", sla}});
+        }
+    };
+
+    for (const auto& job : running) {
+        if (has_deadline(job)) {
+            int64_t runtime = runtime_of(job);
+            int64_t started = job.value("assigned_at", now_ms);
+            note(job, sla(job, runtime, std::max(now_ms, started + runtime), true, now_ms));
+        }
+    }
+
+    std::vector<nlohmann::json> pending = job_repo_->get_jobs_by_status("pending");
+    size_t deadlines_left = std::count_if(pending.begin(), pending.end(), has_deadline);
+    std::sort(pending.begin(), pending.end(), pending_job_precedes);
+    for (const auto& job : pending) {
+        if (deadlines_left == 0) {
+            break;
+        }
+        int64_t runtime = runtime_of(job);
+        int64_t finish = now_ms + runtime;
+        if (!slots.empty()) {
+            std::pop_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+            slots.back() += runtime;
+            finish = slots.back();
+            std::push_heap(slots.begin(), slots.end(), std::greater<int64_t>());
+        }
+        if (!has_deadline(job)) {
+            continue;
+        }
+        --deadlines_left;
+
+        nlohmann::json forecast = sla(job, runtime, finish, !slots.empty(), now_ms);
+        note(job, forecast);
+
+        // Persist only what changes scheduling or the flag, not every re-forecast
+        int64_t latest_start = job["deadline"].get<int64_t>() - runtime;
+        bool was_at_risk = job.contains("sla") && job["sla"].value("at_risk", false);
+        bool moved = !job.contains("latest_start") || !job["latest_start"].is_number_integer() ||
+                     std::llabs(job["latest_start"].get<int64_t>() - latest_start) >= tolerance_ms;
+        if (moved || was_at_risk != forecast["at_risk"].get<bool>()) {
+            job_repo_->update_job(job["job_id"], {{"latest_start", latest_start}, {"sla", forecast}});
+        }
+    }
+
+    std::sort(at_risk.begin(), at_risk.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        // Unknown slack (no engines) first, then the furthest behind
+        const auto& sa = a["sla"]["slack_ms"];
+        const auto& sb = b["sla"]["slack_ms"];
+        if (sa.is_null() != sb.is_null()) return sa.is_null();
+        return !sa.is_null() && sa.get<int64_t>() < sb.get<int64_t>();
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    at_risk_ = std::move(at_risk);
+    evaluated_at_ = now_ms;
+    tracked_ = tracked;
+    overdue_ = overdue;
+}
+
+nlohmann::json DeadlineMonitor::at_risk() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {{"jobs", at_risk_}, {"count", at_risk_.size()}, {"evaluated_at", evaluated_at_}};
+}
+
+nlohmann::json DeadlineMonitor::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {{"tracked", tracked_}, {"at_risk", at_risk_.size()}, {"overdue", overdue_},
+            {"flagged_at_submission", flagged_at_submission_}};
+}
+
+} // namespace DispatchServer
+} // namespace distconv
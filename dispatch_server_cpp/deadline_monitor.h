@@ -0,0 +1,73 @@
+#ifndef DEADLINE_MONITOR_H
+#define DEADLINE_MONITOR_H
+
+#include "repositories.h"
+#include "runtime_estimator.h"
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// A job's "deadline": epoch milliseconds, or an ISO 8601 timestamp such as
+// "2026-05-01T18:00:00Z" (fractional seconds and a +hh:mm offset allowed; no
+// offset means UTC). False when the value is neither.
+bool parse_deadline(const nlohmann::json& value, int64_t& deadline_ms);
+
+// Deadline (EDF) scheduling and SLA miss prediction.
+//
+// A job submitted with a deadline gets "latest_start" = deadline - predicted
+// runtime, which the repositories use to order it ahead of deadline-less work
+// of the same priority. assess() at submission and scan() (background worker)
+// forecast each deadline job's finish by list-scheduling the running and
+// pending jobs, in queue order, onto the registered engines' slots using the
+// runtime estimator. Jobs forecast to finish after their deadline carry
+// "sla": {"at_risk": true, ...} and are listed by at_risk() so capacity can be
+// added before the miss. Jobs with no runtime history count as instantaneous.
+class DeadlineMonitor {
+public:
+    DeadlineMonitor(std::shared_ptr<IJobRepository> job_repo,
+                    std::shared_ptr<IEngineRepository> engine_repo,
+                    std::shared_ptr<RuntimeEstimator> estimator);
+
+    // Sets latest_start and sla on a job with a deadline that is about to be saved
+    void assess(nlohmann::json& job, int64_t now_ms);
+
+    void scan(int64_t now_ms);
+
+    // {"jobs": [...], "count": n, "evaluated_at": ms}, least slack first, as of the last scan
+    nlohmann::json at_risk() const;
+    nlohmann::json metrics() const;
+
+private:
+    // Predicted runtime, 0 when unknown
+    int64_t runtime_of(const nlohmann::json& job) const;
+    // Slot release times: now for idle slots, else when the running job should end.
+    // Empty when no engine is registered.
+    std::vector<int64_t> slot_release_times(int64_t now_ms, const std::vector<nlohmann::json>& running) const;
+    std::vector<nlohmann::json> running_jobs() const;
+    static bool has_deadline(const nlohmann::json& job);
+    static nlohmann::json sla(const nlohmann::json& job, int64_t runtime_ms, int64_t finish_ms, bool finish_known,
+                              int64_t now_ms);
+
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<RuntimeEstimator> estimator_;
+
+    mutable std::mutex mutex_;
+    std::vector<nlohmann::json> at_risk_;
+    int64_t evaluated_at_ = 0;
+    size_t tracked_ = 0;
+    size_t overdue_ = 0;
+    uint64_t flagged_at_submission_ = 0;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // DEADLINE_MONITOR_H
@@ -14,27 +14,141 @@ constexpr std::chrono::seconds BACKGROUND_WORKER_INTERVAL{30};
 // Engine timeout and cleanup
 constexpr std::chrono::minutes ENGINE_HEARTBEAT_TIMEOUT{5};
 
-// Job timeout
+// Job timeouts: a running job may take its predicted runtime (codec history,
+// job size, the engine's throughput) times the safety factor, clamped to the
+// min/max; JOB_TIMEOUT applies while nothing has been learned. A job that has
+// reported progress times out early once it goes quiet for the stall timeout.
 constexpr std::chrono::minutes JOB_TIMEOUT{30};
+constexpr double JOB_TIMEOUT_SAFETY_FACTOR = 3.0;
+constexpr std::chrono::minutes JOB_TIMEOUT_MIN{5};
+constexpr std::chrono::hours JOB_TIMEOUT_MAX{12};
+constexpr std::chrono::minutes JOB_PROGRESS_STALL_TIMEOUT{5};
+
+// Upper bound for /assign_job/?wait= long-polls
+constexpr std::chrono::seconds LONG_POLL_MAX_WAIT{60};
+
+// GET /events stream tuning
+constexpr std::chrono::seconds EVENT_STREAM_KEEPALIVE{15};
+constexpr std::chrono::milliseconds EVENT_STREAM_RETRY_MS{3000};
+constexpr size_t EVENT_HISTORY_SIZE = 1024;         // Replay window for Last-Event-ID
+constexpr size_t EVENT_SUBSCRIBER_QUEUE_SIZE = 256; // Backlog before a subscriber is dropped
+
+// Event-loop HTTP front end: I/O threads multiplexing all connections, parsed
+// requests allowed to wait for a worker before new ones get 503, how long an
+// idle keep-alive connection is kept open, and the largest request body
+constexpr size_t EVENT_LOOP_IO_THREADS = 2;
+constexpr size_t EVENT_LOOP_MAX_QUEUED_REQUESTS = 1024;
+constexpr std::chrono::seconds EVENT_LOOP_IDLE_TIMEOUT{120};
+constexpr size_t EVENT_LOOP_MAX_BODY_BYTES = 64 * 1024 * 1024;
+
+// Response compression: level (1-9, used for both gzip and zstd; 0 disables)
+// and the smallest buffered body worth compressing
+constexpr int COMPRESSION_LEVEL = 6;
+constexpr size_t COMPRESSION_MIN_BYTES = 1024;
+
+// Source-cache locality: how long a pending job whose source is cached on
+// another engine is held back for that engine, and how deep the claim path
+// looks past the queue head for such jobs
+constexpr std::chrono::seconds SOURCE_LOCALITY_WAIT{20};
+constexpr size_t SOURCE_LOCALITY_SCAN_LIMIT = 32;
+
+// Speculative re-execution: a running job whose projected runtime exceeds the
+// codec's median completed duration by this factor gets a copy on an idle
+// engine, within per-job and cluster-wide budgets
+constexpr double STRAGGLER_SLOWDOWN_FACTOR = 3.0;
+constexpr size_t STRAGGLER_MIN_SAMPLES = 5;
+constexpr int SPECULATION_MAX_COPIES_PER_JOB = 1;
+constexpr size_t SPECULATION_MAX_ACTIVE = 2;
+constexpr double SPECULATION_MAX_ENGINE_SHARE = 0.1;
+
+// Preemption: an urgent job pending this long with no free engine has a
+// preemptible engine suspend lower-priority work for it. The urgent job stays
+// reserved for that engine until it claims it or the timeout passes.
+constexpr std::chrono::seconds PREEMPTION_GRACE{30};
+constexpr std::chrono::minutes PREEMPTION_RESERVATION_TIMEOUT{5};
+
+// Admission control on POST /jobs/: pending counts are re-read from the
+// repository at most this often (admissions in between are added locally).
+// Retry-After is the time the measured drain rate needs to bring the queue
+// back under the limit, clamped to these bounds; the default applies while
+// nothing has drained yet.
+constexpr std::chrono::seconds ADMISSION_COUNT_REFRESH{1};
+constexpr std::chrono::seconds ADMISSION_MIN_RETRY_AFTER{1};
+constexpr std::chrono::seconds ADMISSION_MAX_RETRY_AFTER{300};
+constexpr std::chrono::seconds ADMISSION_DEFAULT_RETRY_AFTER{30};
+constexpr double ADMISSION_DRAIN_SMOOTHING = 0.3; // Weight of the newest drain-rate sample
+
+// Deadline scheduling: the background re-forecast rewrites a pending job's
+// latest_start only when the runtime prediction moved it by at least this much
+constexpr std::chrono::seconds DEADLINE_RESCHEDULE_TOLERANCE{60};
 
-// Default retry limits
 // Default retry limits
 constexpr int DEFAULT_MAX_RETRIES = 3;
 constexpr int MAX_RETRIES = 5; // Hard limit or default if not specified
 constexpr int RETRY_DELAY_BASE_SECONDS = 30;
 
-// Default persistent storage file
-inline const std::string DEFAULT_STATE_FILE = "dispatch_server_state.json";
+// Retry backoff: the n-th retry for a failure class (download, transcode,
+// upload, timeout, engine_lost) waits a uniformly random time in
+// [0, min(cap, base * 2^n)]. Due retries re-enter the queue through a token
+// bucket of RETRY_BUDGET_PER_MINUTE (bursts up to RETRY_BUDGET_BURST), so a
+// storage outage that failed hundreds of jobs does not replay them at once.
+constexpr std::chrono::minutes RETRY_BACKOFF_CAP{10};
+constexpr size_t RETRY_BUDGET_PER_MINUTE = 60;
+constexpr size_t RETRY_BUDGET_BURST = 20;
 
 // Job priority levels
+constexpr int PRIORITY_LOW = -1; // Jobs admitted over a soft pending limit
 constexpr int PRIORITY_NORMAL = 0;
 constexpr int PRIORITY_HIGH = 1;
 constexpr int PRIORITY_URGENT = 2;
 
-// Job size thresholds (in MB) for scheduling
+// Job size thresholds (in MB) for scheduling: jobs below the small threshold
+// run in the small lane, below the medium threshold in the medium lane, the
+// rest in the large lane
 constexpr double JOB_SIZE_SMALL_THRESHOLD = 50.0;
 constexpr double JOB_SIZE_MEDIUM_THRESHOLD = 100.0;
 
+// Size-class lanes: share of the cluster's engine slots held for the small and
+// large lanes while they have pending work (other lanes may use them otherwise).
+// Lane occupancy is re-read from the repositories at most this often.
+constexpr double SIZE_LANE_SMALL_RESERVE = 0.2;
+constexpr double SIZE_LANE_LARGE_RESERVE = 0.2;
+constexpr std::chrono::seconds SIZE_LANE_COUNT_REFRESH{1};
+
+// Most small jobs handed to an engine in one batched assignment
+constexpr size_t BATCH_MAX_ITEMS = 16;
+
+// Engine health: outcomes of an engine's last ENGINE_HEALTH_WINDOW jobs are
+// kept, and once at least ENGINE_HEALTH_MIN_SAMPLES are in, a failure rate at
+// or above ENGINE_QUARANTINE_FAILURE_RATE quarantines the engine. After the
+// quarantine one probe job decides; each failed probe doubles the quarantine
+// up to ENGINE_QUARANTINE_MAX.
+constexpr size_t ENGINE_HEALTH_WINDOW = 20;
+constexpr size_t ENGINE_HEALTH_MIN_SAMPLES = 5;
+constexpr double ENGINE_QUARANTINE_FAILURE_RATE = 0.5;
+constexpr std::chrono::minutes ENGINE_QUARANTINE_DURATION{2};
+constexpr std::chrono::minutes ENGINE_QUARANTINE_MAX{30};
+
+// A job that failed or timed out on an engine is not handed back to it for this long
+constexpr std::chrono::minutes RETRY_ANTI_AFFINITY_WINDOW{5};
+
+// Job traces: batches of finished spans waiting for the exporter thread; a
+// slow file or collector drops batches past this instead of holding up reports
+constexpr size_t TRACE_EXPORT_QUEUE_SIZE = 1024;
+constexpr std::chrono::seconds TRACE_EXPORT_TIMEOUT{5};
+constexpr int TRACE_EXPORT_ATTEMPTS = 3; // Tries per batch when the collector refuses connections
+
+// Restarts: how long a stopping or replaced dispatcher keeps answering
+// requests it already received, and how long it waits for a successor that
+// took its listening socket to confirm that it is serving
+constexpr std::chrono::seconds DRAIN_TIMEOUT{30};
+constexpr std::chrono::seconds HANDOFF_CONFIRM_TIMEOUT{30};
+
+// State snapshot: how often the background worker rewrites it (and once more
+// at shutdown), and the file suffix used next to the database by default
+constexpr std::chrono::seconds SNAPSHOT_INTERVAL{60};
+inline const std::string SNAPSHOT_SUFFIX = ".snapshot";
+
 }  // namespace Constants
 }  // namespace DispatchServer
 }  // namespace distconv
@@ -1,4 +1,3 @@
-#include <iostream>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -7,30 +6,33 @@
 #include <atomic>
 #include <future>
 #include <stdexcept>
+#include <unistd.h>
 #include <uuid/uuid.h>
 #include "httplib.h"
 #include "nlohmann/json.hpp"
 #include "dispatch_server_core.h"
 #include "dispatch_server_constants.h"
+#include "wall_clock.h"
 #include "request_handlers.h"
 #include "job_handlers.h"
 #include "engine_handlers.h"
 #include "job_action_handlers.h"
 #include "assignment_handler.h"
 #include "job_update_handler.h"
+#include "event_stream_handler.h"
+#include "engine_channel_handler.h"
+#include "scheduler_stats_handler.h"
 #include "storage_pool_handler.h"
 #include "api_middleware.h"
 #include "enhanced_endpoints.h"
+#include "repository_metrics.h"
+#include "structured_log.hpp"
 
 namespace distconv {
 namespace DispatchServer {
 
 using namespace Constants;
 
-// Global flag for mocking
-bool mock_save_state_enabled = false;
-std::atomic<int> save_state_call_count{0};
-
 // Utility function to generate UUID for job IDs
 std::string generate_uuid() {
     uuid_t uuid;
@@ -121,8 +123,14 @@ Engine Engine::from_json(const nlohmann::json& j) {
 // DispatchServer Implementation
 
 DispatchServer::DispatchServer(const std::string& api_key) 
-    : job_repo_(std::make_shared<SqliteJobRepository>("dispatch_jobs.db")),
-      engine_repo_(std::make_shared<SqliteEngineRepository>("dispatch_engines.db")),
+    : job_repo_(std::make_shared<PublishingJobRepository>(
+          std::make_shared<InstrumentedJobRepository>(std::make_shared<SqliteJobRepository>("dispatch_jobs.db"),
+                                                      metrics_),
+          job_events_, versions_)),
+      engine_repo_(std::make_shared<VersionedEngineRepository>(
+          std::make_shared<InstrumentedEngineRepository>(
+              std::make_shared<SqliteEngineRepository>("dispatch_engines.db"), metrics_),
+          versions_)),
       api_key_(api_key) {
     
     // Initialize Tdarr client with default URL or from environment
@@ -138,8 +146,10 @@ DispatchServer::DispatchServer(const std::string& api_key)
 DispatchServer::DispatchServer(std::shared_ptr<IJobRepository> job_repo, 
                                std::shared_ptr<IEngineRepository> engine_repo,
                                const std::string& api_key) 
-    : job_repo_(job_repo), 
-      engine_repo_(engine_repo),
+    : job_repo_(std::make_shared<PublishingJobRepository>(
+          std::make_shared<InstrumentedJobRepository>(job_repo, metrics_), job_events_, versions_)),
+      engine_repo_(std::make_shared<VersionedEngineRepository>(
+          std::make_shared<InstrumentedEngineRepository>(engine_repo, metrics_), versions_)),
       api_key_(api_key) {
     
     // Initialize Tdarr client with default URL or from environment
@@ -156,14 +166,22 @@ DispatchServer::DispatchServer(std::shared_ptr<IJobRepository> job_repo,
                                std::shared_ptr<IEngineRepository> engine_repo,
                                std::unique_ptr<MessageQueueFactory> mq_factory,
                                const std::string& api_key)
-    : job_repo_(job_repo),
-      engine_repo_(engine_repo),
+    : job_repo_(std::make_shared<PublishingJobRepository>(
+          std::make_shared<InstrumentedJobRepository>(job_repo, metrics_), job_events_, versions_)),
+      engine_repo_(std::make_shared<VersionedEngineRepository>(
+          std::make_shared<InstrumentedEngineRepository>(engine_repo, metrics_), versions_)),
       mq_factory_(std::move(mq_factory)),
       api_key_(api_key) {
 
     if (mq_factory_) {
         job_publisher_ = std::make_shared<JobPublisher>(mq_factory_->createProducer());
         status_subscriber_ = std::make_shared<StatusSubscriber>(mq_factory_->createConsumer("dispatch-server-group"));
+        Histogram* lag = &metrics_->histogram("dispatch_mq_lag_seconds",
+                                              "Time status updates spent in the message queue", latency_buckets(),
+                                              {{"topic", "status"}});
+        status_subscriber_->setLagObserver([lag](std::chrono::milliseconds queued) {
+            lag->observe(queued.count() / 1000.0);
+        });
         status_subscriber_->subscribeToStatusUpdates([this](const std::string& message_payload) {
             try {
                 auto j = nlohmann::json::parse(message_payload);
@@ -189,8 +207,14 @@ DispatchServer::DispatchServer(std::shared_ptr<IJobRepository> job_repo,
 }
 
 DispatchServer::DispatchServer() 
-    : job_repo_(std::make_shared<SqliteJobRepository>("dispatch_jobs.db")),
-      engine_repo_(std::make_shared<SqliteEngineRepository>("dispatch_engines.db")) {
+    : job_repo_(std::make_shared<PublishingJobRepository>(
+          std::make_shared<InstrumentedJobRepository>(std::make_shared<SqliteJobRepository>("dispatch_jobs.db"),
+                                                      metrics_),
+          job_events_, versions_)),
+      engine_repo_(std::make_shared<VersionedEngineRepository>(
+          std::make_shared<InstrumentedEngineRepository>(
+              std::make_shared<SqliteEngineRepository>("dispatch_engines.db"), metrics_),
+          versions_)) {
     
     // Initialize Tdarr client with default URL or from environment
     const char* tdarr_url_env = std::getenv("TDARR_URL");
@@ -200,6 +224,45 @@ DispatchServer::DispatchServer()
 
 DispatchServer::~DispatchServer() {
     stop();
+    metrics_->remove_collector(job_depths_collector_);
+    metrics_->remove_collector(log_drops_collector_);
+    metrics_->remove_collector(engine_log_drops_collector_);
+}
+
+uint64_t DispatchServer::add_job_depths_collector() {
+    static const char* const STATUSES[] = {"pending", "assigned", "processing", "suspended", "failed_retry",
+                                           "completed", "failed_permanently", "cancelled", "expired",
+                                           "submitted_to_tdarr"};
+    return metrics_->add_collector("dispatch_jobs", "Jobs by status", [job_repo = job_repo_]() {
+        std::vector<MetricsRegistry::Sample> samples;
+        for (const char* status : STATUSES) {
+            size_t count = 0;
+            for (const auto& tenant : job_repo->count_jobs_by_tenant(status)) count += tenant.second;
+            samples.push_back({{{"status", status}}, static_cast<double>(count)});
+        }
+        return samples;
+    });
+}
+
+uint64_t DispatchServer::add_log_drops_collector() {
+    return metrics_->add_counter_collector(
+        "dispatch_log_records_dropped_total", "Log records dropped because the log buffer was full", []() {
+            return std::vector<MetricsRegistry::Sample>{{{}, static_cast<double>(logging::logger().dropped())}};
+        });
+}
+
+uint64_t DispatchServer::add_engine_log_drops_collector() {
+    return metrics_->add_counter_collector(
+        "dispatch_engine_log_records_dropped_total", "Log records dropped by engines, as of their last heartbeat",
+        [engine_repo = engine_repo_]() {
+            std::vector<MetricsRegistry::Sample> samples;
+            for (const auto& engine : engine_repo->get_all_engines()) {
+                if (!engine.contains("log_records_dropped") || !engine["log_records_dropped"].is_number()) continue;
+                samples.push_back({{{"engine_id", engine.value("engine_id", "")}},
+                                   engine["log_records_dropped"].get<double>()});
+            }
+            return samples;
+        });
 }
 
 void DispatchServer::set_api_key(const std::string& key) {
@@ -209,47 +272,91 @@ void DispatchServer::set_api_key(const std::string& key) {
 
 void DispatchServer::start(int port, bool block) {
     shutdown_requested_.store(false);
+    if (!snapshot_options_.path.empty()) {
+        restore_state();
+    }
+    assignment_waiters_->open();
+    job_events_->open();
     background_worker_thread_ = std::thread(&DispatchServer::background_worker, this);
 
+    if (event_loop_options_) {
+        event_server_ = std::make_unique<EventLoopServer>(routes_, *event_loop_options_, endpoint_pools_);
+        auto compression = compression_;
+        event_server_->set_post_routing_handler([compression](const httplib::Request& req, httplib::Response& res) {
+            compression->apply(req, res);
+        });
+    }
+
     int bound_port = -1;
-    if (port == 0) {
-        bound_port = svr.bind_to_any_port("0.0.0.0");
+    if (inherited_listen_fd_ >= 0) {
+        bound_port = event_server_ ? event_server_->adopt_listen_socket(inherited_listen_fd_) : -1;
+        if (bound_port == -1) {
+            logging::error("server", "Cannot serve on the inherited listening socket (needs the event loop)");
+            ::close(inherited_listen_fd_);
+        }
+        inherited_listen_fd_ = -1;
+    } else if (port == 0) {
+        bound_port = event_server_ ? event_server_->bind_to_any_port("0.0.0.0") : svr.bind_to_any_port("0.0.0.0");
     } else {
-        if (svr.bind_to_port("0.0.0.0", port)) {
+        if (event_server_ ? event_server_->bind_to_port("0.0.0.0", port) : svr.bind_to_port("0.0.0.0", port)) {
             bound_port = port;
         }
     }
 
     if (bound_port == -1) {
-        std::cerr << "Failed to bind to port " << port << std::endl;
+        logging::error("server", "Failed to bind to port", {{"port", port}});
         return;
     }
 
     bound_port_ = bound_port;
     
     if (block) {
-        svr.listen_after_bind();
+        event_server_ ? event_server_->listen_after_bind() : svr.listen_after_bind();
     } else {
         server_thread = std::thread([this]() {
-            this->svr.listen_after_bind();
+            this->event_server_ ? this->event_server_->listen_after_bind() : this->svr.listen_after_bind();
         });
     }
 }
 
 void DispatchServer::stop() {
-    shutdown_requested_.store(true);
-    shutdown_cv_.notify_all();
-    if (background_worker_thread_.joinable()) {
-        background_worker_thread_.join();
-    }
+    stop_background_worker();
+    assignment_waiters_->close();
+    job_events_->close();
     
+    if (event_server_) {
+        event_server_->stop();
+    }
     if (svr.is_running()) {
         svr.stop();
     }
     if (server_thread.joinable()) {
         server_thread.join();
     }
-    std::cout << "DispatchServer stopped. State managed by repositories." << std::endl;
+    if (snapshot_due_.exchange(false)) {
+        write_snapshot();
+    }
+    logging::info("server", "DispatchServer stopped");
+}
+
+void DispatchServer::drain(std::chrono::milliseconds timeout) {
+    // A successor may already be serving on the same socket; only one process
+    // should time out and requeue jobs
+    stop_background_worker();
+    assignment_waiters_->close();
+    job_events_->close();
+    if (event_server_) {
+        event_server_->drain(timeout);
+    }
+    stop();
+}
+
+void DispatchServer::stop_background_worker() {
+    shutdown_requested_.store(true);
+    shutdown_cv_.notify_all();
+    if (background_worker_thread_.joinable()) {
+        background_worker_thread_.join();
+    }
 }
 
 httplib::Server* DispatchServer::getServer() {
@@ -257,27 +364,63 @@ httplib::Server* DispatchServer::getServer() {
 }
 
 void DispatchServer::background_worker() {
+    Histogram& pass_duration = metrics_->histogram("dispatch_background_pass_seconds",
+                                                   "Duration of one background maintenance pass", latency_buckets());
     while (!shutdown_requested_.load()) {
         try {
+            auto pass_start = std::chrono::steady_clock::now();
             cleanup_stale_engines();
             handle_job_timeouts();
+            auto now_ms = wall_clock_ms();
+            speculation_->scan(now_ms);
+            preemption_->scan(now_ms);
+            deadlines_->scan(now_ms);
             requeue_failed_jobs();
             expire_pending_jobs();
+            pass_duration.observe_since(pass_start);
+            if (snapshot_due_.load() && snapshot_options_.interval.count() > 0 &&
+                std::chrono::steady_clock::now() - snapshot_written_at_ >= snapshot_options_.interval) {
+                write_snapshot();
+            }
             
             std::unique_lock<std::mutex> lock(shutdown_mutex_);
             shutdown_cv_.wait_for(lock, BACKGROUND_WORKER_INTERVAL, [this] {
                 return shutdown_requested_.load();
             });
         } catch (const std::exception& e) {
-            std::cerr << "Background worker error: " << e.what() << std::endl;
+            logging::error("server", "Background worker error", {{"error", e.what()}});
         }
     }
 }
 
+void DispatchServer::restore_state() {
+    auto started = std::chrono::steady_clock::now();
+    int64_t watermark_ms = 0;
+    if (!snapshot_->load(snapshot_options_.path, watermark_ms)) {
+        logging::info("snapshot", "No usable state snapshot; scheduling state starts empty",
+                      {{"path", snapshot_options_.path}});
+    } else {
+        size_t replayed = snapshot_->replay(*job_repo_, watermark_ms);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        logging::info("snapshot", "Restored scheduling state",
+                      {{"path", snapshot_options_.path}, {"watermark_ms", watermark_ms},
+                       {"replayed_jobs", replayed}, {"duration_ms", elapsed.count()}});
+    }
+    snapshot_written_at_ = std::chrono::steady_clock::now();
+    snapshot_due_.store(true);
+}
+
+void DispatchServer::write_snapshot() {
+    // Taken before the state is read: a job recorded while it is read is at
+    // worst replayed on top of it, never lost
+    int64_t watermark_ms = wall_clock_ms();
+    snapshot_->write(snapshot_options_.path, watermark_ms);
+    snapshot_written_at_ = std::chrono::steady_clock::now();
+}
+
 void DispatchServer::cleanup_stale_engines() {
     auto engines = engine_repo_->get_all_engines();
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
     
     int64_t timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(ENGINE_HEARTBEAT_TIMEOUT).count();
 
@@ -288,47 +431,56 @@ void DispatchServer::cleanup_stale_engines() {
             
             if (diff_ms > timeout_ms) {
                 std::string engine_id = engine["engine_id"];
-                std::cout << "Removing stale engine: " << engine_id << std::endl;
+                logging::warn("engines", "Removing stale engine", {{"engine_id", engine_id}});
                 
-                if (engine.contains("current_job_id") && !engine["current_job_id"].is_null()) {
-                    std::string job_id = engine["current_job_id"];
-                    if (job_repo_->job_exists(job_id)) {
-                        nlohmann::json job = job_repo_->get_job(job_id);
-                        if (job["status"] == "assigned" || job["status"] == "processing") {
-                            job["status"] = "pending";
-                            job["assigned_engine"] = nullptr;
-                            job["retries"] = job.value("retries", 0) + 1;
-                            job_repo_->save_job(job_id, job);
-                        }
+                // Every slot's job is retried, and jobs it suspended for urgent
+                // work, which will never be resumed there, go back to the queue
+                for (auto& job : job_repo_->get_jobs_by_engine(engine_id)) {
+                    std::string status = job.value("status", "");
+                    if (status != "assigned" && status != "processing" && status != "suspended") {
+                        continue;
                     }
+                    job["assigned_engine"] = nullptr;
+                    if (status == "suspended") {
+                        job["status"] = "pending";
+                        job_repo_->save_job(job["job_id"], job);
+                        assignment_waiters_->notify_job_available(job);
+                        continue;
+                    }
+                    retries_->schedule(job, "engine_lost",
+                                       "Engine " + engine_id + " stopped sending heartbeats and retries are exhausted",
+                                       now_ms);
+                    job_repo_->save_job(job["job_id"], job);
                 }
                 engine_repo_->remove_engine(engine_id);
+                source_cache_->remove(engine_id);
+                health_->forget(engine_id);
             }
         }
     }
 }
 
 void DispatchServer::handle_job_timeouts() {
-    auto timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(JOB_TIMEOUT).count();
-    auto jobs = job_repo_->get_jobs_to_timeout(timeout_ms);
+    auto now_ms = wall_clock_ms();
     
-    for (auto& job : jobs) {
+    for (auto& [job, reason] : timeouts_->expired(now_ms)) {
         std::string job_id = job["job_id"];
-        std::cout << "Job " << job_id << " timed out, marking as failed" << std::endl;
-
-        int retries = job.value("retries", 0);
-        int max_retries = job.value("max_retries", 3);
-
-        if (retries < max_retries) {
-            job["status"] = "failed_retry";
-            job["retries"] = retries + 1;
-            job["retry_after"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch() + std::chrono::seconds(30)).count();
-        } else {
-            job["status"] = "failed_permanently";
-            job["error_message"] = "Job timed out and exceeded max retries";
+        logging::warn("scheduler", reason == "stalled" ? "Job stopped reporting progress, marking as failed"
+                                                       : "Job timed out, marking as failed",
+                      {{"job_id", job_id}, {"reason", reason}});
+        job["timeout_reason"] = reason;
+
+        // The retry goes to another engine first, and the timeout counts against this one
+        if (job.contains("assigned_engine") && job["assigned_engine"].is_string()) {
+            health_->record_failure(job["assigned_engine"], job, reason, now_ms);
+            mark_retry_anti_affinity(job, job["assigned_engine"], now_ms);
         }
 
+        retries_->schedule(job, "timeout",
+                           reason == "stalled" ? "Job stopped reporting progress and exceeded max retries"
+                                               : "Job timed out and exceeded max retries",
+                           now_ms);
+
         if (job.contains("assigned_engine") && !job["assigned_engine"].is_null()) {
             std::string engine_id = job["assigned_engine"];
             nlohmann::json engine = engine_repo_->get_engine(engine_id);
@@ -343,16 +495,8 @@ void DispatchServer::handle_job_timeouts() {
 }
 
 void DispatchServer::requeue_failed_jobs() {
-    auto jobs = job_repo_->get_jobs_by_status("failed_retry");
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
-    
-    for (auto& job : jobs) {
-        int64_t retry_after = job.value("retry_after", 0LL);
-        if (now_ms >= retry_after) {
-            job["status"] = "pending";
-            job_repo_->save_job(job["job_id"], job);
-        }
+    for (const auto& job : retries_->release_due(*job_repo_, wall_clock_ms())) {
+        assignment_waiters_->notify_job_available(job);
     }
 }
 
@@ -371,6 +515,11 @@ void DispatchServer::expire_pending_jobs() {
 // Endpoint Setup
 
 void DispatchServer::setup_endpoints() {
+    auto compression = compression_;
+    svr.set_post_routing_handler([compression](const httplib::Request& req, httplib::Response& res) {
+        compression->apply(req, res);
+    });
+
     setup_system_endpoints();
     setup_job_endpoints();
     setup_engine_endpoints();
@@ -378,93 +527,146 @@ void DispatchServer::setup_endpoints() {
     setup_tdarr_endpoints();
     
     // Wire up enhanced endpoints
-    setup_enhanced_job_endpoints(svr, api_key_, job_repo_, engine_repo_);
-    setup_enhanced_system_endpoints(svr, api_key_, job_repo_, engine_repo_);
+    setup_enhanced_job_endpoints(routes_, api_key_, job_repo_, engine_repo_, assignment_waiters_);
+    setup_enhanced_system_endpoints(routes_, api_key_, job_repo_, engine_repo_, assignment_waiters_);
 }
 
 void DispatchServer::setup_system_endpoints() {
-    svr.Get("/", [](const httplib::Request&, httplib::Response& res) {
+    routes_.Get("/", [](const httplib::Request&, httplib::Response& res) {
         res.set_content("OK", "text/plain");
-    });
+    }, EndpointClass::Control);
 
-    svr.Get("/health", [](const httplib::Request&, httplib::Response& res) {
+    routes_.Get("/health", [](const httplib::Request&, httplib::Response& res) {
         nlohmann::json health;
         health["status"] = "healthy";
         res.set_content(health.dump(), "application/json");
+    }, EndpointClass::Control);
+
+    // Unauthenticated like /health, for Prometheus scrapers
+    auto metrics = metrics_;
+    routes_.Get("/metrics", [metrics](const httplib::Request&, httplib::Response& res) {
+        res.set_content(metrics->render(), METRICS_CONTENT_TYPE);
+    });
+
+    auto auth = std::make_shared<AuthMiddleware>(api_key_);
+    auto stats_handler = std::make_shared<SchedulerStatsHandler>(auth, speculation_, preemption_, admission_,
+                                                                  deadlines_, size_lanes_, health_, retries_,
+                                                                  endpoint_pools_);
+    routes_.Get("/scheduler/stats", [stats_handler](const httplib::Request& req, httplib::Response& res) {
+        stats_handler->handle(req, res);
     });
 }
 
 void DispatchServer::setup_job_endpoints() {
     auto auth = std::make_shared<AuthMiddleware>(api_key_);
     
-    auto submit_handler = std::make_shared<JobSubmissionHandler>(auth, job_repo_);
-    svr.Post("/jobs/", [submit_handler](const httplib::Request& req, httplib::Response& res) {
+    auto submit_handler = std::make_shared<JobSubmissionHandler>(auth, job_repo_, assignment_waiters_, admission_,
+                                                                 deadlines_);
+    routes_.Post("/jobs/", [submit_handler](const httplib::Request& req, httplib::Response& res) {
         submit_handler->handle(req, res);
-    });
+    }, EndpointClass::Submission);
 
-    auto status_handler = std::make_shared<JobStatusHandler>(auth, job_repo_);
-    svr.Get(R"(/jobs/([a-fA-F0-9\-]{36}))", [status_handler](const httplib::Request& req, httplib::Response& res) {
+    auto status_handler = std::make_shared<JobStatusHandler>(auth, job_repo_, versions_);
+    routes_.Get("/jobs/{job_id:uuid}", [status_handler](const httplib::Request& req, httplib::Response& res) {
         status_handler->handle(req, res);
     });
 
+    auto at_risk_handler = std::make_shared<AtRiskJobsHandler>(auth, deadlines_);
+    routes_.Get("/jobs/at_risk", [at_risk_handler](const httplib::Request& req, httplib::Response& res) {
+        at_risk_handler->handle(req, res);
+    });
+
     auto list_handler = std::make_shared<JobListHandler>(auth, job_repo_);
-    svr.Get("/jobs/", [list_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Get("/jobs/", [list_handler](const httplib::Request& req, httplib::Response& res) {
         list_handler->handle(req, res);
     });
 
-    auto complete_handler = std::make_shared<JobCompletionHandler>(auth, job_repo_, engine_repo_);
-    svr.Post(R"(/jobs/([a-fA-F0-9\-]{36})/complete)", [complete_handler](const httplib::Request& req, httplib::Response& res) {
-        complete_handler->handle(req, res);
+    auto events_handler = std::make_shared<JobEventStreamHandler>(auth, job_events_);
+    routes_.Get("/events", [events_handler](const httplib::Request& req, httplib::Response& res) {
+        events_handler->handle(req, res);
     });
 
-    auto fail_handler = std::make_shared<JobFailureHandler>(auth, job_repo_, engine_repo_);
-    svr.Post(R"(/jobs/([a-fA-F0-9\-]{36})/fail)", [fail_handler](const httplib::Request& req, httplib::Response& res) {
+    auto complete_handler = std::make_shared<JobCompletionHandler>(auth, job_repo_, engine_repo_, speculation_,
+                                                                   health_, tracer_);
+    routes_.Post("/jobs/{job_id:uuid}/complete", [complete_handler](const httplib::Request& req, httplib::Response& res) {
+        complete_handler->handle(req, res);
+    }, EndpointClass::Control);
+
+    auto fail_handler = std::make_shared<JobFailureHandler>(auth, job_repo_, engine_repo_, speculation_, health_,
+                                                            retries_, tracer_);
+    routes_.Post("/jobs/{job_id:uuid}/fail", [fail_handler](const httplib::Request& req, httplib::Response& res) {
         fail_handler->handle(req, res);
-    });
+    }, EndpointClass::Control);
+
+    auto suspend_handler = std::make_shared<JobSuspendHandler>(auth, job_repo_, preemption_);
+    routes_.Post("/jobs/{job_id:uuid}/suspend", [suspend_handler](const httplib::Request& req, httplib::Response& res) {
+        suspend_handler->handle(req, res);
+    }, EndpointClass::Control);
+
+    auto resume_handler = std::make_shared<JobResumeHandler>(auth, job_repo_, preemption_);
+    routes_.Post("/jobs/{job_id:uuid}/resume", [resume_handler](const httplib::Request& req, httplib::Response& res) {
+        resume_handler->handle(req, res);
+    }, EndpointClass::Control);
 
-    auto retry_handler = std::make_shared<JobRetryHandler>(auth, job_repo_);
-    svr.Post(R"(/jobs/([a-fA-F0-9\-]{36})/retry)", [retry_handler](const httplib::Request& req, httplib::Response& res) {
+    auto retry_handler = std::make_shared<JobRetryHandler>(auth, job_repo_, assignment_waiters_);
+    routes_.Post("/jobs/{job_id:uuid}/retry", [retry_handler](const httplib::Request& req, httplib::Response& res) {
         retry_handler->handle(req, res);
-    });
+    }, EndpointClass::Submission);
 
     auto cancel_handler = std::make_shared<JobCancelHandler>(auth, job_repo_, engine_repo_);
-    svr.Post(R"(/jobs/([a-fA-F0-9\-]{36})/cancel)", [cancel_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Post("/jobs/{job_id:uuid}/cancel", [cancel_handler](const httplib::Request& req, httplib::Response& res) {
         cancel_handler->handle(req, res);
-    });
+    }, EndpointClass::Submission);
 
     auto update_handler = std::make_shared<JobUpdateHandler>(auth, job_repo_);
-    svr.Put(R"(/jobs/([a-fA-F0-9\-]{36}))", [update_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Put("/jobs/{job_id:uuid}", [update_handler](const httplib::Request& req, httplib::Response& res) {
         update_handler->handle(req, res);
-    });
+    }, EndpointClass::Submission);
 
-    auto progress_handler = std::make_shared<JobProgressHandler>(auth, job_repo_);
-    svr.Post(R"(/jobs/([a-fA-F0-9\-]{36})/progress)", [progress_handler](const httplib::Request& req, httplib::Response& res) {
+    auto progress_handler = std::make_shared<JobProgressHandler>(auth, job_repo_, speculation_);
+    routes_.Post("/jobs/{job_id:uuid}/progress", [progress_handler](const httplib::Request& req, httplib::Response& res) {
         progress_handler->handle(req, res);
-    });
+    }, EndpointClass::Control);
 }
 
 void DispatchServer::setup_engine_endpoints() {
     auto auth = std::make_shared<AuthMiddleware>(api_key_);
 
-    auto heartbeat_handler = std::make_shared<EngineHeartbeatHandler>(auth, engine_repo_);
-    svr.Post("/engines/heartbeat", [heartbeat_handler](const httplib::Request& req, httplib::Response& res) {
+    auto heartbeat_handler = std::make_shared<EngineHeartbeatHandler>(auth, engine_repo_, source_cache_,
+                                                                      preemption_);
+    routes_.Post("/engines/heartbeat", [heartbeat_handler](const httplib::Request& req, httplib::Response& res) {
         heartbeat_handler->handle(req, res);
-    });
+    }, EndpointClass::Control);
 
-    auto list_handler = std::make_shared<EngineListHandler>(auth, engine_repo_);
-    svr.Get("/engines/", [list_handler](const httplib::Request& req, httplib::Response& res) {
+    auto list_handler = std::make_shared<EngineListHandler>(auth, engine_repo_, versions_);
+    routes_.Get("/engines/", [list_handler](const httplib::Request& req, httplib::Response& res) {
         list_handler->handle(req, res);
     });
 
-    auto assignment_handler = std::make_shared<JobAssignmentHandler>(auth, job_repo_, engine_repo_);
-    svr.Post("/assign_job/", [assignment_handler](const httplib::Request& req, httplib::Response& res) {
-        assignment_handler->handle(req, res);
+    auto assignment_handler = std::make_shared<JobAssignmentHandler>(auth, job_repo_, engine_repo_,
+                                                                     assignment_waiters_, source_cache_, speculation_,
+                                                                     preemption_, size_lanes_, health_, metrics_);
+    // Wake a parked engine that already caches the job's source ahead of the others
+    auto source_cache = source_cache_;
+    assignment_waiters_->set_preference([source_cache](const std::string& engine_id, const nlohmann::json& job) {
+        return source_cache->engine_holds(engine_id, job.value("source_url", ""));
     });
+    routes_.Post("/assign_job/", [assignment_handler](const httplib::Request& req, httplib::Response& res) {
+        assignment_handler->handle(req, res);
+    }, EndpointClass::Control);
     
     auto benchmark_handler = std::make_shared<EngineBenchmarkHandler>(auth, engine_repo_);
-    svr.Post("/engines/benchmark_result", [benchmark_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Post("/engines/benchmark_result", [benchmark_handler](const httplib::Request& req, httplib::Response& res) {
         benchmark_handler->handle(req, res);
-    });
+    }, EndpointClass::Control);
+
+    auto channel_handler = std::make_shared<EngineChannelHandler>(auth, job_repo_, engine_repo_,
+                                                                  assignment_waiters_, source_cache_, speculation_,
+                                                                  preemption_, size_lanes_, health_, retries_,
+                                                                  metrics_, tracer_);
+    routes_.Post("/engines/channel", [channel_handler](const httplib::Request& req, httplib::Response& res) {
+        channel_handler->handle(req, res);
+    }, EndpointClass::Control);
 }
 
 void DispatchServer::setup_storage_endpoints() {
@@ -472,21 +674,21 @@ void DispatchServer::setup_storage_endpoints() {
     static auto storage_repo = std::make_shared<InMemoryStorageRepository>();
     
     auto create_handler = std::make_shared<StoragePoolCreateHandler>(auth, storage_repo);
-    svr.Post("/storage_pools/", [create_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Post("/storage_pools/", [create_handler](const httplib::Request& req, httplib::Response& res) {
         create_handler->handle(req, res);
     });
 
     auto list_handler = std::make_shared<StoragePoolListHandler>(auth, storage_repo);
-    svr.Get("/storage_pools/", [list_handler](const httplib::Request& req, httplib::Response& res) {
+    routes_.Get("/storage_pools/", [list_handler](const httplib::Request& req, httplib::Response& res) {
         list_handler->handle(req, res);
     });
 }
 
 void DispatchServer::setup_tdarr_endpoints() {
-    std::cout << "Registering Tdarr integration endpoints..." << std::endl;
+    logging::debug("server", "Registering Tdarr integration endpoints");
     auto auth = std::make_shared<AuthMiddleware>(api_key_);
 
-    svr.Get("/tdarr/status", [this, auth](const httplib::Request& req, httplib::Response& res) {
+    routes_.Get("/tdarr/status", [this, auth](const httplib::Request& req, httplib::Response& res) {
         if (!auth->authenticate(req, res)) return;
         
         nlohmann::json status;
@@ -498,7 +700,7 @@ void DispatchServer::setup_tdarr_endpoints() {
         res.set_content(status.dump(), "application/json");
     });
 
-    svr.Post("/tdarr/submit", [this, auth](const httplib::Request& req, httplib::Response& res) {
+    routes_.Post("/tdarr/submit", [this, auth](const httplib::Request& req, httplib::Response& res) {
         if (!auth->authenticate(req, res)) return;
 
         try {
@@ -517,7 +719,7 @@ void DispatchServer::setup_tdarr_endpoints() {
             res.status = 400;
             res.set_content("{\"error\": \"Invalid JSON\"}", "application/json");
         }
-    });
+    }, EndpointClass::Submission);
 }
 
 // Global functions for backward compatibility
@@ -533,7 +735,7 @@ DispatchServer* run_dispatch_server(int argc, char* argv[], DispatchServer* serv
 
     if (server_instance) {
         server_instance->set_api_key(api_key);
-        std::cout << "Dispatch Server listening on port 8080" << std::endl;
+        logging::info("server", "Dispatch Server listening", {{"port", 8080}});
         server_instance->start(8080, false);
     }
 
@@ -543,7 +745,7 @@ DispatchServer* run_dispatch_server(int argc, char* argv[], DispatchServer* serv
 DispatchServer* run_dispatch_server(DispatchServer* server_instance) {
     if (server_instance) {
         server_instance->set_api_key("");
-        std::cout << "Dispatch Server listening on port 8080" << std::endl;
+        logging::info("server", "Dispatch Server listening", {{"port", 8080}});
         server_instance->start(8080, false);
     }
     return server_instance;
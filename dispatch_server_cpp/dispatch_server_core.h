@@ -10,20 +10,34 @@
 #include <future>
 #include "nlohmann/json.hpp"
 #include "httplib.h"
+#include "http_router.h"
+#include "event_loop_server.h"
+#include "response_compression.h"
+#include "metrics.h"
 #include "repositories.h"
 #include "api_middleware.h"
 #include "message_queue.h"
 #include "job_publisher.h"
 #include "status_subscriber.h"
 #include "tdarr_client.h"
+#include "assignment_waiters.h"
+#include "job_events.h"
+#include "source_cache_index.h"
+#include "speculation.h"
+#include "preemption.h"
+#include "admission_control.h"
+#include "deadline_monitor.h"
+#include "size_lanes.h"
+#include "engine_health.h"
+#include "job_timeouts.h"
+#include "retry_policy.h"
+#include "job_tracing.h"
+#include "state_snapshot.h"
+#include "dispatch_server_constants.h"
 
 namespace distconv {
 namespace DispatchServer {
 
-// Global flag for mocking (kept for tests)
-extern bool mock_save_state_enabled;
-extern std::atomic<int> save_state_call_count;
-
 // Job and Engine domain classes
 struct Job {
     std::string id;
@@ -83,9 +97,34 @@ public:
     
     void start(int port, bool block = true);
     void stop();
-    httplib::Server* getServer();
+    // Graceful stop: background passes, long polls and event streams end
+    // first, then requests already received are answered (see
+    // EventLoopServer::drain) for up to `timeout` before stop()
+    void drain(std::chrono::milliseconds timeout = Constants::DRAIN_TIMEOUT);
+    httplib::Server* getServer(); // Has every route; listens only without set_event_loop()
     int get_port() const { return bound_port_; }
     void set_api_key(const std::string& key);
+    void set_admission_policy(const AdmissionPolicy& policy) { admission_->set_policy(policy); }
+    void set_size_lane_policy(const SizeLanePolicy& policy) { size_lanes_->set_policy(policy); }
+    void set_engine_health_policy(const EngineHealthPolicy& policy) { health_->set_policy(policy); }
+    void set_job_timeout_policy(const JobTimeoutPolicy& policy) { timeouts_->set_policy(policy); }
+    void set_retry_policy(const RetryPolicy& policy) { retries_->set_policy(policy); }
+    // Serve through the epoll front end instead of httplib's thread per connection; call before start()
+    void set_event_loop(const EventLoopOptions& options) { event_loop_options_ = std::make_unique<EventLoopOptions>(options); }
+    // Serve on an inherited, already listening socket instead of binding
+    // start()'s port; needs set_event_loop(). The server takes ownership.
+    void set_listen_socket(int fd) { inherited_listen_fd_ = fd; }
+    // The event loop's listening socket while serving, for a handoff; -1 otherwise
+    int listen_socket() const { return event_server_ ? event_server_->listen_socket() : -1; }
+    void set_compression(const CompressionOptions& options) { compression_->set_options(options); }
+    // Restore learned scheduling state from a snapshot at start() and keep it
+    // written there (see StateSnapshot); call before start()
+    void set_state_snapshot(const SnapshotOptions& options) { snapshot_options_ = options; }
+    // Export job spans as OTLP JSON to a file and/or collector; phases are recorded either way
+    void set_trace_export(const TraceExportOptions& options) {
+        tracer_->set_exporter(options.file.empty() && options.endpoint.empty()
+                                  ? nullptr : std::make_shared<SpanExporter>(options, metrics_));
+    }
     
     // For testing
     IJobRepository* get_job_repository() { return job_repo_.get(); }
@@ -93,9 +132,20 @@ public:
 
 private:
     httplib::Server svr;
+    // Process-wide registry behind GET /metrics; routes and repositories record into it
+    std::shared_ptr<MetricsRegistry> metrics_ = default_metrics_registry();
+    // Every route is registered here and mirrored into svr
+    HttpRouter routes_{&svr, metrics_};
+    std::unique_ptr<EventLoopOptions> event_loop_options_;
+    std::unique_ptr<EventLoopServer> event_server_;
+    // Per-class handler pools the event loop runs routes on; reported by /scheduler/stats
+    std::shared_ptr<EndpointPools> endpoint_pools_ = std::make_shared<EndpointPools>();
+    // Accept-Encoding negotiation, hooked in after routing on either front end
+    std::shared_ptr<ResponseCompression> compression_ = std::make_shared<ResponseCompression>();
     std::thread server_thread;
     std::string api_key_;
     int bound_port_ = -1;
+    int inherited_listen_fd_ = -1;
     
     // Thread-safe background processing
     std::atomic<bool> shutdown_requested_{false};
@@ -103,9 +153,24 @@ private:
     std::mutex shutdown_mutex_;
     std::thread background_worker_thread_;
     
+    // Job transition pub/sub behind GET /events; declared before job_repo_,
+    // which wraps the injected repository to publish into it. Streams hold a
+    // worker thread each, so they get half of the query pool.
+    std::shared_ptr<JobEventBus> job_events_ = std::make_shared<JobEventBus>(
+        Constants::EVENT_HISTORY_SIZE, Constants::EVENT_SUBSCRIBER_QUEUE_SIZE,
+        std::max<size_t>(1, CPPHTTPLIB_THREAD_POOL_COUNT / 4));
+    // ETag versions of jobs and the engine list; bumped by the repository decorators
+    std::shared_ptr<ResourceVersions> versions_ = std::make_shared<ResourceVersions>();
+
     // Injected dependencies
     std::shared_ptr<IJobRepository> job_repo_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+
+    // Scrape-time dispatch_jobs{status} gauge over job_repo_; removed on destruction
+    uint64_t job_depths_collector_ = add_job_depths_collector();
+    // Log records dropped by this process's logger and, from heartbeats, by each engine's
+    uint64_t log_drops_collector_ = add_log_drops_collector();
+    uint64_t engine_log_drops_collector_ = add_engine_log_drops_collector();
     
     // Message Queue components
     std::unique_ptr<MessageQueueFactory> mq_factory_;
@@ -115,19 +180,76 @@ private:
     // Tdarr Integration
     std::unique_ptr<Tdarr::TdarrClient> tdarr_client_;
 
+    // Parked /assign_job/ long-polls; half the control pool so polls cannot starve heartbeats
+    std::shared_ptr<AssignmentWaiterRegistry> assignment_waiters_ =
+        std::make_shared<AssignmentWaiterRegistry>(
+            std::max<size_t>(1, CPPHTTPLIB_THREAD_POOL_COUNT / 2));
+
+    // Source-cache Bloom filters from engine heartbeats, used for locality-aware claims
+    std::shared_ptr<SourceCacheIndex> source_cache_ = std::make_shared<SourceCacheIndex>(
+        Constants::SOURCE_LOCALITY_WAIT, Constants::ENGINE_HEARTBEAT_TIMEOUT);
+
+    // Runtimes of completed jobs by codec, shared by straggler detection and deadline forecasts
+    std::shared_ptr<RuntimeEstimator> runtime_estimator_ = std::make_shared<RuntimeEstimator>();
+
+    // Straggler detection and speculative copies; declared after the repositories it uses
+    std::shared_ptr<SpeculationManager> speculation_ =
+        std::make_shared<SpeculationManager>(job_repo_, engine_repo_, SpeculationPolicy{}, runtime_estimator_);
+
+    // Suspends lower-priority work for urgent jobs stuck behind a full cluster
+    std::shared_ptr<PreemptionCoordinator> preemption_ = std::make_shared<PreemptionCoordinator>(
+        job_repo_, engine_repo_, Constants::PREEMPTION_GRACE, Constants::PREEMPTION_RESERVATION_TIMEOUT);
+
+    // Pending-queue limits on POST /jobs/; unbounded until configured
+    std::shared_ptr<AdmissionController> admission_ = std::make_shared<AdmissionController>(job_repo_);
+
+    // EDF latest-start times and SLA miss forecasts for jobs submitted with a deadline
+    std::shared_ptr<DeadlineMonitor> deadlines_ =
+        std::make_shared<DeadlineMonitor>(job_repo_, engine_repo_, runtime_estimator_);
+
+    // Engine-slot reservations per job-size lane, so small clips are not stuck behind large masters
+    std::shared_ptr<SizeLanes> size_lanes_ = std::make_shared<SizeLanes>(job_repo_, engine_repo_);
+
+    // Rolling per-engine success rates; quarantines failing engines behind probe jobs
+    std::shared_ptr<EngineHealth> health_ = std::make_shared<EngineHealth>();
+
+    // Per-job run-time allowances and progress liveness for the timeout sweep
+    std::shared_ptr<JobTimeouts> timeouts_ =
+        std::make_shared<JobTimeouts>(job_repo_, runtime_estimator_, health_);
+
+    // Jittered per-failure-class backoff and the retry budget for requeues
+    std::shared_ptr<RetryScheduler> retries_ = std::make_shared<RetryScheduler>();
+
+    // Per-phase job timings from completion and failure reports; spans are exported once set_trace_export() is called
+    std::shared_ptr<JobTracer> tracer_ = std::make_shared<JobTracer>(metrics_);
+
+    // Runtime samples, engine health and retry counters carried across restarts
+    SnapshotOptions snapshot_options_;
+    std::shared_ptr<StateSnapshot> snapshot_ =
+        std::make_shared<StateSnapshot>(runtime_estimator_, health_, retries_);
+    std::chrono::steady_clock::time_point snapshot_written_at_;
+    // Set by start(); the final snapshot is written once, by whichever stop comes first
+    std::atomic<bool> snapshot_due_{false};
+
     void setup_endpoints();
     void setup_job_endpoints();
     void setup_engine_endpoints();
     void setup_storage_endpoints();
     void setup_tdarr_endpoints();
     void setup_system_endpoints();
+    uint64_t add_job_depths_collector();
+    uint64_t add_log_drops_collector();
+    uint64_t add_engine_log_drops_collector();
     
     // Background processing
     void background_worker();
+    void stop_background_worker();
     void cleanup_stale_engines();
     void handle_job_timeouts();
     void requeue_failed_jobs();
     void expire_pending_jobs();
+    void restore_state();
+    void write_snapshot();
     
     // Thread-safe job operations
     Job* find_next_pending_job();
@@ -0,0 +1,182 @@
+#include "endpoint_pools.h"
+#include "httplib.h"
+#include "dispatch_server_constants.h"
+#include <algorithm>
+#include <cmath>
+
+namespace distconv {
+namespace DispatchServer {
+
+const char* to_string(EndpointClass endpoint_class) {
+    switch (endpoint_class) {
+    case EndpointClass::Control: return "control";
+    case EndpointClass::Submission: return "submission";
+    case EndpointClass::Query: return "query";
+    }
+    return "query";
+}
+
+EndpointPoolLimits default_endpoint_pool_limits() {
+    const size_t threads = CPPHTTPLIB_THREAD_POOL_COUNT;
+    const size_t queued = Constants::EVENT_LOOP_MAX_QUEUED_REQUESTS;
+    EndpointPoolLimits limits;
+    limits[static_cast<size_t>(EndpointClass::Control)] = {threads, queued};
+    limits[static_cast<size_t>(EndpointClass::Submission)] = {std::max<size_t>(2, threads / 4), queued};
+    limits[static_cast<size_t>(EndpointClass::Query)] = {std::max<size_t>(2, threads / 2), queued};
+    return limits;
+}
+
+WorkerPool::WorkerPool(std::string name, WorkerPoolLimits limits)
+    : name_(std::move(name)),
+      limits_{std::max<size_t>(1, limits.workers), std::max<size_t>(1, limits.max_queued)} {
+    for (size_t i = 0; i < limits_.workers; ++i) {
+        threads_.emplace_back(&WorkerPool::work, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+bool WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ || queue_.size() >= limits_.max_queued) {
+            rejected_++;
+            return false;
+        }
+        queue_.push_back({std::move(task), std::chrono::steady_clock::now()});
+    }
+    available_.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void WorkerPool::work() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            task = std::move(queue_.front());
+            queue_.pop_front();
+            active_++;
+            record_wait(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - task.queued_at)
+                            .count());
+        }
+
+        task.run();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_--;
+        served_++;
+    }
+}
+
+void WorkerPool::record_wait(double waited_ms) {
+    auto bucket = std::lower_bound(QUEUE_MS_BOUNDS.begin(), QUEUE_MS_BOUNDS.end(), waited_ms) - QUEUE_MS_BOUNDS.begin();
+    queue_ms_buckets_[static_cast<size_t>(bucket)]++;
+    queue_ms_sum_ += waited_ms;
+    queue_ms_max_ = std::max(queue_ms_max_, waited_ms);
+}
+
+double WorkerPool::queue_ms_percentile(double quantile) const {
+    size_t total = 0;
+    for (size_t count : queue_ms_buckets_) total += count;
+    if (total == 0) return 0.0;
+
+    size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(quantile * static_cast<double>(total))));
+    size_t seen = 0;
+    for (size_t i = 0; i < QUEUE_MS_BOUNDS.size(); ++i) {
+        seen += queue_ms_buckets_[i];
+        if (seen >= rank) return std::min(QUEUE_MS_BOUNDS[i], queue_ms_max_);
+    }
+    return queue_ms_max_;
+}
+
+nlohmann::json WorkerPool::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t started = 0;
+    for (size_t count : queue_ms_buckets_) started += count;
+    return {
+        {"workers", limits_.workers},
+        {"max_queued", limits_.max_queued},
+        {"queued", queue_.size()},
+        {"active", active_},
+        {"served", served_},
+        {"rejected", rejected_},
+        {"queue_ms", {
+            {"mean", started > 0 ? queue_ms_sum_ / static_cast<double>(started) : 0.0},
+            {"p50", queue_ms_percentile(0.5)},
+            {"p99", queue_ms_percentile(0.99)},
+            {"max", queue_ms_max_}
+        }}
+    };
+}
+
+size_t WorkerPool::rejected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+}
+
+void EndpointPools::start(const EndpointPoolLimits& limits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < ENDPOINT_CLASS_COUNT; ++i) {
+        pools_[i] = std::make_unique<WorkerPool>(to_string(static_cast<EndpointClass>(i)), limits[i]);
+    }
+}
+
+void EndpointPools::shutdown() {
+    std::array<std::unique_ptr<WorkerPool>, ENDPOINT_CLASS_COUNT> stopped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped.swap(pools_);
+    }
+    // Joined outside the lock: a draining handler may be reading metrics()
+    for (auto& pool : stopped) {
+        if (pool) pool->shutdown();
+    }
+}
+
+bool EndpointPools::running() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pools_[0] != nullptr;
+}
+
+bool EndpointPools::submit(EndpointClass endpoint_class, std::function<void()> task) {
+    return pools_[static_cast<size_t>(endpoint_class)]->submit(std::move(task));
+}
+
+nlohmann::json EndpointPools::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json metrics = nlohmann::json::object();
+    for (size_t i = 0; i < ENDPOINT_CLASS_COUNT; ++i) {
+        if (pools_[i]) {
+            metrics[to_string(static_cast<EndpointClass>(i))] = pools_[i]->metrics();
+        }
+    }
+    return metrics;
+}
+
+size_t EndpointPools::rejected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t rejected = 0;
+    for (const auto& pool : pools_) {
+        if (pool) rejected += pool->rejected();
+    }
+    return rejected;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,108 @@
+#ifndef ENDPOINT_POOLS_H
+#define ENDPOINT_POOLS_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+namespace distconv {
+namespace DispatchServer {
+
+// Request classes served from separate worker pools, so a burst in one cannot
+// take the threads another needs: engine liveness (heartbeats, claims,
+// completion and progress reports), client submissions, and reads/admin.
+enum class EndpointClass { Control = 0, Submission = 1, Query = 2 };
+constexpr size_t ENDPOINT_CLASS_COUNT = 3;
+const char* to_string(EndpointClass endpoint_class);
+
+struct WorkerPoolLimits {
+    size_t workers;    // Requests of the class handled at once
+    size_t max_queued; // Requests waiting for a worker before new ones are refused
+};
+using EndpointPoolLimits = std::array<WorkerPoolLimits, ENDPOINT_CLASS_COUNT>;
+
+// Sized against CPPHTTPLIB_THREAD_POOL_COUNT: long-polls may hold half the
+// control pool and event streams half the query pool
+EndpointPoolLimits default_endpoint_pool_limits();
+
+// Fixed-size thread pool with a bounded queue that records how long tasks
+// waited for a worker.
+class WorkerPool {
+public:
+    WorkerPool(std::string name, WorkerPoolLimits limits);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // False when the queue is full or the pool is shutting down
+    bool submit(std::function<void()> task);
+    // Runs what is already queued, then joins the workers
+    void shutdown();
+
+    // workers, max_queued, queued, active, served, rejected and queue_ms
+    // (mean, p50, p99, max; percentiles are histogram bucket bounds)
+    nlohmann::json metrics() const;
+    size_t rejected() const;
+
+private:
+    struct Task {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queued_at;
+    };
+
+    static constexpr std::array<double, 12> QUEUE_MS_BOUNDS = {1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000};
+
+    void work();
+    void record_wait(double waited_ms);
+    double queue_ms_percentile(double quantile) const;
+
+    const std::string name_;
+    const WorkerPoolLimits limits_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<Task> queue_;
+    std::vector<std::thread> threads_;
+    bool stopping_ = false;
+
+    size_t active_ = 0;
+    size_t served_ = 0;
+    size_t rejected_ = 0;
+    std::array<size_t, QUEUE_MS_BOUNDS.size() + 1> queue_ms_buckets_{};
+    double queue_ms_sum_ = 0.0;
+    double queue_ms_max_ = 0.0;
+};
+
+// One WorkerPool per EndpointClass. Shared between the event-loop front end,
+// which submits into it, and GET /scheduler/stats, which reports it.
+class EndpointPools {
+public:
+    void start(const EndpointPoolLimits& limits);
+    void shutdown();
+    bool running() const;
+
+    // Only valid between start() and shutdown()
+    bool submit(EndpointClass endpoint_class, std::function<void()> task);
+
+    // Per-class pool metrics; empty while the pools are not running
+    nlohmann::json metrics() const;
+    size_t rejected() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<std::unique_ptr<WorkerPool>, ENDPOINT_CLASS_COUNT> pools_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // ENDPOINT_POOLS_H
@@ -0,0 +1,201 @@
+#include "engine_channel_handler.h"
+#include "engine_handlers.h"
+#include "job_action_handlers.h"
+#include "job_update_handler.h"
+#include "assignment_handler.h"
+#include "http_router.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+nlohmann::json make_ack(const std::string& type, int status, const nlohmann::json& body) {
+    return {{"type", "ack"}, {"frame", type}, {"status", status}, {"body", body}};
+}
+
+} // namespace
+
+EngineChannelHandler::EngineChannelHandler(std::shared_ptr<AuthMiddleware> auth,
+                                           std::shared_ptr<IJobRepository> job_repo,
+                                           std::shared_ptr<IEngineRepository> engine_repo,
+                                           std::shared_ptr<AssignmentWaiterRegistry> waiters,
+                                           std::shared_ptr<SourceCacheIndex> source_cache,
+                                           std::shared_ptr<SpeculationManager> speculation,
+                                           std::shared_ptr<PreemptionCoordinator> preemption,
+                                           std::shared_ptr<SizeLanes> size_lanes,
+                                           std::shared_ptr<EngineHealth> health,
+                                           std::shared_ptr<RetryScheduler> retries,
+                                           std::shared_ptr<MetricsRegistry> metrics,
+                                           std::shared_ptr<JobTracer> tracer)
+    : auth_(auth),
+      job_repo_(job_repo),
+      heartbeat_handler_(std::make_shared<EngineHeartbeatHandler>(auth, engine_repo, source_cache)),
+      benchmark_handler_(std::make_shared<EngineBenchmarkHandler>(auth, engine_repo)),
+      progress_handler_(std::make_shared<JobProgressHandler>(auth, job_repo, speculation)),
+      complete_handler_(std::make_shared<JobCompletionHandler>(auth, job_repo, engine_repo, speculation, health,
+                                                               tracer)),
+      fail_handler_(std::make_shared<JobFailureHandler>(auth, job_repo, engine_repo, speculation, health, retries,
+                                                        tracer)),
+      assignment_handler_(std::make_shared<JobAssignmentHandler>(auth, job_repo, engine_repo, waiters,
+                                                                   source_cache, speculation, preemption,
+                                                                   size_lanes, health, metrics)),
+      preemption_(preemption) {
+    if (preemption_) {
+        suspend_handler_ = std::make_shared<JobSuspendHandler>(auth, job_repo, preemption);
+        resume_handler_ = std::make_shared<JobResumeHandler>(auth, job_repo, preemption);
+    }
+}
+
+void EngineChannelHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+
+    nlohmann::json request_json;
+    try {
+        request_json = nlohmann::json::parse(req.body);
+    } catch (const nlohmann::json::parse_error& e) {
+        set_json_error_response(res, "Invalid JSON in request body", "json_parse_error", 400, e.what());
+        return;
+    }
+
+    if (!request_json.contains("engine_id") || !request_json["engine_id"].is_string()) {
+        set_json_error_response(res, "Bad Request: 'engine_id' is missing or not a string.", "validation_error", 400);
+        return;
+    }
+    nlohmann::json frames = request_json.value("frames", nlohmann::json::array());
+    if (!frames.is_array()) {
+        set_json_error_response(res, "Bad Request: 'frames' must be an array.", "validation_error", 400);
+        return;
+    }
+
+    std::string engine_id = request_json["engine_id"];
+    nlohmann::json downlink = nlohmann::json::array();
+    const nlohmann::json* assign_frame = nullptr;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const auto& frame = frames[i];
+        if (!frame.is_object() || !frame.contains("type") || !frame["type"].is_string()) {
+            auto ack = make_ack("", 400, "Frame must be an object with a string 'type'");
+            ack["index"] = i;
+            downlink.push_back(ack);
+            continue;
+        }
+        // Assignment runs last so completions in the same batch free the engine first
+        if (frame["type"] == "assign") {
+            assign_frame = &frame;
+            continue;
+        }
+        auto ack = dispatch_frame(req, engine_id, frame);
+        ack["index"] = i;
+        downlink.push_back(ack);
+    }
+
+    append_cancellations(engine_id, request_json.value("active_jobs", nlohmann::json::array()), downlink);
+    if (preemption_) {
+        nlohmann::json directive = preemption_->directive_for(engine_id);
+        if (!directive.is_null()) {
+            downlink.push_back(directive);
+        }
+    }
+
+    if (assign_frame) {
+        auto result = dispatch_frame(req, engine_id, *assign_frame);
+        if (result["status"] == 200) {
+            downlink.push_back({{"type", "assignment"}, {"job", result["body"]}});
+        } else if (result["status"] != 204) {
+            downlink.push_back(result);
+        }
+    }
+
+    set_json_response(res, {{"frames", downlink}}, 200);
+}
+
+nlohmann::json EngineChannelHandler::dispatch_frame(const httplib::Request& req, const std::string& engine_id,
+                                                    const nlohmann::json& frame) {
+    std::string type = frame["type"];
+    nlohmann::json body = frame.value("body", nlohmann::json::object());
+    if (!body.is_object()) {
+        return make_ack(type, 400, "Frame 'body' must be an object");
+    }
+
+    httplib::Request sub_req;
+    sub_req.method = "POST";
+    sub_req.headers = req.headers;
+
+    // Job reports carry the sender too, so speculative copies can be told apart
+    if (!body.contains("engine_id")) {
+        body["engine_id"] = engine_id;
+    }
+
+    std::shared_ptr<IRequestHandler> handler;
+    if (type == "heartbeat" || type == "benchmark" || type == "assign") {
+        if (type == "heartbeat") {
+            handler = heartbeat_handler_;
+            sub_req.path = "/engines/heartbeat";
+        } else if (type == "benchmark") {
+            handler = benchmark_handler_;
+            sub_req.path = "/engines/benchmark_result";
+        } else {
+            handler = assignment_handler_;
+            sub_req.path = "/assign_job/";
+            if (req.has_param("wait")) {
+                sub_req.params.emplace("wait", req.get_param_value("wait"));
+            }
+        }
+    } else if (type == "progress" || type == "complete" || type == "fail" ||
+               ((type == "suspend" || type == "resume") && preemption_)) {
+        // Same capture as the REST job action routes in setup_job_endpoints()
+        std::string job_id = frame.value("job_id", "");
+        if (!is_uuid_segment(job_id)) {
+            return make_ack(type, 404, "Unknown job_id");
+        }
+        sub_req.path = "/jobs/" + job_id + "/" + type;
+        sub_req.path_params.emplace("job_id", job_id);
+        handler = type == "progress" ? progress_handler_
+                : type == "complete" ? complete_handler_
+                : type == "fail"     ? fail_handler_
+                : type == "suspend"  ? suspend_handler_ : resume_handler_;
+    } else {
+        return make_ack(type, 400, "Unknown frame type: " + type);
+    }
+
+    sub_req.body = body.dump();
+    httplib::Response sub_res;
+    handler->handle(sub_req, sub_res);
+
+    // Handlers that only set content leave the status for httplib to default
+    int status = sub_res.status == -1 ? 200 : sub_res.status;
+    auto parsed = nlohmann::json::parse(sub_res.body, nullptr, false);
+    return make_ack(type, status, parsed.is_discarded() ? nlohmann::json(sub_res.body) : parsed);
+}
+
+void EngineChannelHandler::append_cancellations(const std::string& engine_id, const nlohmann::json& active_jobs,
+                                                nlohmann::json& downlink) {
+    if (!active_jobs.is_array()) return;
+
+    // Tell the engine to drop work that was cancelled or handed to another engine
+    for (const auto& job_id : active_jobs) {
+        if (!job_id.is_string()) continue;
+        nlohmann::json job = job_repo_->get_job(job_id);
+        if (job.is_null() || job.empty()) {
+            downlink.push_back({{"type", "cancel"}, {"job_id", job_id}, {"reason", "not_found"}});
+            continue;
+        }
+        std::string status = job.value("status", "");
+        const nlohmann::json speculation = job.value("speculation", nlohmann::json::object());
+        bool running_copy = speculation.is_object() && speculation.value("state", "") == "running" &&
+                            speculation.value("engine", "") == engine_id;
+        bool reassigned = job.contains("assigned_engine") && job["assigned_engine"].is_string() &&
+                          job["assigned_engine"] != engine_id && !running_copy;
+        // The losing side of a speculative race learns the job is done
+        bool lost_race = status == "completed" && speculation.is_object() && speculation.contains("winner") &&
+                         speculation["winner"] != engine_id;
+        if (status == "cancelled" || reassigned || lost_race) {
+            downlink.push_back({{"type", "cancel"}, {"job_id", job_id},
+                                {"reason", status == "cancelled" ? "cancelled" : lost_race ? "completed" : "reassigned"}});
+        }
+    }
+}
+
+} // namespace DispatchServer
+} // namespace distconv
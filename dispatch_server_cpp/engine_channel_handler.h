@@ -0,0 +1,67 @@
+#ifndef ENGINE_CHANNEL_HANDLER_H
+#define ENGINE_CHANNEL_HANDLER_H
+
+#include "request_handlers.h"
+#include "repositories.h"
+#include "assignment_waiters.h"
+#include "source_cache_index.h"
+#include "speculation.h"
+#include "preemption.h"
+#include "size_lanes.h"
+#include "engine_health.h"
+#include "retry_policy.h"
+#include "metrics.h"
+#include "job_tracing.h"
+#include "nlohmann/json.hpp"
+#include <memory>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Handler for POST /engines/channel - batched engine<->dispatcher exchange.
+//
+// One request carries every pending uplink frame (heartbeat, benchmark,
+// progress, complete, fail, suspend, resume, assign) and the response carries
+// the downlink frames (ack, assignment, cancel, preempt). Frames are dispatched to the same handlers
+// that serve the REST endpoints, so engines can fall back to those at any time.
+// With ?wait= an assign frame long-polls exactly like /assign_job/.
+class EngineChannelHandler : public IRequestHandler {
+public:
+    EngineChannelHandler(std::shared_ptr<AuthMiddleware> auth,
+                         std::shared_ptr<IJobRepository> job_repo,
+                         std::shared_ptr<IEngineRepository> engine_repo,
+                         std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr,
+                         std::shared_ptr<SourceCacheIndex> source_cache = nullptr,
+                         std::shared_ptr<SpeculationManager> speculation = nullptr,
+                         std::shared_ptr<PreemptionCoordinator> preemption = nullptr,
+                         std::shared_ptr<SizeLanes> size_lanes = nullptr,
+                         std::shared_ptr<EngineHealth> health = nullptr,
+                         std::shared_ptr<RetryScheduler> retries = nullptr,
+                         std::shared_ptr<MetricsRegistry> metrics = nullptr,
+                         std::shared_ptr<JobTracer> tracer = nullptr);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    nlohmann::json dispatch_frame(const httplib::Request& req, const std::string& engine_id,
+                                  const nlohmann::json& frame);
+    void append_cancellations(const std::string& engine_id, const nlohmann::json& active_jobs,
+                              nlohmann::json& downlink);
+
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<IRequestHandler> heartbeat_handler_;
+    std::shared_ptr<IRequestHandler> benchmark_handler_;
+    std::shared_ptr<IRequestHandler> progress_handler_;
+    std::shared_ptr<IRequestHandler> complete_handler_;
+    std::shared_ptr<IRequestHandler> fail_handler_;
+    std::shared_ptr<IRequestHandler> suspend_handler_;
+    std::shared_ptr<IRequestHandler> resume_handler_;
+    std::shared_ptr<IRequestHandler> assignment_handler_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // ENGINE_CHANNEL_HANDLER_H
@@ -1,4 +1,5 @@
 #include "engine_handlers.h"
+#include "wall_clock.h"
 #include "dispatch_server_core.h"
 #include <mutex>
 
@@ -7,11 +8,20 @@ namespace DispatchServer {
 
 // ==================== EngineListHandler ====================
 
-EngineListHandler::EngineListHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo)
-    : auth_(auth), engine_repo_(engine_repo) {}
+EngineListHandler::EngineListHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo,
+                                     std::shared_ptr<ResourceVersions> versions)
+    : auth_(auth), engine_repo_(engine_repo), versions_(versions) {}
 
 void EngineListHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
+    std::string etag = versions_ ? versions_->engines_etag() : "";
+    if (!etag.empty()) {
+        res.set_header("ETag", etag);
+        if (etag_matches(req, etag)) {
+            res.status = 304;
+            return;
+        }
+    }
     auto all_engines_vec = engine_repo_->get_all_engines();
     nlohmann::json all_engines = nlohmann::json::array();
     for (const auto& engine : all_engines_vec) {
@@ -22,8 +32,10 @@ void EngineListHandler::handle(const httplib::Request& req, httplib::Response& r
 
 // ==================== EngineHeartbeatHandler ====================
 
-EngineHeartbeatHandler::EngineHeartbeatHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo)
-    : auth_(auth), engine_repo_(engine_repo) {}
+EngineHeartbeatHandler::EngineHeartbeatHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo,
+                                               std::shared_ptr<SourceCacheIndex> source_cache,
+                                               std::shared_ptr<PreemptionCoordinator> preemption)
+    : auth_(auth), engine_repo_(engine_repo), source_cache_(source_cache), preemption_(preemption) {}
 
 bool EngineHeartbeatHandler::validate_heartbeat_input(const nlohmann::json& input, httplib::Response& res) {
     if (!input.contains("engine_id") || !input["engine_id"].is_string()) {
@@ -47,9 +59,21 @@ void EngineHeartbeatHandler::handle(const httplib::Request& req, httplib::Respon
 
     std::string engine_id = request_json["engine_id"];
     try {
-        request_json["last_heartbeat"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (request_json.contains("source_cache")) {
+            if (source_cache_) {
+                source_cache_->update(engine_id, request_json["source_cache"]);
+            }
+            request_json.erase("source_cache");
+        }
+        request_json["last_heartbeat"] = wall_clock_ms();
         engine_repo_->save_engine(engine_id, request_json);
+        if (preemption_) {
+            nlohmann::json directive = preemption_->directive_for(engine_id);
+            if (!directive.is_null()) {
+                res.set_header("X-Preempt-Job", directive["job_id"].get<std::string>());
+                res.set_header("X-Preempt-For", directive["for"].get<std::string>());
+            }
+        }
         res.set_content("Heartbeat received from engine " + engine_id, "text/plain");
     } catch (const std::exception& e) {
         set_json_error_response(res, "Internal server error", "server_error", 500, e.what());
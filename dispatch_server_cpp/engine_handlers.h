@@ -4,32 +4,45 @@
 #include "request_handlers.h"
 #include "nlohmann/json.hpp"
 #include "repositories.h"
+#include "source_cache_index.h"
+#include "preemption.h"
+#include "resource_versions.h"
 #include <string>
 #include <memory>
 
 namespace distconv {
 namespace DispatchServer {
 
-// Handler for GET /engines/ - List all engines
+// Handler for GET /engines/ - List all engines, tagged with the engine list
+// ETag; a matching If-None-Match gets 304 without reading the repository.
 class EngineListHandler : public IRequestHandler {
 public:
-    EngineListHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo);
+    EngineListHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo,
+                      std::shared_ptr<ResourceVersions> versions = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<ResourceVersions> versions_;
 };
 
 // Handler for POST /engines/heartbeat - Engine heartbeat
+// An optional "source_cache" Bloom filter is routed to the source-cache index
+// rather than stored with the engine record. A pending preempt directive is
+// returned in the X-Preempt-Job / X-Preempt-For response headers.
 class EngineHeartbeatHandler : public IRequestHandler {
 public:
-    EngineHeartbeatHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo);
+    EngineHeartbeatHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IEngineRepository> engine_repo,
+                           std::shared_ptr<SourceCacheIndex> source_cache = nullptr,
+                           std::shared_ptr<PreemptionCoordinator> preemption = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<SourceCacheIndex> source_cache_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
     bool validate_heartbeat_input(const nlohmann::json& input, httplib::Response& res);
 };
 
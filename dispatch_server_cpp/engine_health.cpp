@@ -0,0 +1,295 @@
+#include "engine_health.h"
+#include "state_snapshot.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+using namespace Constants;
+
+namespace {
+
+// Reasons past this many distinct ones are counted together
+constexpr size_t MAX_FAILURE_REASONS = 8;
+
+int64_t to_ms(std::chrono::milliseconds duration) {
+    return duration.count();
+}
+
+} // namespace
+
+const char* circuit_state_name(CircuitState state) {
+    switch (state) {
+        case CircuitState::Open: return "quarantined";
+        case CircuitState::HalfOpen: return "probing";
+        default: return "healthy";
+    }
+}
+
+void mark_retry_anti_affinity(nlohmann::json& job, const std::string& engine_id, int64_t now_ms) {
+    if (engine_id.empty()) {
+        return;
+    }
+    job["avoid_engine"] = engine_id;
+    job["avoid_until"] = now_ms + std::chrono::duration_cast<std::chrono::milliseconds>(
+        RETRY_ANTI_AFFINITY_WINDOW).count();
+}
+
+bool avoids_engine(const nlohmann::json& job, const std::string& engine_id, int64_t now_ms) {
+    return job.contains("avoid_engine") && job["avoid_engine"].is_string() && job["avoid_engine"] == engine_id &&
+           job.contains("avoid_until") && job["avoid_until"].is_number_integer() &&
+           job["avoid_until"].get<int64_t>() > now_ms;
+}
+
+EngineHealth::EngineHealth(EngineHealthPolicy policy) : policy_(policy) {}
+
+void EngineHealth::set_policy(const EngineHealthPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+EngineHealthPolicy EngineHealth::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void EngineHealth::record_success(const std::string& engine_id, const nlohmann::json& job, int64_t now_ms) {
+    if (engine_id.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Record& record = engines_[engine_id];
+    advance_locked(record, now_ms);
+
+    double size_mb = job.contains("job_size") && job["job_size"].is_number() ? job["job_size"].get<double>() : 0.0;
+    int64_t assigned_at = job.contains("assigned_at") && job["assigned_at"].is_number_integer()
+                              ? job["assigned_at"].get<int64_t>() : now_ms;
+    if (size_mb > 0 && now_ms > assigned_at) {
+        record.completed_mb += size_mb;
+        record.completed_ms += now_ms - assigned_at;
+    }
+
+    if (record.state == CircuitState::HalfOpen && record.probe_job_id == job.value("job_id", "")) {
+        // The probe went through: back in service with a clean window
+        record.state = CircuitState::Closed;
+        record.outcomes.clear();
+        record.probe_job_id.clear();
+    }
+    push_outcome_locked(record, true);
+}
+
+void EngineHealth::record_failure(const std::string& engine_id, const nlohmann::json& job,
+                                  const std::string& reason, int64_t now_ms) {
+    if (engine_id.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Record& record = engines_[engine_id];
+    advance_locked(record, now_ms);
+
+    std::string key = reason.empty() ? "unknown" : reason.substr(0, 120);
+    if (!record.failure_reasons.count(key) && record.failure_reasons.size() >= MAX_FAILURE_REASONS) {
+        key = "other";
+    }
+    ++record.failure_reasons[key];
+
+    if (record.state == CircuitState::HalfOpen && record.probe_job_id == job.value("job_id", "")) {
+        open_locked(record, now_ms, std::min(record.quarantine_ms * 2, to_ms(policy_.max_quarantine)));
+        return;
+    }
+    push_outcome_locked(record, false);
+    if (record.state == CircuitState::Closed && record.outcomes.size() >= policy_.min_samples &&
+        failure_rate(record) >= policy_.max_failure_rate) {
+        open_locked(record, now_ms, to_ms(policy_.quarantine));
+    }
+}
+
+bool EngineHealth::may_assign(const std::string& engine_id, int64_t now_ms, bool* probe) {
+    if (probe) *probe = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = engines_.find(engine_id);
+    if (it == engines_.end()) {
+        return true;
+    }
+    Record& record = it->second;
+    advance_locked(record, now_ms);
+    switch (record.state) {
+        case CircuitState::Closed:
+            return true;
+        case CircuitState::Open:
+            return false;
+        case CircuitState::HalfOpen:
+            // One probe at a time; one that never reports back stops blocking after a quarantine period
+            if (record.probe_job_id.empty() || now_ms >= record.probe_claimed_at + record.quarantine_ms) {
+                if (probe) *probe = true;
+                return true;
+            }
+            return false;
+    }
+    return true;
+}
+
+void EngineHealth::on_claimed(const std::string& engine_id, const std::string& job_id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = engines_.find(engine_id);
+    if (it == engines_.end() || it->second.state != CircuitState::HalfOpen) {
+        return;
+    }
+    it->second.probe_job_id = job_id;
+    it->second.probe_claimed_at = now_ms;
+    ++probes_;
+}
+
+void EngineHealth::forget(const std::string& engine_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    engines_.erase(engine_id);
+}
+
+CircuitState EngineHealth::state(const std::string& engine_id, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = engines_.find(engine_id);
+    if (it == engines_.end()) {
+        return CircuitState::Closed;
+    }
+    advance_locked(it->second, now_ms);
+    return it->second.state;
+}
+
+bool EngineHealth::throughput(const std::string& engine_id, double& mb_per_s) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = engines_.find(engine_id);
+    if (it == engines_.end() || it->second.completed_ms <= 0) {
+        return false;
+    }
+    mb_per_s = it->second.completed_mb * 1000.0 / it->second.completed_ms;
+    return true;
+}
+
+bool EngineHealth::cluster_throughput(double& mb_per_s) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<double> rates;
+    for (const auto& [engine_id, record] : engines_) {
+        if (record.completed_ms > 0) {
+            rates.push_back(record.completed_mb * 1000.0 / record.completed_ms);
+        }
+    }
+    if (rates.empty()) {
+        return false;
+    }
+    std::nth_element(rates.begin(), rates.begin() + rates.size() / 2, rates.end());
+    mb_per_s = rates[rates.size() / 2];
+    return true;
+}
+
+nlohmann::json EngineHealth::metrics(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json engines = nlohmann::json::object();
+    size_t quarantined = 0;
+    for (auto& [engine_id, record] : engines_) {
+        advance_locked(record, now_ms);
+        if (record.state != CircuitState::Closed) {
+            ++quarantined;
+        }
+        size_t completed = std::count(record.outcomes.begin(), record.outcomes.end(), true);
+        nlohmann::json entry = {
+            {"state", circuit_state_name(record.state)},
+            {"samples", record.outcomes.size()},
+            {"success_rate", record.outcomes.empty() ? 1.0 : static_cast<double>(completed) / record.outcomes.size()},
+            {"failure_reasons", record.failure_reasons},
+            {"throughput_mb_per_s", record.completed_ms > 0 ? record.completed_mb * 1000.0 / record.completed_ms : 0.0},
+            {"quarantines", record.quarantines}
+        };
+        if (record.state == CircuitState::Open) {
+            entry["quarantined_until"] = record.open_until;
+        }
+        engines[engine_id] = entry;
+    }
+    return {{"engines", engines}, {"quarantined", quarantined}, {"quarantines_total", quarantines_},
+            {"probes_total", probes_}};
+}
+
+void EngineHealth::save(SnapshotWriter& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.u32(static_cast<uint32_t>(engines_.size()));
+    for (const auto& [engine_id, record] : engines_) {
+        out.str(engine_id);
+        out.u32(static_cast<uint32_t>(record.outcomes.size()));
+        for (bool completed : record.outcomes) out.u8(completed ? 1 : 0);
+        out.u32(static_cast<uint32_t>(record.failure_reasons.size()));
+        for (const auto& [reason, count] : record.failure_reasons) {
+            out.str(reason);
+            out.u64(count);
+        }
+        out.f64(record.completed_mb);
+        out.i64(record.completed_ms);
+        out.u8(static_cast<uint8_t>(record.state));
+        out.i64(record.open_until);
+        out.i64(record.quarantine_ms);
+        out.str(record.probe_job_id);
+        out.i64(record.probe_claimed_at);
+        out.u64(record.quarantines);
+    }
+    out.u64(quarantines_);
+    out.u64(probes_);
+}
+
+void EngineHealth::restore(SnapshotReader& in) {
+    std::map<std::string, Record> engines;
+    for (size_t n = in.count(4); n > 0; --n) {
+        Record& record = engines[in.str()];
+        for (size_t outcomes = in.count(1); outcomes > 0; --outcomes) record.outcomes.push_back(in.u8() != 0);
+        for (size_t reasons = in.count(12); reasons > 0; --reasons) {
+            std::string reason = in.str();
+            record.failure_reasons[reason] = in.u64();
+        }
+        record.completed_mb = in.f64();
+        record.completed_ms = in.i64();
+        uint8_t state = in.u8();
+        if (state > static_cast<uint8_t>(CircuitState::HalfOpen)) {
+            throw std::runtime_error("Unknown circuit state in snapshot");
+        }
+        record.state = static_cast<CircuitState>(state);
+        record.open_until = in.i64();
+        record.quarantine_ms = in.i64();
+        record.probe_job_id = in.str();
+        record.probe_claimed_at = in.i64();
+        record.quarantines = in.u64();
+    }
+    uint64_t quarantines = in.u64();
+    uint64_t probes = in.u64();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    engines_ = std::move(engines);
+    quarantines_ = quarantines;
+    probes_ = probes;
+}
+
+void EngineHealth::push_outcome_locked(Record& record, bool completed) {
+    record.outcomes.push_back(completed);
+    while (record.outcomes.size() > std::max<size_t>(policy_.window, 1)) {
+        record.outcomes.pop_front();
+    }
+}
+
+void EngineHealth::open_locked(Record& record, int64_t now_ms, int64_t quarantine_ms) {
+    record.state = CircuitState::Open;
+    record.quarantine_ms = std::max<int64_t>(quarantine_ms, 1);
+    record.open_until = now_ms + record.quarantine_ms;
+    record.probe_job_id.clear();
+    ++record.quarantines;
+    ++quarantines_;
+}
+
+void EngineHealth::advance_locked(Record& record, int64_t now_ms) {
+    if (record.state == CircuitState::Open && now_ms >= record.open_until) {
+        record.state = CircuitState::HalfOpen;
+        record.probe_job_id.clear();
+    }
+}
+
+double EngineHealth::failure_rate(const Record& record) {
+    if (record.outcomes.empty()) return 0.0;
+    size_t failed = std::count(record.outcomes.begin(), record.outcomes.end(), false);
+    return static_cast<double>(failed) / record.outcomes.size();
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,108 @@
+#ifndef ENGINE_HEALTH_H
+#define ENGINE_HEALTH_H
+
+#include "dispatch_server_constants.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+class SnapshotReader;
+class SnapshotWriter;
+
+struct EngineHealthPolicy {
+    size_t window = Constants::ENGINE_HEALTH_WINDOW;               // Job outcomes kept per engine
+    size_t min_samples = Constants::ENGINE_HEALTH_MIN_SAMPLES;     // Needed before quarantining
+    double max_failure_rate = Constants::ENGINE_QUARANTINE_FAILURE_RATE;
+    std::chrono::milliseconds quarantine = Constants::ENGINE_QUARANTINE_DURATION;
+    std::chrono::milliseconds max_quarantine = Constants::ENGINE_QUARANTINE_MAX;
+};
+
+// Closed: assigned normally. Open: quarantined, nothing is assigned.
+// HalfOpen: quarantine over, a single probe job decides which way it goes.
+enum class CircuitState { Closed, Open, HalfOpen };
+const char* circuit_state_name(CircuitState state);
+
+// Retry anti-affinity: the engine a job just failed on is recorded in the job
+// ("avoid_engine", "avoid_until") and skipped by claims until the window ends.
+void mark_retry_anti_affinity(nlohmann::json& job, const std::string& engine_id, int64_t now_ms);
+bool avoids_engine(const nlohmann::json& job, const std::string& engine_id, int64_t now_ms);
+
+// Per-engine health and circuit breaking.
+//
+// The job action handlers and the timeout sweep record each job's outcome on
+// the engine that ran it: a rolling success rate over the last `window` jobs,
+// failure reasons, and throughput (MB of source per second of run time) of
+// the successes. An engine whose failure rate reaches max_failure_rate is
+// quarantined: claims from it get nothing until the quarantine ends, then it
+// is handed one probe job. A completed probe closes the circuit with a clean
+// window; a failed one reopens it for twice as long. State is kept in memory
+// and carried across restarts by the state snapshot.
+class EngineHealth {
+public:
+    explicit EngineHealth(EngineHealthPolicy policy = {});
+
+    void set_policy(const EngineHealthPolicy& policy);
+    EngineHealthPolicy policy() const;
+
+    void record_success(const std::string& engine_id, const nlohmann::json& job, int64_t now_ms);
+    void record_failure(const std::string& engine_id, const nlohmann::json& job, const std::string& reason,
+                        int64_t now_ms);
+
+    // Whether the engine may claim work now; probe is set when the claim is its probe job
+    bool may_assign(const std::string& engine_id, int64_t now_ms, bool* probe = nullptr);
+    void on_claimed(const std::string& engine_id, const std::string& job_id, int64_t now_ms);
+    void forget(const std::string& engine_id);
+
+    CircuitState state(const std::string& engine_id, int64_t now_ms);
+
+    // MB of source per second over the engine's completed jobs; false until it has completed a sized job
+    bool throughput(const std::string& engine_id, double& mb_per_s) const;
+    // Median of the engines' throughputs; false when no engine has one yet
+    bool cluster_throughput(double& mb_per_s) const;
+
+    // Per engine: state, success rate, failure reasons, throughput; plus totals
+    nlohmann::json metrics(int64_t now_ms);
+
+    // Every engine's record and the totals, as a state snapshot section;
+    // restore() replaces them. Quarantine times are wall-clock, so a
+    // quarantine runs out on schedule across a restart.
+    void save(SnapshotWriter& out) const;
+    void restore(SnapshotReader& in);
+
+private:
+    struct Record {
+        std::deque<bool> outcomes; // true = completed, newest last
+        std::map<std::string, uint64_t> failure_reasons;
+        double completed_mb = 0;
+        int64_t completed_ms = 0;
+        CircuitState state = CircuitState::Closed;
+        int64_t open_until = 0;
+        int64_t quarantine_ms = 0; // Length of the current quarantine
+        std::string probe_job_id;
+        int64_t probe_claimed_at = 0;
+        uint64_t quarantines = 0;
+    };
+
+    void push_outcome_locked(Record& record, bool completed);
+    void open_locked(Record& record, int64_t now_ms, int64_t quarantine_ms);
+    void advance_locked(Record& record, int64_t now_ms);
+    static double failure_rate(const Record& record);
+
+    mutable std::mutex mutex_;
+    EngineHealthPolicy policy_;
+    std::map<std::string, Record> engines_;
+    uint64_t quarantines_ = 0;
+    uint64_t probes_ = 0;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // ENGINE_HEALTH_H
@@ -1,6 +1,7 @@
 #include "enhanced_endpoints.h"
 #include "dispatch_server_core.h"
-#include <regex>
+#include "request_handlers.h"
+#include "response_utils.h"
 #include <chrono>
 #include <iostream>
 
@@ -14,9 +15,7 @@ namespace EnhancedEndpoints {
     
     // Utility functions for validation
     bool is_valid_url(const std::string& url) {
-        if (url.empty()) return false;
-        std::regex url_regex(R"(^https?://[^\s/$.?#].[^\s]*$)", std::regex_constants::icase);
-        return std::regex_match(url, url_regex);
+        return ResponseUtils::is_valid_url(url);
     }
     
     void error_response(httplib::Response& res, const std::string& code, const std::string& message, int status = 400) {
@@ -42,12 +41,13 @@ namespace EnhancedEndpoints {
     }
 }
 
-void setup_enhanced_job_endpoints(httplib::Server &svr, const std::string& api_key, 
+void setup_enhanced_job_endpoints(HttpRouter& routes, const std::string& api_key, 
                                  std::shared_ptr<IJobRepository> job_repo,
-                                 std::shared_ptr<IEngineRepository> engine_repo) {
+                                 std::shared_ptr<IEngineRepository> engine_repo,
+                                 std::shared_ptr<AssignmentWaiterRegistry> waiters) {
     
     // POST /api/v1/jobs - Enhanced job submission
-    svr.Post("/api/v1/jobs", [api_key, job_repo](const httplib::Request& req, httplib::Response& res) {
+    routes.Post("/api/v1/jobs", [api_key, job_repo, waiters](const httplib::Request& req, httplib::Response& res) {
         if (!EnhancedEndpoints::validate_api_key(req, res, api_key)) return;
         
         try {
@@ -70,19 +70,23 @@ void setup_enhanced_job_endpoints(httplib::Server &svr, const std::string& api_k
             job["created_at"] = now_ms;
             job["updated_at"] = now_ms;
             job["priority"] = request_json.value("priority", 0);
+            if (request_json.contains("tenant") && request_json["tenant"].is_string()) {
+                job["tenant"] = request_json["tenant"];
+            }
             
             job_repo->save_job(job_id, job);
+            if (waiters) waiters->notify_job_available(job);
             EnhancedEndpoints::success_response(res, job, 201);
             
         } catch (const std::exception& e) {
             EnhancedEndpoints::error_response(res, "INTERNAL_ERROR", e.what(), 500);
         }
-    });
+    }, EndpointClass::Submission);
 
     // GET /api/v1/jobs/{id} - Get job status
-    svr.Get(R"(/api/v1/jobs/([a-fA-F0-9\-]{36}))", [api_key, job_repo](const httplib::Request& req, httplib::Response& res) {
+    routes.Get("/api/v1/jobs/{job_id:uuid}", [api_key, job_repo](const httplib::Request& req, httplib::Response& res) {
         if (!EnhancedEndpoints::validate_api_key(req, res, api_key)) return;
-        std::string job_id = req.matches[1];
+        std::string job_id = path_param(req, "job_id");
         nlohmann::json job = job_repo->get_job(job_id);
         if (job.is_null()) {
             EnhancedEndpoints::error_response(res, "NOT_FOUND", "Job not found", 404);
@@ -92,12 +96,13 @@ void setup_enhanced_job_endpoints(httplib::Server &svr, const std::string& api_k
     });
 }
 
-void setup_enhanced_system_endpoints(httplib::Server &svr, const std::string& api_key,
+void setup_enhanced_system_endpoints(HttpRouter& routes, const std::string& api_key,
                                     std::shared_ptr<IJobRepository> job_repo,
-                                    std::shared_ptr<IEngineRepository> engine_repo) {
+                                    std::shared_ptr<IEngineRepository> engine_repo,
+                                    std::shared_ptr<AssignmentWaiterRegistry> waiters) {
     
     // GET /api/v1/status - Enhanced status
-    svr.Get("/api/v1/status", [api_key, job_repo, engine_repo](const httplib::Request& req, httplib::Response& res) {
+    routes.Get("/api/v1/status", [api_key, job_repo, engine_repo](const httplib::Request& req, httplib::Response& res) {
         if (!EnhancedEndpoints::validate_api_key(req, res, api_key)) return;
         
         nlohmann::json status;
@@ -119,9 +124,9 @@ void setup_enhanced_system_endpoints(httplib::Server &svr, const std::string& ap
     });
 
     // DELETE /api/v1/engines/{id} - Deregister engine
-    svr.Delete(R"(/api/v1/engines/([a-zA-Z0-9\-_]+))", [api_key, job_repo, engine_repo](const httplib::Request& req, httplib::Response& res) {
+    routes.Delete("/api/v1/engines/{engine_id}", [api_key, job_repo, engine_repo, waiters](const httplib::Request& req, httplib::Response& res) {
         if (!EnhancedEndpoints::validate_api_key(req, res, api_key)) return;
-        std::string engine_id = req.matches[1];
+        std::string engine_id = path_param(req, "engine_id");
         
         if (!engine_repo->engine_exists(engine_id)) {
             EnhancedEndpoints::error_response(res, "NOT_FOUND", "Engine not found", 404);
@@ -133,6 +138,7 @@ void setup_enhanced_system_endpoints(httplib::Server &svr, const std::string& ap
             job["status"] = "pending";
             job["assigned_engine"] = nullptr;
             job_repo->save_job(job["job_id"], job);
+            if (waiters) waiters->notify_job_available(job);
         }
 
         engine_repo->remove_engine(engine_id);
@@ -2,7 +2,9 @@
 #define ENHANCED_ENDPOINTS_H
 
 #include "httplib.h"
+#include "http_router.h"
 #include "repositories.h"
+#include "assignment_waiters.h"
 #include <string>
 #include <memory>
 
@@ -10,13 +12,15 @@ namespace distconv {
 namespace DispatchServer {
 
 // Enhanced API endpoints with improved validation and features
-void setup_enhanced_job_endpoints(httplib::Server &svr, const std::string& api_key, 
+void setup_enhanced_job_endpoints(HttpRouter& routes, const std::string& api_key, 
                                  std::shared_ptr<IJobRepository> job_repo, 
-                                 std::shared_ptr<IEngineRepository> engine_repo);
+                                 std::shared_ptr<IEngineRepository> engine_repo,
+                                 std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr);
 
-void setup_enhanced_system_endpoints(httplib::Server &svr, const std::string& api_key,
+void setup_enhanced_system_endpoints(HttpRouter& routes, const std::string& api_key,
                                     std::shared_ptr<IJobRepository> job_repo,
-                                    std::shared_ptr<IEngineRepository> engine_repo);
+                                    std::shared_ptr<IEngineRepository> engine_repo,
+                                    std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr);
 
 } // namespace DispatchServer
 } // namespace distconv
@@ -0,0 +1,819 @@
+#include "event_loop_server.h"
+#include "request_handlers.h"
+#include "structured_log.hpp"
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+constexpr int EPOLL_BATCH = 256;
+constexpr int SWEEP_INTERVAL_MS = 1000;
+constexpr size_t READ_CHUNK = 16 * 1024;
+constexpr time_t STREAM_WRITE_TIMEOUT_SEC = 5;
+
+enum class ParseResult { Incomplete, Complete, Failed };
+
+bool iequals(const std::string& a, const std::string& b) {
+    return httplib::detail::case_ignore::equal(a, b);
+}
+
+// Parses the request line and headers held in in[0, header_end)
+bool parse_head(const std::string& in, size_t header_end, httplib::Request& req, int& status) {
+    auto line_end = in.find("\r\n");
+    auto first_space = in.find(' ');
+    auto second_space = first_space < line_end ? in.find(' ', first_space + 1) : std::string::npos;
+    if (second_space >= line_end || in.find(' ', second_space + 1) < line_end) {
+        status = 400;
+        return false;
+    }
+
+    req.method = in.substr(0, first_space);
+    req.target = in.substr(first_space + 1, second_space - first_space - 1);
+    req.version = in.substr(second_space + 1, line_end - second_space - 1);
+    if (req.method.empty() || req.target.empty() || (req.version != "HTTP/1.1" && req.version != "HTTP/1.0")) {
+        status = 400;
+        return false;
+    }
+    if (req.target.size() > CPPHTTPLIB_REQUEST_URI_MAX_LENGTH) {
+        status = 414;
+        return false;
+    }
+
+    auto query = req.target.find('?');
+    req.path = httplib::detail::decode_url(req.target.substr(0, query), false);
+    if (query != std::string::npos) {
+        httplib::detail::parse_query_text(req.target.substr(query + 1), req.params);
+    }
+
+    for (size_t pos = line_end + 2; pos < header_end;) {
+        auto end = in.find("\r\n", pos);
+        auto added = httplib::detail::parse_header(
+            in.data() + pos, in.data() + end,
+            [&req](const std::string& key, const std::string& value) { req.headers.emplace(key, value); });
+        if (!added) {
+            status = 400;
+            return false;
+        }
+        pos = end + 2;
+    }
+    return true;
+}
+
+// Decodes a chunked body starting at `pos`; Incomplete until the last chunk and its trailers are in
+ParseResult decode_chunked(const std::string& in, size_t pos, size_t max_body, std::string& body, size_t& end,
+                           int& status) {
+    body.clear();
+    while (true) {
+        auto line_end = in.find("\r\n", pos);
+        if (line_end == std::string::npos) return ParseResult::Incomplete;
+
+        size_t size = 0;
+        size_t digits = 0;
+        for (; pos + digits < line_end && std::isxdigit(static_cast<unsigned char>(in[pos + digits])); ++digits) {
+            char c = static_cast<char>(std::tolower(static_cast<unsigned char>(in[pos + digits])));
+            size = size * 16 + static_cast<size_t>(c <= '9' ? c - '0' : c - 'a' + 10);
+            if (size > max_body) {
+                status = 413;
+                return ParseResult::Failed;
+            }
+        }
+        if (digits == 0) {
+            status = 400;
+            return ParseResult::Failed;
+        }
+        pos = line_end + 2;
+
+        if (size == 0) {
+            // Trailers are skipped up to the empty line
+            while (true) {
+                auto trailer_end = in.find("\r\n", pos);
+                if (trailer_end == std::string::npos) return ParseResult::Incomplete;
+                if (trailer_end == pos) {
+                    end = pos + 2;
+                    return ParseResult::Complete;
+                }
+                pos = trailer_end + 2;
+            }
+        }
+
+        if (in.size() < pos + size + 2) return ParseResult::Incomplete;
+        if (in.compare(pos + size, 2, "\r\n") != 0) {
+            status = 400;
+            return ParseResult::Failed;
+        }
+        body.append(in, pos, size);
+        if (body.size() > max_body) {
+            status = 413;
+            return ParseResult::Failed;
+        }
+        pos += size + 2;
+    }
+}
+
+// Status line and headers, without the framing header and the blank line
+std::string response_head(const httplib::Response& res, bool close) {
+    std::string head = "HTTP/1.1 " + std::to_string(res.status) + " " + httplib::status_message(res.status) + "\r\n";
+    for (const auto& header : res.headers) {
+        head += header.first + ": " + header.second + "\r\n";
+    }
+    if (!res.has_header("Connection")) {
+        head += close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+    }
+    return head;
+}
+
+std::string serialize_response(const httplib::Request& req, const httplib::Response& res, bool close) {
+    std::string out = response_head(res, close);
+    if (!res.has_header("Content-Length") && res.status != 204 && res.status != 304) {
+        out += "Content-Length: " + std::to_string(res.body.size()) + "\r\n";
+    }
+    out += "\r\n";
+    if (req.method != "HEAD") {
+        out += res.body;
+    }
+    return out;
+}
+
+int bound_port(int fd) {
+    sockaddr_storage address{};
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    return address.ss_family == AF_INET6 ? ntohs(reinterpret_cast<sockaddr_in6*>(&address)->sin6_port)
+                                         : ntohs(reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+}
+
+std::string header_safe(const char* text) {
+    std::string value;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '\r') value += "\\r";
+        else if (*c == '\n') value += "\\n";
+        else value += *c;
+    }
+    return value;
+}
+
+} // namespace
+
+struct EventLoopServer::Connection {
+    enum class State { Reading, Working, Writing };
+
+    explicit Connection(int socket) : fd(socket) {}
+    ~Connection() { ::close(fd); }
+
+    int fd;
+    State state = State::Reading;
+    std::string remote_addr;
+    int remote_port = 0;
+    std::string local_addr;
+    int local_port = 0;
+    std::chrono::steady_clock::time_point last_active = std::chrono::steady_clock::now();
+
+    std::string in;     // Received and not yet consumed
+    size_t scanned = 0; // Prefix of `in` known not to contain the end of the headers
+    std::shared_ptr<httplib::Request> request; // Headers parsed, body still arriving
+    size_t body_start = 0;
+    size_t content_length = 0;
+    bool chunked = false;
+    bool continue_sent = false;
+
+    std::string out;
+    size_t out_offset = 0;
+    bool close_after_write = false;
+};
+
+// One epoll instance and the connections it accepted. Everything here runs on
+// the loop's thread except post(), which workers call to hand a connection
+// back. Connections are armed EPOLLONESHOT, so a connection is touched either
+// by its loop or by the one worker serving it, never both.
+class EventLoopServer::Loop {
+public:
+    explicit Loop(EventLoopServer& server);
+    ~Loop();
+
+    void run();
+    void wake();
+    void post(std::shared_ptr<Connection> conn);
+
+private:
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    void accept_connections();
+    void on_ready(const ConnectionPtr& conn);
+    void process_input(const ConnectionPtr& conn);
+    ParseResult parse(Connection& conn, std::shared_ptr<httplib::Request>& req, int& status);
+    void dispatch(const ConnectionPtr& conn, std::shared_ptr<httplib::Request> req);
+    void respond_error(const ConnectionPtr& conn, int status);
+    void flush(const ConnectionPtr& conn);
+    void arm(const Connection& conn, uint32_t events);
+    void close(const ConnectionPtr& conn);
+    void sweep(std::chrono::steady_clock::time_point now);
+    void stop_accepting();
+
+    EventLoopServer& server_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int spare_fd_ = -1; // Given up to shed a connection when out of descriptors
+    bool accepting_ = true;
+    std::unordered_map<int, ConnectionPtr> connections_;
+
+    std::mutex posted_mutex_;
+    std::vector<ConnectionPtr> posted_;
+};
+
+EventLoopServer::Loop::Loop(EventLoopServer& server)
+    : server_(server),
+      epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      spare_fd_(open("/dev/null", O_RDONLY | O_CLOEXEC)) {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    // Every loop waits on the listen socket; EPOLLEXCLUSIVE wakes one per connection burst
+    ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+    ev.data.fd = server_.listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_.listen_fd_, &ev);
+}
+
+EventLoopServer::Loop::~Loop() {
+    connections_.clear();
+    posted_.clear();
+    if (spare_fd_ >= 0) ::close(spare_fd_);
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void EventLoopServer::Loop::wake() {
+    uint64_t one = 1;
+    ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+    (void)written;
+}
+
+void EventLoopServer::Loop::post(std::shared_ptr<Connection> conn) {
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        posted_.push_back(std::move(conn));
+    }
+    wake();
+}
+
+void EventLoopServer::Loop::run() {
+    std::vector<epoll_event> events(EPOLL_BATCH);
+    auto next_sweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(SWEEP_INTERVAL_MS);
+
+    while (!server_.stopping_.load()) {
+        int ready = epoll_wait(epoll_fd_, events.data(), EPOLL_BATCH, SWEEP_INTERVAL_MS);
+        if (ready < 0 && errno != EINTR) {
+            logging::error("event_loop", "epoll_wait failed", {{"error", std::strerror(errno)}});
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == server_.listen_fd_) {
+                accept_connections();
+            } else if (fd == wake_fd_) {
+                uint64_t count;
+                ssize_t drained = ::read(wake_fd_, &count, sizeof(count));
+                (void)drained;
+                std::vector<ConnectionPtr> done;
+                {
+                    std::lock_guard<std::mutex> lock(posted_mutex_);
+                    done.swap(posted_);
+                }
+                for (const auto& conn : done) {
+                    // Streamed responses were written by the worker and end the connection
+                    if (conn->out.empty() && conn->close_after_write) {
+                        close(conn);
+                    } else {
+                        flush(conn);
+                    }
+                }
+            } else {
+                auto it = connections_.find(fd);
+                if (it != connections_.end()) {
+                    auto conn = it->second;
+                    on_ready(conn);
+                }
+            }
+        }
+
+        if (accepting_ && server_.draining_.load()) {
+            stop_accepting();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_sweep) {
+            sweep(now);
+            next_sweep = now + std::chrono::milliseconds(SWEEP_INTERVAL_MS);
+        }
+    }
+
+    for (const auto& entry : connections_) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry.first, nullptr);
+    }
+    server_.connections_ -= connections_.size();
+    connections_.clear();
+}
+
+void EventLoopServer::Loop::accept_connections() {
+    while (true) {
+        int fd = accept4(server_.listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if ((errno == EMFILE || errno == ENFILE) && spare_fd_ >= 0) {
+                // Out of descriptors: accept and drop one connection so the
+                // level-triggered listen socket stops reporting readiness
+                ::close(spare_fd_);
+                int shed = accept(server_.listen_fd_, nullptr, nullptr);
+                if (shed >= 0) ::close(shed);
+                spare_fd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            }
+            return;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        auto conn = std::make_shared<Connection>(fd);
+        httplib::detail::get_remote_ip_and_port(fd, conn->remote_addr, conn->remote_port);
+        httplib::detail::get_local_ip_and_port(fd, conn->local_addr, conn->local_port);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            continue;
+        }
+        connections_.emplace(fd, std::move(conn));
+        server_.connections_++;
+    }
+}
+
+void EventLoopServer::Loop::on_ready(const ConnectionPtr& conn) {
+    if (conn->state == Connection::State::Writing) {
+        flush(conn);
+        return;
+    }
+    if (conn->state != Connection::State::Reading) {
+        return;
+    }
+
+    // Stop reading once the buffer already exceeds anything parse() accepts
+    const size_t read_limit = CPPHTTPLIB_HEADER_MAX_LENGTH + server_.options_.max_body_bytes + READ_CHUNK;
+    char buffer[READ_CHUNK];
+    while (conn->in.size() <= read_limit) {
+        ssize_t received = ::recv(conn->fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            conn->in.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close(conn);
+        return;
+    }
+
+    conn->last_active = std::chrono::steady_clock::now();
+    process_input(conn);
+}
+
+void EventLoopServer::Loop::process_input(const ConnectionPtr& conn) {
+    std::shared_ptr<httplib::Request> req;
+    int status = 400;
+    switch (parse(*conn, req, status)) {
+    case ParseResult::Incomplete:
+        if (conn->request && !conn->continue_sent &&
+            iequals(conn->request->get_header_value("Expect"), "100-continue")) {
+            static const char continue_line[] = "HTTP/1.1 100 Continue\r\n\r\n";
+            ssize_t sent = ::send(conn->fd, continue_line, sizeof(continue_line) - 1, MSG_NOSIGNAL);
+            (void)sent;
+            conn->continue_sent = true;
+        }
+        arm(*conn, EPOLLIN);
+        break;
+    case ParseResult::Failed:
+        respond_error(conn, status);
+        break;
+    case ParseResult::Complete:
+        dispatch(conn, std::move(req));
+        break;
+    }
+}
+
+ParseResult EventLoopServer::Loop::parse(Connection& conn, std::shared_ptr<httplib::Request>& req, int& status) {
+    if (!conn.request) {
+        auto header_end = conn.in.find("\r\n\r\n", conn.scanned);
+        if (header_end == std::string::npos) {
+            if (conn.in.size() > CPPHTTPLIB_HEADER_MAX_LENGTH) {
+                status = 431;
+                return ParseResult::Failed;
+            }
+            conn.scanned = conn.in.size() > 3 ? conn.in.size() - 3 : 0;
+            return ParseResult::Incomplete;
+        }
+        if (header_end > CPPHTTPLIB_HEADER_MAX_LENGTH) {
+            status = 431;
+            return ParseResult::Failed;
+        }
+
+        auto head = std::make_shared<httplib::Request>();
+        if (!parse_head(conn.in, header_end, *head, status)) {
+            return ParseResult::Failed;
+        }
+
+        conn.body_start = header_end + 4;
+        conn.content_length = 0;
+        conn.chunked = false;
+        const auto transfer_encoding = head->get_header_value("Transfer-Encoding");
+        if (!transfer_encoding.empty()) {
+            if (!iequals(transfer_encoding, "chunked")) {
+                status = 501;
+                return ParseResult::Failed;
+            }
+            conn.chunked = true;
+        } else if (head->has_header("Content-Length")) {
+            const auto length = head->get_header_value("Content-Length");
+            if (length.empty() || length.size() > 18 || length.find_first_not_of("0123456789") != std::string::npos) {
+                status = 400;
+                return ParseResult::Failed;
+            }
+            conn.content_length = std::stoull(length);
+            if (conn.content_length > server_.options_.max_body_bytes) {
+                status = 413;
+                return ParseResult::Failed;
+            }
+        }
+        conn.request = std::move(head);
+    }
+
+    size_t end = 0;
+    if (conn.chunked) {
+        auto result = decode_chunked(conn.in, conn.body_start, server_.options_.max_body_bytes,
+                                     conn.request->body, end, status);
+        if (result != ParseResult::Complete) return result;
+    } else {
+        if (conn.in.size() - conn.body_start < conn.content_length) return ParseResult::Incomplete;
+        conn.request->body.assign(conn.in, conn.body_start, conn.content_length);
+        end = conn.body_start + conn.content_length;
+    }
+
+    if (conn.request->get_header_value("Content-Type").rfind("application/x-www-form-urlencoded", 0) == 0) {
+        httplib::detail::parse_query_text(conn.request->body, conn.request->params);
+    }
+
+    conn.in.erase(0, end);
+    conn.scanned = 0;
+    conn.continue_sent = false;
+    req = std::move(conn.request);
+    return ParseResult::Complete;
+}
+
+void EventLoopServer::Loop::dispatch(const ConnectionPtr& conn, std::shared_ptr<httplib::Request> req) {
+    req->remote_addr = conn->remote_addr;
+    req->remote_port = conn->remote_port;
+    req->set_header("REMOTE_ADDR", req->remote_addr);
+    req->set_header("REMOTE_PORT", std::to_string(req->remote_port));
+    req->local_addr = conn->local_addr;
+    req->local_port = conn->local_port;
+    req->set_header("LOCAL_ADDR", req->local_addr);
+    req->set_header("LOCAL_PORT", std::to_string(req->local_port));
+    int fd = conn->fd;
+    req->is_connection_closed = [fd]() { return !httplib::detail::is_socket_alive(fd); };
+
+    const auto connection = req->get_header_value("Connection");
+    conn->close_after_write = iequals(connection, "close") || server_.draining_.load() ||
+                              (req->version == "HTTP/1.0" && !iequals(connection, "keep-alive"));
+    conn->state = Connection::State::Working;
+
+    HttpRouter::Match route;
+    httplib::Response res;
+    if (server_.router_.match(*req, route)) {
+        Loop* loop = this;
+        EventLoopServer* server = &server_;
+        const HttpRouter::Handler* handler = route.handler;
+        bool queued = server_.pools_->submit(route.endpoint_class, [loop, server, conn, req, handler]() {
+            server->serve(*conn, *req, *handler);
+            loop->post(conn);
+        });
+        if (queued) {
+            server_.requests_++;
+            return;
+        }
+        server_.rejected_++;
+        res.set_header("Retry-After", "1");
+        set_json_error_response(res, "Server is busy", "capacity_exceeded", 503);
+    } else {
+        res.status = 404;
+    }
+
+    conn->out = serialize_response(*req, res, conn->close_after_write);
+    conn->out_offset = 0;
+    flush(conn);
+}
+
+void EventLoopServer::Loop::respond_error(const ConnectionPtr& conn, int status) {
+    httplib::Request req;
+    httplib::Response res;
+    res.status = status;
+    conn->request.reset();
+    conn->in.clear();
+    conn->out = serialize_response(req, res, true);
+    conn->out_offset = 0;
+    conn->close_after_write = true;
+    flush(conn);
+}
+
+void EventLoopServer::Loop::flush(const ConnectionPtr& conn) {
+    conn->state = Connection::State::Writing;
+    while (conn->out_offset < conn->out.size()) {
+        ssize_t sent = ::send(conn->fd, conn->out.data() + conn->out_offset,
+                              conn->out.size() - conn->out_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn->out_offset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            arm(*conn, EPOLLOUT);
+            return;
+        }
+        close(conn);
+        return;
+    }
+
+    conn->out.clear();
+    conn->out_offset = 0;
+    conn->last_active = std::chrono::steady_clock::now();
+    if (conn->close_after_write || server_.stopping_.load() || server_.draining_.load()) {
+        close(conn);
+        return;
+    }
+
+    conn->state = Connection::State::Reading;
+    if (!conn->in.empty()) {
+        process_input(conn); // A pipelined request is already buffered
+    } else {
+        arm(*conn, EPOLLIN);
+    }
+}
+
+void EventLoopServer::Loop::arm(const Connection& conn, uint32_t events) {
+    epoll_event ev{};
+    ev.events = events | EPOLLRDHUP | EPOLLONESHOT;
+    ev.data.fd = conn.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void EventLoopServer::Loop::close(const ConnectionPtr& conn) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd, nullptr);
+    if (connections_.erase(conn->fd) > 0) {
+        server_.connections_--;
+    }
+}
+
+void EventLoopServer::Loop::stop_accepting() {
+    accepting_ = false;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, server_.listen_fd_, nullptr);
+
+    // A keep-alive connection between requests is closed now; one part way
+    // through a request is closed after its response
+    std::vector<ConnectionPtr> idle;
+    for (const auto& entry : connections_) {
+        const auto& conn = entry.second;
+        if (conn->state == Connection::State::Reading && !conn->request && conn->in.empty()) {
+            idle.push_back(conn);
+        }
+    }
+    for (const auto& conn : idle) {
+        close(conn);
+    }
+}
+
+void EventLoopServer::Loop::sweep(std::chrono::steady_clock::time_point now) {
+    std::vector<ConnectionPtr> idle;
+    for (const auto& entry : connections_) {
+        const auto& conn = entry.second;
+        if (conn->state != Connection::State::Working && now - conn->last_active > server_.options_.idle_timeout) {
+            idle.push_back(conn);
+        }
+    }
+    for (const auto& conn : idle) {
+        close(conn);
+    }
+}
+
+EventLoopServer::EventLoopServer(const HttpRouter& router, EventLoopOptions options,
+                                 std::shared_ptr<EndpointPools> pools)
+    : router_(router), options_(options), pools_(pools ? pools : std::make_shared<EndpointPools>()) {
+    options_.io_threads = std::max<size_t>(1, options_.io_threads);
+}
+
+EventLoopServer::~EventLoopServer() {
+    stop();
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+    }
+}
+
+int EventLoopServer::bind_to_any_port(const std::string& host) {
+    return bind_internal(host, 0);
+}
+
+bool EventLoopServer::bind_to_port(const std::string& host, int port) {
+    return bind_internal(host, port) >= 0;
+}
+
+int EventLoopServer::bind_internal(const std::string& host, int port) {
+    if (listen_fd_ >= 0) return -1;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* addresses = nullptr;
+    auto service = std::to_string(port);
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (auto* ai = addresses; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, SOMAXCONN) == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) return -1;
+
+    int bound = bound_port(fd);
+
+    listen_fd_ = fd;
+    stopping_.store(false);
+    draining_.store(false);
+    return bound;
+}
+
+int EventLoopServer::adopt_listen_socket(int fd) {
+    if (listen_fd_ >= 0 || fd < 0) return -1;
+
+    int accepting = 0;
+    socklen_t option_length = sizeof(accepting);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &option_length) != 0 || !accepting) {
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    int bound = bound_port(fd);
+
+    listen_fd_ = fd;
+    stopping_.store(false);
+    draining_.store(false);
+    return bound;
+}
+
+bool EventLoopServer::listen_after_bind() {
+    if (listen_fd_ < 0) return false;
+
+    pools_->start(options_.pools);
+    for (size_t i = 0; i < options_.io_threads; ++i) {
+        loops_.push_back(std::make_unique<Loop>(*this));
+    }
+    std::vector<std::thread> threads;
+    for (auto& loop : loops_) {
+        threads.emplace_back(&Loop::run, loop.get());
+    }
+    running_.store(true);
+
+    {
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        stop_cv_.wait(lock, [this]() { return stopping_.load(); });
+    }
+
+    for (auto& loop : loops_) {
+        loop->wake();
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Queued and running handlers finish; their responses are dropped with the loops
+    pools_->shutdown();
+    loops_.clear();
+
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    running_.store(false);
+    return true;
+}
+
+void EventLoopServer::drain(std::chrono::milliseconds timeout) {
+    if (running_.load()) {
+        draining_.store(true);
+        for (auto& loop : loops_) {
+            loop->wake();
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (connections_.load() > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    stop();
+}
+
+void EventLoopServer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stopping_.store(true);
+    }
+    stop_cv_.notify_all();
+}
+
+EventLoopStats EventLoopServer::stats() const {
+    EventLoopStats stats;
+    stats.connections = connections_.load();
+    stats.requests = requests_.load();
+    stats.rejected = rejected_.load();
+    return stats;
+}
+
+void EventLoopServer::serve(Connection& conn, httplib::Request& req, const HttpRouter::Handler& handler) {
+    httplib::Response res;
+    res.version = "HTTP/1.1";
+
+    try {
+        handler(req, res);
+    } catch (const std::exception& e) {
+        res.status = 500;
+        res.set_header("EXCEPTION_WHAT", header_safe(e.what()));
+    } catch (...) {
+        res.status = 500;
+        res.set_header("EXCEPTION_WHAT", "UNKNOWN");
+    }
+    if (res.status == -1) {
+        res.status = 200;
+    }
+    if (post_routing_handler_) {
+        post_routing_handler_(req, res);
+    }
+    if (draining_.load()) {
+        conn.close_after_write = true;
+    }
+
+    if (res.content_provider_) {
+        stream(conn, req, res);
+        conn.out.clear();
+        conn.close_after_write = true;
+        return;
+    }
+    conn.out = serialize_response(req, res, conn.close_after_write);
+    conn.out_offset = 0;
+}
+
+void EventLoopServer::stream(Connection& conn, const httplib::Request& req, httplib::Response& res) {
+    httplib::detail::SocketStream strm(conn.fd, 0, 0, STREAM_WRITE_TIMEOUT_SEC, 0);
+    auto is_shutting_down = [this]() { return stopping_.load() || draining_.load(); };
+
+    std::string head = response_head(res, true);
+    bool ok;
+    if (res.content_length_ > 0) {
+        head += "Content-Length: " + std::to_string(res.content_length_) + "\r\n\r\n";
+        ok = httplib::detail::write_data(strm, head.data(), head.size()) &&
+             (req.method == "HEAD" ||
+              httplib::detail::write_content(strm, res.content_provider_, 0, res.content_length_,
+                                             is_shutting_down));
+    } else if (res.is_chunked_content_provider_) {
+        head += "Transfer-Encoding: chunked\r\n\r\n";
+        httplib::detail::nocompressor compressor;
+        ok = httplib::detail::write_data(strm, head.data(), head.size()) &&
+             httplib::detail::write_content_chunked(strm, res.content_provider_, is_shutting_down, compressor);
+    } else {
+        head += "\r\n";
+        ok = httplib::detail::write_data(strm, head.data(), head.size()) &&
+             httplib::detail::write_content_without_length(strm, res.content_provider_, is_shutting_down);
+    }
+    res.content_provider_success_ = ok;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
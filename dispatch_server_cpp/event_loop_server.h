@@ -0,0 +1,104 @@
+#ifndef EVENT_LOOP_SERVER_H
+#define EVENT_LOOP_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "httplib.h"
+#include "http_router.h"
+#include "endpoint_pools.h"
+#include "dispatch_server_constants.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+struct EventLoopOptions {
+    size_t io_threads = Constants::EVENT_LOOP_IO_THREADS;
+    EndpointPoolLimits pools = default_endpoint_pool_limits(); // Handler threads per endpoint class
+    std::chrono::seconds idle_timeout = Constants::EVENT_LOOP_IDLE_TIMEOUT;
+    size_t max_body_bytes = Constants::EVENT_LOOP_MAX_BODY_BYTES;
+};
+
+struct EventLoopStats {
+    size_t connections = 0; // Open right now
+    size_t requests = 0;    // Handed to a worker pool
+    size_t rejected = 0;    // Refused with 503 because their pool's queue was full
+};
+
+// HTTP/1.1 front end on epoll. A few I/O threads accept connections and read,
+// parse, route and write without blocking; only a complete request takes a
+// thread, from the bounded pool of its route's endpoint class, so an idle
+// keep-alive connection costs a socket and a buffer rather than a thread and
+// a flood of queries cannot delay heartbeats. Handlers come from an
+// HttpRouter and are the same functions the httplib server runs. A streamed
+// response (the event stream) keeps its worker until it ends and then closes
+// the connection.
+class EventLoopServer {
+public:
+    // `pools` is started and shut down with the server; one is created if omitted
+    explicit EventLoopServer(const HttpRouter& router, EventLoopOptions options = {},
+                             std::shared_ptr<EndpointPools> pools = nullptr);
+    ~EventLoopServer();
+
+    EventLoopServer(const EventLoopServer&) = delete;
+    EventLoopServer& operator=(const EventLoopServer&) = delete;
+
+    // Return the bound port (-1 on failure) / whether the bind succeeded
+    int bind_to_any_port(const std::string& host);
+    bool bind_to_port(const std::string& host, int port);
+    // Serves on a socket that is already listening (handed over by another
+    // process) and takes ownership of it; returns its port, -1 if it is not a listening socket
+    int adopt_listen_socket(int fd);
+    int listen_socket() const { return listen_fd_; }
+
+    // Serves until stop(); false if nothing is bound
+    bool listen_after_bind();
+    void stop();
+    // Stops accepting and closes idle keep-alive connections; requests
+    // already received are answered with "Connection: close". Stops once no
+    // connection is left or `timeout` has passed. Connections still queued on
+    // the listen socket are left to whichever process shares it.
+    void drain(std::chrono::milliseconds timeout);
+    bool is_running() const { return running_.load(); }
+
+    EventLoopStats stats() const;
+
+    // Runs after each routed handler, before the response is written, as
+    // httplib::Server::set_post_routing_handler does; set before listening
+    void set_post_routing_handler(HttpRouter::Handler handler) { post_routing_handler_ = std::move(handler); }
+
+private:
+    struct Connection;
+    class Loop;
+
+    int bind_internal(const std::string& host, int port);
+    void serve(Connection& conn, httplib::Request& req, const HttpRouter::Handler& handler);
+    void stream(Connection& conn, const httplib::Request& req, httplib::Response& res);
+
+    const HttpRouter& router_;
+    EventLoopOptions options_;
+    HttpRouter::Handler post_routing_handler_;
+    int listen_fd_ = -1;
+
+    std::shared_ptr<EndpointPools> pools_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> draining_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+
+    std::atomic<size_t> connections_{0};
+    std::atomic<size_t> requests_{0};
+    std::atomic<size_t> rejected_{0};
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // EVENT_LOOP_SERVER_H
@@ -0,0 +1,101 @@
+#include "event_stream_handler.h"
+#include "dispatch_server_constants.h"
+#include <sstream>
+
+namespace distconv {
+namespace DispatchServer {
+
+using namespace Constants;
+
+namespace {
+
+void add_param_values(const httplib::Request& req, const std::string& key, std::set<std::string>& out) {
+    for (size_t i = 0; i < req.get_param_value_count(key); ++i) {
+        std::stringstream values(req.get_param_value(key, i));
+        std::string value;
+        while (std::getline(values, value, ',')) {
+            if (!value.empty()) out.insert(value);
+        }
+    }
+}
+
+std::string format_event(const JobEvent& event) {
+    return "id: " + std::to_string(event.id) + "\nevent: " + event.type +
+           "\ndata: " + event.data.dump() + "\n\n";
+}
+
+} // namespace
+
+JobEventStreamHandler::JobEventStreamHandler(std::shared_ptr<AuthMiddleware> auth,
+                                             std::shared_ptr<JobEventBus> events)
+    : auth_(auth), events_(events) {}
+
+void JobEventStreamHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+
+    auto subscriber = events_->subscribe(parse_filter(req), parse_last_event_id(req));
+    if (!subscriber) {
+        res.set_header("Retry-After", std::to_string(EVENT_STREAM_RETRY_MS.count() / 1000));
+        set_json_error_response(res, "Too many event stream subscribers", "capacity_exceeded", 503);
+        return;
+    }
+
+    res.set_header("Cache-Control", "no-cache");
+    res.set_header("X-Accel-Buffering", "no");
+
+    auto events = events_;
+    auto greeted = std::make_shared<bool>(false);
+    res.set_chunked_content_provider(
+        "text/event-stream",
+        [events, subscriber, greeted](size_t, httplib::DataSink& sink) {
+            std::string chunk;
+            if (!*greeted) {
+                // Flush headers right away and tell EventSource how fast to reconnect
+                *greeted = true;
+                chunk = "retry: " + std::to_string(EVENT_STREAM_RETRY_MS.count()) + "\n\n";
+                return sink.write(chunk.data(), chunk.size());
+            }
+
+            std::vector<JobEvent> batch;
+            auto deadline = std::chrono::steady_clock::now() + EVENT_STREAM_KEEPALIVE;
+            if (!events->next(subscriber, deadline, batch)) {
+                // Lagged or shutting down; the client resumes via Last-Event-ID
+                sink.done();
+                return true;
+            }
+
+            if (batch.empty()) {
+                chunk = ": keepalive\n\n";
+            }
+            for (const auto& event : batch) {
+                chunk += format_event(event);
+            }
+            return sink.write(chunk.data(), chunk.size());
+        },
+        [events, subscriber](bool) { events->unsubscribe(subscriber); });
+}
+
+JobEventFilter JobEventStreamHandler::parse_filter(const httplib::Request& req) {
+    JobEventFilter filter;
+    add_param_values(req, "job_id", filter.job_ids);
+    add_param_values(req, "status", filter.statuses);
+    if (req.has_param("tenant")) {
+        filter.tenant = req.get_param_value("tenant");
+    }
+    return filter;
+}
+
+uint64_t JobEventStreamHandler::parse_last_event_id(const httplib::Request& req) {
+    std::string value = req.get_header_value("Last-Event-ID");
+    if (value.empty() && req.has_param("last_event_id")) {
+        value = req.get_param_value("last_event_id");
+    }
+    try {
+        return value.empty() ? 0 : std::stoull(value);
+    } catch (...) {
+        return 0;
+    }
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,30 @@
+#ifndef EVENT_STREAM_HANDLER_H
+#define EVENT_STREAM_HANDLER_H
+
+#include "request_handlers.h"
+#include "job_events.h"
+#include <memory>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Handler for GET /events - Server-Sent Events stream of job transitions.
+// Filters: job_id, status (repeatable or comma-separated), tenant.
+// Resumes from the Last-Event-ID header or ?last_event_id=.
+class JobEventStreamHandler : public IRequestHandler {
+public:
+    JobEventStreamHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<JobEventBus> events);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    static JobEventFilter parse_filter(const httplib::Request& req);
+    static uint64_t parse_last_event_id(const httplib::Request& req);
+
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<JobEventBus> events_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // EVENT_STREAM_HANDLER_H
@@ -0,0 +1,280 @@
+#include "http_router.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+const char* const CAPTURE_REGEX[] = {R"(([a-fA-F0-9\-]{36}))", R"(([a-zA-Z0-9\-_]+))"};
+
+bool is_token_segment(std::string_view segment) {
+    if (segment.empty()) return false;
+    for (char c : segment) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') return false;
+    }
+    return true;
+}
+
+// "/jobs/{job_id:uuid}/complete" -> "jobs", "{job_id:uuid}", "complete";
+// "/" -> ""; a trailing slash leaves an empty last segment
+void split_path(std::string_view path, std::vector<std::string_view>& segments) {
+    segments.clear();
+    size_t start = path.empty() || path[0] != '/' ? 0 : 1;
+    while (true) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string_view::npos) {
+            segments.push_back(path.substr(start));
+            return;
+        }
+        segments.push_back(path.substr(start, slash - start));
+        start = slash + 1;
+    }
+}
+
+// The httplib mirror still matches with std::regex, so it gets each route's
+// regex and a wrapper moving the captures into path_params
+std::string escape_regex(std::string_view literal) {
+    std::string escaped;
+    for (char c : literal) {
+        if (std::string_view("\\^$.|?*+()[]{}").find(c) != std::string_view::npos) escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+httplib::Server::Handler with_path_params(std::vector<std::string> names, httplib::Server::Handler handler) {
+    return [names = std::move(names), handler = std::move(handler)](const httplib::Request& req,
+                                                                    httplib::Response& res) {
+        // httplib passes its own non-const Request as const
+        auto& params = const_cast<httplib::Request&>(req).path_params;
+        for (size_t i = 0; i < names.size() && i + 1 < req.matches.size(); ++i) {
+            params.emplace(names[i], req.matches[i + 1].str());
+        }
+        handler(req, res);
+    };
+}
+
+// Response counters of one route by status code. A route answers with a
+// handful of codes, so each gets a slot on first use and later responses
+// find their counter without touching the registry's lock.
+class StatusCounters {
+public:
+    StatusCounters(std::shared_ptr<MetricsRegistry> metrics, MetricLabels labels)
+        : metrics_(std::move(metrics)), labels_(std::move(labels)) {}
+
+    Counter& get(int code) {
+        for (auto& slot : slots_) {
+            int seen = slot.code.load(std::memory_order_acquire);
+            if (seen == 0 && slot.code.compare_exchange_strong(seen, code, std::memory_order_acq_rel)) {
+                Counter* counter = &lookup(code);
+                slot.counter.store(counter, std::memory_order_release);
+                return *counter;
+            }
+            if (seen == code) {
+                Counter* counter = slot.counter.load(std::memory_order_acquire);
+                return counter ? *counter : lookup(code); // Still being filled in by its first thread
+            }
+        }
+        return lookup(code);
+    }
+
+private:
+    struct Slot {
+        std::atomic<int> code{0};
+        std::atomic<Counter*> counter{nullptr};
+    };
+
+    Counter& lookup(int code) {
+        MetricLabels labels = labels_;
+        labels.emplace_back("code", std::to_string(code));
+        return metrics_->counter("dispatch_http_responses_total", "HTTP responses by route and status code", labels);
+    }
+
+    std::shared_ptr<MetricsRegistry> metrics_;
+    MetricLabels labels_;
+    Slot slots_[8];
+};
+
+} // namespace
+
+bool is_uuid_segment(std::string_view segment) {
+    if (segment.size() != 36) return false;
+    for (char c : segment) {
+        if (!std::isxdigit(static_cast<unsigned char>(c)) && c != '-') return false;
+    }
+    return true;
+}
+
+HttpRouter& HttpRouter::Get(const std::string& pattern, Handler handler, EndpointClass cls) {
+    add("GET", pattern, std::move(handler), cls);
+    return *this;
+}
+
+HttpRouter& HttpRouter::Post(const std::string& pattern, Handler handler, EndpointClass cls) {
+    add("POST", pattern, std::move(handler), cls);
+    return *this;
+}
+
+HttpRouter& HttpRouter::Put(const std::string& pattern, Handler handler, EndpointClass cls) {
+    add("PUT", pattern, std::move(handler), cls);
+    return *this;
+}
+
+HttpRouter& HttpRouter::Delete(const std::string& pattern, Handler handler, EndpointClass cls) {
+    add("DELETE", pattern, std::move(handler), cls);
+    return *this;
+}
+
+void HttpRouter::add(const std::string& method, const std::string& pattern, Handler handler, EndpointClass cls) {
+    if (pattern.empty() || pattern[0] != '/') {
+        throw std::invalid_argument("Route pattern must start with '/': " + pattern);
+    }
+    handler = instrument(method, pattern, std::move(handler));
+
+    std::vector<std::string_view> segments;
+    split_path(pattern, segments);
+    std::vector<std::string> params;
+    std::string regex;
+    Node* node = &root_;
+    for (std::string_view segment : segments) {
+        regex += '/';
+        if (segment.empty() || segment.front() != '{') {
+            auto child = std::find_if(node->literals.begin(), node->literals.end(),
+                                      [&](const auto& literal) { return literal.first == segment; });
+            if (child == node->literals.end()) {
+                node->literals.emplace_back(std::string(segment), std::make_unique<Node>());
+                child = std::prev(node->literals.end());
+            }
+            node = child->second.get();
+            regex += escape_regex(segment);
+            continue;
+        }
+
+        if (segment.back() != '}') {
+            throw std::invalid_argument("Unterminated capture in route pattern: " + pattern);
+        }
+        std::string_view capture = segment.substr(1, segment.size() - 2);
+        std::string_view type = "token";
+        size_t colon = capture.find(':');
+        if (colon != std::string_view::npos) {
+            type = capture.substr(colon + 1);
+            capture = capture.substr(0, colon);
+        }
+        if (capture.empty() || (type != "uuid" && type != "token")) {
+            throw std::invalid_argument("Bad capture in route pattern: " + pattern);
+        }
+        size_t slot = static_cast<size_t>(type == "uuid" ? Capture::Uuid : Capture::Token);
+        if (!node->captures[slot]) {
+            node->captures[slot] = std::make_unique<Node>();
+        }
+        node = node->captures[slot].get();
+        params.emplace_back(capture);
+        regex += CAPTURE_REGEX[slot];
+    }
+
+    if (mirror_) {
+        Handler mirrored = params.empty() ? handler : with_path_params(params, handler);
+        if (method == "GET") mirror_->Get(regex, std::move(mirrored));
+        else if (method == "POST") mirror_->Post(regex, std::move(mirrored));
+        else if (method == "PUT") mirror_->Put(regex, std::move(mirrored));
+        else mirror_->Delete(regex, std::move(mirrored));
+    }
+
+    // As with httplib, the first registration of a method and path wins
+    for (const auto& existing : node->routes) {
+        if (existing.first == method) return;
+    }
+    node->routes.emplace_back(method, routes_.size());
+    routes_.push_back({method, pattern, std::move(handler), cls, std::move(params)});
+}
+
+HttpRouter::Handler HttpRouter::instrument(const std::string& method, const std::string& pattern,
+                                           Handler handler) const {
+    if (!metrics_) {
+        return handler;
+    }
+    MetricLabels labels{{"method", method}, {"route", pattern}};
+    Histogram* latency = &metrics_->histogram("dispatch_http_request_duration_seconds",
+                                              "Time spent in the route's handler", latency_buckets(), labels);
+    auto codes = std::make_shared<StatusCounters>(metrics_, labels);
+    return [handler = std::move(handler), latency, codes](const httplib::Request& req, httplib::Response& res) {
+        auto start = std::chrono::steady_clock::now();
+        handler(req, res);
+        latency->observe_since(start);
+        // Both front ends send a status the handler left unset as 200
+        codes->get(res.status == -1 ? 200 : res.status).inc();
+    };
+}
+
+size_t HttpRouter::find(const Node& node, const std::vector<std::string_view>& segments, size_t depth,
+                        const std::string& method, std::vector<std::string_view>& captured) const {
+    if (depth == segments.size()) {
+        for (const auto& route : node.routes) {
+            if (route.first == method) return route.second;
+        }
+        return NO_ROUTE;
+    }
+
+    std::string_view segment = segments[depth];
+    for (const auto& literal : node.literals) {
+        if (literal.first == segment) {
+            size_t found = find(*literal.second, segments, depth + 1, method, captured);
+            if (found != NO_ROUTE) return found;
+            break;
+        }
+    }
+
+    for (size_t slot = 0; slot < CAPTURE_TYPES; ++slot) {
+        const Node* child = node.captures[slot].get();
+        if (!child) continue;
+        bool accepts = slot == static_cast<size_t>(Capture::Uuid) ? is_uuid_segment(segment)
+                                                                   : is_token_segment(segment);
+        if (!accepts) continue;
+        captured.push_back(segment);
+        size_t found = find(*child, segments, depth + 1, method, captured);
+        if (found != NO_ROUTE) return found;
+        captured.pop_back();
+    }
+    return NO_ROUTE;
+}
+
+bool HttpRouter::match(httplib::Request& req, Match& match) const {
+    static const std::string GET = "GET";
+    const std::string& method = req.method == "HEAD" ? GET : req.method;
+
+    std::vector<std::string_view> segments;
+    std::vector<std::string_view> captured;
+    split_path(req.path, segments);
+    size_t index = find(root_, segments, 0, method, captured);
+    if (index == NO_ROUTE) {
+        return false;
+    }
+
+    const Route& route = routes_[index];
+    req.path_params.clear();
+    for (size_t i = 0; i < captured.size(); ++i) {
+        req.path_params.emplace(route.params[i], std::string(captured[i]));
+    }
+    req.matched_route = route.pattern;
+    match.handler = &route.handler;
+    match.endpoint_class = route.endpoint_class;
+    return true;
+}
+
+bool HttpRouter::route(httplib::Request& req, httplib::Response& res) const {
+    Match found;
+    if (!match(req, found)) {
+        return false;
+    }
+    (*found.handler)(req, res);
+    return true;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,97 @@
+#ifndef HTTP_ROUTER_H
+#define HTTP_ROUTER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "httplib.h"
+#include "endpoint_pools.h"
+#include "metrics.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+// Route table behind the dispatch API. Registration mirrors httplib::Server's
+// Get/Post/Put/Delete, and every route is also registered on the attached
+// httplib server, so one set of setup_*_endpoints calls feeds both the
+// thread-per-connection server and the event-loop front end. Each route names
+// the worker pool the event loop runs it on.
+//
+// Patterns are paths whose segments are literals or typed captures:
+//   /jobs/{job_id:uuid}/complete   36 hex digits and dashes
+//   /api/v1/engines/{engine_id}    letters, digits, '-' and '_'
+// Captures land in req.path_params by name. Routes are compiled into a trie of
+// path segments, so matching costs one walk down the path with no regex; a
+// literal segment is preferred over a capture, a uuid over a plain capture.
+//
+// With a metrics registry every handler is timed, on either front end, into
+// dispatch_http_request_duration_seconds and its responses are counted into
+// dispatch_http_responses_total, both labelled by method and route pattern.
+class HttpRouter {
+public:
+    using Handler = httplib::Server::Handler;
+
+    explicit HttpRouter(httplib::Server* mirror = nullptr, std::shared_ptr<MetricsRegistry> metrics = nullptr)
+        : mirror_(mirror), metrics_(std::move(metrics)) {}
+
+    struct Match {
+        const Handler* handler = nullptr;
+        EndpointClass endpoint_class = EndpointClass::Query;
+    };
+
+    // Throw std::invalid_argument for a malformed pattern
+    HttpRouter& Get(const std::string& pattern, Handler handler, EndpointClass cls = EndpointClass::Query);
+    HttpRouter& Post(const std::string& pattern, Handler handler, EndpointClass cls = EndpointClass::Query);
+    HttpRouter& Put(const std::string& pattern, Handler handler, EndpointClass cls = EndpointClass::Query);
+    HttpRouter& Delete(const std::string& pattern, Handler handler, EndpointClass cls = EndpointClass::Query);
+
+    // Finds the route registered for req.method whose pattern matches
+    // req.path, filling req.path_params. HEAD is served by GET routes. Returns
+    // false when no route matches. Routes must not be added while serving.
+    bool match(httplib::Request& req, Match& match) const;
+
+    // match() and run the handler
+    bool route(httplib::Request& req, httplib::Response& res) const;
+
+    size_t size() const { return routes_.size(); }
+
+private:
+    enum class Capture { Uuid = 0, Token = 1 };
+    static constexpr size_t CAPTURE_TYPES = 2;
+
+    struct Route {
+        std::string method;
+        std::string pattern;
+        Handler handler;
+        EndpointClass endpoint_class;
+        std::vector<std::string> params; // Capture names in path order
+    };
+
+    struct Node {
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> literals;
+        std::unique_ptr<Node> captures[CAPTURE_TYPES];
+        std::vector<std::pair<std::string, size_t>> routes; // Method -> index into routes_
+    };
+
+    static constexpr size_t NO_ROUTE = static_cast<size_t>(-1);
+
+    void add(const std::string& method, const std::string& pattern, Handler handler, EndpointClass cls);
+    Handler instrument(const std::string& method, const std::string& pattern, Handler handler) const;
+    size_t find(const Node& node, const std::vector<std::string_view>& segments, size_t depth,
+                const std::string& method, std::vector<std::string_view>& captured) const;
+
+    httplib::Server* mirror_;
+    std::shared_ptr<MetricsRegistry> metrics_;
+    std::vector<Route> routes_;
+    Node root_;
+};
+
+// Whether a path segment is a job id: 36 hex digits and dashes
+bool is_uuid_segment(std::string_view segment);
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // HTTP_ROUTER_H
@@ -1,4 +1,5 @@
 #include "job_action_handlers.h"
+#include "wall_clock.h"
 #include "dispatch_server_core.h"
 #include <mutex>
 #include <chrono>
@@ -6,18 +7,35 @@
 namespace distconv {
 namespace DispatchServer {
 
+namespace {
+
+// The engine a job report is about: the reporter, or the assignee for engines that do not say
+std::string reporting_engine(const nlohmann::json& job, const std::string& reporter) {
+    if (!reporter.empty()) {
+        return reporter;
+    }
+    return job.contains("assigned_engine") && job["assigned_engine"].is_string()
+               ? job["assigned_engine"].get<std::string>() : "";
+}
+
+} // namespace
+
 JobCompletionHandler::JobCompletionHandler(std::shared_ptr<AuthMiddleware> auth, 
                                            std::shared_ptr<IJobRepository> job_repo,
-                                           std::shared_ptr<IEngineRepository> engine_repo)
-    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo) {}
+                                           std::shared_ptr<IEngineRepository> engine_repo,
+                                           std::shared_ptr<SpeculationManager> speculation,
+                                           std::shared_ptr<EngineHealth> health,
+                                           std::shared_ptr<JobTracer> tracer)
+    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo), speculation_(speculation), health_(health),
+      tracer_(tracer) {}
 
 void JobCompletionHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
         return;
     }
-    std::string job_id = req.matches[1];
     
     nlohmann::json job = job_repo_->get_job(job_id);
     if (job.is_null() || job.empty()) {
@@ -31,10 +49,32 @@ void JobCompletionHandler::handle(const httplib::Request& req, httplib::Response
         request_json = nlohmann::json::parse(req.body);
     } catch (...) {}
 
+    std::string reporter = request_json.is_object() && request_json.contains("engine_id") &&
+                           request_json["engine_id"].is_string() ? request_json["engine_id"].get<std::string>() : "";
+    if (speculation_ && speculation_->is_losing_report(job, reporter)) {
+        set_json_error_response(res, "Job already completed by another engine", "conflict", 409, "Job ID: " + job_id);
+        return;
+    }
+
+    int64_t now_ms = wall_clock_ms();
+    std::string completed_by = reporting_engine(job, reporter);
+    if (health_) {
+        health_->record_success(completed_by, job, now_ms);
+    }
+
     job["status"] = "completed";
+    if (!completed_by.empty()) {
+        // Kept after assigned_engine is cleared; a restart replays engine health from it
+        job["completed_by"] = completed_by;
+    }
     job["output_url"] = request_json.value("output_url", "");
-    job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    job["updated_at"] = now_ms;
+    if (speculation_) {
+        speculation_->resolve_completion(job, reporter, job["updated_at"]);
+    }
+    if (tracer_) {
+        tracer_->end_attempt(job, request_json, now_ms);
+    }
     
     if (!job["assigned_engine"].is_null()) {
         std::string engine_id = job["assigned_engine"];
@@ -53,16 +93,21 @@ void JobCompletionHandler::handle(const httplib::Request& req, httplib::Response
 
 JobFailureHandler::JobFailureHandler(std::shared_ptr<AuthMiddleware> auth, 
                                      std::shared_ptr<IJobRepository> job_repo,
-                                     std::shared_ptr<IEngineRepository> engine_repo)
-    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo) {}
+                                     std::shared_ptr<IEngineRepository> engine_repo,
+                                     std::shared_ptr<SpeculationManager> speculation,
+                                     std::shared_ptr<EngineHealth> health,
+                                     std::shared_ptr<RetryScheduler> retries,
+                                     std::shared_ptr<JobTracer> tracer)
+    : auth_(auth), job_repo_(job_repo), engine_repo_(engine_repo), speculation_(speculation), health_(health),
+      retries_(retries), tracer_(tracer) {}
 
 void JobFailureHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
         return;
     }
-    std::string job_id = req.matches[1];
     
     nlohmann::json job = job_repo_->get_job(job_id);
     if (job.is_null() || job.empty()) {
@@ -76,10 +121,40 @@ void JobFailureHandler::handle(const httplib::Request& req, httplib::Response& r
         request_json = nlohmann::json::parse(req.body);
     } catch (...) {}
 
-    job["status"] = "failed_permanently";
-    job["error_message"] = request_json.value("error_message", "Job reported failure");
-    job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::string reporter = request_json.is_object() && request_json.contains("engine_id") &&
+                           request_json["engine_id"].is_string() ? request_json["engine_id"].get<std::string>() : "";
+    if (speculation_ && speculation_->is_losing_report(job, reporter)) {
+        set_json_error_response(res, "Job already completed by another engine", "conflict", 409, "Job ID: " + job_id);
+        return;
+    }
+
+    int64_t now_ms = wall_clock_ms();
+    std::string error_message = request_json.is_object() ? request_json.value("error_message", "Job reported failure")
+                                                         : "Job reported failure";
+    std::string failed_on = reporting_engine(job, reporter);
+    if (health_) {
+        health_->record_failure(failed_on, job, error_message, now_ms);
+    }
+    // Should the job be retried, it goes to another engine first
+    mark_retry_anti_affinity(job, failed_on, now_ms);
+
+    if (speculation_ && speculation_->absorb_failure(job, reporter)) {
+        job_repo_->save_job(job_id, job);
+        set_json_response(res, job, 200);
+        return;
+    }
+
+    std::string failure_class = classify_failure(request_json, error_message);
+    if (retries_) {
+        retries_->schedule(job, failure_class, error_message, now_ms);
+    } else {
+        job["status"] = "failed_permanently";
+    }
+    job["error_message"] = error_message;
+    job["updated_at"] = now_ms;
+    if (tracer_) {
+        tracer_->end_attempt(job, request_json, now_ms, failure_class);
+    }
 
     if (!job["assigned_engine"].is_null()) {
         std::string engine_id = job["assigned_engine"];
@@ -95,5 +170,89 @@ void JobFailureHandler::handle(const httplib::Request& req, httplib::Response& r
     set_json_response(res, job, 200);
 }
 
+namespace {
+
+// Shared prologue of the suspend/resume reports: job lookup and engine_id
+bool parse_preemption_report(const httplib::Request& req, httplib::Response& res, IJobRepository& job_repo,
+                             nlohmann::json& job, nlohmann::json& request_json, std::string& engine_id) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
+        set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
+        return false;
+    }
+
+    try {
+        request_json = nlohmann::json::parse(req.body);
+    } catch (const nlohmann::json::parse_error& e) {
+        set_json_error_response(res, "Invalid JSON in request body", "json_parse_error", 400, e.what());
+        return false;
+    }
+    if (!request_json.is_object() || !request_json.contains("engine_id") || !request_json["engine_id"].is_string()) {
+        set_json_error_response(res, "Bad Request: 'engine_id' is missing or not a string.", "validation_error", 400);
+        return false;
+    }
+    engine_id = request_json["engine_id"];
+
+    job = job_repo.get_job(job_id);
+    if (job.is_null() || job.empty()) {
+        set_json_error_response(res, "Job not found", "not_found", 404, "Job ID: " + job_id);
+        return false;
+    }
+    return true;
+}
+
+int64_t now_millis() {
+    return wall_clock_ms();
+}
+
+} // namespace
+
+JobSuspendHandler::JobSuspendHandler(std::shared_ptr<AuthMiddleware> auth,
+                                     std::shared_ptr<IJobRepository> job_repo,
+                                     std::shared_ptr<PreemptionCoordinator> preemption)
+    : auth_(auth), job_repo_(job_repo), preemption_(preemption) {}
+
+void JobSuspendHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+
+    nlohmann::json job, request_json;
+    std::string engine_id;
+    if (!parse_preemption_report(req, res, *job_repo_, job, request_json, engine_id)) return;
+
+    int64_t now_ms = now_millis();
+    nlohmann::json checkpoint = request_json.value("checkpoint", nlohmann::json::object());
+    if (!preemption_->on_suspended(job, engine_id, checkpoint, now_ms)) {
+        set_json_error_response(res, "Job is not running on this engine", "conflict", 409,
+                                "Job ID: " + job.value("job_id", ""));
+        return;
+    }
+    job["updated_at"] = now_ms;
+    job_repo_->save_job(job["job_id"], job);
+    set_json_response(res, job, 200);
+}
+
+JobResumeHandler::JobResumeHandler(std::shared_ptr<AuthMiddleware> auth,
+                                   std::shared_ptr<IJobRepository> job_repo,
+                                   std::shared_ptr<PreemptionCoordinator> preemption)
+    : auth_(auth), job_repo_(job_repo), preemption_(preemption) {}
+
+void JobResumeHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+
+    nlohmann::json job, request_json;
+    std::string engine_id;
+    if (!parse_preemption_report(req, res, *job_repo_, job, request_json, engine_id)) return;
+
+    int64_t now_ms = now_millis();
+    if (!preemption_->on_resumed(job, engine_id, now_ms)) {
+        set_json_error_response(res, "Job is not suspended on this engine", "conflict", 409,
+                                "Job ID: " + job.value("job_id", ""));
+        return;
+    }
+    job["updated_at"] = now_ms;
+    job_repo_->save_job(job["job_id"], job);
+    set_json_response(res, job, 200);
+}
+
 } // namespace DispatchServer
 } // namespace distconv
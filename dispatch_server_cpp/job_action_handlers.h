@@ -4,6 +4,11 @@
 #include "request_handlers.h"
 #include "nlohmann/json.hpp"
 #include "repositories.h"
+#include "speculation.h"
+#include "preemption.h"
+#include "engine_health.h"
+#include "retry_policy.h"
+#include "job_tracing.h"
 #include <string>
 #include <memory>
 
@@ -11,31 +16,85 @@ namespace distconv {
 namespace DispatchServer {
 
 // Handler for POST /jobs/{id}/complete - Mark job as completed
+// With speculation, the first report wins; a later one from the other copy
+// (identified by "engine_id" in the body) gets 409.
+// With engine health tracking, the completion counts as a success of that engine.
+// With a tracer, the attempt's phases (from the body's "phases") are recorded.
 class JobCompletionHandler : public IRequestHandler {
 public:
     JobCompletionHandler(std::shared_ptr<AuthMiddleware> auth, 
                          std::shared_ptr<IJobRepository> job_repo,
-                         std::shared_ptr<IEngineRepository> engine_repo);
+                         std::shared_ptr<IEngineRepository> engine_repo,
+                         std::shared_ptr<SpeculationManager> speculation = nullptr,
+                         std::shared_ptr<EngineHealth> health = nullptr,
+                         std::shared_ptr<JobTracer> tracer = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<SpeculationManager> speculation_;
+    std::shared_ptr<EngineHealth> health_;
+    std::shared_ptr<JobTracer> tracer_;
 };
 
 // Handler for POST /jobs/{id}/fail - Mark job as failed
+// Body: {"engine_id", "error_message", "error_class", "phases"}; error_class (download,
+// transcode, upload) picks the retry policy and is guessed from the message
+// when absent. Without a RetryScheduler the job fails permanently.
+// A failure while a speculative copy runs only ends that one copy.
+// The failure counts against the reporting engine's health, and the job keeps
+// away from that engine for RETRY_ANTI_AFFINITY_WINDOW if it is retried.
 class JobFailureHandler : public IRequestHandler {
 public:
     JobFailureHandler(std::shared_ptr<AuthMiddleware> auth, 
                       std::shared_ptr<IJobRepository> job_repo,
-                      std::shared_ptr<IEngineRepository> engine_repo);
+                      std::shared_ptr<IEngineRepository> engine_repo,
+                      std::shared_ptr<SpeculationManager> speculation = nullptr,
+                      std::shared_ptr<EngineHealth> health = nullptr,
+                      std::shared_ptr<RetryScheduler> retries = nullptr,
+                      std::shared_ptr<JobTracer> tracer = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
     std::shared_ptr<IEngineRepository> engine_repo_;
+    std::shared_ptr<SpeculationManager> speculation_;
+    std::shared_ptr<EngineHealth> health_;
+    std::shared_ptr<RetryScheduler> retries_;
+    std::shared_ptr<JobTracer> tracer_;
+};
+
+// Handler for POST /jobs/{id}/suspend - Engine checkpointed the job to run an urgent one
+// Body: {"engine_id": "...", "checkpoint": {...}}; 409 unless the engine holds the job.
+class JobSuspendHandler : public IRequestHandler {
+public:
+    JobSuspendHandler(std::shared_ptr<AuthMiddleware> auth,
+                      std::shared_ptr<IJobRepository> job_repo,
+                      std::shared_ptr<PreemptionCoordinator> preemption);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
+};
+
+// Handler for POST /jobs/{id}/resume - Engine picked a suspended job back up
+// Body: {"engine_id": "..."}; 409 unless the job is suspended on that engine.
+class JobResumeHandler : public IRequestHandler {
+public:
+    JobResumeHandler(std::shared_ptr<AuthMiddleware> auth,
+                     std::shared_ptr<IJobRepository> job_repo,
+                     std::shared_ptr<PreemptionCoordinator> preemption);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
 };
 
 } // namespace DispatchServer
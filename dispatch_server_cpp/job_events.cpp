@@ -0,0 +1,242 @@
+#include "job_events.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+bool JobEventFilter::matches(const JobEvent& event) const {
+    if (!job_ids.empty() && job_ids.count(event.data.value("job_id", "")) == 0) {
+        return false;
+    }
+    if (!statuses.empty() && statuses.count(event.data.value("status", "")) == 0) {
+        return false;
+    }
+    if (!tenant.empty() && event.data.value("tenant", "") != tenant) {
+        return false;
+    }
+    return true;
+}
+
+JobEventBus::JobEventBus(size_t history_size, size_t queue_size, size_t max_subscribers)
+    : history_size_(history_size), queue_size_(queue_size), max_subscribers_(max_subscribers) {}
+
+void JobEventBus::publish(const std::string& type, const nlohmann::json& job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    JobEvent event{next_id_++, type, summarize(job)};
+
+    history_.push_back(event);
+    if (history_.size() > history_size_) {
+        history_.pop_front();
+    }
+
+    for (auto& subscriber : subscribers_) {
+        if (subscriber->lagged || !subscriber->filter.matches(event)) {
+            continue;
+        }
+        if (subscriber->pending.size() >= queue_size_) {
+            // Never block the write path on a slow reader
+            subscriber->lagged = true;
+            subscriber->pending.clear();
+        } else {
+            subscriber->pending.push_back(event);
+        }
+        subscriber->cv.notify_one();
+    }
+}
+
+std::shared_ptr<JobEventBus::Subscriber> JobEventBus::subscribe(const JobEventFilter& filter,
+                                                                uint64_t last_event_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_ || subscribers_.size() >= max_subscribers_) {
+        return nullptr;
+    }
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->filter = filter;
+    if (last_event_id > 0) {
+        for (const auto& event : history_) {
+            if (event.id > last_event_id && filter.matches(event)) {
+                subscriber->pending.push_back(event);
+            }
+        }
+    }
+    subscribers_.push_back(subscriber);
+    return subscriber;
+}
+
+void JobEventBus::unsubscribe(const std::shared_ptr<Subscriber>& subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.remove(subscriber);
+}
+
+bool JobEventBus::next(const std::shared_ptr<Subscriber>& subscriber,
+                       std::chrono::steady_clock::time_point deadline,
+                       std::vector<JobEvent>& events) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    subscriber->cv.wait_until(lock, deadline, [this, &subscriber] {
+        return !subscriber->pending.empty() || subscriber->lagged || closed_;
+    });
+    if (subscriber->lagged || closed_) {
+        return false;
+    }
+    events.assign(subscriber->pending.begin(), subscriber->pending.end());
+    subscriber->pending.clear();
+    return true;
+}
+
+void JobEventBus::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    for (auto& subscriber : subscribers_) {
+        subscriber->cv.notify_one();
+    }
+}
+
+void JobEventBus::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = false;
+}
+
+uint64_t JobEventBus::last_event_id() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_id_ - 1;
+}
+
+size_t JobEventBus::subscriber_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+nlohmann::json JobEventBus::summarize(const nlohmann::json& job) {
+    // Only the fields dashboards track; clients fetch /jobs/{id} for the rest
+    nlohmann::json data = nlohmann::json::object();
+    for (const char* key : {"job_id", "status", "tenant", "assigned_engine", "progress",
+                            "progress_message", "error_message", "output_url", "updated_at"}) {
+        if (job.contains(key) && !job[key].is_null()) {
+            data[key] = job[key];
+        }
+    }
+    return data;
+}
+
+// PublishingJobRepository Implementation
+
+PublishingJobRepository::PublishingJobRepository(std::shared_ptr<IJobRepository> inner,
+                                                 std::shared_ptr<JobEventBus> events,
+                                                 std::shared_ptr<ResourceVersions> versions)
+    : inner_(inner), events_(events), versions_(versions) {}
+
+void PublishingJobRepository::save_job(const std::string& job_id, const nlohmann::json& job) {
+    inner_->save_job(job_id, job);
+    changed(job_id);
+    events_->publish("job", job);
+}
+
+nlohmann::json PublishingJobRepository::get_job(const std::string& job_id) {
+    return inner_->get_job(job_id);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_all_jobs() {
+    return inner_->get_all_jobs();
+}
+
+bool PublishingJobRepository::job_exists(const std::string& job_id) {
+    return inner_->job_exists(job_id);
+}
+
+void PublishingJobRepository::remove_job(const std::string& job_id) {
+    inner_->remove_job(job_id);
+    changed(job_id);
+    events_->publish("job", {{"job_id", job_id}, {"status", "removed"}});
+}
+
+void PublishingJobRepository::clear_all_jobs() {
+    inner_->clear_all_jobs();
+    if (versions_) {
+        versions_->all_jobs_changed();
+    }
+}
+
+nlohmann::json PublishingJobRepository::get_next_pending_job(const std::vector<std::string>& capable_engines) {
+    return inner_->get_next_pending_job(capable_engines);
+}
+
+nlohmann::json PublishingJobRepository::get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) {
+    return inner_->get_next_pending_job_by_priority(capable_engines);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_pending_jobs(size_t limit) {
+    return inner_->get_pending_jobs(limit);
+}
+
+void PublishingJobRepository::mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) {
+    inner_->mark_job_as_failed_retry(job_id, retry_after_timestamp);
+    changed(job_id);
+    publish_current("job", job_id);
+}
+
+std::vector<std::string> PublishingJobRepository::get_stale_pending_jobs(int64_t timeout_seconds) {
+    return inner_->get_stale_pending_jobs(timeout_seconds);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_jobs_to_timeout(int timeout_minutes) {
+    return inner_->get_jobs_to_timeout(timeout_minutes);
+}
+
+bool PublishingJobRepository::update_job(const std::string& job_id, const nlohmann::json& updates) {
+    if (!inner_->update_job(job_id, updates)) {
+        return false;
+    }
+    changed(job_id);
+    publish_current("job", job_id);
+    return true;
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_jobs_by_engine(const std::string& engine_id) {
+    return inner_->get_jobs_by_engine(engine_id);
+}
+
+bool PublishingJobRepository::update_job_progress(const std::string& job_id, int progress, const std::string& message) {
+    if (!inner_->update_job_progress(job_id, progress, message)) {
+        return false;
+    }
+    changed(job_id);
+    publish_current("progress", job_id);
+    return true;
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_jobs_by_status(const std::string& status) {
+    return inner_->get_jobs_by_status(status);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_timed_out_jobs(int64_t older_than_timestamp) {
+    return inner_->get_timed_out_jobs(older_than_timestamp);
+}
+
+std::map<std::string, size_t> PublishingJobRepository::count_jobs_by_tenant(const std::string& status) {
+    return inner_->count_jobs_by_tenant(status);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_pending_jobs_by_size_class(const std::string& size_class,
+                                                                                    size_t limit) {
+    return inner_->get_pending_jobs_by_size_class(size_class, limit);
+}
+
+std::vector<nlohmann::json> PublishingJobRepository::get_jobs_updated_since(int64_t timestamp_ms) {
+    return inner_->get_jobs_updated_since(timestamp_ms);
+}
+
+void PublishingJobRepository::changed(const std::string& job_id) {
+    if (versions_) {
+        versions_->job_changed(job_id);
+    }
+}
+
+void PublishingJobRepository::publish_current(const std::string& type, const std::string& job_id) {
+    nlohmann::json job = inner_->get_job(job_id);
+    if (!job.is_null() && !job.empty()) {
+        events_->publish(type, job);
+    }
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,126 @@
+#ifndef JOB_EVENTS_H
+#define JOB_EVENTS_H
+
+#include "repositories.h"
+#include "resource_versions.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// A job state or progress transition as delivered to /events subscribers
+struct JobEvent {
+    uint64_t id = 0;
+    std::string type; // "job" (state change) or "progress"
+    nlohmann::json data;
+};
+
+// Subscriber-side filter; empty sets match everything
+struct JobEventFilter {
+    std::set<std::string> job_ids;
+    std::set<std::string> statuses;
+    std::string tenant;
+
+    bool matches(const JobEvent& event) const;
+};
+
+// In-process pub/sub for job transitions. Keeps a bounded history so clients
+// can resume with Last-Event-ID, and bounded per-subscriber queues: a
+// subscriber that falls behind is dropped and must resume from history.
+class JobEventBus {
+public:
+    struct Subscriber {
+        JobEventFilter filter;
+        std::deque<JobEvent> pending;
+        bool lagged = false;
+        std::condition_variable cv;
+    };
+
+    JobEventBus(size_t history_size, size_t queue_size, size_t max_subscribers);
+
+    void publish(const std::string& type, const nlohmann::json& job);
+
+    // Returns nullptr when full or closed. Events newer than last_event_id
+    // still held in history are queued immediately.
+    std::shared_ptr<Subscriber> subscribe(const JobEventFilter& filter, uint64_t last_event_id = 0);
+    void unsubscribe(const std::shared_ptr<Subscriber>& subscriber);
+
+    // Waits until events are queued, the deadline passes or the subscriber is
+    // dropped. Returns false once the stream should end (lagged or closed).
+    bool next(const std::shared_ptr<Subscriber>& subscriber,
+              std::chrono::steady_clock::time_point deadline,
+              std::vector<JobEvent>& events);
+
+    void close();
+    void open();
+
+    uint64_t last_event_id() const;
+    size_t subscriber_count() const;
+
+private:
+    static nlohmann::json summarize(const nlohmann::json& job);
+
+    const size_t history_size_;
+    const size_t queue_size_;
+    const size_t max_subscribers_;
+    mutable std::mutex mutex_;
+    std::deque<JobEvent> history_;
+    std::list<std::shared_ptr<Subscriber>> subscribers_;
+    uint64_t next_id_ = 1;
+    bool closed_ = false;
+};
+
+// Decorates a job repository so every write path publishes into the bus and,
+// when given, bumps the job's ETag version
+class PublishingJobRepository : public IJobRepository {
+public:
+    PublishingJobRepository(std::shared_ptr<IJobRepository> inner, std::shared_ptr<JobEventBus> events,
+                            std::shared_ptr<ResourceVersions> versions = nullptr);
+
+    void save_job(const std::string& job_id, const nlohmann::json& job) override;
+    nlohmann::json get_job(const std::string& job_id) override;
+    std::vector<nlohmann::json> get_all_jobs() override;
+    bool job_exists(const std::string& job_id) override;
+    void remove_job(const std::string& job_id) override;
+    void clear_all_jobs() override;
+
+    nlohmann::json get_next_pending_job(const std::vector<std::string>& capable_engines) override;
+    nlohmann::json get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) override;
+    std::vector<nlohmann::json> get_pending_jobs(size_t limit) override;
+    void mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) override;
+    std::vector<std::string> get_stale_pending_jobs(int64_t timeout_seconds) override;
+    std::vector<nlohmann::json> get_jobs_to_timeout(int timeout_minutes) override;
+
+    bool update_job(const std::string& job_id, const nlohmann::json& updates) override;
+    std::vector<nlohmann::json> get_jobs_by_engine(const std::string& engine_id) override;
+    bool update_job_progress(const std::string& job_id, int progress, const std::string& message) override;
+    std::vector<nlohmann::json> get_jobs_by_status(const std::string& status) override;
+
+    std::vector<nlohmann::json> get_timed_out_jobs(int64_t older_than_timestamp) override;
+    std::map<std::string, size_t> count_jobs_by_tenant(const std::string& status) override;
+    std::vector<nlohmann::json> get_pending_jobs_by_size_class(const std::string& size_class, size_t limit) override;
+    std::vector<nlohmann::json> get_jobs_updated_since(int64_t timestamp_ms) override;
+
+private:
+    void publish_current(const std::string& type, const std::string& job_id);
+    void changed(const std::string& job_id);
+
+    std::shared_ptr<IJobRepository> inner_;
+    std::shared_ptr<JobEventBus> events_;
+    std::shared_ptr<ResourceVersions> versions_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // JOB_EVENTS_H
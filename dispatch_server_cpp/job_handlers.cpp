@@ -1,6 +1,10 @@
 #include "job_handlers.h"
+#include "wall_clock.h"
 #include "dispatch_server_core.h"
 #include "dispatch_server_constants.h"
+#include "resource_packing.h"
+#include "size_lanes.h"
+#include "job_tracing.h"
 #include <chrono>
 #include <mutex>
 
@@ -12,8 +16,11 @@ extern std::string generate_uuid();
 
 using namespace Constants;
 
-JobSubmissionHandler::JobSubmissionHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo)
-    : auth_(auth), job_repo_(job_repo) {}
+JobSubmissionHandler::JobSubmissionHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                                           std::shared_ptr<AssignmentWaiterRegistry> waiters,
+                                           std::shared_ptr<AdmissionController> admission,
+                                           std::shared_ptr<DeadlineMonitor> deadlines)
+    : auth_(auth), job_repo_(job_repo), waiters_(waiters), admission_(admission), deadlines_(deadlines) {}
 
 void JobSubmissionHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
@@ -30,8 +37,29 @@ void JobSubmissionHandler::handle(const httplib::Request& req, httplib::Response
     
     try {
         nlohmann::json job = create_job(request_json);
+        job["trace"] = start_job_trace(req.get_header_value("traceparent"));
+        if (admission_) {
+            std::string tenant = job.value("tenant", "");
+            auto decision = admission_->admit(tenant, job["created_at"].get<int64_t>());
+            if (decision.outcome == AdmissionDecision::Outcome::Reject) {
+                res.set_header("Retry-After", std::to_string(decision.retry_after_seconds));
+                set_json_error_response(res, "Too Many Requests: pending job limit reached", "rate_limited", 429,
+                                        decision.limit == "tenant" ? "Tenant: " + tenant : "Limit: global");
+                return;
+            }
+            if (decision.outcome == AdmissionDecision::Outcome::Deprioritize) {
+                job["admission"] = {{"state", "deprioritized"}, {"limit", decision.limit},
+                                    {"requested_priority", job["priority"]}};
+                job["priority"] = PRIORITY_LOW;
+            }
+        }
+        if (deadlines_) {
+            deadlines_->assess(job, job["created_at"].get<int64_t>());
+        }
         job_repo_->save_job(job["job_id"], job);
+        if (waiters_) waiters_->notify_job_available(job);
         set_json_response(res, job, 200);
+        res.set_header("traceparent", job_traceparent(job));
     } catch (const std::exception& e) {
         set_json_error_response(res, "Internal server error", "server_error", 500, e.what());
     }
@@ -46,19 +74,32 @@ bool JobSubmissionHandler::validate_job_input(const nlohmann::json& input, httpl
         set_json_error_response(res, "Bad Request: 'target_codec' is missing or not a string.", "validation_error", 400);
         return false;
     }
+    if (input.contains("resource_requirements")) {
+        std::string problem = validate_resource_requirements(input["resource_requirements"]);
+        if (!problem.empty()) {
+            set_json_error_response(res, "Bad Request: " + problem, "validation_error", 400);
+            return false;
+        }
+    }
+    int64_t deadline_ms = 0;
+    if (input.contains("deadline") && !parse_deadline(input["deadline"], deadline_ms)) {
+        set_json_error_response(res, "Bad Request: 'deadline' must be epoch milliseconds or an ISO 8601 timestamp.",
+                                "validation_error", 400);
+        return false;
+    }
     return true;
 }
 
 nlohmann::json JobSubmissionHandler::create_job(const nlohmann::json& input) {
     std::string job_id = generate_uuid();
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
     
     nlohmann::json job;
     job["job_id"] = job_id;
     job["source_url"] = input["source_url"];
     job["target_codec"] = input["target_codec"];
     job["job_size"] = input.value("job_size", 0.0);
+    job["size_class"] = size_class_name(classify_job_size(job["job_size"].get<double>()));
     job["status"] = "pending";
     job["assigned_engine"] = nullptr;
     job["output_url"] = nullptr;
@@ -66,24 +107,40 @@ nlohmann::json JobSubmissionHandler::create_job(const nlohmann::json& input) {
     job["max_retries"] = input.value("max_retries", DEFAULT_MAX_RETRIES);
     job["priority"] = input.value("priority", PRIORITY_NORMAL);
     job["resource_requirements"] = input.value("resource_requirements", nlohmann::json::object());
+    if (input.contains("tenant") && input["tenant"].is_string()) {
+        job["tenant"] = input["tenant"];
+    }
+    int64_t deadline_ms = 0;
+    if (input.contains("deadline") && parse_deadline(input["deadline"], deadline_ms)) {
+        job["deadline"] = deadline_ms;
+        job["latest_start"] = deadline_ms; // Refined by the deadline monitor once a runtime is predicted
+    }
     job["created_at"] = now_ms;
     job["updated_at"] = now_ms;
     
     return job;
 }
 
-JobStatusHandler::JobStatusHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo)
-    : auth_(auth), job_repo_(job_repo) {}
+JobStatusHandler::JobStatusHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                                   std::shared_ptr<ResourceVersions> versions)
+    : auth_(auth), job_repo_(job_repo), versions_(versions) {}
 
 void JobStatusHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
         return;
     }
-    std::string job_id = req.matches[1];
+    std::string etag = versions_ ? versions_->job_etag(job_id) : "";
+    if (!etag.empty() && etag_matches(req, etag)) {
+        res.status = 304;
+        res.set_header("ETag", etag);
+        return;
+    }
     nlohmann::json job = job_repo_->get_job(job_id);
     if (!job.is_null() && !job.empty()) {
+        if (!etag.empty()) res.set_header("ETag", etag);
         set_json_response(res, job, 200);
     } else {
         res.status = 404;
@@ -104,16 +161,17 @@ void JobListHandler::handle(const httplib::Request& req, httplib::Response& res)
     set_json_response(res, all_jobs, 200);
 }
 
-JobRetryHandler::JobRetryHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo)
-    : auth_(auth), job_repo_(job_repo) {}
+JobRetryHandler::JobRetryHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                                 std::shared_ptr<AssignmentWaiterRegistry> waiters)
+    : auth_(auth), job_repo_(job_repo), waiters_(waiters) {}
 
 void JobRetryHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
         return;
     }
-    std::string job_id = req.matches[1];
     nlohmann::json job = job_repo_->get_job(job_id);
     if (job.is_null() || job.empty()) {
         res.status = 404;
@@ -126,8 +184,12 @@ void JobRetryHandler::handle(const httplib::Request& req, httplib::Response& res
         job["status"] = "pending";
         job["retries"] = 0;
         job["assigned_engine"] = nullptr;
-        job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        job["updated_at"] = wall_clock_ms();
+        if (job.contains("trace") && job["trace"].is_object()) {
+            job["trace"]["queued_since"] = job["updated_at"]; // The next attempt queues from here
+        }
         job_repo_->save_job(job_id, job);
+        if (waiters_) waiters_->notify_job_available(job);
         set_json_response(res, job, 200);
     } else {
         set_json_error_response(res, "Job is not in a failed or cancelled state", "validation_error", 400, "Job ID: " + job_id);
@@ -141,11 +203,11 @@ JobCancelHandler::JobCancelHandler(std::shared_ptr<AuthMiddleware> auth,
 
 void JobCancelHandler::handle(const httplib::Request& req, httplib::Response& res) {
     if (!auth_->authenticate(req, res)) return;
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Internal Server Error: Job ID not found in path", "server_error", 500);
         return;
     }
-    std::string job_id = req.matches[1];
     nlohmann::json job = job_repo_->get_job(job_id);
     if (job.is_null() || job.empty()) {
         res.status = 404;
@@ -156,7 +218,7 @@ void JobCancelHandler::handle(const httplib::Request& req, httplib::Response& re
     std::string status = job.value("status", "");
     if (status != "completed" && status != "failed_permanently" && status != "cancelled") {
         job["status"] = "cancelled";
-        job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        job["updated_at"] = wall_clock_ms();
         
         if (!job["assigned_engine"].is_null()) {
             std::string engine_id = job["assigned_engine"];
@@ -4,6 +4,10 @@
 #include "request_handlers.h"
 #include "nlohmann/json.hpp"
 #include "repositories.h"
+#include "assignment_waiters.h"
+#include "admission_control.h"
+#include "deadline_monitor.h"
+#include "resource_versions.h"
 #include <string>
 #include <memory>
 
@@ -11,14 +15,27 @@ namespace distconv {
 namespace DispatchServer {
 
 // Handler for POST /jobs/ - Job submission
+// With admission control, a job over a pending limit is refused with 429 and
+// Retry-After, or accepted at PRIORITY_LOW when the limits are soft.
+// An optional "deadline" (epoch ms or ISO 8601) schedules the job earliest
+// deadline first within its priority; the deadline monitor flags it at
+// submission when it is forecast to finish late.
+// Every job gets a "trace" (see job_tracing.h), continuing the submitter's
+// traceparent header when it sends one; the response's traceparent names the job.
 class JobSubmissionHandler : public IRequestHandler {
 public:
-    JobSubmissionHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo);
+    JobSubmissionHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                         std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr,
+                         std::shared_ptr<AdmissionController> admission = nullptr,
+                         std::shared_ptr<DeadlineMonitor> deadlines = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<AssignmentWaiterRegistry> waiters_;
+    std::shared_ptr<AdmissionController> admission_;
+    std::shared_ptr<DeadlineMonitor> deadlines_;
     
     // Validation helper
     bool validate_job_input(const nlohmann::json& input, httplib::Response& res);
@@ -27,15 +44,18 @@ private:
     nlohmann::json create_job(const nlohmann::json& input);
 };
 
-// Handler for GET /jobs/{id} - Get job status
+// Handler for GET /jobs/{id} - Get job status. Tagged with the job's ETag;
+// a matching If-None-Match gets 304 without reading the repository.
 class JobStatusHandler : public IRequestHandler {
 public:
-    JobStatusHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo);
+    JobStatusHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                     std::shared_ptr<ResourceVersions> versions = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<ResourceVersions> versions_;
 };
 
 // Handler for GET /jobs/ - List all jobs
@@ -52,12 +72,14 @@ private:
 // Handler for POST /jobs/{id}/retry
 class JobRetryHandler : public IRequestHandler {
 public:
-    JobRetryHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo);
+    JobRetryHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                    std::shared_ptr<AssignmentWaiterRegistry> waiters = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
     
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<AssignmentWaiterRegistry> waiters_;
 };
 
 // Handler for POST /jobs/{id}/cancel
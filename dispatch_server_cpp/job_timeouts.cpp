@@ -0,0 +1,102 @@
+#include "job_timeouts.h"
+#include <algorithm>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+// Engines are not judged faster or slower than this relative to the cluster
+constexpr double MIN_SPEED_FACTOR = 0.5;
+constexpr double MAX_SPEED_FACTOR = 4.0;
+
+int64_t integer_field(const nlohmann::json& object, const char* key) {
+    return object.is_object() && object.contains(key) && object[key].is_number_integer()
+               ? object[key].get<int64_t>() : 0;
+}
+
+std::string assigned_engine(const nlohmann::json& job) {
+    return job.contains("assigned_engine") && job["assigned_engine"].is_string()
+               ? job["assigned_engine"].get<std::string>() : "";
+}
+
+} // namespace
+
+JobTimeouts::JobTimeouts(std::shared_ptr<IJobRepository> job_repo, std::shared_ptr<RuntimeEstimator> estimator,
+                         std::shared_ptr<EngineHealth> health, JobTimeoutPolicy policy)
+    : job_repo_(job_repo), estimator_(estimator), health_(health), policy_(policy) {}
+
+void JobTimeouts::set_policy(const JobTimeoutPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+JobTimeoutPolicy JobTimeouts::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+int64_t JobTimeouts::timeout_ms(const nlohmann::json& job) const {
+    JobTimeoutPolicy policy = this->policy();
+    std::string engine_id = assigned_engine(job);
+    double engine_rate = 0;
+    bool engine_known = health_ && !engine_id.empty() && health_->throughput(engine_id, engine_rate) &&
+                        engine_rate > 0;
+
+    double predicted_ms = 0;
+    int64_t estimate = 0;
+    if (estimator_ && estimator_->predict(job, estimate)) {
+        predicted_ms = static_cast<double>(estimate);
+        double cluster_rate = 0;
+        if (engine_known && health_->cluster_throughput(cluster_rate) && cluster_rate > 0) {
+            predicted_ms *= std::clamp(cluster_rate / engine_rate, MIN_SPEED_FACTOR, MAX_SPEED_FACTOR);
+        }
+    } else if (engine_known && job.contains("job_size") && job["job_size"].is_number() &&
+               job["job_size"].get<double>() > 0) {
+        predicted_ms = job["job_size"].get<double>() / engine_rate * 1000.0;
+    } else {
+        return policy.fallback.count();
+    }
+
+    double timeout = predicted_ms * policy.safety_factor;
+    return static_cast<int64_t>(std::clamp(timeout, static_cast<double>(policy.min_timeout.count()),
+                                           static_cast<double>(policy.max_timeout.count())));
+}
+
+std::string JobTimeouts::check(const nlohmann::json& job, int64_t now_ms) const {
+    int64_t assigned_at = integer_field(job, "assigned_at");
+    if (assigned_at == 0) {
+        assigned_at = integer_field(job, "updated_at");
+    }
+    const nlohmann::json preemption = job.value("preemption", nlohmann::json::object());
+    int64_t running_ms = now_ms - assigned_at - integer_field(preemption, "suspended_ms");
+    if (running_ms > timeout_ms(job)) {
+        return "timeout";
+    }
+
+    // Progress from an earlier run of the job says nothing about this one
+    int64_t progress_at = integer_field(job, "progress_at");
+    int64_t since = std::max(assigned_at, integer_field(preemption, "resumed_at"));
+    int64_t stall_ms = policy().progress_stall.count();
+    if (stall_ms > 0 && progress_at > 0 && progress_at >= assigned_at &&
+        now_ms - std::max(progress_at, since) > stall_ms) {
+        return "stalled";
+    }
+    return "";
+}
+
+std::vector<std::pair<nlohmann::json, std::string>> JobTimeouts::expired(int64_t now_ms) const {
+    std::vector<std::pair<nlohmann::json, std::string>> result;
+    for (const char* status : {"assigned", "processing"}) {
+        for (auto& job : job_repo_->get_jobs_by_status(status)) {
+            std::string reason = check(job, now_ms);
+            if (!reason.empty()) {
+                result.emplace_back(std::move(job), reason);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,66 @@
+#ifndef JOB_TIMEOUTS_H
+#define JOB_TIMEOUTS_H
+
+#include "repositories.h"
+#include "runtime_estimator.h"
+#include "engine_health.h"
+#include "dispatch_server_constants.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+struct JobTimeoutPolicy {
+    double safety_factor = Constants::JOB_TIMEOUT_SAFETY_FACTOR; // Times the predicted runtime
+    std::chrono::milliseconds min_timeout = Constants::JOB_TIMEOUT_MIN;
+    std::chrono::milliseconds max_timeout = Constants::JOB_TIMEOUT_MAX;
+    std::chrono::milliseconds fallback = Constants::JOB_TIMEOUT;             // Nothing learned about the job yet
+    std::chrono::milliseconds progress_stall = Constants::JOB_PROGRESS_STALL_TIMEOUT; // 0 = off
+};
+
+// Per-job timeouts for the background worker's timeout sweep.
+//
+// A running job may run for its predicted runtime times the safety factor.
+// The prediction is the runtime estimator's (codec history scaled by
+// job_size), scaled by how the engine's throughput compares with the
+// cluster's median. Without a prediction, the size is divided by the engine's
+// own throughput. With neither, the fallback applies. Time spent suspended
+// for preemption does not count. A job that has reported progress on this
+// run also times out once no report has come in for progress_stall.
+class JobTimeouts {
+public:
+    JobTimeouts(std::shared_ptr<IJobRepository> job_repo, std::shared_ptr<RuntimeEstimator> estimator,
+                std::shared_ptr<EngineHealth> health, JobTimeoutPolicy policy = {});
+
+    void set_policy(const JobTimeoutPolicy& policy);
+    JobTimeoutPolicy policy() const;
+
+    // Run time the job is allowed on its assigned engine
+    int64_t timeout_ms(const nlohmann::json& job) const;
+
+    // "timeout" or "stalled" when the job is past its allowance, else empty
+    std::string check(const nlohmann::json& job, int64_t now_ms) const;
+
+    // Assigned and processing jobs that check() flags, with the reason
+    std::vector<std::pair<nlohmann::json, std::string>> expired(int64_t now_ms) const;
+
+private:
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<RuntimeEstimator> estimator_;
+    std::shared_ptr<EngineHealth> health_;
+
+    mutable std::mutex mutex_;
+    JobTimeoutPolicy policy_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // JOB_TIMEOUTS_H
@@ -0,0 +1,339 @@
+#include "job_tracing.h"
+#include "httplib.h"
+#include "structured_log.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <random>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+const char* const PHASES[] = {"queued", "assignment", "download", "transcode", "upload", "report", "engine"};
+const char* const ENGINE_PHASES[] = {"download", "transcode", "upload"};
+
+bool is_lower_hex(const std::string& text, size_t pos, size_t length) {
+    for (size_t i = pos; i < pos + length; ++i) {
+        char c = text[i];
+        if (!(std::isdigit(static_cast<unsigned char>(c)) || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+// Trace and span ids of all zeros are invalid
+bool is_id(const std::string& text, size_t pos, size_t length) {
+    return is_lower_hex(text, pos, length) && text.find_first_not_of('0', pos) < pos + length;
+}
+
+std::string random_hex(size_t bytes) {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    while (out.size() < bytes * 2) {
+        uint64_t bits = rng();
+        for (int i = 0; i < 16 && out.size() < bytes * 2; ++i, bits >>= 4) {
+            out += digits[bits & 0xf];
+        }
+    }
+    // All-zero ids are invalid; vanishingly unlikely, but cheap to rule out
+    if (out.find_first_not_of('0') == std::string::npos) out[0] = '1';
+    return out;
+}
+
+std::string unix_nanos(int64_t ms) {
+    return std::to_string(ms * 1000000);
+}
+
+nlohmann::json string_attribute(const std::string& key, const std::string& value) {
+    return {{"key", key}, {"value", {{"stringValue", value}}}};
+}
+
+nlohmann::json int_attribute(const std::string& key, int64_t value) {
+    // OTLP JSON carries 64-bit integers as strings
+    return {{"key", key}, {"value", {{"intValue", std::to_string(value)}}}};
+}
+
+struct Phase {
+    std::string name;
+    int64_t start_ms;
+    int64_t end_ms;
+};
+
+// Engine-reported {"start_ms", "end_ms"} of one phase
+bool reported_phase(const nlohmann::json& report, const char* name, Phase& phase) {
+    if (!report.is_object() || !report.contains("phases") || !report["phases"].is_object()) return false;
+    const auto& phases = report["phases"];
+    if (!phases.contains(name) || !phases[name].is_object()) return false;
+    const auto& times = phases[name];
+    if (!times.contains("start_ms") || !times["start_ms"].is_number() || !times.contains("end_ms") ||
+        !times["end_ms"].is_number()) {
+        return false;
+    }
+    phase = {name, times["start_ms"].get<int64_t>(), times["end_ms"].get<int64_t>()};
+    return true;
+}
+
+} // namespace
+
+bool parse_traceparent(const std::string& header, std::string& trace_id, std::string& parent_span_id) {
+    // version "-" trace-id "-" parent-id "-" flags; later versions may append fields
+    if (header.size() < 55 || header[2] != '-' || header[35] != '-' || header[52] != '-') return false;
+    std::string version = header.substr(0, 2);
+    if (!is_lower_hex(header, 0, 2) || version == "ff") return false;
+    if ((version == "00" && header.size() != 55) || (header.size() > 55 && header[55] != '-')) return false;
+    if (!is_id(header, 3, 32) || !is_id(header, 36, 16) || !is_lower_hex(header, 53, 2)) return false;
+    trace_id = header.substr(3, 32);
+    parent_span_id = header.substr(36, 16);
+    return true;
+}
+
+nlohmann::json start_job_trace(const std::string& traceparent) {
+    std::string trace_id;
+    std::string parent_span_id;
+    nlohmann::json trace;
+    if (parse_traceparent(traceparent, trace_id, parent_span_id)) {
+        trace["trace_id"] = trace_id;
+        trace["parent_span_id"] = parent_span_id;
+    } else {
+        trace["trace_id"] = random_hex(16);
+    }
+    trace["span_id"] = random_hex(8);
+    return trace;
+}
+
+std::string job_traceparent(const nlohmann::json& job) {
+    if (!job.contains("trace") || !job["trace"].is_object()) return "";
+    const auto& trace = job["trace"];
+    if (!trace.contains("trace_id") || !trace["trace_id"].is_string() || !trace.contains("span_id") ||
+        !trace["span_id"].is_string()) {
+        return "";
+    }
+    return "00-" + trace["trace_id"].get<std::string>() + "-" + trace["span_id"].get<std::string>() + "-01";
+}
+
+const std::vector<double>& phase_buckets() {
+    static const std::vector<double> bounds = {0.01, 0.05, 0.1, 0.5, 1, 5, 15, 30, 60, 300, 900, 1800, 3600,
+                                               7200, 14400};
+    return bounds;
+}
+
+SpanExporter::SpanExporter(TraceExportOptions options, std::shared_ptr<MetricsRegistry> metrics)
+    : options_(std::move(options)) {
+    if (!options_.endpoint.empty()) {
+        size_t scheme = options_.endpoint.find("://");
+        size_t path = options_.endpoint.find('/', scheme == std::string::npos ? 0 : scheme + 3);
+        endpoint_base_ = options_.endpoint.substr(0, path);
+        endpoint_path_ = path == std::string::npos ? "/v1/traces" : options_.endpoint.substr(path);
+    }
+    if (metrics) {
+        dropped_ = &metrics->counter("dispatch_trace_batches_dropped_total",
+                                     "Span batches dropped because the export queue was full");
+        failed_ = &metrics->counter("dispatch_trace_export_failures_total",
+                                    "Span batches the trace file or collector did not accept");
+    }
+    worker_ = std::thread([this]() { run(); });
+}
+
+SpanExporter::~SpanExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void SpanExporter::export_spans(nlohmann::json spans) {
+    if (!spans.is_array() || spans.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= Constants::TRACE_EXPORT_QUEUE_SIZE) {
+            if (dropped_) dropped_->inc();
+            return;
+        }
+        queue_.push_back(std::move(spans));
+    }
+    work_cv_.notify_one();
+}
+
+void SpanExporter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+}
+
+void SpanExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) break; // Stopping with nothing left to write
+        // Everything queued goes out as one request
+        nlohmann::json spans = nlohmann::json::array();
+        while (!queue_.empty()) {
+            for (auto& span : queue_.front()) spans.push_back(std::move(span));
+            queue_.pop_front();
+        }
+        writing_ = true;
+        lock.unlock();
+        nlohmann::json scope_spans = {{"scope", {{"name", "distconv.dispatch"}}}, {"spans", std::move(spans)}};
+        nlohmann::json resource = {
+            {"attributes", nlohmann::json::array({string_attribute("service.name", "distconv-dispatcher")})}};
+        nlohmann::json request = {{"resourceSpans", nlohmann::json::array()}};
+        request["resourceSpans"].push_back({{"resource", resource},
+                                            {"scopeSpans", nlohmann::json::array({scope_spans})}});
+        write(request);
+        lock.lock();
+        writing_ = false;
+        idle_cv_.notify_all();
+    }
+}
+
+void SpanExporter::write(const nlohmann::json& request) {
+    std::string body = request.dump();
+    if (!options_.file.empty()) {
+        std::ofstream out(options_.file, std::ios::app);
+        out << body << '\n';
+        if (!out) {
+            logging::error("tracing", "Failed to write spans", {{"file", options_.file}});
+            if (failed_) failed_->inc();
+        }
+    }
+    if (!endpoint_base_.empty()) {
+        httplib::Client client(endpoint_base_);
+        auto timeout = std::chrono::duration_cast<std::chrono::seconds>(Constants::TRACE_EXPORT_TIMEOUT).count();
+        client.set_connection_timeout(timeout);
+        client.set_read_timeout(timeout);
+        auto res = client.Post(endpoint_path_, body, "application/json");
+        // A collector restarting (or a spurious resolver failure) only costs a short wait
+        for (int attempt = 1; !res && res.error() == httplib::Error::Connection &&
+                              attempt < Constants::TRACE_EXPORT_ATTEMPTS; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100 * attempt));
+            res = client.Post(endpoint_path_, body, "application/json");
+        }
+        if (!res || res->status / 100 != 2) {
+            logging::error("tracing", "Trace collector did not accept spans",
+                           {{"endpoint", options_.endpoint},
+                            {"status", res ? std::to_string(res->status) : httplib::to_string(res.error())}});
+            if (failed_) failed_->inc();
+        }
+    }
+}
+
+JobTracer::JobTracer(std::shared_ptr<MetricsRegistry> metrics) : metrics_(std::move(metrics)) {
+    if (metrics_) {
+        for (const char* phase : PHASES) {
+            phase_seconds_[phase] = &metrics_->histogram("dispatch_job_phase_seconds",
+                                                         "Time jobs spend in each phase of an attempt",
+                                                         phase_buckets(), {{"phase", phase}});
+        }
+    }
+}
+
+void JobTracer::set_exporter(std::shared_ptr<SpanExporter> exporter) {
+    std::lock_guard<std::mutex> lock(exporter_mutex_);
+    exporter_ = std::move(exporter);
+}
+
+void JobTracer::end_attempt(nlohmann::json& job, const nlohmann::json& report, int64_t now_ms,
+                            const std::string& failure_class) {
+    // Jobs submitted before tracing get a trace from here on
+    if (!job.contains("trace") || !job["trace"].is_object() || !job["trace"].contains("span_id")) {
+        job["trace"] = start_job_trace("");
+    }
+    nlohmann::json& trace = job["trace"];
+    int attempt = trace.value("attempts", 0) + 1;
+    trace["attempts"] = attempt;
+
+    int64_t created_at = job.contains("created_at") && job["created_at"].is_number()
+                             ? job["created_at"].get<int64_t>() : now_ms;
+    int64_t queued_since = trace.contains("queued_since") && trace["queued_since"].is_number()
+                               ? trace["queued_since"].get<int64_t>() : created_at;
+    int64_t assigned_at = job.contains("assigned_at") && job["assigned_at"].is_number()
+                              ? job["assigned_at"].get<int64_t>() : 0;
+
+    std::vector<Phase> engine_phases;
+    for (const char* name : ENGINE_PHASES) {
+        Phase phase;
+        if (reported_phase(report, name, phase)) engine_phases.push_back(phase);
+    }
+
+    std::vector<Phase> phases;
+    if (assigned_at > 0) {
+        phases.push_back({"queued", queued_since, assigned_at});
+    }
+    if (!engine_phases.empty()) {
+        if (assigned_at > 0) {
+            phases.push_back({"assignment", assigned_at, engine_phases.front().start_ms});
+        }
+        phases.insert(phases.end(), engine_phases.begin(), engine_phases.end());
+        phases.push_back({"report", engine_phases.back().end_ms, now_ms});
+    } else if (assigned_at > 0) {
+        phases.push_back({"engine", assigned_at, now_ms});
+    }
+
+    std::string engine_id = job.contains("assigned_engine") && job["assigned_engine"].is_string()
+                                ? job["assigned_engine"].get<std::string>() : "";
+    std::string status = job.value("status", "");
+    bool finished = status == "completed" || status == "failed_permanently";
+    std::string trace_id = trace.value("trace_id", "");
+    std::string root_span_id = trace.value("span_id", "");
+
+    if (!trace.contains("phases") || !trace["phases"].is_array()) {
+        trace["phases"] = nlohmann::json::array();
+    }
+    nlohmann::json spans = nlohmann::json::array();
+    for (auto& phase : phases) {
+        phase.end_ms = std::max(phase.end_ms, phase.start_ms);
+        trace["phases"].push_back({{"name", phase.name}, {"attempt", attempt},
+                                   {"start_ms", phase.start_ms}, {"end_ms", phase.end_ms}});
+        auto histogram = phase_seconds_.find(phase.name);
+        if (histogram != phase_seconds_.end()) {
+            histogram->second->observe((phase.end_ms - phase.start_ms) / 1000.0);
+        }
+
+        nlohmann::json attributes = nlohmann::json::array({string_attribute("job.id", job.value("job_id", "")),
+                                                           int_attribute("job.attempt", attempt)});
+        if (!engine_id.empty()) attributes.push_back(string_attribute("engine.id", engine_id));
+        bool failed_here = !failure_class.empty() && failure_class == phase.name;
+        nlohmann::json span_status = failed_here
+            ? nlohmann::json{{"code", 2}, {"message", job.value("error_message", failure_class + " failed")}}
+            : nlohmann::json{{"code", 1}};
+        spans.push_back({{"traceId", trace_id}, {"spanId", random_hex(8)}, {"parentSpanId", root_span_id},
+                         {"name", phase.name}, {"kind", 1}, {"startTimeUnixNano", unix_nanos(phase.start_ms)},
+                         {"endTimeUnixNano", unix_nanos(phase.end_ms)}, {"attributes", attributes},
+                         {"status", span_status}});
+    }
+
+    if (finished) {
+        trace.erase("queued_since");
+        nlohmann::json root = {{"traceId", trace_id}, {"spanId", root_span_id}, {"name", "job"}, {"kind", 1},
+                               {"startTimeUnixNano", unix_nanos(created_at)},
+                               {"endTimeUnixNano", unix_nanos(std::max(now_ms, created_at))},
+                               {"attributes", nlohmann::json::array({
+                                   string_attribute("job.id", job.value("job_id", "")),
+                                   string_attribute("job.status", status),
+                                   string_attribute("job.target_codec", job.value("target_codec", "")),
+                                   int_attribute("job.attempts", attempt)})},
+                               {"status", status == "completed"
+                                              ? nlohmann::json{{"code", 1}}
+                                              : nlohmann::json{{"code", 2}, {"message", job.value("error_message", "")}}}};
+        if (trace.contains("parent_span_id") && trace["parent_span_id"].is_string()) {
+            root["parentSpanId"] = trace["parent_span_id"];
+        }
+        spans.push_back(root);
+    } else {
+        // Whatever follows, until the next assignment, is queueing for the next attempt
+        trace["queued_since"] = now_ms;
+    }
+
+    std::shared_ptr<SpanExporter> exporter;
+    {
+        std::lock_guard<std::mutex> lock(exporter_mutex_);
+        exporter = exporter_;
+    }
+    if (exporter) exporter->export_spans(std::move(spans));
+}
+
+} // namespace DispatchServer
+} // namespace distconv
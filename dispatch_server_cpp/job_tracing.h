@@ -0,0 +1,109 @@
+#ifndef JOB_TRACING_H
+#define JOB_TRACING_H
+
+#include "dispatch_server_constants.h"
+#include "metrics.h"
+#include "nlohmann/json.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// W3C trace context. A valid traceparent yields its trace id and the
+// caller's span id; anything else is ignored and the job starts a new trace.
+bool parse_traceparent(const std::string& header, std::string& trace_id, std::string& parent_span_id);
+
+// The "trace" object stored with a new job: {"trace_id", "span_id"} plus
+// "parent_span_id" when the submitter sent a traceparent. span_id is the
+// job's root span, the parent of every phase span.
+nlohmann::json start_job_trace(const std::string& traceparent);
+
+// traceparent naming the job's root span, for the submit response and the
+// engine's download and upload requests; empty for untraced jobs
+std::string job_traceparent(const nlohmann::json& job);
+
+// Phase histogram buckets, 10 ms to 4 h: claims and reports are quick, encodes are not
+const std::vector<double>& phase_buckets();
+
+struct TraceExportOptions {
+    std::string file;      // Appends one OTLP ExportTraceServiceRequest per line; empty = off
+    std::string endpoint;  // OTLP/HTTP JSON collector, e.g. http://localhost:4318/v1/traces; empty = off
+};
+
+// Writes span batches on a thread of its own so reports never wait on disk or
+// the collector. Batches past Constants::TRACE_EXPORT_QUEUE_SIZE are dropped
+// and counted in dispatch_trace_batches_dropped_total.
+class SpanExporter {
+public:
+    SpanExporter(TraceExportOptions options, std::shared_ptr<MetricsRegistry> metrics = nullptr);
+    ~SpanExporter(); // Writes whatever is still queued
+
+    // spans: OTLP JSON span objects of one resource
+    void export_spans(nlohmann::json spans);
+    // Blocks until every batch queued so far is written
+    void flush();
+
+private:
+    void run();
+    void write(const nlohmann::json& request);
+
+    TraceExportOptions options_;
+    std::string endpoint_base_; // scheme://host:port
+    std::string endpoint_path_;
+    Counter* dropped_ = nullptr;
+    Counter* failed_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<nlohmann::json> queue_;
+    bool writing_ = false;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+// Per-phase timing of jobs, kept in the job's "trace".
+//
+// Each finished attempt (a completion or failure report) is split into
+// phases: queued (submission or the previous attempt's end to assignment),
+// assignment (assignment to the engine starting its download), download,
+// transcode and upload (timestamps from the engine's report "phases"), and
+// report (the engine's upload end to the dispatcher receiving the report).
+// An engine that sends no phases gets a single "engine" phase instead. Engine
+// timestamps come from the engine's clock; skew can shift the assignment and
+// report phases, so negative durations are clamped to zero.
+//
+// Phases are appended to trace["phases"], observed in
+// dispatch_job_phase_seconds{phase} and exported as spans under the job's
+// root span, which is exported itself once the job completes or fails
+// permanently.
+class JobTracer {
+public:
+    explicit JobTracer(std::shared_ptr<MetricsRegistry> metrics = nullptr);
+
+    void set_exporter(std::shared_ptr<SpanExporter> exporter);
+
+    // failure_class: the failed report's class (download, transcode, upload,
+    // ...) marking that phase's span as an error; empty for a completion
+    void end_attempt(nlohmann::json& job, const nlohmann::json& report, int64_t now_ms,
+                     const std::string& failure_class = "");
+
+private:
+    std::shared_ptr<MetricsRegistry> metrics_;
+    std::map<std::string, Histogram*> phase_seconds_; // Looked up once per phase name
+    std::mutex exporter_mutex_;
+    std::shared_ptr<SpanExporter> exporter_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // JOB_TRACING_H
@@ -1,7 +1,7 @@
 #include "job_update_handler.h"
+#include "wall_clock.h"
 #include "dispatch_server_core.h"
 #include "dispatch_server_constants.h"
-#include <regex>
 
 namespace distconv {
 namespace DispatchServer {
@@ -19,11 +19,11 @@ void JobUpdateHandler::handle(const httplib::Request& req, httplib::Response& re
     }
 
     // Extract job ID from URL
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Invalid or missing job ID in URL", "validation_error", 400);
         return;
     }
-    std::string job_id = req.matches[1];
 
     // Check if job exists
     if (!job_repo_->job_exists(job_id)) {
@@ -60,11 +60,11 @@ void EngineJobsHandler::handle(const httplib::Request& req, httplib::Response& r
     }
 
     // Extract engine ID from URL
-    if (req.matches.size() < 2) {
+    std::string engine_id = path_param(req, "engine_id");
+    if (engine_id.empty()) {
         set_json_error_response(res, "Invalid or missing engine ID in URL", "validation_error", 400);
         return;
     }
-    std::string engine_id = req.matches[1];
 
     // Get jobs for this engine
     std::vector<nlohmann::json> jobs = job_repo_->get_jobs_by_engine(engine_id);
@@ -88,11 +88,11 @@ void JobUnifiedStatusHandler::handle(const httplib::Request& req, httplib::Respo
     }
 
     // Extract job ID from URL
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Invalid or missing job ID in URL", "validation_error", 400);
         return;
     }
-    std::string job_id = req.matches[1];
 
     // Check if job exists
     if (!job_repo_->job_exists(job_id)) {
@@ -124,8 +124,7 @@ void JobUnifiedStatusHandler::handle(const httplib::Request& req, httplib::Respo
     // Get the job and update it
     nlohmann::json job = job_repo_->get_job(job_id);
     job["status"] = new_status;
-    job["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    job["updated_at"] = wall_clock_ms();
 
     if (new_status == "completed" && request_json.contains("output_url")) {
         job["output_url"] = request_json["output_url"];
@@ -158,8 +157,9 @@ void JobUnifiedStatusHandler::handle(const httplib::Request& req, httplib::Respo
 }
 
 // JobProgressHandler implementation
-JobProgressHandler::JobProgressHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo)
-    : auth_(auth), job_repo_(job_repo) {}
+JobProgressHandler::JobProgressHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                                       std::shared_ptr<SpeculationManager> speculation)
+    : auth_(auth), job_repo_(job_repo), speculation_(speculation) {}
 
 void JobProgressHandler::handle(const httplib::Request& req, httplib::Response& res) {
     // Authentication
@@ -168,11 +168,11 @@ void JobProgressHandler::handle(const httplib::Request& req, httplib::Response&
     }
 
     // Extract job ID from URL
-    if (req.matches.size() < 2) {
+    std::string job_id = path_param(req, "job_id");
+    if (job_id.empty()) {
         set_json_error_response(res, "Invalid or missing job ID in URL", "validation_error", 400);
         return;
     }
-    std::string job_id = req.matches[1];
 
     // Check if job exists
     if (!job_repo_->job_exists(job_id)) {
@@ -203,6 +203,22 @@ void JobProgressHandler::handle(const httplib::Request& req, httplib::Response&
 
     std::string message = request_json.value("message", "");
 
+    if (speculation_ && request_json.contains("engine_id") && request_json["engine_id"].is_string()) {
+        std::string reporter = request_json["engine_id"];
+        nlohmann::json job = job_repo_->get_job(job_id);
+        if (speculation_->is_losing_report(job, reporter)) {
+            set_json_error_response(res, "Job already completed by another engine", "conflict", 409, "Job ID: " + job_id);
+            return;
+        }
+        if (speculation_->is_copy_report(job, reporter)) {
+            nlohmann::json speculation = job["speculation"];
+            speculation["progress"] = progress;
+            job_repo_->update_job(job_id, {{"speculation", speculation}});
+            set_json_response(res, {{"job_id", job_id}, {"progress", progress}, {"message", message}}, 200);
+            return;
+        }
+    }
+
     // Update progress
     if (job_repo_->update_job_progress(job_id, progress, message)) {
         nlohmann::json response;
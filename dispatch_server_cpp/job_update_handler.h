@@ -3,6 +3,7 @@
 
 #include "request_handlers.h"
 #include "repositories.h"
+#include "speculation.h"
 #include "nlohmann/json.hpp"
 #include <memory>
 
@@ -43,14 +44,18 @@ private:
 };
 
 // Handler for POST /jobs/{id}/progress - Report job progress
+// Progress from a speculative copy is kept under job["speculation"] so the
+// primary's progress (which drives straggler detection) stays intact.
 class JobProgressHandler : public IRequestHandler {
 public:
-    explicit JobProgressHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo);
+    explicit JobProgressHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<IJobRepository> job_repo,
+                                std::shared_ptr<SpeculationManager> speculation = nullptr);
     void handle(const httplib::Request& req, httplib::Response& res) override;
 
 private:
     std::shared_ptr<AuthMiddleware> auth_;
     std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<SpeculationManager> speculation_;
 };
 
 } // namespace DispatchServer
@@ -7,6 +7,7 @@
 #include <unordered_map>
 #include <iostream>
 #include <algorithm>
+#include <chrono>
 
 namespace distconv {
 
@@ -25,7 +26,9 @@ public:
     bool publish(const std::string& topic, const std::string& payload) override {
         std::lock_guard<std::mutex> lock(*mutex_);
         auto& queue = (*storage_)[topic];
-        queue.messages.push_back({topic, payload, std::to_string(message_id_counter_++)});
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        queue.messages.push_back({topic, payload, std::to_string(message_id_counter_++), now_ms});
 
         // Limit queue size to prevent unbounded memory growth
         if (queue.messages.size() > MAX_QUEUE_SIZE) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <vector>
@@ -12,6 +13,7 @@ struct Message {
     std::string topic;
     std::string payload;
     std::string id;
+    int64_t published_at_ms = 0; // Wall-clock publish time, when the transport records one
 };
 
 class MessageQueueProducer {
@@ -0,0 +1,271 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+std::atomic<size_t> next_shard{0};
+
+std::string format_value(double value) {
+    if (std::isnan(value)) return "NaN";
+    if (std::isinf(value)) return value > 0 ? "+Inf" : "-Inf";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+    return buffer;
+}
+
+void append_escaped(std::string& out, const std::string& text, bool quotes) {
+    for (char c : text) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '"' && quotes) out += "\\\"";
+        else out += c;
+    }
+}
+
+// name{a="1",b="2"}; extra is appended last (a histogram's "le")
+void append_series(std::string& out, const std::string& name, const MetricLabels& labels,
+                   const std::pair<std::string, std::string>* extra = nullptr) {
+    out += name;
+    if (labels.empty() && !extra) return;
+    out += '{';
+    bool first = true;
+    auto append_label = [&](const std::pair<std::string, std::string>& label) {
+        if (!first) out += ',';
+        first = false;
+        out += label.first;
+        out += "=\"";
+        append_escaped(out, label.second, true);
+        out += '"';
+    };
+    for (const auto& label : labels) append_label(label);
+    if (extra) append_label(*extra);
+    out += '}';
+}
+
+void append_header(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP " + name + " ";
+    append_escaped(out, help, false);
+    out += "\n# TYPE " + name + " " + type + "\n";
+}
+
+} // namespace
+
+size_t metric_shard() {
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& cell : cells_) total += cell.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+Histogram::Histogram(std::vector<double> bounds) : bounds_(std::move(bounds)) {
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+    // One cell per bound, +Inf and the sum
+    stride_ = (bounds_.size() + 2 + 7) / 8 * 8;
+    lines_ = std::make_unique<Line[]>(METRIC_SHARDS * stride_ / 8);
+}
+
+std::atomic<uint64_t>& Histogram::cell(size_t shard, size_t index) const {
+    size_t offset = shard * stride_ + index;
+    return lines_[offset / 8].cells[offset % 8];
+}
+
+void Histogram::observe(double seconds) {
+    if (std::isnan(seconds)) return;
+    seconds = std::max(seconds, 0.0);
+    // Buckets are "less than or equal": the first bound not below the value
+    size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), seconds) - bounds_.begin();
+    size_t shard = metric_shard();
+    cell(shard, bucket).fetch_add(1, std::memory_order_relaxed);
+    cell(shard, bounds_.size() + 1).fetch_add(static_cast<uint64_t>(std::min(seconds * 1e9, 1.8e19)),
+                                              std::memory_order_relaxed);
+}
+
+void Histogram::observe(std::chrono::steady_clock::duration elapsed) {
+    observe(std::chrono::duration<double>(elapsed).count());
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(bounds_.size() + 1, 0);
+    uint64_t sum_ns = 0;
+    for (size_t shard = 0; shard < METRIC_SHARDS; ++shard) {
+        for (size_t i = 0; i <= bounds_.size(); ++i) {
+            snapshot.buckets[i] += cell(shard, i).load(std::memory_order_relaxed);
+        }
+        sum_ns += cell(shard, bounds_.size() + 1).load(std::memory_order_relaxed);
+    }
+    // Counted from the buckets so that _count always equals the +Inf bucket
+    for (uint64_t n : snapshot.buckets) snapshot.count += n;
+    snapshot.sum = sum_ns / 1e9;
+    return snapshot;
+}
+
+const std::vector<double>& latency_buckets() {
+    static const std::vector<double> bounds = {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+                                               0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+    return bounds;
+}
+
+const std::vector<double>& wait_buckets() {
+    static const std::vector<double> bounds = {0.000001, 0.00001, 0.0001, 0.0005, 0.001, 0.005,
+                                               0.01, 0.05, 0.1, 0.5, 1};
+    return bounds;
+}
+
+const std::vector<double>& queue_wait_buckets() {
+    static const std::vector<double> bounds = {0.1, 0.5, 1, 5, 15, 30, 60, 300, 900, 1800, 3600, 7200, 14400};
+    return bounds;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    auto it = families_.find(name);
+    if (it == families_.end()) {
+        it = families_.emplace(name, Family{type, help, {}, {}, {}, {}}).first;
+    } else if (it->second.type != type) {
+        throw std::logic_error("Metric " + name + " is already registered with another type");
+    }
+    return it->second;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& series = family(name, help, Type::Counter).counters[labels];
+    if (!series) series = std::make_unique<Counter>();
+    return *series;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& series = family(name, help, Type::Gauge).gauges[labels];
+    if (!series) series = std::make_unique<Gauge>();
+    return *series;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      const std::vector<double>& bounds, const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& series = family(name, help, Type::Histogram).histograms[labels];
+    if (!series) series = std::make_unique<Histogram>(bounds);
+    return *series;
+}
+
+uint64_t MetricsRegistry::add_collector(const std::string& name, const std::string& help, Collector collector) {
+    return add_collector(name, help, Type::Gauge, std::move(collector));
+}
+
+uint64_t MetricsRegistry::add_counter_collector(const std::string& name, const std::string& help,
+                                                Collector collector) {
+    return add_collector(name, help, Type::Counter, std::move(collector));
+}
+
+uint64_t MetricsRegistry::add_collector(const std::string& name, const std::string& help, Type type,
+                                        Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_collector_id_++;
+    family(name, help, type).collectors.emplace(id, std::move(collector));
+    collector_names_.emplace(id, name);
+    return id;
+}
+
+void MetricsRegistry::remove_collector(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto name = collector_names_.find(id);
+    if (name == collector_names_.end()) return;
+    families_[name->second].collectors.erase(id);
+    collector_names_.erase(name);
+}
+
+std::string MetricsRegistry::render() const {
+    // Series values are read under the lock; collectors, which may query the
+    // repositories, run after it is released
+    struct Pending {
+        std::string text;
+        std::string name;
+        std::vector<Collector> collectors;
+    };
+    std::vector<Pending> rendered;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [name, family] : families_) {
+            Pending pending{"", name, {}};
+            std::string& out = pending.text;
+            switch (family.type) {
+                case Type::Counter:
+                    if (family.counters.empty() && family.collectors.empty()) continue;
+                    append_header(out, name, family.help, "counter");
+                    for (const auto& [labels, counter] : family.counters) {
+                        append_series(out, name, labels);
+                        out += " " + std::to_string(counter->value()) + "\n";
+                    }
+                    for (const auto& collector : family.collectors) pending.collectors.push_back(collector.second);
+                    break;
+                case Type::Gauge:
+                    if (family.gauges.empty() && family.collectors.empty()) continue;
+                    append_header(out, name, family.help, "gauge");
+                    for (const auto& [labels, gauge] : family.gauges) {
+                        append_series(out, name, labels);
+                        out += " " + format_value(gauge->value()) + "\n";
+                    }
+                    for (const auto& collector : family.collectors) pending.collectors.push_back(collector.second);
+                    break;
+                case Type::Histogram:
+                    if (family.histograms.empty()) continue;
+                    append_header(out, name, family.help, "histogram");
+                    for (const auto& [labels, histogram] : family.histograms) {
+                        Histogram::Snapshot snapshot = histogram->snapshot();
+                        uint64_t cumulative = 0;
+                        for (size_t i = 0; i < snapshot.buckets.size(); ++i) {
+                            cumulative += snapshot.buckets[i];
+                            std::pair<std::string, std::string> le{
+                                "le", i < histogram->bounds().size() ? format_value(histogram->bounds()[i]) : "+Inf"};
+                            append_series(out, name + "_bucket", labels, &le);
+                            out += " " + std::to_string(cumulative) + "\n";
+                        }
+                        append_series(out, name + "_sum", labels);
+                        out += " " + format_value(snapshot.sum) + "\n";
+                        append_series(out, name + "_count", labels);
+                        out += " " + std::to_string(snapshot.count) + "\n";
+                    }
+                    break;
+            }
+            rendered.push_back(std::move(pending));
+        }
+    }
+
+    std::string out;
+    for (auto& pending : rendered) {
+        out += pending.text;
+        for (const auto& collector : pending.collectors) {
+            std::vector<Sample> samples;
+            try {
+                samples = collector();
+            } catch (const std::exception&) {
+                continue; // A failing source leaves its series out of this scrape
+            }
+            for (const auto& sample : samples) {
+                append_series(out, pending.name, sample.labels);
+                out += " " + format_value(sample.value) + "\n";
+            }
+        }
+    }
+    return out;
+}
+
+std::shared_ptr<MetricsRegistry> default_metrics_registry() {
+    static auto registry = std::make_shared<MetricsRegistry>();
+    return registry;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,144 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Label names and values of one series, in the order they are rendered
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// Hot-path updates land in one of METRIC_SHARDS cache-line-sized cells,
+// picked per thread, so threads recording the same series do not bounce a
+// shared line between cores. Reads sum the cells.
+constexpr size_t METRIC_SHARDS = 16;
+size_t metric_shard();
+
+// A monotonically increasing count
+class Counter {
+public:
+    void inc(uint64_t n = 1) { cells_[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+    Cell cells_[METRIC_SHARDS];
+};
+
+// A value that goes up and down; set from one place at a time
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0};
+};
+
+// Durations counted into fixed buckets (upper bounds in seconds, ascending).
+// The sum is kept in nanoseconds so that every update is an integer add.
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double seconds);
+    void observe(std::chrono::steady_clock::duration elapsed);
+    // Time since start
+    void observe_since(std::chrono::steady_clock::time_point start) {
+        observe(std::chrono::steady_clock::now() - start);
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets; // Per bound, not cumulative; the last is +Inf
+        uint64_t count = 0;
+        double sum = 0;
+    };
+    Snapshot snapshot() const;
+    const std::vector<double>& bounds() const { return bounds_; }
+
+private:
+    struct alignas(64) Line {
+        std::atomic<uint64_t> cells[8];
+    };
+
+    std::atomic<uint64_t>& cell(size_t shard, size_t index) const;
+
+    std::vector<double> bounds_;
+    size_t stride_;                  // Cells per shard: buckets, +Inf, count, sum; rounded to whole lines
+    std::unique_ptr<Line[]> lines_;
+};
+
+// Bucket sets for the dispatcher's histograms
+const std::vector<double>& latency_buckets();   // 0.5 ms to 10 s: requests, repository calls, passes
+const std::vector<double>& wait_buckets();      // 1 µs to 1 s: lock and SQLite busy waits
+const std::vector<double>& queue_wait_buckets(); // 100 ms to 4 h: jobs waiting for an engine
+
+// Named families of series, rendered in the Prometheus text exposition
+// format (version 0.0.4). Lookups take a mutex and create the series on first
+// use; callers on hot paths look their series up once and keep the reference,
+// which stays valid for the registry's lifetime. Asking for an existing name
+// with another metric type throws std::logic_error.
+class MetricsRegistry {
+public:
+    Counter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help, const std::vector<double>& bounds,
+                         const MetricLabels& labels = {});
+
+    // Gauges computed when scraped (queue depths and the like). Returns an id
+    // for remove_collector; the owner of whatever the collector reads removes
+    // it before going away.
+    struct Sample {
+        MetricLabels labels;
+        double value;
+    };
+    using Collector = std::function<std::vector<Sample>()>;
+    uint64_t add_collector(const std::string& name, const std::string& help, Collector collector);
+    // The same for counters kept elsewhere (the logger's drops)
+    uint64_t add_counter_collector(const std::string& name, const std::string& help, Collector collector);
+    void remove_collector(uint64_t id);
+
+    std::string render() const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<MetricLabels, std::unique_ptr<Counter>> counters;
+        std::map<MetricLabels, std::unique_ptr<Gauge>> gauges;
+        std::map<MetricLabels, std::unique_ptr<Histogram>> histograms;
+        std::map<uint64_t, Collector> collectors;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Type type);
+    uint64_t add_collector(const std::string& name, const std::string& help, Type type, Collector collector);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+    std::map<uint64_t, std::string> collector_names_;
+    uint64_t next_collector_id_ = 1;
+};
+
+// The process-wide registry behind GET /metrics
+std::shared_ptr<MetricsRegistry> default_metrics_registry();
+
+constexpr const char* METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // METRICS_H
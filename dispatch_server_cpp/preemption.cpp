@@ -0,0 +1,293 @@
+#include "preemption.h"
+#include "dispatch_server_constants.h"
+#include "resource_packing.h"
+#include "structured_log.hpp"
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+using namespace Constants;
+
+namespace {
+
+std::string string_field(const nlohmann::json& object, const char* key) {
+    return object.contains(key) && object[key].is_string() ? object[key].get<std::string>() : std::string();
+}
+
+int64_t integer_field(const nlohmann::json& object, const char* key) {
+    return object.contains(key) && object[key].is_number_integer() ? object[key].get<int64_t>() : 0;
+}
+
+bool running(const nlohmann::json& job) {
+    std::string status = job.value("status", "");
+    return status == "assigned" || status == "processing";
+}
+
+} // namespace
+
+bool reserved_for_other(const nlohmann::json& job, const std::string& engine_id, int64_t now_ms,
+                        int64_t timeout_ms) {
+    std::string reserved_for = string_field(job, "reserved_for");
+    return !reserved_for.empty() && reserved_for != engine_id &&
+           now_ms - integer_field(job, "reserved_at") < timeout_ms;
+}
+
+PreemptionCoordinator::PreemptionCoordinator(std::shared_ptr<IJobRepository> job_repo,
+                                             std::shared_ptr<IEngineRepository> engine_repo,
+                                             std::chrono::milliseconds grace,
+                                             std::chrono::milliseconds reservation_timeout)
+    : job_repo_(job_repo), engine_repo_(engine_repo), grace_ms_(grace.count()),
+      reservation_timeout_ms_(reservation_timeout.count()) {}
+
+void PreemptionCoordinator::scan(int64_t now_ms) {
+    std::set<std::string> lapsed = expire_requests(now_ms);
+
+    // Urgent jobs that have waited out the grace period and are not yet promised an engine
+    std::vector<nlohmann::json> urgent;
+    for (auto& job : job_repo_->get_pending_jobs(SOURCE_LOCALITY_SCAN_LIMIT)) {
+        if (job.value("priority", 0) < PRIORITY_URGENT) {
+            break;
+        }
+        if (now_ms - integer_field(job, "created_at") < grace_ms_ ||
+            reserved_for_other(job, "", now_ms, reservation_timeout_ms_)) {
+            continue;
+        }
+        urgent.push_back(job);
+    }
+    if (urgent.empty()) {
+        return;
+    }
+
+    // Occupancy comes from the jobs; heartbeats overwrite the engine records
+    std::map<std::string, std::vector<nlohmann::json>> running_on;
+    for (const char* status : {"assigned", "processing"}) {
+        for (auto& job : job_repo_->get_jobs_by_status(status)) {
+            std::string engine_id = string_field(job, "assigned_engine");
+            if (!engine_id.empty()) {
+                running_on[engine_id].push_back(job);
+            }
+            if (job.contains("speculation") && job["speculation"].is_object() &&
+                job["speculation"].value("state", "") == "running") {
+                running_on[string_field(job["speculation"], "engine")].push_back(job);
+            }
+        }
+    }
+
+    auto cheaper = [](const nlohmann::json& a, const nlohmann::json& b) {
+        int pa = a.value("priority", 0), pb = b.value("priority", 0);
+        if (pa != pb) return pa < pb;
+        return integer_field(a, "assigned_at") > integer_field(b, "assigned_at");
+    };
+
+    // Each engine offers its cheapest job: lowest priority, then the one that has run the shortest
+    struct Victim {
+        std::string engine_id;
+        nlohmann::json job;
+        Resources free_after; // What the engine has free once the job is suspended
+    };
+    std::vector<Victim> victims;
+    const std::vector<nlohmann::json> none;
+    for (const auto& engine : engine_repo_->get_all_engines()) {
+        std::string engine_id = string_field(engine, "engine_id");
+        if (engine_id.empty()) {
+            continue;
+        }
+        auto it = running_on.find(engine_id);
+        const auto& jobs = it == running_on.end() ? none : it->second;
+        Resources free = free_capacity(engine, jobs);
+        for (const auto& job : urgent) {
+            if (free.covers(job_demand(job))) {
+                // A free slot will claim the urgent job on its next poll
+                return;
+            }
+        }
+        if (!engine.value("preemptible", false) || lapsed.count(engine_id)) {
+            continue;
+        }
+        const nlohmann::json* cheapest = nullptr;
+        for (const auto& job : jobs) {
+            // Speculative copies are not the engine's to suspend
+            if (string_field(job, "assigned_engine") == engine_id && (!cheapest || cheaper(job, *cheapest))) {
+                cheapest = &job;
+            }
+        }
+        if (cheapest) {
+            free += job_demand(*cheapest);
+            victims.push_back({engine_id, *cheapest, free});
+        }
+    }
+    std::sort(victims.begin(), victims.end(),
+              [&](const Victim& a, const Victim& b) { return cheaper(a.job, b.job); });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<bool> taken(victims.size(), false);
+    for (const auto& job : urgent) {
+        auto victim = victims.end();
+        for (auto it = victims.begin(); it != victims.end(); ++it) {
+            if (it->job.value("priority", 0) >= job.value("priority", 0)) {
+                break;
+            }
+            if (!taken[it - victims.begin()] && !requests_.count(it->engine_id) &&
+                it->free_after.covers(job_demand(job))) {
+                victim = it;
+                break;
+            }
+        }
+        if (victim == victims.end()) {
+            continue;
+        }
+        taken[victim - victims.begin()] = true;
+
+        const std::string& engine_id = victim->engine_id;
+        std::string urgent_id = job.value("job_id", "");
+        std::string victim_id = victim->job.value("job_id", "");
+        job_repo_->update_job(urgent_id, {{"reserved_for", engine_id}, {"reserved_at", now_ms}});
+        job_repo_->update_job(victim_id, {{"preemption", {{"state", "requested"}, {"for", urgent_id},
+                                                          {"requested_at", now_ms}}}});
+        requests_[engine_id] = {victim_id, urgent_id, now_ms};
+        ++requested_;
+        logging::info("preemption", "Preempting job",
+                      {{"job_id", victim_id}, {"engine_id", engine_id}, {"urgent_job_id", urgent_id}});
+    }
+}
+
+std::set<std::string> PreemptionCoordinator::expire_requests(int64_t now_ms) {
+    std::set<std::string> lapsed;
+    std::vector<Request> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = requests_.begin(); it != requests_.end();) {
+            if (now_ms - it->second.requested_at >= reservation_timeout_ms_) {
+                expired.push_back(it->second);
+                lapsed.insert(it->first);
+                it = requests_.erase(it);
+                ++expired_;
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (const auto& request : expired) {
+        nlohmann::json urgent = job_repo_->get_job(request.urgent_job_id);
+        if (urgent.is_object() && urgent.contains("reserved_for")) {
+            urgent.erase("reserved_for");
+            urgent.erase("reserved_at");
+            job_repo_->save_job(request.urgent_job_id, urgent);
+        }
+        if (request.suspended) {
+            // The suspended job is resumed by its engine whenever it gets back to it
+            continue;
+        }
+        nlohmann::json victim = job_repo_->get_job(request.job_id);
+        if (victim.is_object() && victim.contains("preemption") && victim["preemption"].is_object() &&
+            victim["preemption"].value("state", "") == "requested") {
+            victim["preemption"]["state"] = "expired";
+            job_repo_->save_job(request.job_id, victim);
+        }
+    }
+    return lapsed;
+}
+
+nlohmann::json PreemptionCoordinator::directive_for(const std::string& engine_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = requests_.find(engine_id);
+    if (it == requests_.end() || it->second.suspended) {
+        return nullptr;
+    }
+    return {{"type", "preempt"}, {"job_id", it->second.job_id}, {"for", it->second.urgent_job_id}};
+}
+
+std::string PreemptionCoordinator::reserved_job_for(const std::string& engine_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = requests_.find(engine_id);
+    return it == requests_.end() ? std::string() : it->second.urgent_job_id;
+}
+
+void PreemptionCoordinator::on_claimed(const std::string& engine_id, const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = requests_.find(engine_id);
+    if (it != requests_.end() && it->second.urgent_job_id == job_id) {
+        requests_.erase(it);
+    }
+}
+
+bool PreemptionCoordinator::on_suspended(nlohmann::json& job, const std::string& engine_id,
+                                         const nlohmann::json& checkpoint, int64_t now_ms) {
+    if (!running(job) || string_field(job, "assigned_engine") != engine_id) {
+        return false;
+    }
+
+    nlohmann::json preemption = job.contains("preemption") && job["preemption"].is_object()
+                                    ? job["preemption"] : nlohmann::json::object();
+    preemption["state"] = "suspended";
+    preemption["suspended_at"] = now_ms;
+    preemption["checkpoint"] = checkpoint;
+    preemption["count"] = preemption.value("count", 0) + 1;
+    job["preemption"] = preemption;
+    job["status"] = "suspended";
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = requests_.find(engine_id);
+        if (it != requests_.end() && !it->second.suspended && it->second.job_id == job.value("job_id", "")) {
+            suspend_latency_ms_ += now_ms - it->second.requested_at;
+            it->second.suspended = true;
+        }
+        ++suspended_;
+    }
+
+    update_engine(engine_id, {{"status", "idle"}, {"current_job_id", ""}});
+    return true;
+}
+
+bool PreemptionCoordinator::on_resumed(nlohmann::json& job, const std::string& engine_id, int64_t now_ms) {
+    if (job.value("status", "") != "suspended" || string_field(job, "assigned_engine") != engine_id) {
+        return false;
+    }
+
+    auto& preemption = job["preemption"];
+    int64_t suspended_for = std::max<int64_t>(0, now_ms - integer_field(preemption, "suspended_at"));
+    preemption["state"] = "resumed";
+    preemption["resumed_at"] = now_ms;
+    preemption["suspended_ms"] = integer_field(preemption, "suspended_ms") + suspended_for;
+    job["status"] = "processing";
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++resumed_;
+        suspended_ms_ += suspended_for;
+    }
+
+    update_engine(engine_id, {{"status", "busy"}, {"current_job_id", job.value("job_id", "")}});
+    return true;
+}
+
+void PreemptionCoordinator::update_engine(const std::string& engine_id, const nlohmann::json& fields) {
+    nlohmann::json engine = engine_repo_->get_engine(engine_id);
+    if (engine.is_null() || engine.empty()) {
+        return;
+    }
+    engine.update(fields);
+    engine_repo_->save_engine(engine_id, engine);
+}
+
+nlohmann::json PreemptionCoordinator::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"requested", requested_},
+        {"suspended", suspended_},
+        {"resumed", resumed_},
+        {"expired", expired_},
+        {"pending_requests", requests_.size()},
+        {"suspend_latency_ms_total", suspend_latency_ms_},
+        {"suspend_latency_ms_avg", suspended_ > 0 ? suspend_latency_ms_ / static_cast<int64_t>(suspended_) : 0},
+        {"suspended_ms_total", suspended_ms_}
+    };
+}
+
+} // namespace DispatchServer
+} // namespace distconv
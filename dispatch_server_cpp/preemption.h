@@ -0,0 +1,88 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+
+#include "repositories.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+// True while job["reserved_for"] names another engine and the reservation is
+// still within timeout_ms; reserved jobs are skipped by everyone else's claims.
+bool reserved_for_other(const nlohmann::json& job, const std::string& engine_id, int64_t now_ms,
+                        int64_t timeout_ms);
+
+// Preemption of lower-priority work for urgent jobs.
+//
+// scan() (background worker) looks for urgent pending jobs that have waited
+// past the grace period while no engine has room for them. It picks a preemptible
+// engine whose lowest-priority job, once suspended, frees enough capacity,
+// reserves the urgent job for it and queues a preempt directive. The engine receives the directive on its next heartbeat
+// or channel exchange. It checkpoints the running job, reports /suspend, runs the
+// urgent job and finally reports /resume. Requests the engine does not act on
+// within the reservation timeout are dropped.
+class PreemptionCoordinator {
+public:
+    PreemptionCoordinator(std::shared_ptr<IJobRepository> job_repo,
+                          std::shared_ptr<IEngineRepository> engine_repo,
+                          std::chrono::milliseconds grace,
+                          std::chrono::milliseconds reservation_timeout);
+
+    void scan(int64_t now_ms);
+
+    // {"type": "preempt", "job_id": victim, "for": urgent job} until the engine suspends, else null
+    nlohmann::json directive_for(const std::string& engine_id) const;
+
+    // The urgent job held for an engine that was asked to preempt, or "". The
+    // claim path hands it out first and reports the claim back.
+    std::string reserved_job_for(const std::string& engine_id) const;
+    void on_claimed(const std::string& engine_id, const std::string& job_id);
+
+    // Applied by the suspend/resume handlers; false when the engine does not hold the job
+    bool on_suspended(nlohmann::json& job, const std::string& engine_id, const nlohmann::json& checkpoint,
+                      int64_t now_ms);
+    bool on_resumed(nlohmann::json& job, const std::string& engine_id, int64_t now_ms);
+
+    // Counters and accumulated cost (time to suspend, time spent suspended)
+    nlohmann::json metrics() const;
+
+    int64_t reservation_timeout_ms() const { return reservation_timeout_ms_; }
+
+private:
+    struct Request {
+        std::string job_id;
+        std::string urgent_job_id;
+        int64_t requested_at = 0;
+        bool suspended = false;
+    };
+
+    // Returns the engines whose requests lapsed; they are not asked again in the same scan
+    std::set<std::string> expire_requests(int64_t now_ms);
+    void update_engine(const std::string& engine_id, const nlohmann::json& fields);
+
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<IEngineRepository> engine_repo_;
+    const int64_t grace_ms_;
+    const int64_t reservation_timeout_ms_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Request> requests_; // by engine_id, until the urgent job is claimed
+    uint64_t requested_ = 0;
+    uint64_t suspended_ = 0;
+    uint64_t expired_ = 0;
+    uint64_t resumed_ = 0;
+    int64_t suspend_latency_ms_ = 0;
+    int64_t suspended_ms_ = 0;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // PREEMPTION_H
@@ -1,7 +1,8 @@
 #include "redis_message_queue.h"
-#include <iostream>
+#include "structured_log.hpp"
 #include <uuid/uuid.h>
 #include <chrono>
+#include <cstdlib>
 
 namespace distconv {
 
@@ -15,7 +16,7 @@ bool RedisMessageQueueProducer::publish(const std::string& topic, const std::str
         redis_->xadd(topic, "*", attrs.begin(), attrs.end());
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis publish error: " << e.what() << std::endl;
+        logging::error("redis", "Redis publish error", {{"topic", topic}, {"error", e.what()}});
         return false;
     }
 }
@@ -62,10 +63,10 @@ void RedisMessageQueueConsumer::subscribe(const std::string& topic, std::functio
         // Ignore if group already exists (BUSYGROUP)
         std::string msg = e.what();
         if (msg.find("BUSYGROUP") == std::string::npos) {
-             std::cerr << "Warning creating group: " << e.what() << std::endl;
+             logging::warn("redis", "Could not create consumer group", {{"topic", topic}, {"error", e.what()}});
         }
     } catch (const std::exception& e) {
-         std::cerr << "Error creating group: " << e.what() << std::endl;
+         logging::error("redis", "Could not create consumer group", {{"topic", topic}, {"error", e.what()}});
     }
 
     std::lock_guard<std::mutex> lock(threads_mutex_);
@@ -99,7 +100,9 @@ void RedisMessageQueueConsumer::pollLoop(std::string topic, std::function<void(c
                         }
                         
                         if (!payload.empty()) {
-                             callback({topic, payload, id});
+                             // Stream entry IDs are "<ms since epoch>-<sequence>", stamped by XADD
+                             int64_t published_at_ms = std::strtoll(id.c_str(), nullptr, 10);
+                             callback({topic, payload, id, published_at_ms});
                         }
                     }
                 }
@@ -108,10 +111,10 @@ void RedisMessageQueueConsumer::pollLoop(std::string topic, std::function<void(c
             // Timeout is expected
             continue;
         } catch (const sw::redis::Error& e) {
-             std::cerr << "Redis poll error: " << e.what() << std::endl;
+             logging::error("redis", "Redis poll error", {{"error", e.what()}});
              std::this_thread::sleep_for(std::chrono::seconds(1));
         } catch (const std::exception& e) {
-            std::cerr << "Redis poll exception: " << e.what() << std::endl;
+            logging::error("redis", "Redis poll exception", {{"error", e.what()}});
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
     }
@@ -122,7 +125,7 @@ bool RedisMessageQueueConsumer::ack(const Message& message) {
         redis_->xack(message.topic, group_id_, {message.id});
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis ack error: " << e.what() << std::endl;
+        logging::error("redis", "Redis ack error", {{"topic", message.topic}, {"error", e.what()}});
         return false;
     }
 }
@@ -143,7 +146,7 @@ bool RedisMessageQueueConsumer::nack(const Message& message) {
         
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis nack error: " << e.what() << std::endl;
+        logging::error("redis", "Redis nack error", {{"topic", message.topic}, {"error", e.what()}});
         return false;
     }
 }
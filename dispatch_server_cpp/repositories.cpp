@@ -1,13 +1,78 @@
 #include "repositories.h"
+#include "wall_clock.h"
 #include <sqlite3.h>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <chrono>
+#include <algorithm>
+#include <thread>
 
 namespace distconv {
 namespace DispatchServer {
 
+bool pending_job_precedes(const nlohmann::json& a, const nlohmann::json& b) {
+    int pa = a.value("priority", 0), pb = b.value("priority", 0);
+    if (pa != pb) return pa > pb;
+    bool da = a.contains("latest_start") && a["latest_start"].is_number_integer();
+    bool db = b.contains("latest_start") && b["latest_start"].is_number_integer();
+    if (da != db) return da;
+    if (da) {
+        int64_t la = a["latest_start"].get<int64_t>(), lb = b["latest_start"].get<int64_t>();
+        if (la != lb) return la < lb;
+    }
+    return a.value("created_at", 0LL) < b.value("created_at", 0LL);
+}
+
+std::map<std::string, size_t> IJobRepository::count_jobs_by_tenant(const std::string& status) {
+    std::map<std::string, size_t> counts;
+    for (const auto& job : get_jobs_by_status(status)) {
+        std::string tenant = job.contains("tenant") && job["tenant"].is_string() ? job["tenant"].get<std::string>() : "";
+        ++counts[tenant];
+    }
+    return counts;
+}
+
+std::vector<nlohmann::json> IJobRepository::get_pending_jobs_by_size_class(const std::string& size_class,
+                                                                           size_t limit) {
+    std::vector<nlohmann::json> jobs;
+    for (auto& job : get_jobs_by_status("pending")) {
+        if (job.contains("size_class") && job["size_class"] == size_class) {
+            jobs.push_back(std::move(job));
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), pending_job_precedes);
+    if (jobs.size() > limit) {
+        jobs.resize(limit);
+    }
+    return jobs;
+}
+
+namespace {
+
+int64_t updated_at_of(const nlohmann::json& job) {
+    return job.contains("updated_at") && job["updated_at"].is_number_integer() ? job["updated_at"].get<int64_t>() : 0;
+}
+
+void sort_by_update(std::vector<nlohmann::json>& jobs) {
+    std::stable_sort(jobs.begin(), jobs.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        return updated_at_of(a) < updated_at_of(b);
+    });
+}
+
+} // namespace
+
+std::vector<nlohmann::json> IJobRepository::get_jobs_updated_since(int64_t timestamp_ms) {
+    std::vector<nlohmann::json> jobs;
+    for (auto& job : get_all_jobs()) {
+        if (updated_at_of(job) > timestamp_ms) {
+            jobs.push_back(std::move(job));
+        }
+    }
+    sort_by_update(jobs);
+    return jobs;
+}
+
 // RAII wrapper for sqlite3_stmt
 class StatementFinalizer {
 public:
@@ -24,13 +89,65 @@ private:
     sqlite3_stmt* stmt_;
 };
 
+namespace {
+
+constexpr int SQLITE_BUSY_TIMEOUT_MS = 5000;
+
+// sqlite3_busy_timeout's backoff, with each sleep recorded: the waits grow to
+// 100 ms and stop once they add up to SQLITE_BUSY_TIMEOUT_MS
+int busy_handler(void* context, int attempt) {
+    static const int DELAYS_MS[] = {1, 2, 5, 10, 15, 20, 25, 25, 25, 50, 50, 100};
+    constexpr int STEPS = sizeof(DELAYS_MS) / sizeof(DELAYS_MS[0]);
+    auto* waits = static_cast<SqliteWaitMetrics*>(context);
+
+    int delay = attempt < STEPS ? DELAYS_MS[attempt] : DELAYS_MS[STEPS - 1];
+    int prior = 0;
+    for (int i = 0; i < std::min(attempt, STEPS); ++i) prior += DELAYS_MS[i];
+    if (attempt > STEPS) prior += (attempt - STEPS) * DELAYS_MS[STEPS - 1];
+    delay = std::min(delay, SQLITE_BUSY_TIMEOUT_MS - prior);
+    if (delay <= 0) {
+        waits->busy_timeouts->inc();
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    waits->busy_wait->observe_since(start);
+    return 1;
+}
+
+} // namespace
+
+SqliteWaitMetrics::SqliteWaitMetrics(const std::string& database) {
+    auto metrics = default_metrics_registry();
+    MetricLabels labels{{"database", database}};
+    busy_wait = &metrics->histogram("dispatch_sqlite_busy_wait_seconds",
+                                    "Backoff sleeps while another connection held the SQLite lock",
+                                    wait_buckets(), labels);
+    busy_timeouts = &metrics->counter("dispatch_sqlite_busy_timeouts_total",
+                                      "SQLite statements that gave up with SQLITE_BUSY", labels);
+    lock_wait = &metrics->histogram("dispatch_repository_lock_wait_seconds",
+                                    "Time spent waiting for a contended repository mutex", wait_buckets(),
+                                    {{"repository", database}});
+}
+
 // SqliteJobRepository implementation
 SqliteJobRepository::SqliteJobRepository(const std::string& db_path) : db_path_(db_path), db_(nullptr) {
     initialize_database();
 }
 
+std::unique_lock<std::mutex> SqliteJobRepository::acquire() const {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        waits_.lock_wait->observe_since(start);
+    }
+    return lock;
+}
+
 SqliteJobRepository::~SqliteJobRepository() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     for (auto const& [sql, stmt] : statements_) {
         sqlite3_finalize(stmt);
     }
@@ -54,8 +171,8 @@ void SqliteJobRepository::initialize_database() {
     
     // Enable WAL mode
     sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
-    // Set busy timeout
-    sqlite3_busy_timeout(db_, 5000);
+    // Wait out other connections' locks, recording the waits
+    sqlite3_busy_handler(db_, busy_handler, &waits_);
 
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS jobs (
@@ -71,10 +188,15 @@ void SqliteJobRepository::initialize_database() {
         CREATE INDEX IF NOT EXISTS idx_jobs_priority ON jobs(priority);
         CREATE INDEX IF NOT EXISTS idx_jobs_created_at ON jobs(created_at);
         CREATE INDEX IF NOT EXISTS idx_jobs_updated_at ON jobs(updated_at);
+        CREATE INDEX IF NOT EXISTS idx_jobs_size_class ON jobs(json_extract(job_data, '$.size_class'), status);
     )";
     
     char* err_msg = nullptr;
     rc = sqlite3_exec(db_, sql, nullptr, nullptr, &err_msg);
+    if (rc == SQLITE_OK && execute_query("SELECT 1 FROM pragma_table_info('jobs') WHERE name = 'latest_start'").empty()) {
+        // Databases created before deadline scheduling
+        rc = sqlite3_exec(db_, "ALTER TABLE jobs ADD COLUMN latest_start INTEGER", nullptr, nullptr, &err_msg);
+    }
     if (rc != SQLITE_OK) {
         std::string error = err_msg ? err_msg : "Unknown error";
         sqlite3_free(err_msg);
@@ -145,8 +267,8 @@ nlohmann::json SqliteJobRepository::execute_query(const std::string& sql) {
 
 void SqliteJobRepository::save_job_internal(const std::string& job_id, const nlohmann::json& job) {
     const char* sql = R"(
-        INSERT OR REPLACE INTO jobs (job_id, job_data, status, priority, updated_at) 
-        VALUES (?, ?, ?, ?, datetime('now'))
+        INSERT OR REPLACE INTO jobs (job_id, job_data, status, priority, latest_start, updated_at) 
+        VALUES (?, ?, ?, ?, ?, datetime('now'))
     )";
     
     sqlite3_stmt* stmt = get_prepared_statement(sql);
@@ -159,6 +281,11 @@ void SqliteJobRepository::save_job_internal(const std::string& job_id, const nlo
     sqlite3_bind_text(stmt, 2, job_data.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 3, status.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 4, priority);
+    if (job.contains("latest_start") && job["latest_start"].is_number_integer()) {
+        sqlite3_bind_int64(stmt, 5, job["latest_start"].get<int64_t>());
+    } else {
+        sqlite3_bind_null(stmt, 5);
+    }
     
     int rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
@@ -167,7 +294,7 @@ void SqliteJobRepository::save_job_internal(const std::string& job_id, const nlo
 }
 
 void SqliteJobRepository::save_job(const std::string& job_id, const nlohmann::json& job) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     save_job_internal(job_id, job);
 }
 
@@ -192,12 +319,12 @@ nlohmann::json SqliteJobRepository::get_job_internal(const std::string& job_id)
 }
 
 nlohmann::json SqliteJobRepository::get_job(const std::string& job_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     return get_job_internal(job_id);
 }
 
 std::vector<nlohmann::json> SqliteJobRepository::get_all_jobs() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     std::vector<nlohmann::json> jobs;
     const std::string sql = "SELECT job_data FROM jobs ORDER BY created_at DESC";
@@ -223,12 +350,12 @@ bool SqliteJobRepository::job_exists_internal(const std::string& job_id) {
 }
 
 bool SqliteJobRepository::job_exists(const std::string& job_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     return job_exists_internal(job_id);
 }
 
 void SqliteJobRepository::remove_job(const std::string& job_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     const std::string sql = "DELETE FROM jobs WHERE job_id = ?";
     sqlite3_stmt* stmt = get_prepared_statement(sql);
     sqlite3_bind_text(stmt, 1, job_id.c_str(), -1, SQLITE_STATIC);
@@ -236,12 +363,12 @@ void SqliteJobRepository::remove_job(const std::string& job_id) {
 }
 
 void SqliteJobRepository::clear_all_jobs() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     execute_sql("DELETE FROM jobs");
 }
 
 nlohmann::json SqliteJobRepository::get_next_pending_job(const std::vector<std::string>& capable_engines) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     // For now, simple scheduling ignoring capable_engines filter in SQL 
     // unless it becomes a bottleneck. We filter Engines in the scheduler usually.
@@ -252,6 +379,8 @@ nlohmann::json SqliteJobRepository::get_next_pending_job(const std::vector<std::
         WHERE status = 'pending'
         ORDER BY 
             priority DESC,
+            latest_start IS NULL,
+            latest_start ASC,
             created_at ASC
         LIMIT 1
     )";
@@ -274,8 +403,38 @@ nlohmann::json SqliteJobRepository::get_next_pending_job_by_priority(const std::
     return get_next_pending_job(capable_engines);
 }
 
+std::vector<nlohmann::json> SqliteJobRepository::get_pending_jobs(size_t limit) {
+    auto lock = acquire();
+    std::vector<nlohmann::json> jobs;
+
+    const char* sql = R"(
+        SELECT job_data FROM jobs 
+        WHERE status = 'pending'
+        ORDER BY 
+            priority DESC,
+            latest_start IS NULL,
+            latest_start ASC,
+            created_at ASC
+        LIMIT ?
+    )";
+
+    sqlite3_stmt* stmt = get_prepared_statement(sql);
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(limit));
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* job_data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (job_data) {
+            try {
+                jobs.push_back(nlohmann::json::parse(job_data));
+            } catch (...) {}
+        }
+    }
+
+    return jobs;
+}
+
 void SqliteJobRepository::mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     nlohmann::json job = get_job_internal(job_id);
     if (!job.is_null()) {
@@ -286,7 +445,7 @@ void SqliteJobRepository::mark_job_as_failed_retry(const std::string& job_id, in
 }
 
 std::vector<std::string> SqliteJobRepository::get_stale_pending_jobs(int64_t timeout_seconds) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     std::vector<std::string> stale_jobs;
     
     std::string sql = "SELECT job_id FROM jobs WHERE status = 'pending' AND "
@@ -302,7 +461,7 @@ std::vector<std::string> SqliteJobRepository::get_stale_pending_jobs(int64_t tim
 }
 
 std::vector<nlohmann::json> SqliteJobRepository::get_jobs_to_timeout(int timeout_minutes) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
 
     std::string sql = "SELECT job_data FROM jobs WHERE (status = 'assigned' OR status = 'processing') AND "
                       "updated_at < datetime('now', '-" + std::to_string(timeout_minutes) + " minutes')";
@@ -320,7 +479,7 @@ std::vector<nlohmann::json> SqliteJobRepository::get_jobs_to_timeout(int timeout
 }
 
 bool SqliteJobRepository::update_job(const std::string& job_id, const nlohmann::json& updates) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     nlohmann::json job = get_job_internal(job_id);
     if (job.is_null()) return false;
@@ -330,8 +489,7 @@ bool SqliteJobRepository::update_job(const std::string& job_id, const nlohmann::
         job[it.key()] = it.value();
     }
     
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
     job["updated_at"] = now_ms;
     
     save_job_internal(job_id, job);
@@ -339,7 +497,7 @@ bool SqliteJobRepository::update_job(const std::string& job_id, const nlohmann::
 }
 
 std::vector<nlohmann::json> SqliteJobRepository::get_jobs_by_engine(const std::string& engine_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     std::vector<nlohmann::json> jobs;
     const char* sql = "SELECT job_data FROM jobs WHERE json_extract(job_data, '$.assigned_engine') = ?";
@@ -359,7 +517,7 @@ std::vector<nlohmann::json> SqliteJobRepository::get_jobs_by_engine(const std::s
 }
 
 bool SqliteJobRepository::update_job_progress(const std::string& job_id, int progress, const std::string& message) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     nlohmann::json job = get_job_internal(job_id);
     if (job.is_null()) return false;
@@ -367,16 +525,16 @@ bool SqliteJobRepository::update_job_progress(const std::string& job_id, int pro
     job["progress"] = progress;
     job["progress_message"] = message;
     
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
     job["updated_at"] = now_ms;
+    job["progress_at"] = now_ms; // Liveness for the job timeout sweep
     
     save_job_internal(job_id, job);
     return true;
 }
 
 std::vector<nlohmann::json> SqliteJobRepository::get_jobs_by_status(const std::string& status) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
     
     std::vector<nlohmann::json> jobs;
     const char* sql = "SELECT job_data FROM jobs WHERE status = ? ORDER BY created_at ASC";
@@ -395,8 +553,59 @@ std::vector<nlohmann::json> SqliteJobRepository::get_jobs_by_status(const std::s
     return jobs;
 }
 
+std::map<std::string, size_t> SqliteJobRepository::count_jobs_by_tenant(const std::string& status) {
+    auto lock = acquire();
+
+    std::map<std::string, size_t> counts;
+    const char* sql = R"(
+        SELECT COALESCE(json_extract(job_data, '$.tenant'), ''), COUNT(*) FROM jobs
+        WHERE status = ?
+        GROUP BY 1
+    )";
+    sqlite3_stmt* stmt = get_prepared_statement(sql);
+    sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* tenant = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        counts[tenant ? tenant : ""] += static_cast<size_t>(sqlite3_column_int64(stmt, 1));
+    }
+
+    return counts;
+}
+
+std::vector<nlohmann::json> SqliteJobRepository::get_pending_jobs_by_size_class(const std::string& size_class,
+                                                                                size_t limit) {
+    auto lock = acquire();
+    std::vector<nlohmann::json> jobs;
+
+    const char* sql = R"(
+        SELECT job_data FROM jobs
+        WHERE json_extract(job_data, '$.size_class') = ? AND status = 'pending'
+        ORDER BY
+            priority DESC,
+            latest_start IS NULL,
+            latest_start ASC,
+            created_at ASC
+        LIMIT ?
+    )";
+    sqlite3_stmt* stmt = get_prepared_statement(sql);
+    sqlite3_bind_text(stmt, 1, size_class.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(limit));
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* job_data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (job_data) {
+            try {
+                jobs.push_back(nlohmann::json::parse(job_data));
+            } catch (...) {}
+        }
+    }
+
+    return jobs;
+}
+
 std::vector<nlohmann::json> SqliteJobRepository::get_timed_out_jobs(int64_t older_than_timestamp) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    auto lock = acquire();
 
     std::vector<nlohmann::json> jobs;
     const char* sql = "SELECT job_data FROM jobs WHERE status IN ('assigned', 'processing')";
@@ -417,6 +626,32 @@ std::vector<nlohmann::json> SqliteJobRepository::get_timed_out_jobs(int64_t olde
     return jobs;
 }
 
+std::vector<nlohmann::json> SqliteJobRepository::get_jobs_updated_since(int64_t timestamp_ms) {
+    auto lock = acquire();
+
+    // The column is the save time in whole seconds; a second of slack covers
+    // rounding, and the job's own millisecond "updated_at" decides
+    std::vector<nlohmann::json> jobs;
+    const char* sql = "SELECT job_data FROM jobs WHERE updated_at >= datetime(?, 'unixepoch')";
+    sqlite3_stmt* stmt = get_prepared_statement(sql);
+    sqlite3_bind_int64(stmt, 1, timestamp_ms / 1000 - 1);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* job_data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (job_data) {
+            try {
+                nlohmann::json job = nlohmann::json::parse(job_data);
+                if (updated_at_of(job) > timestamp_ms) {
+                    jobs.push_back(std::move(job));
+                }
+            } catch (...) {}
+        }
+    }
+
+    sort_by_update(jobs);
+    return jobs;
+}
+
 // SqliteEngineRepository implementation
 SqliteEngineRepository::SqliteEngineRepository(const std::string& db_path) : db_path_(db_path), db_(nullptr) {
     initialize_database();
@@ -441,7 +676,7 @@ void SqliteEngineRepository::initialize_database() {
     }
     
     sqlite3_exec(db_, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
-    sqlite3_busy_timeout(db_, 5000);
+    sqlite3_busy_handler(db_, busy_handler, &waits_);
 
     const char* sql = R"(
         CREATE TABLE IF NOT EXISTS engines (
@@ -610,20 +845,10 @@ void InMemoryJobRepository::clear_all_jobs() {
 nlohmann::json InMemoryJobRepository::get_next_pending_job(const std::vector<std::string>& capable_engines) {
     std::lock_guard<std::mutex> lock(mutex_);
     nlohmann::json best_job = nullptr;
-    int highest_priority = -1;
-    int64_t oldest_created_at = std::numeric_limits<int64_t>::max();
-    
     for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
         const auto& job = it.value();
-        if (job.value("status", "") == "pending") {
-            int priority = job.value("priority", 0);
-            int64_t created_at = job.value("created_at", 0LL);
-            
-            if (priority > highest_priority || (priority == highest_priority && created_at < oldest_created_at)) {
-                highest_priority = priority;
-                oldest_created_at = created_at;
-                best_job = job;
-            }
+        if (job.value("status", "") == "pending" && (best_job.is_null() || pending_job_precedes(job, best_job))) {
+            best_job = job;
         }
     }
     return best_job;
@@ -633,6 +858,22 @@ nlohmann::json InMemoryJobRepository::get_next_pending_job_by_priority(const std
     return get_next_pending_job(capable_engines);
 }
 
+std::vector<nlohmann::json> InMemoryJobRepository::get_pending_jobs(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<nlohmann::json> jobs;
+    for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+        if (it.value().value("status", "") == "pending") {
+            jobs.push_back(it.value());
+        }
+    }
+
+    std::stable_sort(jobs.begin(), jobs.end(), pending_job_precedes);
+    if (jobs.size() > limit) {
+        jobs.resize(limit);
+    }
+    return jobs;
+}
+
 void InMemoryJobRepository::mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (jobs_.contains(job_id)) {
@@ -644,7 +885,7 @@ void InMemoryJobRepository::mark_job_as_failed_retry(const std::string& job_id,
 std::vector<std::string> InMemoryJobRepository::get_stale_pending_jobs(int64_t timeout_seconds) {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> stale_jobs;
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
     
     for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
         const auto& job = it.value();
@@ -661,7 +902,7 @@ std::vector<std::string> InMemoryJobRepository::get_stale_pending_jobs(int64_t t
 std::vector<nlohmann::json> InMemoryJobRepository::get_jobs_to_timeout(int timeout_minutes) {
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<nlohmann::json> result;
-    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto now_ms = wall_clock_ms();
 
     for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
         const auto& job = it.value();
@@ -683,7 +924,7 @@ bool InMemoryJobRepository::update_job(const std::string& job_id, const nlohmann
     for (auto it = updates.begin(); it != updates.end(); ++it) {
         jobs_[job_id][it.key()] = it.value();
     }
-    jobs_[job_id]["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    jobs_[job_id]["updated_at"] = wall_clock_ms();
     return true;
 }
 
@@ -691,7 +932,8 @@ std::vector<nlohmann::json> InMemoryJobRepository::get_jobs_by_engine(const std:
     std::lock_guard<std::mutex> lock(mutex_);
     std::vector<nlohmann::json> result;
     for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
-        if (it.value().value("assigned_engine", "") == engine_id) result.push_back(it.value());
+        const auto& job = it.value();
+        if (job.contains("assigned_engine") && job["assigned_engine"] == engine_id) result.push_back(job);
     }
     return result;
 }
@@ -701,7 +943,8 @@ bool InMemoryJobRepository::update_job_progress(const std::string& job_id, int p
     if (!jobs_.contains(job_id)) return false;
     jobs_[job_id]["progress"] = progress;
     jobs_[job_id]["progress_message"] = message;
-    jobs_[job_id]["updated_at"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    jobs_[job_id]["updated_at"] = wall_clock_ms();
+    jobs_[job_id]["progress_at"] = jobs_[job_id]["updated_at"]; // Liveness for the job timeout sweep
     return true;
 }
 
@@ -7,6 +7,7 @@
 #include <memory>
 #include <mutex>
 #include <map>
+#include "metrics.h"
 
 struct sqlite3;
 struct sqlite3_stmt;
@@ -14,6 +15,11 @@ struct sqlite3_stmt;
 namespace distconv {
 namespace DispatchServer {
 
+// Queue order of pending jobs: priority descending; within a priority, jobs
+// with a deadline by "latest_start" (earliest deadline first, net of predicted
+// runtime), then everything else oldest first.
+bool pending_job_precedes(const nlohmann::json& a, const nlohmann::json& b);
+
 // Abstract interface for job repository
 class IJobRepository {
 public:
@@ -28,6 +34,8 @@ public:
     // New methods for improved scheduling
     virtual nlohmann::json get_next_pending_job(const std::vector<std::string>& capable_engines) = 0;
     virtual nlohmann::json get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) = 0;
+    // Head of the pending queue in claim order (priority DESC, created_at ASC)
+    virtual std::vector<nlohmann::json> get_pending_jobs(size_t limit) = 0;
     virtual void mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) = 0;
     virtual std::vector<std::string> get_stale_pending_jobs(int64_t timeout_seconds) = 0;
     virtual std::vector<nlohmann::json> get_jobs_to_timeout(int timeout_minutes) = 0;
@@ -40,6 +48,19 @@ public:
 
     // Optimization for timeout check
     virtual std::vector<nlohmann::json> get_timed_out_jobs(int64_t older_than_timestamp) = 0;
+
+    // Number of jobs in the status by "tenant" ("" for jobs without one). The
+    // default walks get_jobs_by_status; repositories that can count natively override it.
+    virtual std::map<std::string, size_t> count_jobs_by_tenant(const std::string& status);
+
+    // Pending jobs stamped with the "size_class" (small/medium/large), in queue
+    // order. The default walks get_jobs_by_status; SQLite uses an expression index.
+    virtual std::vector<nlohmann::json> get_pending_jobs_by_size_class(const std::string& size_class, size_t limit);
+
+    // Jobs whose "updated_at" is after the timestamp, oldest change first; what
+    // a restart replays on top of the state snapshot. The default walks
+    // get_all_jobs; SQLite narrows by its updated_at index first.
+    virtual std::vector<nlohmann::json> get_jobs_updated_since(int64_t timestamp_ms);
 };
 
 // Abstract interface for engine repository
@@ -54,6 +75,18 @@ public:
     virtual void clear_all_engines() = 0;
 };
 
+// Lock contention of a SQLite repository, recorded into the default metrics
+// registry: every backoff sleep while another connection holds the database
+// lock, statements that gave up with SQLITE_BUSY after 5 s of them, and
+// contended acquisitions of the repository's own mutex
+struct SqliteWaitMetrics {
+    explicit SqliteWaitMetrics(const std::string& database);
+
+    Histogram* busy_wait;
+    Counter* busy_timeouts;
+    Histogram* lock_wait;
+};
+
 // SQLite-based job repository implementation
 class SqliteJobRepository : public IJobRepository {
 private:
@@ -61,6 +94,10 @@ private:
     sqlite3* db_ = nullptr;
     mutable std::mutex mutex_;
     std::map<std::string, sqlite3_stmt*> statements_;
+    SqliteWaitMetrics waits_{"jobs"};
+
+    // Locks mutex_, timing the wait when another thread holds it
+    std::unique_lock<std::mutex> acquire() const;
 
     sqlite3_stmt* get_prepared_statement(const std::string& sql);
 
@@ -86,6 +123,7 @@ public:
     
     nlohmann::json get_next_pending_job(const std::vector<std::string>& capable_engines) override;
     nlohmann::json get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) override;
+    std::vector<nlohmann::json> get_pending_jobs(size_t limit) override;
     void mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) override;
     std::vector<std::string> get_stale_pending_jobs(int64_t timeout_seconds) override;
     std::vector<nlohmann::json> get_jobs_to_timeout(int timeout_minutes) override;
@@ -96,6 +134,9 @@ public:
     std::vector<nlohmann::json> get_jobs_by_status(const std::string& status) override;
 
     std::vector<nlohmann::json> get_timed_out_jobs(int64_t older_than_timestamp) override;
+    std::map<std::string, size_t> count_jobs_by_tenant(const std::string& status) override;
+    std::vector<nlohmann::json> get_pending_jobs_by_size_class(const std::string& size_class, size_t limit) override;
+    std::vector<nlohmann::json> get_jobs_updated_since(int64_t timestamp_ms) override;
 };
 
 // SQLite-based engine repository implementation
@@ -104,6 +145,7 @@ private:
     std::string db_path_;
     sqlite3* db_ = nullptr;
     mutable std::mutex mutex_;
+    SqliteWaitMetrics waits_{"engines"};
     
     void initialize_database();
     void execute_sql(const std::string& sql);
@@ -142,6 +184,7 @@ public:
     
     nlohmann::json get_next_pending_job(const std::vector<std::string>& capable_engines) override;
     nlohmann::json get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) override;
+    std::vector<nlohmann::json> get_pending_jobs(size_t limit) override;
     void mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) override;
     std::vector<std::string> get_stale_pending_jobs(int64_t timeout_seconds) override;
     std::vector<nlohmann::json> get_jobs_to_timeout(int timeout_minutes) override;
@@ -0,0 +1,189 @@
+#include "repository_metrics.h"
+#include <chrono>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+const char* const JOB_OPERATIONS[] = {
+    "save_job", "get_job", "get_all_jobs", "job_exists", "remove_job", "clear_all_jobs", "get_next_pending_job",
+    "get_next_pending_job_by_priority", "get_pending_jobs", "mark_job_as_failed_retry", "get_stale_pending_jobs",
+    "get_jobs_to_timeout", "update_job", "get_jobs_by_engine", "update_job_progress", "get_jobs_by_status",
+    "get_timed_out_jobs", "count_jobs_by_tenant", "get_pending_jobs_by_size_class",
+    "get_jobs_updated_since"};
+
+const char* const ENGINE_OPERATIONS[] = {"save_engine", "get_engine", "get_all_engines", "engine_exists",
+                                         "remove_engine", "clear_all_engines"};
+
+// Observes on the way out, whether the call returns or throws
+class Timer {
+public:
+    explicit Timer(Histogram* latency) : latency_(latency), start_(std::chrono::steady_clock::now()) {}
+    ~Timer() { latency_->observe_since(start_); }
+
+private:
+    Histogram* latency_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+template <size_t N>
+void lookup(Histogram* (&latency)[N], const char* const (&names)[N], MetricsRegistry& metrics,
+            const std::string& repository) {
+    for (size_t i = 0; i < N; ++i) {
+        latency[i] = &metrics.histogram("dispatch_repository_operation_seconds", "Repository call latency",
+                                        latency_buckets(), {{"repository", repository}, {"operation", names[i]}});
+    }
+}
+
+} // namespace
+
+InstrumentedJobRepository::InstrumentedJobRepository(std::shared_ptr<IJobRepository> inner,
+                                                     std::shared_ptr<MetricsRegistry> metrics)
+    : inner_(std::move(inner)) {
+    static_assert(sizeof(JOB_OPERATIONS) / sizeof(JOB_OPERATIONS[0]) == OPERATIONS, "one name per operation");
+    lookup(latency_, JOB_OPERATIONS, *metrics, "jobs");
+}
+
+void InstrumentedJobRepository::save_job(const std::string& job_id, const nlohmann::json& job) {
+    Timer timer(latency_[SaveJob]);
+    inner_->save_job(job_id, job);
+}
+
+nlohmann::json InstrumentedJobRepository::get_job(const std::string& job_id) {
+    Timer timer(latency_[GetJob]);
+    return inner_->get_job(job_id);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_all_jobs() {
+    Timer timer(latency_[GetAllJobs]);
+    return inner_->get_all_jobs();
+}
+
+bool InstrumentedJobRepository::job_exists(const std::string& job_id) {
+    Timer timer(latency_[JobExists]);
+    return inner_->job_exists(job_id);
+}
+
+void InstrumentedJobRepository::remove_job(const std::string& job_id) {
+    Timer timer(latency_[RemoveJob]);
+    inner_->remove_job(job_id);
+}
+
+void InstrumentedJobRepository::clear_all_jobs() {
+    Timer timer(latency_[ClearAllJobs]);
+    inner_->clear_all_jobs();
+}
+
+nlohmann::json InstrumentedJobRepository::get_next_pending_job(const std::vector<std::string>& capable_engines) {
+    Timer timer(latency_[GetNextPendingJob]);
+    return inner_->get_next_pending_job(capable_engines);
+}
+
+nlohmann::json InstrumentedJobRepository::get_next_pending_job_by_priority(
+    const std::vector<std::string>& capable_engines) {
+    Timer timer(latency_[GetNextPendingJobByPriority]);
+    return inner_->get_next_pending_job_by_priority(capable_engines);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_pending_jobs(size_t limit) {
+    Timer timer(latency_[GetPendingJobs]);
+    return inner_->get_pending_jobs(limit);
+}
+
+void InstrumentedJobRepository::mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) {
+    Timer timer(latency_[MarkJobAsFailedRetry]);
+    inner_->mark_job_as_failed_retry(job_id, retry_after_timestamp);
+}
+
+std::vector<std::string> InstrumentedJobRepository::get_stale_pending_jobs(int64_t timeout_seconds) {
+    Timer timer(latency_[GetStalePendingJobs]);
+    return inner_->get_stale_pending_jobs(timeout_seconds);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_jobs_to_timeout(int timeout_minutes) {
+    Timer timer(latency_[GetJobsToTimeout]);
+    return inner_->get_jobs_to_timeout(timeout_minutes);
+}
+
+bool InstrumentedJobRepository::update_job(const std::string& job_id, const nlohmann::json& updates) {
+    Timer timer(latency_[UpdateJob]);
+    return inner_->update_job(job_id, updates);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_jobs_by_engine(const std::string& engine_id) {
+    Timer timer(latency_[GetJobsByEngine]);
+    return inner_->get_jobs_by_engine(engine_id);
+}
+
+bool InstrumentedJobRepository::update_job_progress(const std::string& job_id, int progress,
+                                                    const std::string& message) {
+    Timer timer(latency_[UpdateJobProgress]);
+    return inner_->update_job_progress(job_id, progress, message);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_jobs_by_status(const std::string& status) {
+    Timer timer(latency_[GetJobsByStatus]);
+    return inner_->get_jobs_by_status(status);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_timed_out_jobs(int64_t older_than_timestamp) {
+    Timer timer(latency_[GetTimedOutJobs]);
+    return inner_->get_timed_out_jobs(older_than_timestamp);
+}
+
+std::map<std::string, size_t> InstrumentedJobRepository::count_jobs_by_tenant(const std::string& status) {
+    Timer timer(latency_[CountJobsByTenant]);
+    return inner_->count_jobs_by_tenant(status);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_pending_jobs_by_size_class(const std::string& size_class,
+                                                                                      size_t limit) {
+    Timer timer(latency_[GetPendingJobsBySizeClass]);
+    return inner_->get_pending_jobs_by_size_class(size_class, limit);
+}
+
+std::vector<nlohmann::json> InstrumentedJobRepository::get_jobs_updated_since(int64_t timestamp_ms) {
+    Timer timer(latency_[GetJobsUpdatedSince]);
+    return inner_->get_jobs_updated_since(timestamp_ms);
+}
+
+InstrumentedEngineRepository::InstrumentedEngineRepository(std::shared_ptr<IEngineRepository> inner,
+                                                           std::shared_ptr<MetricsRegistry> metrics)
+    : inner_(std::move(inner)) {
+    static_assert(sizeof(ENGINE_OPERATIONS) / sizeof(ENGINE_OPERATIONS[0]) == OPERATIONS, "one name per operation");
+    lookup(latency_, ENGINE_OPERATIONS, *metrics, "engines");
+}
+
+void InstrumentedEngineRepository::save_engine(const std::string& engine_id, const nlohmann::json& engine) {
+    Timer timer(latency_[SaveEngine]);
+    inner_->save_engine(engine_id, engine);
+}
+
+nlohmann::json InstrumentedEngineRepository::get_engine(const std::string& engine_id) {
+    Timer timer(latency_[GetEngine]);
+    return inner_->get_engine(engine_id);
+}
+
+std::vector<nlohmann::json> InstrumentedEngineRepository::get_all_engines() {
+    Timer timer(latency_[GetAllEngines]);
+    return inner_->get_all_engines();
+}
+
+bool InstrumentedEngineRepository::engine_exists(const std::string& engine_id) {
+    Timer timer(latency_[EngineExists]);
+    return inner_->engine_exists(engine_id);
+}
+
+void InstrumentedEngineRepository::remove_engine(const std::string& engine_id) {
+    Timer timer(latency_[RemoveEngine]);
+    inner_->remove_engine(engine_id);
+}
+
+void InstrumentedEngineRepository::clear_all_engines() {
+    Timer timer(latency_[ClearAllEngines]);
+    inner_->clear_all_engines();
+}
+
+} // namespace DispatchServer
+} // namespace distconv
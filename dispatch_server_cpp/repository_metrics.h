@@ -0,0 +1,77 @@
+#ifndef REPOSITORY_METRICS_H
+#define REPOSITORY_METRICS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "metrics.h"
+#include "repositories.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+// Repository decorators timing every call into
+// dispatch_repository_operation_seconds{repository, operation}. The series
+// are looked up once, so a call costs two clock reads and a histogram update.
+class InstrumentedJobRepository : public IJobRepository {
+public:
+    InstrumentedJobRepository(std::shared_ptr<IJobRepository> inner, std::shared_ptr<MetricsRegistry> metrics);
+
+    void save_job(const std::string& job_id, const nlohmann::json& job) override;
+    nlohmann::json get_job(const std::string& job_id) override;
+    std::vector<nlohmann::json> get_all_jobs() override;
+    bool job_exists(const std::string& job_id) override;
+    void remove_job(const std::string& job_id) override;
+    void clear_all_jobs() override;
+
+    nlohmann::json get_next_pending_job(const std::vector<std::string>& capable_engines) override;
+    nlohmann::json get_next_pending_job_by_priority(const std::vector<std::string>& capable_engines) override;
+    std::vector<nlohmann::json> get_pending_jobs(size_t limit) override;
+    void mark_job_as_failed_retry(const std::string& job_id, int64_t retry_after_timestamp) override;
+    std::vector<std::string> get_stale_pending_jobs(int64_t timeout_seconds) override;
+    std::vector<nlohmann::json> get_jobs_to_timeout(int timeout_minutes) override;
+
+    bool update_job(const std::string& job_id, const nlohmann::json& updates) override;
+    std::vector<nlohmann::json> get_jobs_by_engine(const std::string& engine_id) override;
+    bool update_job_progress(const std::string& job_id, int progress, const std::string& message) override;
+    std::vector<nlohmann::json> get_jobs_by_status(const std::string& status) override;
+
+    std::vector<nlohmann::json> get_timed_out_jobs(int64_t older_than_timestamp) override;
+    std::map<std::string, size_t> count_jobs_by_tenant(const std::string& status) override;
+    std::vector<nlohmann::json> get_pending_jobs_by_size_class(const std::string& size_class, size_t limit) override;
+    std::vector<nlohmann::json> get_jobs_updated_since(int64_t timestamp_ms) override;
+
+private:
+    enum Operation {
+        SaveJob, GetJob, GetAllJobs, JobExists, RemoveJob, ClearAllJobs, GetNextPendingJob,
+        GetNextPendingJobByPriority, GetPendingJobs, MarkJobAsFailedRetry, GetStalePendingJobs, GetJobsToTimeout,
+        UpdateJob, GetJobsByEngine, UpdateJobProgress, GetJobsByStatus, GetTimedOutJobs, CountJobsByTenant,
+        GetPendingJobsBySizeClass, GetJobsUpdatedSince, OPERATIONS
+    };
+
+    std::shared_ptr<IJobRepository> inner_;
+    Histogram* latency_[OPERATIONS];
+};
+
+class InstrumentedEngineRepository : public IEngineRepository {
+public:
+    InstrumentedEngineRepository(std::shared_ptr<IEngineRepository> inner, std::shared_ptr<MetricsRegistry> metrics);
+
+    void save_engine(const std::string& engine_id, const nlohmann::json& engine) override;
+    nlohmann::json get_engine(const std::string& engine_id) override;
+    std::vector<nlohmann::json> get_all_engines() override;
+    bool engine_exists(const std::string& engine_id) override;
+    void remove_engine(const std::string& engine_id) override;
+    void clear_all_engines() override;
+
+private:
+    enum Operation { SaveEngine, GetEngine, GetAllEngines, EngineExists, RemoveEngine, ClearAllEngines, OPERATIONS };
+
+    std::shared_ptr<IEngineRepository> inner_;
+    Histogram* latency_[OPERATIONS];
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // REPOSITORY_METRICS_H
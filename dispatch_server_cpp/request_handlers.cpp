@@ -40,6 +40,11 @@ void set_json_response(httplib::Response& res, const nlohmann::json& data, int s
     res.set_content(data.dump(), "application/json");
 }
 
+std::string path_param(const httplib::Request& req, const std::string& name) {
+    auto it = req.path_params.find(name);
+    return it == req.path_params.end() ? std::string() : it->second;
+}
+
 void set_error_response(httplib::Response& res, const std::string& message, int status) {
     res.status = status;
     res.set_content(message, "text/plain");
@@ -36,6 +36,10 @@ void set_json_error_response(httplib::Response& res, const std::string& error_me
                              const std::string& error_type, int status,
                              const std::string& details = "");
 
+// Segment captured by the matched route pattern, e.g. "job_id" in
+// /jobs/{job_id:uuid}; empty when the route has no such capture
+std::string path_param(const httplib::Request& req, const std::string& name);
+
 } // namespace DispatchServer
 } // namespace distconv
 
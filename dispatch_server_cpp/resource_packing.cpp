@@ -0,0 +1,131 @@
+#include "resource_packing.h"
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+constexpr double UNBOUNDED = std::numeric_limits<double>::infinity();
+
+double number_field(const nlohmann::json& object, const char* key, double fallback) {
+    return object.is_object() && object.contains(key) && object[key].is_number() ? object[key].get<double>()
+                                                                                 : fallback;
+}
+
+bool occupies_slot(const nlohmann::json& job, const std::string& engine_id) {
+    if (job.contains("assigned_engine") && job["assigned_engine"] == engine_id) {
+        return true;
+    }
+    return job.contains("speculation") && job["speculation"].is_object() &&
+           job["speculation"].value("state", "") == "running" &&
+           job["speculation"].value("engine", "") == engine_id;
+}
+
+} // namespace
+
+Resources& Resources::operator+=(const Resources& other) {
+    slots += other.slots;
+    cpu_cores += other.cpu_cores;
+    memory_gb += other.memory_gb;
+    scratch_gb += other.scratch_gb;
+    return *this;
+}
+
+Resources& Resources::operator-=(const Resources& other) {
+    slots -= other.slots;
+    cpu_cores -= other.cpu_cores;
+    memory_gb -= other.memory_gb;
+    scratch_gb -= other.scratch_gb;
+    return *this;
+}
+
+bool Resources::covers(const Resources& demand) const {
+    return slots >= demand.slots && cpu_cores >= demand.cpu_cores && memory_gb >= demand.memory_gb &&
+           scratch_gb >= demand.scratch_gb;
+}
+
+Resources engine_capacity(const nlohmann::json& engine) {
+    nlohmann::json capacity = engine.is_object() ? engine.value("capacity", nlohmann::json::object())
+                                                 : nlohmann::json::object();
+    Resources total;
+    total.slots = std::max(1.0, number_field(capacity, "slots", 1));
+    total.cpu_cores = number_field(capacity, "cpu_cores", UNBOUNDED);
+    total.memory_gb = number_field(capacity, "memory_gb", UNBOUNDED);
+    total.scratch_gb = number_field(capacity, "scratch_gb", UNBOUNDED);
+    return total;
+}
+
+size_t engine_slots(const nlohmann::json& engine) {
+    double slots = engine_capacity(engine).slots;
+    return std::isfinite(slots) ? static_cast<size_t>(slots) : 1;
+}
+
+Resources job_demand(const nlohmann::json& job) {
+    nlohmann::json requirements = job.is_object() ? job.value("resource_requirements", nlohmann::json::object())
+                                                  : nlohmann::json::object();
+    Resources demand;
+    demand.slots = 1;
+    demand.cpu_cores = number_field(requirements, "cpu_cores", 0);
+    demand.memory_gb = number_field(requirements, "memory_gb", 0);
+    demand.scratch_gb = number_field(requirements, "scratch_gb", 0);
+    return demand;
+}
+
+std::string validate_resource_requirements(const nlohmann::json& requirements) {
+    if (!requirements.is_object()) {
+        return "'resource_requirements' must be an object.";
+    }
+    for (const char* key : {"cpu_cores", "memory_gb", "scratch_gb"}) {
+        if (requirements.contains(key) && (!requirements[key].is_number() || requirements[key].get<double>() < 0)) {
+            return std::string("'resource_requirements.") + key + "' must be a non-negative number.";
+        }
+    }
+    return "";
+}
+
+std::vector<nlohmann::json> jobs_running_on(IJobRepository& job_repo, const std::string& engine_id) {
+    std::vector<nlohmann::json> running;
+    for (const char* status : {"assigned", "processing"}) {
+        for (auto& job : job_repo.get_jobs_by_status(status)) {
+            if (occupies_slot(job, engine_id)) {
+                running.push_back(std::move(job));
+            }
+        }
+    }
+    return running;
+}
+
+Resources free_capacity(const nlohmann::json& engine, const std::vector<nlohmann::json>& running) {
+    Resources free = engine_capacity(engine);
+    std::set<std::string> batches;
+    for (const auto& job : running) {
+        Resources demand = job_demand(job);
+        // A batch runs in one process, so it takes a single slot
+        if (job.contains("batch_id") && job["batch_id"].is_string() && !batches.insert(job["batch_id"]).second) {
+            demand.slots = 0;
+        }
+        free -= demand;
+    }
+    return free;
+}
+
+double packing_score(const Resources& demand, const Resources& free, const Resources& total) {
+    if (!free.covers(demand)) {
+        return -1.0;
+    }
+    // Every job takes one slot, so only the other dimensions tell candidates apart
+    double score = 0;
+    const double Resources::*dimensions[] = {&Resources::cpu_cores, &Resources::memory_gb, &Resources::scratch_gb};
+    for (auto dimension : dimensions) {
+        if (total.*dimension != UNBOUNDED && total.*dimension > 0) {
+            score += (free.*dimension - demand.*dimension) / total.*dimension;
+        }
+    }
+    return score;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
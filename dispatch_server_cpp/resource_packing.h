@@ -0,0 +1,51 @@
+#ifndef RESOURCE_PACKING_H
+#define RESOURCE_PACKING_H
+
+#include "repositories.h"
+#include "nlohmann/json.hpp"
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Engine capacity and job demand along the dimensions engines report:
+//   heartbeat:  "capacity": {"slots": 8, "cpu_cores": 64, "memory_gb": 256, "scratch_gb": 2000}
+//   job:        "resource_requirements": {"cpu_cores": 8, "memory_gb": 16, "scratch_gb": 40}
+// An engine without "capacity" has one slot and no other limits; a dimension
+// it leaves out is unbounded. Every job takes one slot; the jobs of one batched
+// assignment (same "batch_id") share a single slot.
+struct Resources {
+    double slots = 0;
+    double cpu_cores = 0;
+    double memory_gb = 0;
+    double scratch_gb = 0;
+
+    Resources& operator+=(const Resources& other);
+    Resources& operator-=(const Resources& other);
+    bool covers(const Resources& demand) const;
+};
+
+Resources engine_capacity(const nlohmann::json& engine);
+// Whole job slots the engine offers (at least one)
+size_t engine_slots(const nlohmann::json& engine);
+Resources job_demand(const nlohmann::json& job);
+
+// Empty when the requirements are well-formed, otherwise what is wrong with them
+std::string validate_resource_requirements(const nlohmann::json& requirements);
+
+// Assigned/processing jobs occupying a slot on the engine, speculative copies included
+std::vector<nlohmann::json> jobs_running_on(IJobRepository& job_repo, const std::string& engine_id);
+
+// Capacity left after the given running jobs
+Resources free_capacity(const nlohmann::json& engine, const std::vector<nlohmann::json>& running);
+
+// Best-fit score of placing demand into free (lower packs tighter): the share
+// of the engine's total capacity left idle, summed over its bounded
+// dimensions. Negative when the job does not fit.
+double packing_score(const Resources& demand, const Resources& free, const Resources& total);
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // RESOURCE_PACKING_H
@@ -0,0 +1,112 @@
+#include "resource_versions.h"
+#include <cstdio>
+#include <random>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+std::string new_epoch() {
+    std::random_device device;
+    std::uniform_int_distribution<uint32_t> digits;
+    char epoch[17];
+    std::snprintf(epoch, sizeof(epoch), "%08x%08x", digits(device), digits(device));
+    return epoch;
+}
+
+} // namespace
+
+ResourceVersions::ResourceVersions() : epoch_(new_epoch()) {}
+
+void ResourceVersions::job_changed(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_[job_id] = ++version_;
+}
+
+void ResourceVersions::all_jobs_changed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Unwritten jobs fall back to version 0, so tags issued for them must go too
+    epoch_ = new_epoch();
+    jobs_.clear();
+}
+
+void ResourceVersions::engines_changed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    engines_version_ = ++version_;
+}
+
+std::string ResourceVersions::job_etag(const std::string& job_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(job_id);
+    return etag(it == jobs_.end() ? 0 : it->second);
+}
+
+std::string ResourceVersions::engines_etag() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return etag(engines_version_);
+}
+
+size_t ResourceVersions::tracked_jobs() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+std::string ResourceVersions::etag(uint64_t version) const {
+    return "\"" + epoch_ + "-" + std::to_string(version) + "\"";
+}
+
+bool etag_matches(const httplib::Request& req, const std::string& etag) {
+    if (!req.has_header("If-None-Match")) return false;
+    const std::string header = req.get_header_value("If-None-Match");
+
+    size_t start = 0;
+    while (start < header.size()) {
+        size_t end = header.find(',', start);
+        if (end == std::string::npos) end = header.size();
+        size_t first = header.find_first_not_of(" \t", start);
+        size_t last = header.find_last_not_of(" \t", end - 1);
+        if (first != std::string::npos && first < end && last >= first) {
+            std::string candidate = header.substr(first, last - first + 1);
+            // Weak comparison, as RFC 9110 requires for If-None-Match
+            if (candidate.rfind("W/", 0) == 0) candidate.erase(0, 2);
+            if (candidate == "*" || candidate == etag) return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+VersionedEngineRepository::VersionedEngineRepository(std::shared_ptr<IEngineRepository> inner,
+                                                     std::shared_ptr<ResourceVersions> versions)
+    : inner_(inner), versions_(versions) {}
+
+void VersionedEngineRepository::save_engine(const std::string& engine_id, const nlohmann::json& engine) {
+    inner_->save_engine(engine_id, engine);
+    versions_->engines_changed();
+}
+
+nlohmann::json VersionedEngineRepository::get_engine(const std::string& engine_id) {
+    return inner_->get_engine(engine_id);
+}
+
+std::vector<nlohmann::json> VersionedEngineRepository::get_all_engines() {
+    return inner_->get_all_engines();
+}
+
+bool VersionedEngineRepository::engine_exists(const std::string& engine_id) {
+    return inner_->engine_exists(engine_id);
+}
+
+void VersionedEngineRepository::remove_engine(const std::string& engine_id) {
+    inner_->remove_engine(engine_id);
+    versions_->engines_changed();
+}
+
+void VersionedEngineRepository::clear_all_engines() {
+    inner_->clear_all_engines();
+    versions_->engines_changed();
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,70 @@
+#ifndef RESOURCE_VERSIONS_H
+#define RESOURCE_VERSIONS_H
+
+#include "httplib.h"
+#include "repositories.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace distconv {
+namespace DispatchServer {
+
+// In-memory version counters behind the ETags of GET /jobs/{id} and
+// GET /engines/, so a poll whose If-None-Match still matches is answered 304
+// without reading the repositories. Every write bumps one global counter and
+// stamps it on the job (or the engine list); a job not written since startup
+// is at version 0. ETags carry a random per-process epoch, so tags handed out
+// before a restart never match. Only writes made through the decorated
+// repositories are seen.
+class ResourceVersions {
+public:
+    ResourceVersions();
+
+    void job_changed(const std::string& job_id);
+    void all_jobs_changed();
+    void engines_changed();
+
+    // Read before loading the resource: a write in between can only make the
+    // tag older than the body, which costs one extra full response
+    std::string job_etag(const std::string& job_id) const;
+    std::string engines_etag() const;
+
+    size_t tracked_jobs() const;
+
+private:
+    std::string etag(uint64_t version) const;
+
+    mutable std::mutex mutex_;
+    std::string epoch_;
+    uint64_t version_ = 0;
+    uint64_t engines_version_ = 0;
+    std::unordered_map<std::string, uint64_t> jobs_;
+};
+
+// Whether the request's If-None-Match lists `etag` (or is "*")
+bool etag_matches(const httplib::Request& req, const std::string& etag);
+
+// Decorates an engine repository so every write bumps the engine list version
+class VersionedEngineRepository : public IEngineRepository {
+public:
+    VersionedEngineRepository(std::shared_ptr<IEngineRepository> inner, std::shared_ptr<ResourceVersions> versions);
+
+    void save_engine(const std::string& engine_id, const nlohmann::json& engine) override;
+    nlohmann::json get_engine(const std::string& engine_id) override;
+    std::vector<nlohmann::json> get_all_engines() override;
+    bool engine_exists(const std::string& engine_id) override;
+    void remove_engine(const std::string& engine_id) override;
+    void clear_all_engines() override;
+
+private:
+    std::shared_ptr<IEngineRepository> inner_;
+    std::shared_ptr<ResourceVersions> versions_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // RESOURCE_VERSIONS_H
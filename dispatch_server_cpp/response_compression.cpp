@@ -0,0 +1,239 @@
+#include "response_compression.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+constexpr size_t OUTPUT_BUFFER_BYTES = 16 * 1024;
+
+class GzipCompressor final : public httplib::detail::compressor {
+public:
+    explicit GzipCompressor(int level) {
+        std::memset(&strm_, 0, sizeof(strm_));
+        // 15 + 16: the largest window, with a gzip header and trailer
+        valid_ = deflateInit2(&strm_, std::min(std::max(level, 1), 9), Z_DEFLATED, 15 + 16, 8,
+                              Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    ~GzipCompressor() override {
+        if (valid_) deflateEnd(&strm_);
+    }
+
+    bool compress(const char* data, size_t data_length, bool last, Callback callback) override {
+        if (!valid_) return false;
+        std::array<char, OUTPUT_BUFFER_BYTES> out;
+        size_t offset = 0;
+        do {
+            // zlib counts input in uInt
+            size_t piece = std::min<size_t>(data_length - offset, std::numeric_limits<uInt>::max());
+            strm_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + offset));
+            strm_.avail_in = static_cast<uInt>(piece);
+            offset += piece;
+            int flush = offset < data_length ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+            do {
+                strm_.next_out = reinterpret_cast<Bytef*>(out.data());
+                strm_.avail_out = static_cast<uInt>(out.size());
+                if (deflate(&strm_, flush) == Z_STREAM_ERROR) return false;
+                size_t produced = out.size() - strm_.avail_out;
+                if (produced > 0 && !callback(out.data(), produced)) return false;
+            } while (strm_.avail_out == 0);
+        } while (offset < data_length);
+        return true;
+    }
+
+private:
+    bool valid_ = false;
+    z_stream strm_;
+};
+
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+class ZstdCompressor final : public httplib::detail::compressor {
+public:
+    explicit ZstdCompressor(int level) : ctx_(ZSTD_createCCtx()) {
+        if (ctx_) ZSTD_CCtx_setParameter(ctx_, ZSTD_c_compressionLevel, std::max(level, 1));
+    }
+
+    ~ZstdCompressor() override { ZSTD_freeCCtx(ctx_); }
+
+    bool compress(const char* data, size_t data_length, bool last, Callback callback) override {
+        if (!ctx_) return false;
+        std::array<char, OUTPUT_BUFFER_BYTES> out;
+        ZSTD_inBuffer in{data, data_length, 0};
+        size_t remaining;
+        do {
+            ZSTD_outBuffer buffer{out.data(), out.size(), 0};
+            remaining = ZSTD_compressStream2(ctx_, &buffer, &in, last ? ZSTD_e_end : ZSTD_e_flush);
+            if (ZSTD_isError(remaining)) return false;
+            if (buffer.pos > 0 && !callback(out.data(), buffer.pos)) return false;
+        } while (remaining != 0);
+        return true;
+    }
+
+private:
+    ZSTD_CCtx* ctx_;
+};
+#endif
+
+std::string trimmed_lower(const std::string& text, size_t begin, size_t end) {
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) ++begin;
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+    std::string value = text.substr(begin, end - begin);
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool compressible(const std::string& content_type) {
+    return content_type.rfind("text/", 0) == 0 || content_type.find("json") != std::string::npos ||
+           content_type.find("javascript") != std::string::npos || content_type.find("xml") != std::string::npos;
+}
+
+void weaken_etag(httplib::Response& res) {
+    auto etag = res.headers.find("ETag");
+    if (etag != res.headers.end() && etag->second.rfind("W/", 0) != 0) {
+        etag->second = "W/" + etag->second;
+    }
+}
+
+} // namespace
+
+bool zstd_available() {
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+ContentCoding negotiate_coding(const std::string& accept_encoding) {
+    double gzip = -1, zstd = -1, any = -1;
+    size_t start = 0;
+    while (start < accept_encoding.size()) {
+        size_t end = accept_encoding.find(',', start);
+        if (end == std::string::npos) end = accept_encoding.size();
+
+        size_t params = std::min(accept_encoding.find(';', start), end);
+        std::string name = trimmed_lower(accept_encoding, start, params);
+        double q = 1.0;
+        while (params < end) {
+            size_t next = std::min(accept_encoding.find(';', params + 1), end);
+            std::string param = trimmed_lower(accept_encoding, params + 1, next);
+            if (param.rfind("q=", 0) == 0) q = std::strtod(param.c_str() + 2, nullptr);
+            params = next;
+        }
+
+        if (name == "gzip" || name == "x-gzip") gzip = q;
+        else if (name == "zstd") zstd = q;
+        else if (name == "*") any = q;
+        start = end + 1;
+    }
+
+    if (gzip < 0) gzip = any;
+    if (zstd < 0) zstd = any;
+    if (!zstd_available()) zstd = 0;
+    if (zstd > 0 && zstd >= gzip) return ContentCoding::Zstd;
+    if (gzip > 0) return ContentCoding::Gzip;
+    return ContentCoding::Identity;
+}
+
+const char* coding_name(ContentCoding coding) {
+    switch (coding) {
+        case ContentCoding::Gzip: return "gzip";
+        case ContentCoding::Zstd: return "zstd";
+        default: return "identity";
+    }
+}
+
+std::unique_ptr<httplib::detail::compressor> make_compressor(ContentCoding coding, int level) {
+    switch (coding) {
+        case ContentCoding::Gzip: return std::make_unique<GzipCompressor>(level);
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+        case ContentCoding::Zstd: return std::make_unique<ZstdCompressor>(level);
+#endif
+        default: return std::make_unique<httplib::detail::nocompressor>();
+    }
+}
+
+std::string compress_body(const std::string& body, ContentCoding coding, int level) {
+    std::string encoded;
+    auto compressor = make_compressor(coding, level);
+    bool ok = compressor->compress(body.data(), body.size(), true, [&encoded](const char* data, size_t size) {
+        encoded.append(data, size);
+        return true;
+    });
+    return ok ? encoded : std::string();
+}
+
+ResponseCompression::ResponseCompression(CompressionOptions options) : options_(options) {}
+
+void ResponseCompression::set_options(const CompressionOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+CompressionOptions ResponseCompression::options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+void ResponseCompression::apply(const httplib::Request& req, httplib::Response& res) const {
+    CompressionOptions options = this->options();
+    if (options.level <= 0 || req.method == "HEAD") return;
+    if (res.status < 200 || res.status == 204 || res.status == 206 || res.status == 304) return;
+    if (res.has_header("Content-Encoding") || !compressible(res.get_header_value("Content-Type"))) return;
+
+    bool streamed = static_cast<bool>(res.content_provider_);
+    if (streamed ? !res.is_chunked_content_provider_ : res.body.size() < options.min_bytes) return;
+
+    // From here the bytes sent depend on Accept-Encoding
+    if (!res.has_header("Vary")) res.set_header("Vary", "Accept-Encoding");
+    ContentCoding coding = negotiate_coding(req.get_header_value("Accept-Encoding"));
+    if (coding == ContentCoding::Identity) return;
+
+    if (streamed) {
+        std::shared_ptr<httplib::detail::compressor> compressor = make_compressor(coding, options.level);
+        auto provider = std::move(res.content_provider_);
+        res.content_provider_ = [provider, compressor](size_t offset, size_t length, httplib::DataSink& sink) {
+            auto forward = [&sink](const char* data, size_t size) { return sink.write(data, size); };
+            httplib::DataSink encoded;
+            encoded.write = [&](const char* data, size_t size) {
+                return compressor->compress(data, size, false, forward);
+            };
+            encoded.is_writable = [&sink]() { return sink.is_writable(); };
+            encoded.done = [&]() {
+                compressor->compress(nullptr, 0, true, forward);
+                sink.done();
+            };
+            encoded.done_with_trailer = [&](const httplib::Headers& trailer) {
+                compressor->compress(nullptr, 0, true, forward);
+                sink.done_with_trailer(trailer);
+            };
+            return provider(offset, length, encoded);
+        };
+    } else {
+        std::string encoded = compress_body(res.body, coding, options.level);
+        if (encoded.empty() || encoded.size() >= res.body.size()) return;
+        res.body = std::move(encoded);
+        // httplib has already counted the identity body by the time this runs
+        if (res.has_header("Content-Length")) {
+            res.headers.erase("Content-Length");
+            res.set_header("Content-Length", std::to_string(res.body.size()));
+        }
+    }
+    res.set_header("Content-Encoding", coding_name(coding));
+    weaken_etag(res);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,58 @@
+#ifndef RESPONSE_COMPRESSION_H
+#define RESPONSE_COMPRESSION_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include "httplib.h"
+#include "dispatch_server_constants.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+struct CompressionOptions {
+    int level = Constants::COMPRESSION_LEVEL;            // 1-9; 0 sends everything uncompressed
+    size_t min_bytes = Constants::COMPRESSION_MIN_BYTES; // Smaller buffered bodies are sent as-is
+};
+
+enum class ContentCoding { Identity, Gzip, Zstd };
+
+// Whether this build can produce zstd (libzstd was found at configure time)
+bool zstd_available();
+
+// The coding to answer an Accept-Encoding header with: the highest q-value
+// among the codings this build has, zstd ahead of gzip on a tie
+ContentCoding negotiate_coding(const std::string& accept_encoding);
+const char* coding_name(ContentCoding coding);
+
+// An encoder for one response. Every non-final piece is flushed, so a client
+// reading a stream can decode each event as soon as it arrives.
+std::unique_ptr<httplib::detail::compressor> make_compressor(ContentCoding coding, int level);
+
+// Whole-body encoding; empty if the encoder failed
+std::string compress_body(const std::string& body, ContentCoding coding, int level);
+
+// Encodes responses per the request's Accept-Encoding, after routing and
+// before anything is written. Text and JSON bodies of at least min_bytes are
+// compressed in one go; chunked streams (GET /events) are compressed as they
+// are written. Length-delimited streams and anything already encoded are left
+// alone. A compressed response's ETag is made weak, as its bytes differ from
+// the identity representation's.
+class ResponseCompression {
+public:
+    explicit ResponseCompression(CompressionOptions options = {});
+
+    void set_options(const CompressionOptions& options);
+    CompressionOptions options() const;
+
+    void apply(const httplib::Request& req, httplib::Response& res) const;
+
+private:
+    mutable std::mutex mutex_;
+    CompressionOptions options_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // RESPONSE_COMPRESSION_H
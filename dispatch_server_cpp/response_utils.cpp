@@ -1,5 +1,7 @@
 #include "response_utils.h"
-#include <regex>
+#include <cctype>
+#include <cstring>
+#include <strings.h>
 
 namespace distconv {
 namespace DispatchServer {
@@ -54,12 +56,25 @@ namespace ResponseUtils {
         return true;
     }
     
+    // Same rule as the former ^https?://[^\s/$.?#].[^\s]*$ (case-insensitive)
+    // without building a std::regex per call: an http(s) scheme, then at least
+    // two characters, none of them whitespace, not starting with / $ . ? or #
     bool is_valid_url(const std::string& url) {
-        if (url.empty()) return false;
-        
-        // Basic URL validation regex
-        std::regex url_regex(R"(^https?://[^\s/$.?#].[^\s]*$)", std::regex_constants::icase);
-        return std::regex_match(url, url_regex);
+        size_t rest = 0;
+        if (url.size() >= 7 && strncasecmp(url.c_str(), "http://", 7) == 0) {
+            rest = 7;
+        } else if (url.size() >= 8 && strncasecmp(url.c_str(), "https://", 8) == 0) {
+            rest = 8;
+        } else {
+            return false;
+        }
+        if (url.size() - rest < 2 || std::strchr("/$.?#", url[rest]) != nullptr) {
+            return false;
+        }
+        for (size_t i = rest; i < url.size(); ++i) {
+            if (std::isspace(static_cast<unsigned char>(url[i]))) return false;
+        }
+        return true;
     }
     
     bool validate_output_url(httplib::Response& res, const std::string& url) {
@@ -0,0 +1,184 @@
+#include "retry_policy.h"
+#include "state_snapshot.h"
+#include <algorithm>
+#include <cctype>
+
+namespace distconv {
+namespace DispatchServer {
+
+std::map<std::string, RetryClassPolicy> default_retry_classes() {
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+    const milliseconds base = seconds(Constants::RETRY_DELAY_BASE_SECONDS);
+    const milliseconds cap = Constants::RETRY_BACKOFF_CAP;
+    return {
+        {"download", {5, base, cap}},
+        {"upload", {5, base, cap}},
+        {"transcode", {1, base * 2, cap}},
+        {"timeout", {3, base, cap}},
+        {"engine_lost", {5, seconds(5), seconds(60)}},
+        {"other", {3, base, cap}}
+    };
+}
+
+std::string classify_failure(const nlohmann::json& report, const std::string& error_message) {
+    if (report.is_object() && report.contains("error_class") && report["error_class"].is_string()) {
+        std::string named = report["error_class"];
+        if (default_retry_classes().count(named)) {
+            return named;
+        }
+    }
+    std::string message = error_message;
+    std::transform(message.begin(), message.end(), message.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (message.find("download") != std::string::npos) return "download";
+    if (message.find("upload") != std::string::npos) return "upload";
+    if (message.find("ffmpeg") != std::string::npos || message.find("transcod") != std::string::npos) {
+        return "transcode";
+    }
+    return "other";
+}
+
+RetryScheduler::RetryScheduler(RetryPolicy policy, uint64_t seed)
+    : policy_(std::move(policy)), rng_(seed), tokens_(static_cast<double>(policy_.budget_burst)) {}
+
+void RetryScheduler::set_policy(const RetryPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+    tokens_ = std::min(tokens_, static_cast<double>(policy_.budget_burst));
+}
+
+RetryPolicy RetryScheduler::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+RetryClassPolicy RetryScheduler::class_policy_locked(const std::string& failure_class) const {
+    auto it = policy_.classes.find(failure_class);
+    if (it == policy_.classes.end()) {
+        it = policy_.classes.find("other");
+    }
+    return it != policy_.classes.end() ? it->second : default_retry_classes().at("other");
+}
+
+int64_t RetryScheduler::backoff_locked(const RetryClassPolicy& policy, int attempt) {
+    // base * 2^attempt, without overflowing for large attempt counts
+    int64_t ceiling = policy.base.count();
+    for (int i = 0; i < attempt && ceiling < policy.cap.count(); ++i) {
+        ceiling *= 2;
+    }
+    ceiling = std::min<int64_t>(ceiling, policy.cap.count());
+    if (ceiling <= 0) {
+        return 0;
+    }
+    return std::uniform_int_distribution<int64_t>(0, ceiling)(rng_);
+}
+
+int64_t RetryScheduler::backoff_ms(const std::string& failure_class, int attempt) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backoff_locked(class_policy_locked(failure_class), attempt);
+}
+
+bool RetryScheduler::schedule(nlohmann::json& job, const std::string& failure_class,
+                              const std::string& error_message, int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RetryClassPolicy policy = class_policy_locked(failure_class);
+
+    nlohmann::json counts = job.contains("retry_counts") && job["retry_counts"].is_object()
+                                ? job["retry_counts"] : nlohmann::json::object();
+    int attempts = counts.value(failure_class, 0);
+    int retries = job.value("retries", 0);
+    int max_retries = job.value("max_retries", Constants::DEFAULT_MAX_RETRIES);
+
+    job["failure_class"] = failure_class;
+    job["updated_at"] = now_ms;
+    if (retries >= max_retries || attempts >= policy.max_retries) {
+        job["status"] = "failed_permanently";
+        job["error_message"] = error_message;
+        ++exhausted_;
+        return false;
+    }
+
+    counts[failure_class] = attempts + 1;
+    job["retry_counts"] = counts;
+    job["retries"] = retries + 1;
+    job["status"] = "failed_retry";
+    job["retry_after"] = now_ms + backoff_locked(policy, attempts);
+    ++scheduled_[failure_class];
+    return true;
+}
+
+void RetryScheduler::refill_locked(int64_t now_ms) {
+    if (refilled_at_ >= 0 && now_ms > refilled_at_) {
+        tokens_ = std::min(static_cast<double>(policy_.budget_burst),
+                           tokens_ + (now_ms - refilled_at_) * policy_.budget_per_minute / 60000.0);
+    }
+    refilled_at_ = std::max(refilled_at_, now_ms);
+}
+
+bool RetryScheduler::try_release(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (policy_.budget_per_minute == 0) {
+        return true;
+    }
+    refill_locked(now_ms);
+    if (tokens_ < 1.0) {
+        ++deferred_;
+        return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+}
+
+std::vector<nlohmann::json> RetryScheduler::release_due(IJobRepository& job_repo, int64_t now_ms) {
+    auto jobs = job_repo.get_jobs_by_status("failed_retry");
+    // Longest-waiting retries take the budget first; the rest wait for the next sweep
+    std::sort(jobs.begin(), jobs.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        return a.value("retry_after", 0LL) < b.value("retry_after", 0LL);
+    });
+    std::vector<nlohmann::json> released;
+    for (auto& job : jobs) {
+        if (now_ms < job.value("retry_after", 0LL) || !try_release(now_ms)) {
+            break;
+        }
+        job["status"] = "pending";
+        job_repo.save_job(job["job_id"], job);
+        released.push_back(std::move(job));
+    }
+    return released;
+}
+
+nlohmann::json RetryScheduler::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {{"scheduled", scheduled_}, {"exhausted", exhausted_}, {"deferred", deferred_},
+            {"budget_per_minute", policy_.budget_per_minute}, {"budget_tokens", tokens_}};
+}
+
+void RetryScheduler::save(SnapshotWriter& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.u32(static_cast<uint32_t>(scheduled_.size()));
+    for (const auto& [failure_class, count] : scheduled_) {
+        out.str(failure_class);
+        out.u64(count);
+    }
+    out.u64(exhausted_);
+    out.u64(deferred_);
+}
+
+void RetryScheduler::restore(SnapshotReader& in) {
+    std::map<std::string, uint64_t> scheduled;
+    for (size_t n = in.count(12); n > 0; --n) {
+        std::string failure_class = in.str();
+        scheduled[failure_class] = in.u64();
+    }
+    uint64_t exhausted = in.u64();
+    uint64_t deferred = in.u64();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    scheduled_ = std::move(scheduled);
+    exhausted_ = exhausted;
+    deferred_ = deferred;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
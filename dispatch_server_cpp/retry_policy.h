@@ -0,0 +1,99 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include "dispatch_server_constants.h"
+#include "repositories.h"
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+class SnapshotReader;
+class SnapshotWriter;
+
+struct RetryClassPolicy {
+    int max_retries;                 // Retries of this class per job, on top of the job's own max_retries
+    std::chrono::milliseconds base;  // Backoff ceiling of the first retry
+    std::chrono::milliseconds cap;   // Backoff ceiling never grows past this
+};
+
+// download/upload: storage trouble, often shared by many jobs at once
+// transcode: usually the input; anti-affinity gives it one other engine
+// timeout: ran out of time or stopped reporting progress
+// engine_lost: the engine stopped sending heartbeats mid-job
+// other: anything the failure report does not identify
+std::map<std::string, RetryClassPolicy> default_retry_classes();
+
+struct RetryPolicy {
+    std::map<std::string, RetryClassPolicy> classes = default_retry_classes();
+    size_t budget_per_minute = Constants::RETRY_BUDGET_PER_MINUTE; // 0 = unlimited
+    size_t budget_burst = Constants::RETRY_BUDGET_BURST;
+};
+
+// Failure class of an engine's report: its "error_class" when it names a
+// known class, else keywords of the error message ("download", "upload",
+// "ffmpeg"/"transcod"), else "other"
+std::string classify_failure(const nlohmann::json& report, const std::string& error_message);
+
+// Retry scheduling shared by the failure report, timeout and stale-engine paths.
+//
+// schedule() marks a failed job failed_retry with a full-jitter exponential
+// backoff for its failure class, or failed_permanently once the job's
+// max_retries or the class's retries are spent. Per-class counts are kept in
+// the job's "retry_counts". requeue_failed_jobs then releases due retries
+// through try_release(), the retry budget: a token bucket refilled at
+// budget_per_minute. Retries over budget stay failed_retry until a token frees up.
+class RetryScheduler {
+public:
+    explicit RetryScheduler(RetryPolicy policy = {}, uint64_t seed = std::random_device{}());
+
+    void set_policy(const RetryPolicy& policy);
+    RetryPolicy policy() const;
+
+    // True when the job was scheduled for a retry, false when it failed permanently
+    bool schedule(nlohmann::json& job, const std::string& failure_class, const std::string& error_message,
+                  int64_t now_ms);
+
+    // Jittered delay before the attempt-th (0-based) retry of the class
+    int64_t backoff_ms(const std::string& failure_class, int attempt);
+
+    // Takes a budget token for one due retry; false when the budget is spent
+    bool try_release(int64_t now_ms);
+
+    // Moves due failed_retry jobs back to pending, oldest first, while the
+    // budget lasts; returns the jobs released
+    std::vector<nlohmann::json> release_due(IJobRepository& job_repo, int64_t now_ms);
+
+    nlohmann::json metrics() const;
+
+    // The counters behind metrics(), as a state snapshot section; the budget starts full
+    void save(SnapshotWriter& out) const;
+    void restore(SnapshotReader& in);
+
+private:
+    RetryClassPolicy class_policy_locked(const std::string& failure_class) const;
+    int64_t backoff_locked(const RetryClassPolicy& policy, int attempt);
+    void refill_locked(int64_t now_ms);
+
+    mutable std::mutex mutex_;
+    RetryPolicy policy_;
+    std::mt19937_64 rng_;
+    double tokens_;
+    int64_t refilled_at_ = -1;
+
+    std::map<std::string, uint64_t> scheduled_; // by failure class
+    uint64_t exhausted_ = 0;                     // Failed permanently with retries spent
+    uint64_t deferred_ = 0;                      // Due retries held back by the budget
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // RETRY_POLICY_H
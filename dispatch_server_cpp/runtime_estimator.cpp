@@ -0,0 +1,105 @@
+#include "runtime_estimator.h"
+#include "state_snapshot.h"
+#include <algorithm>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+RuntimeEstimator::RuntimeEstimator(size_t min_samples, size_t sample_window)
+    : min_samples_(std::max<size_t>(1, min_samples)), sample_window_(std::max<size_t>(1, sample_window)) {}
+
+std::string RuntimeEstimator::codec_of(const nlohmann::json& job) {
+    return job.contains("target_codec") && job["target_codec"].is_string() ? job["target_codec"].get<std::string>()
+                                                                            : std::string();
+}
+
+double RuntimeEstimator::size_of(const nlohmann::json& job) {
+    return job.contains("job_size") && job["job_size"].is_number() ? job["job_size"].get<double>() : 0.0;
+}
+
+template <typename T>
+void RuntimeEstimator::push_locked(std::deque<T>& samples, T value) {
+    samples.push_back(value);
+    while (samples.size() > sample_window_) {
+        samples.pop_front();
+    }
+}
+
+template <typename T>
+bool RuntimeEstimator::median_locked(const std::map<std::string, std::deque<T>>& samples, const std::string& codec,
+                                     T& median) const {
+    auto it = samples.find(codec);
+    if (it == samples.end() || it->second.size() < min_samples_) {
+        return false;
+    }
+    std::vector<T> sorted(it->second.begin(), it->second.end());
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    median = sorted[sorted.size() / 2];
+    return median > 0;
+}
+
+void RuntimeEstimator::record(const nlohmann::json& job, int64_t duration_ms) {
+    if (duration_ms <= 0) {
+        return;
+    }
+    std::string codec = codec_of(job);
+    double size = size_of(job);
+    std::lock_guard<std::mutex> lock(mutex_);
+    push_locked(durations_[codec], duration_ms);
+    if (size > 0) {
+        push_locked(ms_per_mb_[codec], duration_ms / size);
+    }
+}
+
+bool RuntimeEstimator::median_duration(const std::string& codec, int64_t& median_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return median_locked(durations_, codec, median_ms);
+}
+
+bool RuntimeEstimator::predict(const nlohmann::json& job, int64_t& runtime_ms) const {
+    std::string codec = codec_of(job);
+    double size = size_of(job);
+    std::lock_guard<std::mutex> lock(mutex_);
+    double rate = 0;
+    if (size > 0 && median_locked(ms_per_mb_, codec, rate)) {
+        runtime_ms = static_cast<int64_t>(rate * size);
+        return true;
+    }
+    return median_locked(durations_, codec, runtime_ms);
+}
+
+void RuntimeEstimator::save(SnapshotWriter& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.u32(static_cast<uint32_t>(durations_.size()));
+    for (const auto& [codec, samples] : durations_) {
+        out.str(codec);
+        out.u32(static_cast<uint32_t>(samples.size()));
+        for (int64_t sample : samples) out.i64(sample);
+    }
+    out.u32(static_cast<uint32_t>(ms_per_mb_.size()));
+    for (const auto& [codec, samples] : ms_per_mb_) {
+        out.str(codec);
+        out.u32(static_cast<uint32_t>(samples.size()));
+        for (double sample : samples) out.f64(sample);
+    }
+}
+
+void RuntimeEstimator::restore(SnapshotReader& in) {
+    std::map<std::string, std::deque<int64_t>> durations;
+    for (size_t codecs = in.count(8); codecs > 0; --codecs) {
+        auto& samples = durations[in.str()];
+        for (size_t n = in.count(8); n > 0; --n) push_locked(samples, in.i64());
+    }
+    std::map<std::string, std::deque<double>> ms_per_mb;
+    for (size_t codecs = in.count(8); codecs > 0; --codecs) {
+        auto& samples = ms_per_mb[in.str()];
+        for (size_t n = in.count(8); n > 0; --n) push_locked(samples, in.f64());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    durations_ = std::move(durations);
+    ms_per_mb_ = std::move(ms_per_mb);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,58 @@
+#ifndef RUNTIME_ESTIMATOR_H
+#define RUNTIME_ESTIMATOR_H
+
+#include "dispatch_server_constants.h"
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+class SnapshotReader;
+class SnapshotWriter;
+
+// Runtimes of completed jobs, by target codec, used to predict how long a job
+// will run. Fed by the completion path (through SpeculationManager) and read
+// by straggler detection and deadline prediction.
+class RuntimeEstimator {
+public:
+    explicit RuntimeEstimator(size_t min_samples = Constants::STRAGGLER_MIN_SAMPLES, size_t sample_window = 50);
+
+    void record(const nlohmann::json& job, int64_t duration_ms);
+
+    // Median runtime of the codec's recent jobs; false until min_samples are in
+    bool median_duration(const std::string& codec, int64_t& median_ms) const;
+
+    // The codec's median time per MB times job_size when both are known, else
+    // the codec's median runtime; false when nothing has been learned for the codec
+    bool predict(const nlohmann::json& job, int64_t& runtime_ms) const;
+
+    // The samples, as a state snapshot section; restore() replaces them
+    void save(SnapshotWriter& out) const;
+    void restore(SnapshotReader& in);
+
+private:
+    static std::string codec_of(const nlohmann::json& job);
+    static double size_of(const nlohmann::json& job);
+    template <typename T>
+    bool median_locked(const std::map<std::string, std::deque<T>>& samples, const std::string& codec,
+                       T& median) const;
+    template <typename T>
+    void push_locked(std::deque<T>& samples, T value);
+
+    const size_t min_samples_;
+    const size_t sample_window_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::deque<int64_t>> durations_; // by target codec
+    std::map<std::string, std::deque<double>> ms_per_mb_;  // by target codec, jobs with a job_size
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // RUNTIME_ESTIMATOR_H
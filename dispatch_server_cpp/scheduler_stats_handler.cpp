@@ -0,0 +1,65 @@
+#include "scheduler_stats_handler.h"
+#include "wall_clock.h"
+#include <chrono>
+
+namespace distconv {
+namespace DispatchServer {
+
+SchedulerStatsHandler::SchedulerStatsHandler(std::shared_ptr<AuthMiddleware> auth,
+                                             std::shared_ptr<SpeculationManager> speculation,
+                                             std::shared_ptr<PreemptionCoordinator> preemption,
+                                             std::shared_ptr<AdmissionController> admission,
+                                             std::shared_ptr<DeadlineMonitor> deadlines,
+                                             std::shared_ptr<SizeLanes> size_lanes,
+                                             std::shared_ptr<EngineHealth> health,
+                                             std::shared_ptr<RetryScheduler> retries,
+                                             std::shared_ptr<EndpointPools> endpoint_pools)
+    : auth_(auth), speculation_(speculation), preemption_(preemption), admission_(admission),
+      deadlines_(deadlines), size_lanes_(size_lanes), health_(health), retries_(retries),
+      endpoint_pools_(endpoint_pools) {}
+
+void SchedulerStatsHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+
+    int64_t now_ms = wall_clock_ms();
+    nlohmann::json stats = nlohmann::json::object();
+    if (preemption_) {
+        stats["preemption"] = preemption_->metrics();
+    }
+    if (speculation_) {
+        stats["speculation"] = {
+            {"active_copies", speculation_->active_copies()},
+            {"queued_stragglers", speculation_->queued_stragglers()}
+        };
+    }
+    if (admission_) {
+        stats["admission"] = admission_->metrics(now_ms);
+    }
+    if (deadlines_) {
+        stats["deadlines"] = deadlines_->metrics();
+    }
+    if (size_lanes_) {
+        stats["size_lanes"] = size_lanes_->metrics(now_ms);
+    }
+    if (health_) {
+        stats["engine_health"] = health_->metrics(now_ms);
+    }
+    if (retries_) {
+        stats["retries"] = retries_->metrics();
+    }
+    if (endpoint_pools_ && endpoint_pools_->running()) {
+        stats["endpoint_pools"] = endpoint_pools_->metrics();
+    }
+    set_json_response(res, stats, 200);
+}
+
+AtRiskJobsHandler::AtRiskJobsHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<DeadlineMonitor> deadlines)
+    : auth_(auth), deadlines_(deadlines) {}
+
+void AtRiskJobsHandler::handle(const httplib::Request& req, httplib::Response& res) {
+    if (!auth_->authenticate(req, res)) return;
+    set_json_response(res, deadlines_->at_risk(), 200);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
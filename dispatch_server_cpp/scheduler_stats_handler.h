@@ -0,0 +1,64 @@
+#ifndef SCHEDULER_STATS_HANDLER_H
+#define SCHEDULER_STATS_HANDLER_H
+
+#include "request_handlers.h"
+#include "speculation.h"
+#include "preemption.h"
+#include "admission_control.h"
+#include "deadline_monitor.h"
+#include "size_lanes.h"
+#include "engine_health.h"
+#include "retry_policy.h"
+#include "endpoint_pools.h"
+#include <memory>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Handler for GET /scheduler/stats - Counters of the scheduling policies:
+// preemptions (and their cost), speculative copies, admission control
+// (queue depth, drain rate, rejections), deadline tracking, size-class lanes
+// per-engine health (success rate, failure reasons, throughput, quarantines)
+// retries (scheduled per failure class, exhausted, held back by the budget)
+// and, on the event-loop front end, the per-class endpoint worker pools.
+class SchedulerStatsHandler : public IRequestHandler {
+public:
+    SchedulerStatsHandler(std::shared_ptr<AuthMiddleware> auth,
+                          std::shared_ptr<SpeculationManager> speculation,
+                          std::shared_ptr<PreemptionCoordinator> preemption,
+                          std::shared_ptr<AdmissionController> admission = nullptr,
+                          std::shared_ptr<DeadlineMonitor> deadlines = nullptr,
+                          std::shared_ptr<SizeLanes> size_lanes = nullptr,
+                          std::shared_ptr<EngineHealth> health = nullptr,
+                          std::shared_ptr<RetryScheduler> retries = nullptr,
+                          std::shared_ptr<EndpointPools> endpoint_pools = nullptr);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<SpeculationManager> speculation_;
+    std::shared_ptr<PreemptionCoordinator> preemption_;
+    std::shared_ptr<AdmissionController> admission_;
+    std::shared_ptr<DeadlineMonitor> deadlines_;
+    std::shared_ptr<SizeLanes> size_lanes_;
+    std::shared_ptr<EngineHealth> health_;
+    std::shared_ptr<RetryScheduler> retries_;
+    std::shared_ptr<EndpointPools> endpoint_pools_;
+};
+
+// Handler for GET /jobs/at_risk - Pending and running jobs forecast to miss
+// their deadline, least slack first
+class AtRiskJobsHandler : public IRequestHandler {
+public:
+    AtRiskJobsHandler(std::shared_ptr<AuthMiddleware> auth, std::shared_ptr<DeadlineMonitor> deadlines);
+    void handle(const httplib::Request& req, httplib::Response& res) override;
+
+private:
+    std::shared_ptr<AuthMiddleware> auth_;
+    std::shared_ptr<DeadlineMonitor> deadlines_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // SCHEDULER_STATS_HANDLER_H
@@ -1,4 +1,5 @@
 #include "server_config.h"
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -26,6 +27,172 @@ ServerConfig parse_arguments(int argc, char* argv[]) {
             config.tdarr_url = argv[++i];
         } else if (arg == "--tdarr-api-key" && i + 1 < argc) {
             config.tdarr_api_key = argv[++i];
+        } else if ((arg == "--max-pending" || arg == "--max-pending-per-tenant") && i + 1 < argc) {
+            try {
+                long long limit = std::stoll(argv[++i]);
+                if (limit < 0) {
+                    throw std::out_of_range("negative");
+                }
+                (arg == "--max-pending" ? config.max_pending_jobs : config.max_pending_jobs_per_tenant) =
+                    static_cast<size_t>(limit);
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid pending job limit: " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--soft-admission") {
+            config.soft_admission_limits = true;
+        } else if ((arg == "--small-lane-reserve" || arg == "--large-lane-reserve") && i + 1 < argc) {
+            try {
+                double share = std::stod(argv[++i]);
+                if (!(share >= 0.0 && share <= 1.0)) {
+                    throw std::out_of_range("share");
+                }
+                (arg == "--small-lane-reserve" ? config.small_lane_reserve : config.large_lane_reserve) = share;
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid lane reserve (expected 0-1): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--quarantine-failure-rate" && i + 1 < argc) {
+            try {
+                double rate = std::stod(argv[++i]);
+                if (!(rate > 0.0)) {
+                    throw std::out_of_range("rate");
+                }
+                config.quarantine_failure_rate = rate;
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid quarantine failure rate (expected > 0): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--progress-stall-timeout" && i + 1 < argc) {
+            try {
+                int seconds = std::stoi(argv[++i]);
+                if (seconds < 0) {
+                    throw std::out_of_range("seconds");
+                }
+                config.progress_stall_seconds = seconds;
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid progress stall timeout (expected seconds >= 0): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--retry-budget" && i + 1 < argc) {
+            try {
+                int budget = std::stoi(argv[++i]);
+                if (budget < 0) {
+                    throw std::out_of_range("budget");
+                }
+                config.retry_budget_per_minute = static_cast<size_t>(budget);
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid retry budget (expected retries per minute >= 0): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--io-threads" && i + 1 < argc) {
+            try {
+                int threads = std::stoi(argv[++i]);
+                if (threads < 0) {
+                    throw std::out_of_range("threads");
+                }
+                config.io_threads = static_cast<size_t>(threads);
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid I/O thread count (expected >= 0): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--compression-level" && i + 1 < argc) {
+            try {
+                int level = std::stoi(argv[++i]);
+                if (level < 0 || level > 9) {
+                    throw std::out_of_range("level");
+                }
+                config.compression_level = level;
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid compression level (expected 0-9): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--compression-min-bytes" && i + 1 < argc) {
+            try {
+                long long bytes = std::stoll(argv[++i]);
+                if (bytes < 0) {
+                    throw std::out_of_range("bytes");
+                }
+                config.compression_min_bytes = static_cast<size_t>(bytes);
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid compression threshold (expected bytes >= 0): " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--trace-file" && i + 1 < argc) {
+            config.trace_file = argv[++i];
+        } else if (arg == "--trace-endpoint" && i + 1 < argc) {
+            std::string endpoint = argv[++i];
+            if (endpoint.rfind("http://", 0) != 0 && endpoint.rfind("https://", 0) != 0) {
+                config.parse_error = true;
+                config.error_message = "Invalid trace endpoint (expected an http:// or https:// URL): " + endpoint;
+                return config;
+            }
+            config.trace_endpoint = endpoint;
+        } else if (arg == "--log-file" && i + 1 < argc) {
+            config.log.path = argv[++i];
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            if (!logging::parse_level(argv[++i], config.log.level)) {
+                config.parse_error = true;
+                config.error_message = "Invalid log level (expected debug, info, warn, error or off): " +
+                                       std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--log-modules" && i + 1 < argc) {
+            if (!logging::parse_module_levels(argv[++i], config.log.module_levels)) {
+                config.parse_error = true;
+                config.error_message = "Invalid module log levels (expected module=level,...): " + std::string(argv[i]);
+                return config;
+            }
+        } else if ((arg == "--log-max-bytes" || arg == "--log-max-files") && i + 1 < argc) {
+            try {
+                long long value = std::stoll(argv[++i]);
+                if (value < 0) {
+                    throw std::out_of_range("negative");
+                }
+                if (arg == "--log-max-bytes") {
+                    config.log.max_file_bytes = static_cast<uint64_t>(value);
+                } else {
+                    config.log.max_files = static_cast<int>(std::min<long long>(value, 1000));
+                }
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid log rotation limit: " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--handoff-socket" && i + 1 < argc) {
+            config.handoff_socket = argv[++i];
+        } else if (arg == "--drain-timeout" && i + 1 < argc) {
+            try {
+                config.drain_timeout_seconds = std::stoi(argv[++i]);
+                if (config.drain_timeout_seconds < 0) {
+                    throw std::out_of_range("negative");
+                }
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid drain timeout: " + std::string(argv[i]);
+                return config;
+            }
+        } else if (arg == "--state-snapshot" && i + 1 < argc) {
+            config.state_snapshot_path = argv[++i];
+        } else if (arg == "--snapshot-interval" && i + 1 < argc) {
+            try {
+                config.snapshot_interval_seconds = std::stoi(argv[++i]);
+                if (config.snapshot_interval_seconds < 0) {
+                    throw std::out_of_range("negative");
+                }
+            } catch (const std::exception& e) {
+                config.parse_error = true;
+                config.error_message = "Invalid snapshot interval: " + std::string(argv[i]);
+                return config;
+            }
         } else if (arg == "--help") {
             config.show_help = true;
             return config;
@@ -1,6 +1,8 @@
 #ifndef SERVER_CONFIG_H
 #define SERVER_CONFIG_H
 
+#include "dispatch_server_constants.h"
+#include "structured_log.hpp"
 #include <string>
 #include <vector>
 
@@ -13,6 +15,24 @@ struct ServerConfig {
     int port = 8080;
     std::string tdarr_url = "http://localhost:8265";
     std::string tdarr_api_key = "";
+    size_t max_pending_jobs = 0;           // Admission control; 0 = unbounded
+    size_t max_pending_jobs_per_tenant = 0;
+    bool soft_admission_limits = false;    // Deprioritize instead of rejecting over a limit
+    double small_lane_reserve = Constants::SIZE_LANE_SMALL_RESERVE; // Share of engine slots, 0-1
+    double large_lane_reserve = Constants::SIZE_LANE_LARGE_RESERVE;
+    double quarantine_failure_rate = Constants::ENGINE_QUARANTINE_FAILURE_RATE; // 0-1; above 1 never quarantines
+    size_t retry_budget_per_minute = Constants::RETRY_BUDGET_PER_MINUTE; // Retries requeued per minute; 0 = unlimited
+    int progress_stall_seconds = static_cast<int>(Constants::JOB_PROGRESS_STALL_TIMEOUT.count() / 1000); // 0 = off
+    size_t io_threads = Constants::EVENT_LOOP_IO_THREADS; // Event-loop front end; 0 = httplib thread per connection
+    int compression_level = Constants::COMPRESSION_LEVEL; // gzip/zstd level 1-9; 0 = no response compression
+    size_t compression_min_bytes = Constants::COMPRESSION_MIN_BYTES;
+    std::string trace_file = "";      // OTLP JSON spans, one export request per line; empty = off
+    std::string trace_endpoint = "";  // OTLP/HTTP JSON collector URL; empty = off
+    logging::LogOptions log;          // JSON-lines log: file (empty = stderr), rotation, levels
+    std::string handoff_socket = "";  // Unix socket for listening-socket handoff on restart; empty = off
+    int drain_timeout_seconds = static_cast<int>(Constants::DRAIN_TIMEOUT.count());
+    std::string state_snapshot_path = "";  // Empty: the database path plus Constants::SNAPSHOT_SUFFIX
+    int snapshot_interval_seconds = static_cast<int>(Constants::SNAPSHOT_INTERVAL.count());  // 0 = only at shutdown
     bool show_help = false;
     bool parse_error = false;
     std::string error_message = "";
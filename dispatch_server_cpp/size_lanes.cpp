@@ -0,0 +1,147 @@
+#include "size_lanes.h"
+#include "resource_packing.h"
+#include <algorithm>
+#include <cmath>
+
+namespace distconv {
+namespace DispatchServer {
+
+using namespace Constants;
+
+SizeClass classify_job_size(double job_size_mb) {
+    if (job_size_mb <= 0) {
+        return SizeClass::Medium;
+    }
+    if (job_size_mb < JOB_SIZE_SMALL_THRESHOLD) {
+        return SizeClass::Small;
+    }
+    return job_size_mb < JOB_SIZE_MEDIUM_THRESHOLD ? SizeClass::Medium : SizeClass::Large;
+}
+
+SizeClass size_class_of(const nlohmann::json& job) {
+    if (job.contains("size_class") && job["size_class"].is_string()) {
+        const std::string name = job["size_class"].get<std::string>();
+        for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+            if (name == size_class_name(static_cast<SizeClass>(lane))) {
+                return static_cast<SizeClass>(lane);
+            }
+        }
+    }
+    return classify_job_size(job.contains("job_size") && job["job_size"].is_number() ? job["job_size"].get<double>()
+                                                                                     : 0.0);
+}
+
+const char* size_class_name(SizeClass size_class) {
+    switch (size_class) {
+        case SizeClass::Small: return "small";
+        case SizeClass::Large: return "large";
+        default: return "medium";
+    }
+}
+
+SizeLanes::SizeLanes(std::shared_ptr<IJobRepository> job_repo, std::shared_ptr<IEngineRepository> engine_repo,
+                     SizeLanePolicy policy, std::chrono::milliseconds refresh)
+    : job_repo_(job_repo), engine_repo_(engine_repo), refresh_ms_(refresh.count()), policy_(policy) {}
+
+void SizeLanes::set_policy(const SizeLanePolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+SizeLanePolicy SizeLanes::policy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_;
+}
+
+void SizeLanes::refresh_locked(int64_t now_ms) {
+    if (counted_ && now_ms - refreshed_at_ < refresh_ms_) {
+        return;
+    }
+    slots_ = 0;
+    for (const auto& engine : engine_repo_->get_all_engines()) {
+        slots_ += engine_slots(engine);
+    }
+    running_.fill(0);
+    for (const char* status : {"assigned", "processing"}) {
+        for (const auto& job : job_repo_->get_jobs_by_status(status)) {
+            ++running_[static_cast<size_t>(size_class_of(job))];
+        }
+    }
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        waiting_[lane] = !job_repo_->get_pending_jobs_by_size_class(size_class_name(static_cast<SizeClass>(lane)), 1)
+                              .empty();
+    }
+    refreshed_at_ = now_ms;
+    counted_ = true;
+}
+
+size_t SizeLanes::reserved_slots_locked(size_t lane) const {
+    double share = std::clamp(policy_.reserved_share[lane], 0.0, 1.0);
+    return static_cast<size_t>(std::ceil(share * slots_));
+}
+
+LaneSet SizeLanes::open_lanes(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked(now_ms);
+
+    size_t running = 0;
+    std::array<size_t, SIZE_CLASS_COUNT> unmet{};
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        running += running_[lane];
+        size_t reserved = reserved_slots_locked(lane);
+        // A lane keeps its reservation while it has work queued or running
+        bool active = waiting_[lane] || running_[lane] > 0;
+        unmet[lane] = active && reserved > running_[lane] ? reserved - running_[lane] : 0;
+    }
+    // The polling engine has at least the slot it is asking to fill
+    size_t free = std::max<size_t>(1, slots_ > running ? slots_ - running : 0);
+
+    LaneSet lanes;
+    bool deadlocked = true;
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        size_t others = 0;
+        size_t others_waiting = 0;
+        for (size_t other = 0; other < SIZE_CLASS_COUNT; ++other) {
+            if (other != lane) {
+                others += unmet[other];
+                others_waiting += waiting_[other] ? unmet[other] : 0;
+            }
+        }
+        lanes.open[lane] = free > others;
+        deadlocked = deadlocked && !(waiting_[lane] && free > others_waiting);
+    }
+    if (deadlocked) {
+        // Queued lanes holding slots against each other (reservations larger
+        // than the cluster, or nothing queued at all): plain queue order
+        return LaneSet{};
+    }
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        lanes.restricted = lanes.restricted || (!lanes.open[lane] && waiting_[lane]);
+    }
+    return lanes;
+}
+
+void SizeLanes::on_claimed(const nlohmann::json& job) {
+    size_t lane = static_cast<size_t>(size_class_of(job));
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++running_[lane];
+    ++claimed_[lane];
+}
+
+nlohmann::json SizeLanes::metrics(int64_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked(now_ms);
+    nlohmann::json metrics = {{"slots", slots_}};
+    for (size_t lane = 0; lane < SIZE_CLASS_COUNT; ++lane) {
+        metrics[size_class_name(static_cast<SizeClass>(lane))] = {
+            {"reserved_slots", reserved_slots_locked(lane)},
+            {"running", running_[lane]},
+            {"waiting", waiting_[lane]},
+            {"claimed", claimed_[lane]}
+        };
+    }
+    return metrics;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
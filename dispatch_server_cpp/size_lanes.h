@@ -0,0 +1,86 @@
+#ifndef SIZE_LANES_H
+#define SIZE_LANES_H
+
+#include "repositories.h"
+#include "dispatch_server_constants.h"
+#include "nlohmann/json.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Lanes by job_size (MB), split at JOB_SIZE_SMALL_THRESHOLD and
+// JOB_SIZE_MEDIUM_THRESHOLD. Jobs without a size run in the medium lane.
+enum class SizeClass { Small = 0, Medium = 1, Large = 2 };
+constexpr size_t SIZE_CLASS_COUNT = 3;
+
+SizeClass classify_job_size(double job_size_mb);
+// job["size_class"] as stamped at submission, else classified from job_size
+SizeClass size_class_of(const nlohmann::json& job);
+const char* size_class_name(SizeClass size_class);
+
+struct SizeLanePolicy {
+    // Share of the cluster's engine slots held for each lane while it has work
+    std::array<double, SIZE_CLASS_COUNT> reserved_share = {Constants::SIZE_LANE_SMALL_RESERVE, 0.0,
+                                                           Constants::SIZE_LANE_LARGE_RESERVE};
+};
+
+// Lanes a free slot may currently be filled from
+struct LaneSet {
+    std::array<bool, SIZE_CLASS_COUNT> open = {true, true, true};
+    bool restricted = false; // Some lane with pending work is held back
+
+    bool admits(const nlohmann::json& job) const { return open[static_cast<size_t>(size_class_of(job))]; }
+};
+
+// Size-class lanes against head-of-line blocking.
+//
+// Each lane may hold a reserved share of the cluster's slots (rounded up).
+// A free slot goes to a lane only if the slots still free afterwards cover
+// the unmet reservations of the other active lanes (work queued or running),
+// so a burst of large masters cannot take the slots small clips need and
+// vice versa. Reservations of lanes with no work at all are not held: any
+// lane may take those slots (work stealing). Occupancy comes from the repositories, refreshed at
+// most every SIZE_LANE_COUNT_REFRESH with claims since then added locally.
+class SizeLanes {
+public:
+    SizeLanes(std::shared_ptr<IJobRepository> job_repo, std::shared_ptr<IEngineRepository> engine_repo,
+              SizeLanePolicy policy = {},
+              std::chrono::milliseconds refresh = Constants::SIZE_LANE_COUNT_REFRESH);
+
+    void set_policy(const SizeLanePolicy& policy);
+    SizeLanePolicy policy() const;
+
+    LaneSet open_lanes(int64_t now_ms);
+    void on_claimed(const nlohmann::json& job);
+
+    // Per lane: reserved and running slots, whether work is waiting, claims
+    nlohmann::json metrics(int64_t now_ms);
+
+private:
+    void refresh_locked(int64_t now_ms);
+    size_t reserved_slots_locked(size_t lane) const;
+
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<IEngineRepository> engine_repo_;
+    const int64_t refresh_ms_;
+
+    mutable std::mutex mutex_;
+    SizeLanePolicy policy_;
+    int64_t refreshed_at_ = 0;
+    bool counted_ = false;
+    size_t slots_ = 0;
+    std::array<size_t, SIZE_CLASS_COUNT> running_{};
+    std::array<bool, SIZE_CLASS_COUNT> waiting_{};
+    std::array<uint64_t, SIZE_CLASS_COUNT> claimed_{};
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // SIZE_LANES_H
@@ -0,0 +1,193 @@
+#include "socket_handoff.h"
+#include "dispatch_server_constants.h"
+#include "structured_log.hpp"
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <chrono>
+#include <cstring>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+constexpr char OFFER = 'S';
+constexpr char CONFIRM = 'R';
+constexpr time_t RECEIVE_TIMEOUT_SEC = 5;
+
+bool unix_address(const std::string& path, sockaddr_un& address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+    address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+HandoffTakeover take_listen_socket(const std::string& path) {
+    HandoffTakeover takeover;
+    sockaddr_un address;
+    if (!unix_address(path, address)) return takeover;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return takeover;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd); // Nothing there, or a socket file nobody listens on
+        return takeover;
+    }
+    timeval timeout{RECEIVE_TIMEOUT_SEC, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char byte = 0;
+    iovec iov{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+
+    cmsghdr* header = received == 1 && byte == OFFER ? CMSG_FIRSTHDR(&message) : nullptr;
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+        logging::warn("handoff", "Predecessor did not hand over its listening socket", {{"path", path}});
+        ::close(fd);
+        return takeover;
+    }
+    std::memcpy(&takeover.listen_fd, CMSG_DATA(header), sizeof(int));
+    takeover.channel_fd = fd;
+    return takeover;
+}
+
+bool confirm_handoff(HandoffTakeover& takeover) {
+    if (takeover.channel_fd < 0) return false;
+    bool sent = ::send(takeover.channel_fd, &CONFIRM, 1, MSG_NOSIGNAL) == 1;
+    ::close(takeover.channel_fd);
+    takeover.channel_fd = -1;
+    return sent;
+}
+
+HandoffListener::HandoffListener(std::string path, int listen_fd, std::function<void()> on_handed_off)
+    : path_(std::move(path)), listen_fd_(listen_fd), on_handed_off_(std::move(on_handed_off)) {
+    sockaddr_un address;
+    if (listen_fd_ < 0 || !unix_address(path_, address)) {
+        logging::error("handoff", "Cannot offer the listening socket", {{"path", path_}});
+        return;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // A predecessor's file is left behind on purpose; its owner no longer listens on it
+    ::unlink(path_.c_str());
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        chmod(path_.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(fd, 4) != 0) {
+        logging::error("handoff", "Cannot listen for a successor", {{"path", path_}, {"error", std::strerror(errno)}});
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+    socket_fd_ = fd;
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    thread_ = std::thread(&HandoffListener::run, this);
+}
+
+HandoffListener::~HandoffListener() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+        (void)written;
+        thread_.join();
+    }
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (socket_fd_ >= 0) {
+        ::close(socket_fd_);
+        // After a handoff the path belongs to the successor
+        if (!handed_off_.load()) ::unlink(path_.c_str());
+    }
+}
+
+void HandoffListener::run() {
+    while (true) {
+        pollfd fds[2] = {{socket_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        int client = accept4(socket_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        bool confirmed = offer(client);
+        ::close(client);
+        if (confirmed) {
+            handed_off_.store(true);
+            logging::info("handoff", "Successor took over the listening socket");
+            if (on_handed_off_) on_handed_off_();
+            break;
+        }
+    }
+}
+
+bool HandoffListener::offer(int client_fd) {
+    ucred peer{};
+    socklen_t length = sizeof(peer);
+    if (getsockopt(client_fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0 || peer.uid != geteuid()) {
+        logging::warn("handoff", "Refused a handoff request from another user", {{"uid", peer.uid}});
+        return false;
+    }
+
+    char byte = OFFER;
+    iovec iov{&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(header), &listen_fd_, sizeof(int));
+    if (sendmsg(client_fd, &message, MSG_NOSIGNAL) != 1) return false;
+
+    // The successor serves on the socket from here on; until it confirms, so do we
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(Constants::HANDOFF_CONFIRM_TIMEOUT);
+    pollfd fds[2] = {{client_fd, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    char reply = 0;
+    if (poll(fds, 2, static_cast<int>(timeout.count())) <= 0 || fds[1].revents ||
+        ::recv(client_fd, &reply, 1, 0) != 1 || reply != CONFIRM) {
+        logging::warn("handoff", "Successor did not confirm the handoff; still serving");
+        return false;
+    }
+    return true;
+}
+
+pid_t spawn_successor(char* const argv[]) {
+    // Exec the resolved path: through /proc/self/exe the process would be named "exe"
+    char path[PATH_MAX];
+    ssize_t length = ::readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length <= 0) return -1;
+    path[length] = '\0';
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Only async-signal-safe calls between fork and exec. The stop signals
+        // are blocked here for sigwait; the new program starts with none blocked.
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, nullptr);
+        execv(path, argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
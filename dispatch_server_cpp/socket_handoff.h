@@ -0,0 +1,70 @@
+#ifndef SOCKET_HANDOFF_H
+#define SOCKET_HANDOFF_H
+
+#include <sys/types.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Zero-downtime restarts by passing the listening socket between processes.
+//
+// A dispatcher started with a handoff path listens on a Unix socket there. A
+// successor started with the same path connects, receives the listening TCP
+// socket (SCM_RIGHTS), starts serving on it and confirms; only then does the
+// predecessor stop accepting and drain. Both processes share one kernel
+// socket in between, so connections are never refused: whichever process
+// accepts first serves them. Only processes of the same user are answered.
+
+// The successor's side. listen_fd is -1 when no predecessor answers at the
+// path (nothing there, or a stale socket file), which is not an error.
+struct HandoffTakeover {
+    int listen_fd = -1;
+    int channel_fd = -1; // Open until confirm_handoff()
+};
+
+HandoffTakeover take_listen_socket(const std::string& path);
+
+// Tells the predecessor that the successor is serving, so it can drain and exit
+bool confirm_handoff(HandoffTakeover& takeover);
+
+// The predecessor's side: offers `listen_fd` to successors at `path`.
+// on_handed_off runs on the listener's thread once a successor confirms;
+// after that the listener stops and leaves the path to the successor. A
+// successor that disconnects without confirming changes nothing.
+class HandoffListener {
+public:
+    HandoffListener(std::string path, int listen_fd, std::function<void()> on_handed_off);
+    ~HandoffListener(); // Removes the socket file unless a successor took over
+
+    HandoffListener(const HandoffListener&) = delete;
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    bool listening() const { return socket_fd_ >= 0; }
+    bool handed_off() const { return handed_off_.load(); }
+
+private:
+    void run();
+    bool offer(int client_fd);
+
+    std::string path_;
+    int listen_fd_;
+    std::function<void()> on_handed_off_;
+    int socket_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> handed_off_{false};
+    std::thread thread_;
+};
+
+// Starts this program again with the same arguments (for SIGHUP); the new
+// process takes the socket over through the handoff path. Returns its pid, or
+// -1 if it could not be started.
+pid_t spawn_successor(char* const argv[]);
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // SOCKET_HANDOFF_H
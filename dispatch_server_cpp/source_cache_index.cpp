@@ -0,0 +1,131 @@
+#include "source_cache_index.h"
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+// Keeps a hostile heartbeat from making us allocate or probe without bound
+constexpr uint32_t MAX_FILTER_BITS = 1u << 20;
+constexpr uint32_t MAX_FILTER_HASHES = 16;
+constexpr size_t MAX_DEFERRED_JOBS = 4096;
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+uint64_t source_url_hash(const std::string& url) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::optional<SourceCacheFilter> SourceCacheFilter::from_json(const nlohmann::json& summary) {
+    if (!summary.is_object() || !summary.contains("m") || !summary["m"].is_number_unsigned() ||
+        !summary.contains("k") || !summary["k"].is_number_unsigned() ||
+        !summary.contains("bits") || !summary["bits"].is_string()) {
+        return std::nullopt;
+    }
+
+    SourceCacheFilter filter;
+    uint64_t m = summary["m"];
+    uint64_t k = summary["k"];
+    const std::string& hex = summary["bits"].get_ref<const std::string&>();
+    if (m == 0 || m > MAX_FILTER_BITS || k == 0 || k > MAX_FILTER_HASHES || hex.size() != ((m + 7) / 8) * 2) {
+        return std::nullopt;
+    }
+    filter.m = static_cast<uint32_t>(m);
+    filter.k = static_cast<uint32_t>(k);
+
+    filter.bits.resize(hex.size() / 2);
+    for (size_t i = 0; i < filter.bits.size(); ++i) {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return std::nullopt;
+        filter.bits[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return filter;
+}
+
+bool SourceCacheFilter::might_contain(uint64_t hash) const {
+    if (m == 0) return false;
+    uint64_t h1 = hash & 0xffffffffULL;
+    uint64_t h2 = (hash >> 32) | 1;
+    for (uint32_t i = 0; i < k; ++i) {
+        uint64_t bit = (h1 + i * h2) % m;
+        if (!(bits[bit / 8] & (1u << (bit % 8)))) return false;
+    }
+    return true;
+}
+
+SourceCacheIndex::SourceCacheIndex(Clock::duration locality_wait, Clock::duration filter_ttl)
+    : locality_wait_(locality_wait), filter_ttl_(filter_ttl) {}
+
+void SourceCacheIndex::update(const std::string& engine_id, const nlohmann::json& summary) {
+    auto filter = SourceCacheFilter::from_json(summary);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!filter) {
+        filters_.erase(engine_id);
+        return;
+    }
+    filters_[engine_id] = Entry{std::move(*filter), Clock::now()};
+}
+
+void SourceCacheIndex::remove(const std::string& engine_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    filters_.erase(engine_id);
+}
+
+bool SourceCacheIndex::fresh(const Entry& entry, Clock::time_point now) const {
+    return now - entry.updated <= filter_ttl_;
+}
+
+bool SourceCacheIndex::engine_holds(const std::string& engine_id, const std::string& source_url) const {
+    if (source_url.empty()) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = filters_.find(engine_id);
+    return it != filters_.end() && fresh(it->second, Clock::now()) &&
+           it->second.filter.might_contain(source_url_hash(source_url));
+}
+
+bool SourceCacheIndex::held_elsewhere(const std::string& engine_id, const std::string& source_url) const {
+    if (source_url.empty()) return false;
+    uint64_t hash = source_url_hash(source_url);
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [id, entry] : filters_) {
+        if (id != engine_id && fresh(entry, now) && entry.filter.might_contain(hash)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SourceCacheIndex::defer(const std::string& job_id) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Jobs cancelled or claimed elsewhere while deferred never call forget()
+    if (deferred_since_.size() >= MAX_DEFERRED_JOBS) {
+        for (auto it = deferred_since_.begin(); it != deferred_since_.end();) {
+            it = now - it->second >= locality_wait_ ? deferred_since_.erase(it) : std::next(it);
+        }
+    }
+    auto it = deferred_since_.emplace(job_id, now).first;
+    return now - it->second < locality_wait_;
+}
+
+void SourceCacheIndex::forget(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deferred_since_.erase(job_id);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,73 @@
+#ifndef SOURCE_CACHE_INDEX_H
+#define SOURCE_CACHE_INDEX_H
+
+#include "nlohmann/json.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+// FNV-1a 64 of the source URL. Engines hash with the same function when
+// building their heartbeat filter (transcoding_engine/src/core/source_cache.h).
+uint64_t source_url_hash(const std::string& url);
+
+// Bloom filter as advertised in the heartbeat:
+//   "source_cache": {"m": <bits>, "k": <hashes>, "bits": "<hex, LSB-first bytes>"}
+// Probe i uses bit (h1 + i * h2) mod m with h1/h2 the low/high halves of the hash.
+struct SourceCacheFilter {
+    uint32_t m = 0;
+    uint32_t k = 0;
+    std::vector<uint8_t> bits;
+
+    static std::optional<SourceCacheFilter> from_json(const nlohmann::json& summary);
+    bool might_contain(uint64_t hash) const;
+};
+
+// Latest source-cache filter per engine, consulted by the claim path to keep
+// jobs on engines that already hold their source. Filters expire with the
+// engine heartbeat timeout, so departed engines stop attracting work.
+class SourceCacheIndex {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SourceCacheIndex(Clock::duration locality_wait, Clock::duration filter_ttl);
+
+    // Replaces the engine's filter; a missing or malformed summary clears it.
+    void update(const std::string& engine_id, const nlohmann::json& summary);
+    void remove(const std::string& engine_id);
+
+    bool engine_holds(const std::string& engine_id, const std::string& source_url) const;
+    bool held_elsewhere(const std::string& engine_id, const std::string& source_url) const;
+
+    // True while a job whose source lives on another engine should still be
+    // left for that engine. The wait starts the first time the job is deferred.
+    bool defer(const std::string& job_id);
+    void forget(const std::string& job_id);
+
+    Clock::duration locality_wait() const { return locality_wait_; }
+
+private:
+    struct Entry {
+        SourceCacheFilter filter;
+        Clock::time_point updated;
+    };
+
+    bool fresh(const Entry& entry, Clock::time_point now) const;
+
+    const Clock::duration locality_wait_;
+    const Clock::duration filter_ttl_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry> filters_;
+    std::map<std::string, Clock::time_point> deferred_since_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // SOURCE_CACHE_INDEX_H
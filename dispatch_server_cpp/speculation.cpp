@@ -0,0 +1,251 @@
+#include "speculation.h"
+#include "wall_clock.h"
+#include "structured_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+int64_t now_millis() {
+    return wall_clock_ms();
+}
+
+double benchmark_of(const nlohmann::json& engine) {
+    if (engine.is_object() && engine.contains("benchmark_time") && engine["benchmark_time"].is_number()) {
+        return engine["benchmark_time"].get<double>();
+    }
+    return 0.0;
+}
+
+} // namespace
+
+SpeculationManager::SpeculationManager(std::shared_ptr<IJobRepository> job_repo,
+                                       std::shared_ptr<IEngineRepository> engine_repo,
+                                       SpeculationPolicy policy,
+                                       std::shared_ptr<RuntimeEstimator> estimator)
+    : job_repo_(job_repo), engine_repo_(engine_repo), policy_(policy),
+      estimator_(estimator ? estimator : std::make_shared<RuntimeEstimator>(policy.min_samples,
+                                                                            policy.sample_window)) {}
+
+bool SpeculationManager::running(const nlohmann::json& job) {
+    std::string status = job.value("status", "");
+    return status == "assigned" || status == "processing";
+}
+
+bool SpeculationManager::copy_active(const nlohmann::json& job) {
+    return job.contains("speculation") && job["speculation"].is_object() &&
+           job["speculation"].value("state", "") == "running";
+}
+
+std::string SpeculationManager::codec_of(const nlohmann::json& job) const {
+    return job.contains("target_codec") && job["target_codec"].is_string() ? job["target_codec"].get<std::string>()
+                                                                            : std::string();
+}
+
+size_t SpeculationManager::budget_locked(size_t engine_count) const {
+    size_t share = std::max<size_t>(1, static_cast<size_t>(engine_count * policy_.max_engine_share));
+    return std::min(policy_.max_active, share);
+}
+
+void SpeculationManager::scan(int64_t now_ms) {
+    std::set<std::string> live_engines;
+    for (const auto& engine : engine_repo_->get_all_engines()) {
+        if (engine.contains("engine_id") && engine["engine_id"].is_string()) {
+            live_engines.insert(engine["engine_id"].get<std::string>());
+        }
+    }
+
+    std::vector<nlohmann::json> jobs = job_repo_->get_jobs_by_status("assigned");
+    auto processing = job_repo_->get_jobs_by_status("processing");
+    jobs.insert(jobs.end(), processing.begin(), processing.end());
+
+    size_t active = 0;
+    std::vector<std::pair<double, std::string>> candidates;
+    for (auto& job : jobs) {
+        std::string job_id = job.value("job_id", "");
+        if (copy_active(job)) {
+            if (!live_engines.count(job["speculation"].value("engine", ""))) {
+                // The copy's engine went away; let the primary carry on alone
+                job["speculation"]["state"] = "abandoned";
+                job_repo_->save_job(job_id, job);
+            } else {
+                ++active;
+            }
+            continue;
+        }
+
+        int copies = job.contains("speculation") ? job["speculation"].value("copies", 0) : 0;
+        if (copies >= policy_.max_copies_per_job || !job.contains("assigned_at") ||
+            !job["assigned_at"].is_number_integer()) {
+            continue;
+        }
+
+        int64_t median_ms = 0;
+        if (!estimator_->median_duration(codec_of(job), median_ms)) {
+            continue;
+        }
+        int64_t elapsed_ms = now_ms - job["assigned_at"].get<int64_t>();
+        if (elapsed_ms < median_ms) {
+            continue;
+        }
+
+        // Without progress reports the elapsed time is the best lower bound
+        int progress = job.contains("progress") && job["progress"].is_number() ? job["progress"].get<int>() : 0;
+        double projected_ms = progress > 0 ? elapsed_ms * 100.0 / progress : static_cast<double>(elapsed_ms);
+        double slowdown = projected_ms / median_ms;
+        if (slowdown >= policy_.slowdown_factor) {
+            candidates.emplace_back(slowdown, job_id);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), std::greater<>());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stragglers_.clear();
+    for (const auto& candidate : candidates) {
+        stragglers_.push_back(candidate.second);
+    }
+    active_ = active;
+    engine_count_ = live_engines.size();
+    if (!stragglers_.empty()) {
+        logging::info("speculation", "Detected straggler jobs",
+                      {{"stragglers", stragglers_.size()}, {"speculative_copies", active_}});
+    }
+}
+
+nlohmann::json SpeculationManager::claim_copy(const std::string& engine_id, const nlohmann::json& engine,
+                                              const Resources* free) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stragglers_.empty() || active_ >= budget_locked(engine_count_)) {
+        return nullptr;
+    }
+
+    for (auto it = stragglers_.begin(); it != stragglers_.end();) {
+        nlohmann::json job = job_repo_->get_job(*it);
+        if (job.is_null() || job.empty() || !running(job) || copy_active(job)) {
+            it = stragglers_.erase(it);
+            continue;
+        }
+
+        std::string primary = job.contains("assigned_engine") && job["assigned_engine"].is_string()
+                                  ? job["assigned_engine"].get<std::string>() : "";
+        // Only an engine at least as fast as the straggling one is worth the capacity
+        double candidate_benchmark = benchmark_of(engine);
+        double primary_benchmark = primary.empty() ? 0.0 : benchmark_of(engine_repo_->get_engine(primary));
+        if (primary == engine_id || (free && !free->covers(job_demand(job))) ||
+            (primary_benchmark > 0 && (candidate_benchmark <= 0 || candidate_benchmark > primary_benchmark))) {
+            ++it;
+            continue;
+        }
+
+        nlohmann::json speculation = job.value("speculation", nlohmann::json::object());
+        speculation["engine"] = engine_id;
+        speculation["primary"] = primary;
+        speculation["state"] = "running";
+        speculation["started_at"] = now_millis();
+        speculation["copies"] = speculation.value("copies", 0) + 1;
+        job["speculation"] = speculation;
+        job_repo_->save_job(*it, job);
+
+        stragglers_.erase(it);
+        ++active_;
+        logging::info("speculation", "Launching speculative copy",
+                      {{"job_id", job.value("job_id", "")}, {"engine_id", engine_id}, {"primary", primary}});
+
+        job["speculative"] = true;
+        return job;
+    }
+    return nullptr;
+}
+
+bool SpeculationManager::is_copy_report(const nlohmann::json& job, const std::string& reporter) const {
+    return !reporter.empty() && copy_active(job) && job["speculation"].value("engine", "") == reporter;
+}
+
+bool SpeculationManager::is_losing_report(const nlohmann::json& job, const std::string& reporter) const {
+    if (reporter.empty() || !job.contains("speculation") || !job["speculation"].is_object()) {
+        return false;
+    }
+    const auto& speculation = job["speculation"];
+    if (!speculation.contains("winner") || speculation["winner"] == reporter) {
+        return false;
+    }
+    return speculation.value("engine", "") == reporter || speculation.value("primary", "") == reporter;
+}
+
+void SpeculationManager::resolve_completion(nlohmann::json& job, const std::string& reporter, int64_t now_ms) {
+    int64_t started_at = job.contains("assigned_at") && job["assigned_at"].is_number_integer()
+                             ? job["assigned_at"].get<int64_t>() : 0;
+
+    if (copy_active(job)) {
+        auto& speculation = job["speculation"];
+        std::string copy_engine = speculation.value("engine", "");
+        bool copy_won = !reporter.empty() && reporter == copy_engine;
+        speculation["state"] = "resolved";
+        speculation["winner"] = copy_won ? copy_engine : speculation.value("primary", "");
+        if (copy_won) {
+            started_at = speculation.value("started_at", started_at);
+        }
+        // The primary is freed by the completion handler itself
+        free_engine(copy_engine, job.value("job_id", ""));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (active_ > 0) --active_;
+    }
+
+    if (started_at > 0 && now_ms > started_at) {
+        estimator_->record(job, now_ms - started_at);
+    }
+}
+
+bool SpeculationManager::absorb_failure(nlohmann::json& job, const std::string& reporter) {
+    if (!copy_active(job)) {
+        return false;
+    }
+
+    auto& speculation = job["speculation"];
+    std::string job_id = job.value("job_id", "");
+    std::string copy_engine = speculation.value("engine", "");
+    if (reporter == copy_engine) {
+        speculation["state"] = "failed";
+        free_engine(copy_engine, job_id);
+    } else {
+        // The primary gave up; the copy becomes the job's only run
+        free_engine(speculation.value("primary", ""), job_id);
+        job["assigned_engine"] = copy_engine;
+        speculation["state"] = "promoted";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ > 0) --active_;
+    return true;
+}
+
+void SpeculationManager::free_engine(const std::string& engine_id, const std::string& job_id) {
+    if (engine_id.empty()) return;
+    nlohmann::json engine = engine_repo_->get_engine(engine_id);
+    // Leave engines that already moved on to other work alone
+    if (engine.is_null() || engine.empty() || !engine.contains("current_job_id") ||
+        !engine["current_job_id"].is_string() || engine["current_job_id"] != job_id) {
+        return;
+    }
+    engine["status"] = "idle";
+    engine["current_job_id"] = "";
+    engine_repo_->save_engine(engine_id, engine);
+}
+
+size_t SpeculationManager::active_copies() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_;
+}
+
+size_t SpeculationManager::queued_stragglers() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stragglers_.size();
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,81 @@
+#ifndef SPECULATION_H
+#define SPECULATION_H
+
+#include "repositories.h"
+#include "dispatch_server_constants.h"
+#include "resource_packing.h"
+#include "runtime_estimator.h"
+#include "nlohmann/json.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace distconv {
+namespace DispatchServer {
+
+struct SpeculationPolicy {
+    double slowdown_factor = Constants::STRAGGLER_SLOWDOWN_FACTOR; // Projected runtime vs. median
+    size_t min_samples = Constants::STRAGGLER_MIN_SAMPLES;         // Completed jobs of the codec needed...
+    size_t sample_window = 50;                                     // ...and kept, when the estimator is our own
+    int max_copies_per_job = Constants::SPECULATION_MAX_COPIES_PER_JOB;
+    size_t max_active = Constants::SPECULATION_MAX_ACTIVE;         // Copies running at once...
+    double max_engine_share = Constants::SPECULATION_MAX_ENGINE_SHARE; // ...capped to this share of engines (min 1)
+};
+
+// Speculative re-execution of stragglers.
+//
+// scan() (background worker) compares each running job's progress rate with
+// the median duration of completed jobs for its codec and queues stragglers.
+// Durations are recorded by resolve_completion into the runtime estimator,
+// which may be shared with deadline prediction.
+// An idle engine that polls with nothing pending may then claim_copy() one, if
+// its benchmark is no slower than the primary engine's. The copy's state lives
+// in job["speculation"]; the first completion wins and the other engine is
+// freed (and sent a cancel over the engine channel).
+class SpeculationManager {
+public:
+    SpeculationManager(std::shared_ptr<IJobRepository> job_repo,
+                       std::shared_ptr<IEngineRepository> engine_repo,
+                       SpeculationPolicy policy = {},
+                       std::shared_ptr<RuntimeEstimator> estimator = nullptr);
+
+    void scan(int64_t now_ms);
+    // free, when given, is the engine's unused capacity; stragglers that do not fit are skipped
+    nlohmann::json claim_copy(const std::string& engine_id, const nlohmann::json& engine,
+                              const Resources* free = nullptr);
+
+    // Applied by the job action handlers before they save the job. reporter is
+    // the engine_id sent with the report and may be empty for older engines.
+    bool is_losing_report(const nlohmann::json& job, const std::string& reporter) const;
+    bool is_copy_report(const nlohmann::json& job, const std::string& reporter) const;
+    void resolve_completion(nlohmann::json& job, const std::string& reporter, int64_t now_ms);
+    // Returns true when the failure was absorbed by the other copy
+    bool absorb_failure(nlohmann::json& job, const std::string& reporter);
+
+    size_t active_copies() const;
+    size_t queued_stragglers() const;
+
+private:
+    static bool running(const nlohmann::json& job);
+    static bool copy_active(const nlohmann::json& job);
+    std::string codec_of(const nlohmann::json& job) const;
+    size_t budget_locked(size_t engine_count) const;
+    void free_engine(const std::string& engine_id, const std::string& job_id);
+
+    std::shared_ptr<IJobRepository> job_repo_;
+    std::shared_ptr<IEngineRepository> engine_repo_;
+    const SpeculationPolicy policy_;
+    std::shared_ptr<RuntimeEstimator> estimator_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> stragglers_;                  // slowest first
+    size_t active_ = 0;
+    size_t engine_count_ = 0;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // SPECULATION_H
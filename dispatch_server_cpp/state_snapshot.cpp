@@ -0,0 +1,258 @@
+#include "state_snapshot.h"
+#include "engine_health.h"
+#include "repositories.h"
+#include "retry_policy.h"
+#include "runtime_estimator.h"
+#include "structured_log.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+constexpr char MAGIC[8] = {'D', 'C', 'S', 'T', 'A', 'T', 'E', '\0'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Sections of the payload: tag, length, bytes. Unknown tags are skipped.
+enum SectionTag : uint32_t { RuntimeSamples = 1, EngineHealthRecords = 2, RetryCounters = 3 };
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int64_t watermark_ms;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+
+uint64_t fnv1a(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void section(SnapshotWriter& payload, uint32_t tag, const SnapshotWriter& body) {
+    payload.u32(tag);
+    payload.u64(body.data().size());
+    payload.raw(body.data());
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// A read-only mapping of a whole file, unmapped on scope exit
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat info {};
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = static_cast<const char*>(mapped);
+                size_ = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (data_) munmap(const_cast<char*>(data_), size_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+int64_t integer_field(const nlohmann::json& object, const char* key) {
+    return object.contains(key) && object[key].is_number_integer() ? object[key].get<int64_t>() : 0;
+}
+
+std::string string_field(const nlohmann::json& object, const char* key) {
+    return object.contains(key) && object[key].is_string() ? object[key].get<std::string>() : "";
+}
+
+// Start of the run that completed the job, as SpeculationManager::resolve_completion takes it
+int64_t completed_run_started_at(const nlohmann::json& job) {
+    int64_t started_at = integer_field(job, "assigned_at");
+    if (job.contains("speculation") && job["speculation"].is_object()) {
+        const auto& speculation = job["speculation"];
+        std::string winner = string_field(speculation, "winner");
+        if (!winner.empty() && winner == string_field(speculation, "engine")) {
+            started_at = speculation.value("started_at", started_at);
+        }
+    }
+    return started_at;
+}
+
+} // namespace
+
+void SnapshotWriter::str(const std::string& value) {
+    u32(static_cast<uint32_t>(value.size()));
+    raw(value);
+}
+
+std::string SnapshotReader::str() {
+    size_t size = u32();
+    const char* bytes = take(size);
+    return std::string(bytes, size);
+}
+
+size_t SnapshotReader::count(size_t min_element_bytes) {
+    size_t n = u32();
+    if (min_element_bytes > 0 && n > remaining() / min_element_bytes) {
+        throw std::runtime_error("Snapshot element count exceeds its section");
+    }
+    return n;
+}
+
+SnapshotReader SnapshotReader::sub(size_t size) {
+    const char* bytes = take(size);
+    return SnapshotReader(bytes, size);
+}
+
+const char* SnapshotReader::take(size_t size) {
+    if (size > size_ - offset_) {
+        throw std::runtime_error("Snapshot is truncated");
+    }
+    const char* bytes = data_ + offset_;
+    offset_ += size;
+    return bytes;
+}
+
+StateSnapshot::StateSnapshot(std::shared_ptr<RuntimeEstimator> estimator, std::shared_ptr<EngineHealth> health,
+                             std::shared_ptr<RetryScheduler> retries)
+    : estimator_(std::move(estimator)), health_(std::move(health)), retries_(std::move(retries)) {}
+
+bool StateSnapshot::write(const std::string& path, int64_t watermark_ms) const {
+    SnapshotWriter payload;
+    SnapshotWriter body;
+    estimator_->save(body);
+    section(payload, RuntimeSamples, body);
+    body = SnapshotWriter();
+    health_->save(body);
+    section(payload, EngineHealthRecords, body);
+    body = SnapshotWriter();
+    retries_->save(body);
+    section(payload, RetryCounters, body);
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.watermark_ms = watermark_ms;
+    header.payload_size = payload.data().size();
+    header.checksum = fnv1a(payload.data().data(), payload.data().size());
+
+    // Readers only ever see the old file or the complete new one
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    bool ok = fd >= 0 && write_all(fd, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+              write_all(fd, payload.data().data(), payload.data().size()) && ::fsync(fd) == 0;
+    if (fd >= 0 && ::close(fd) != 0) ok = false;
+    if (ok && std::rename(temporary.c_str(), path.c_str()) != 0) ok = false;
+    if (!ok) {
+        logging::error("snapshot", "Cannot write the state snapshot", {{"path", path}, {"error", std::strerror(errno)}});
+        ::unlink(temporary.c_str());
+    }
+    return ok;
+}
+
+bool StateSnapshot::load(const std::string& path, int64_t& watermark_ms) {
+    MappedFile file(path);
+    if (!file.data()) {
+        return false;
+    }
+
+    Header header;
+    if (file.size() < sizeof(header)) {
+        logging::warn("snapshot", "Ignoring a truncated state snapshot", {{"path", path}});
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    const char* payload = file.data() + sizeof(header);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION ||
+        header.byte_order != BYTE_ORDER_MARK || header.payload_size != file.size() - sizeof(header) ||
+        header.checksum != fnv1a(payload, header.payload_size)) {
+        logging::warn("snapshot", "Ignoring a damaged or incompatible state snapshot", {{"path", path}});
+        return false;
+    }
+
+    try {
+        SnapshotReader in(payload, header.payload_size);
+        while (in.remaining() > 0) {
+            uint32_t tag = in.u32();
+            SnapshotReader body = in.sub(in.u64());
+            switch (tag) {
+                case RuntimeSamples: estimator_->restore(body); break;
+                case EngineHealthRecords: health_->restore(body); break;
+                case RetryCounters: retries_->restore(body); break;
+                default: break;
+            }
+        }
+    } catch (const std::exception& e) {
+        logging::error("snapshot", "Cannot read the state snapshot", {{"path", path}, {"error", e.what()}});
+        return false;
+    }
+    watermark_ms = header.watermark_ms;
+    return true;
+}
+
+size_t StateSnapshot::replay(IJobRepository& jobs, int64_t watermark_ms) {
+    const int64_t anti_affinity_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Constants::RETRY_ANTI_AFFINITY_WINDOW).count();
+
+    size_t replayed = 0;
+    for (const auto& job : jobs.get_jobs_updated_since(watermark_ms)) {
+        // A failure leaves the engine it failed on, and when, for retry anti-affinity
+        std::string failed_on = string_field(job, "avoid_engine");
+        int64_t failed_at = integer_field(job, "avoid_until") - anti_affinity_ms;
+        if (!failed_on.empty() && failed_at > watermark_ms) {
+            std::string reason = string_field(job, "error_message");
+            health_->record_failure(failed_on, job, reason.empty() ? string_field(job, "timeout_reason") : reason,
+                                    failed_at);
+        }
+
+        if (string_field(job, "status") == "completed") {
+            int64_t completed_at = integer_field(job, "updated_at");
+            health_->record_success(string_field(job, "completed_by"), job, completed_at);
+            int64_t started_at = completed_run_started_at(job);
+            if (started_at > 0 && completed_at > started_at) {
+                estimator_->record(job, completed_at - started_at);
+            }
+        }
+        ++replayed;
+    }
+    return replayed;
+}
+
+} // namespace DispatchServer
+} // namespace distconv
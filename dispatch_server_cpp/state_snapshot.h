@@ -0,0 +1,117 @@
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include "dispatch_server_constants.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace distconv {
+namespace DispatchServer {
+
+class EngineHealth;
+class IJobRepository;
+class RetryScheduler;
+class RuntimeEstimator;
+
+// Fixed-width fields in host byte order, for the state snapshot. Components
+// write and read their own sections with these.
+class SnapshotWriter {
+public:
+    void u8(uint8_t value) { put(&value, sizeof(value)); }
+    void u32(uint32_t value) { put(&value, sizeof(value)); }
+    void u64(uint64_t value) { put(&value, sizeof(value)); }
+    void i64(int64_t value) { put(&value, sizeof(value)); }
+    void f64(double value) { put(&value, sizeof(value)); }
+    void str(const std::string& value);
+    void raw(const std::string& bytes) { put(bytes.data(), bytes.size()); }
+
+    const std::string& data() const { return data_; }
+
+private:
+    void put(const void* bytes, size_t size) { data_.append(static_cast<const char*>(bytes), size); }
+
+    std::string data_;
+};
+
+// Reads what SnapshotWriter wrote; throws std::runtime_error past the end
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t u8() { return get<uint8_t>(); }
+    uint32_t u32() { return get<uint32_t>(); }
+    uint64_t u64() { return get<uint64_t>(); }
+    int64_t i64() { return get<int64_t>(); }
+    double f64() { return get<double>(); }
+    std::string str();
+    // A u32 element count, refused when that many elements of at least
+    // min_element_bytes cannot fit in what is left
+    size_t count(size_t min_element_bytes);
+
+    // The next `size` bytes as a reader of their own
+    SnapshotReader sub(size_t size);
+    size_t remaining() const { return size_ - offset_; }
+
+private:
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+    const char* take(size_t size);
+
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+struct SnapshotOptions {
+    std::string path; // Empty: no snapshot
+    std::chrono::seconds interval = Constants::SNAPSHOT_INTERVAL; // 0: only at shutdown
+};
+
+// Binary snapshot of the scheduling state the dispatcher learns in memory:
+// runtime samples by codec, per-engine health and circuit state, and retry
+// counters. Jobs, engines and the pending queue live in the repositories and
+// need no snapshot.
+//
+// The snapshot records the wall-clock time it reflects. A restart maps the
+// file, restores the state, and replays only the jobs written after that
+// time (IJobRepository::get_jobs_updated_since) through the same recording
+// the live completion and failure paths do, so start-up cost follows the
+// changes since the last snapshot rather than the size of the jobs table.
+// Replay sees each job's latest row only: a job that failed and then
+// completed after the snapshot shows up as its completion and the failure
+// recorded on the failed engine ("avoid_engine").
+//
+// The file is written to a temporary name, synced and renamed over the old
+// one; a torn, foreign or older-format file fails its header or checksum and
+// is ignored, leaving a cold start.
+class StateSnapshot {
+public:
+    StateSnapshot(std::shared_ptr<RuntimeEstimator> estimator, std::shared_ptr<EngineHealth> health,
+                  std::shared_ptr<RetryScheduler> retries);
+
+    // Captures the state, stamped with watermark_ms, and replaces the file
+    bool write(const std::string& path, int64_t watermark_ms) const;
+
+    // Restores the state from the file; false when it is missing or damaged
+    bool load(const std::string& path, int64_t& watermark_ms);
+
+    // Records the jobs written after watermark_ms; returns how many were replayed
+    size_t replay(IJobRepository& jobs, int64_t watermark_ms);
+
+private:
+    std::shared_ptr<RuntimeEstimator> estimator_;
+    std::shared_ptr<EngineHealth> health_;
+    std::shared_ptr<RetryScheduler> retries_;
+};
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // STATE_SNAPSHOT_H
@@ -10,9 +10,18 @@ void StatusSubscriber::subscribeToStatusUpdates(std::function<void(const std::st
         return;
     }
 
-    consumer_->subscribe("status", [callback](const Message& msg) {
+    consumer_->subscribe("status", [callback, lag_observer = lag_observer_](const Message& msg) {
+        if (lag_observer && msg.published_at_ms > 0) {
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch());
+            lag_observer(now - std::chrono::milliseconds(msg.published_at_ms));
+        }
         callback(msg.payload);
     });
 }
 
+void StatusSubscriber::setLagObserver(std::function<void(std::chrono::milliseconds)> observer) {
+    lag_observer_ = std::move(observer);
+}
+
 } // namespace distconv
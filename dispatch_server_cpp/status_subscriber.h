@@ -1,6 +1,7 @@
 #pragma once
 
 #include "message_queue.h"
+#include <chrono>
 #include <memory>
 #include <string>
 #include <functional>
@@ -14,8 +15,13 @@ public:
     // Subscribes to the "status" topic.
     void subscribeToStatusUpdates(std::function<void(const std::string&)> callback);
 
+    // Called with each update's time in the queue (receipt minus publish
+    // time) when the transport stamps one; set before subscribing.
+    void setLagObserver(std::function<void(std::chrono::milliseconds)> observer);
+
 private:
     std::shared_ptr<MessageQueueConsumer> consumer_;
+    std::function<void(std::chrono::milliseconds)> lag_observer_;
 };
 
 } // namespace distconv
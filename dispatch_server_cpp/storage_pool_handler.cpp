@@ -122,11 +122,11 @@ void StoragePoolUpdateHandler::handle(const httplib::Request& req, httplib::Resp
     }
 
     // Extract pool ID from URL
-    if (req.matches.size() < 2) {
+    std::string pool_id = path_param(req, "pool_id");
+    if (pool_id.empty()) {
         set_json_error_response(res, "Invalid or missing pool ID in URL", "validation_error", 400);
         return;
     }
-    std::string pool_id = req.matches[1];
 
     // Check if pool exists
     if (!storage_repo_->pool_exists(pool_id)) {
@@ -177,11 +177,11 @@ void StoragePoolDeleteHandler::handle(const httplib::Request& req, httplib::Resp
     }
 
     // Extract pool ID from URL
-    if (req.matches.size() < 2) {
+    std::string pool_id = path_param(req, "pool_id");
+    if (pool_id.empty()) {
         set_json_error_response(res, "Invalid or missing pool ID in URL", "validation_error", 400);
         return;
     }
-    std::string pool_id = req.matches[1];
 
     // Check if pool exists
     if (!storage_repo_->pool_exists(pool_id)) {
@@ -1,5 +1,5 @@
 #include "tdarr_client.h"
-#include <iostream>
+#include "structured_log.hpp"
 
 namespace distconv {
 namespace Tdarr {
@@ -37,7 +37,8 @@ bool TdarrClient::submit_job(const nlohmann::json& job_data, std::string& out_td
             return true;
         }
     } else {
-        std::cerr << "Tdarr job submission failed. StatusCode: " << (res ? std::to_string(res->status) : "connection error") << std::endl;
+        logging::error("tdarr", "Tdarr job submission failed",
+                       {{"status", res ? std::to_string(res->status) : "connection error"}});
     }
     return false;
 }
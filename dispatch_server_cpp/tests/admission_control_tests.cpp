@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../admission_control.h"
+#include "../job_handlers.h"
+#include "../repositories.h"
+#include "../scheduler_stats_handler.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+class AdmissionControlTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+
+    void add_pending(int count, const std::string& status = "pending") {
+        static int next = 0;
+        for (int i = 0; i < count; ++i) {
+            std::string job_id = "job-" + std::to_string(next++);
+            job_repo->save_job(job_id, {{"job_id", job_id}, {"status", status}});
+        }
+    }
+
+    httplib::Response submit(JobSubmissionHandler& handler, const std::string& tenant = "") {
+        nlohmann::json body = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"}};
+        if (!tenant.empty()) {
+            body["tenant"] = tenant;
+        }
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(AdmissionControlTest, GlobalLimitRefusesWith429AndRetryAfter) {
+    AdmissionPolicy policy;
+    policy.max_pending = 2;
+    auto admission = std::make_shared<AdmissionController>(job_repo, policy);
+    JobSubmissionHandler handler(auth, job_repo, nullptr, admission);
+
+    EXPECT_EQ(submit(handler).status, 200);
+    EXPECT_EQ(submit(handler).status, 200);
+    auto refused = submit(handler);
+    ASSERT_EQ(refused.status, 429);
+    EXPECT_EQ(refused.get_header_value("Retry-After"), "30"); // Nothing has drained yet
+    EXPECT_EQ(nlohmann::json::parse(refused.body)["error_type"], "rate_limited");
+    EXPECT_EQ(job_repo->get_jobs_by_status("pending").size(), 2u);
+
+    // Stats carry queue depth and the rejection
+    SchedulerStatsHandler stats(auth, nullptr, nullptr, admission);
+    httplib::Request req;
+    req.headers.emplace("X-API-Key", "test_key");
+    httplib::Response res;
+    stats.handle(req, res);
+    auto metrics = nlohmann::json::parse(res.body)["admission"];
+    EXPECT_EQ(metrics["pending"], 2);
+    EXPECT_EQ(metrics["admitted"], 2);
+    EXPECT_EQ(metrics["rejected_global"], 1);
+}
+
+TEST_F(AdmissionControlTest, RetryAfterFollowsTheMeasuredDrainRate) {
+    AdmissionPolicy policy;
+    policy.max_pending = 10;
+    AdmissionController admission(job_repo, policy, 1s);
+    add_pending(10);
+
+    auto decision = admission.admit("", 0);
+    EXPECT_EQ(decision.outcome, AdmissionDecision::Outcome::Reject);
+
+    // Four jobs claimed in two seconds: 2 jobs/s
+    int claimed = 0;
+    for (auto& job : job_repo->get_jobs_by_status("pending")) {
+        if (claimed++ < 4) {
+            job_repo->update_job(job["job_id"], {{"status", "assigned"}});
+        }
+    }
+    EXPECT_EQ(admission.admit("", 2000).outcome, AdmissionDecision::Outcome::Admit);
+    add_pending(1);
+
+    // Five more arrive; nothing drains in the next second (smoothed rate 1.4/s)
+    add_pending(5);
+    decision = admission.admit("", 3000);
+    ASSERT_EQ(decision.outcome, AdmissionDecision::Outcome::Reject);
+    EXPECT_EQ(decision.limit, "global");
+    EXPECT_EQ(decision.retry_after_seconds, 3); // 3 jobs over the limit at 1.4/s
+}
+
+TEST_F(AdmissionControlTest, TenantLimitIsSeparateAndSoftLimitsDeprioritize) {
+    AdmissionPolicy policy;
+    policy.max_pending_per_tenant = 1;
+    policy.soft_limit = true;
+    auto admission = std::make_shared<AdmissionController>(job_repo, policy);
+    JobSubmissionHandler handler(auth, job_repo, nullptr, admission);
+
+    auto first = submit(handler, "acme");
+    ASSERT_EQ(first.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(first.body)["priority"], 0);
+
+    auto second = nlohmann::json::parse(submit(handler, "acme").body);
+    EXPECT_EQ(second["priority"], -1);
+    EXPECT_EQ(second["admission"]["state"], "deprioritized");
+    EXPECT_EQ(second["admission"]["limit"], "tenant");
+    EXPECT_EQ(second["admission"]["requested_priority"], 0);
+
+    EXPECT_EQ(nlohmann::json::parse(submit(handler, "globex").body)["priority"], 0);
+
+    policy.soft_limit = false;
+    admission->set_policy(policy);
+    auto refused = submit(handler, "acme");
+    EXPECT_EQ(refused.status, 429);
+    EXPECT_EQ(submit(handler, "initech").status, 200);
+    EXPECT_EQ(admission->metrics(0)["rejected_tenant"], 1);
+}
+
+TEST_F(AdmissionControlTest, UnboundedPolicyAdmitsEverything) {
+    AdmissionController admission(job_repo);
+    add_pending(100);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(admission.admit("acme", i).outcome, AdmissionDecision::Outcome::Admit);
+    }
+    EXPECT_EQ(admission.metrics(0)["pending"], 105);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
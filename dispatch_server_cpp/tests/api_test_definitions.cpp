@@ -8,5 +8,4 @@ httplib::Client* ApiTest::client = nullptr;
 int ApiTest::port = 0;
 std::string ApiTest::api_key = "test_api_key";
 httplib::Headers ApiTest::admin_headers;
-std::string ApiTest::persistent_storage_file;
 bool ApiTest::use_legacy_mode = true;
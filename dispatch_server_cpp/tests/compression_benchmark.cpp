@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "engine_handlers.h"
+#include "job_handlers.h"
+#include "repositories.h"
+#include "response_compression.h"
+#include "nlohmann/json.hpp"
+
+using namespace distconv::DispatchServer;
+
+// Bytes saved and CPU spent compressing the dispatcher's large responses:
+// GET /jobs/ over a 20k-job backlog and GET /engines/ over a 500-engine
+// fleet, both produced by the real handlers, plus the /events stream, where
+// every event is flushed on its own. Each coding runs at the levels worth
+// configuring; decompression is the client's cost and is not measured.
+
+namespace {
+
+constexpr int JOBS = 20000;
+constexpr int ENGINES = 500;
+constexpr int EVENTS = 5000;
+constexpr int ROUNDS = 5;
+
+httplib::Request request(const std::string& method, const std::string& path, const std::string& body = "") {
+    httplib::Request req;
+    req.method = method;
+    req.path = path;
+    req.body = body;
+    req.headers.emplace("X-API-Key", "bench");
+    return req;
+}
+
+std::string job_listing() {
+    auto auth = std::make_shared<AuthMiddleware>("bench");
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    JobSubmissionHandler submit(auth, job_repo);
+    for (int i = 0; i < JOBS; ++i) {
+        nlohmann::json job = {{"source_url", "https://media.example.com/ingest/2024/show-" + std::to_string(i / 40) +
+                                                 "/episode-" + std::to_string(i % 40) + ".mov"},
+                              {"target_codec", i % 4 == 0 ? "h265" : "h264"},
+                              {"job_size", 20.0 + (i * 37) % 4000},
+                              {"tenant", "studio-" + std::to_string(i % 7)}};
+        httplib::Response res;
+        submit.handle(request("POST", "/jobs/", job.dump()), res);
+    }
+    httplib::Response res;
+    JobListHandler(auth, job_repo).handle(request("GET", "/jobs/"), res);
+    return res.body;
+}
+
+std::string engine_listing() {
+    auto auth = std::make_shared<AuthMiddleware>("bench");
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    EngineHeartbeatHandler heartbeat(auth, engine_repo);
+    for (int i = 0; i < ENGINES; ++i) {
+        nlohmann::json engine = {{"engine_id", "engine-" + std::to_string(i)},
+                                 {"hostname", "transcode-" + std::to_string(i) + ".dc1.example.com"},
+                                 {"status", i % 5 == 0 ? "busy" : "idle"},
+                                 {"storage_capacity_gb", 500},
+                                 {"streaming_support", true},
+                                 {"benchmark_time", 40.0 + i % 17}};
+        httplib::Response res;
+        heartbeat.handle(request("POST", "/engines/heartbeat", engine.dump()), res);
+    }
+    httplib::Response res;
+    EngineListHandler(auth, engine_repo).handle(request("GET", "/engines/"), res);
+    return res.body;
+}
+
+std::vector<std::string> event_stream() {
+    std::vector<std::string> events;
+    for (int i = 0; i < EVENTS; ++i) {
+        char job_id[37];
+        std::snprintf(job_id, sizeof(job_id), "%08x-4b1e-4c6a-9d3f-%012x", i * 2654435761u, i);
+        nlohmann::json data = {{"job_id", job_id}, {"status", i % 3 ? "assigned" : "completed"},
+                               {"assigned_engine", "engine-" + std::to_string(i % ENGINES)}};
+        events.push_back("id: " + std::to_string(i + 1) + "\nevent: job.status\ndata: " + data.dump() + "\n\n");
+    }
+    return events;
+}
+
+struct Setting {
+    ContentCoding coding;
+    int level;
+};
+
+void report(const std::string& name, size_t raw, size_t encoded, double ms) {
+    std::cout << "  " << std::left << std::setw(8) << name << std::right << std::setw(11) << encoded << " B"
+              << std::fixed << std::setprecision(1) << std::setw(7) << 100.0 * (raw - encoded) / raw << "% saved"
+              << std::setw(9) << std::setprecision(2) << ms << " ms" << std::setw(8) << std::setprecision(0)
+              << raw / 1e6 / (ms / 1000.0) << " MB/s" << std::endl;
+}
+
+void run_body(const std::string& title, const std::string& body, const std::vector<Setting>& settings) {
+    std::cout << title << ": " << body.size() << " B uncompressed" << std::endl;
+    for (const auto& setting : settings) {
+        size_t encoded = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < ROUNDS; ++round) {
+            encoded = compress_body(body, setting.coding, setting.level).size();
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+        report(std::string(coding_name(setting.coding)) + "-" + std::to_string(setting.level), body.size(), encoded, ms);
+    }
+}
+
+void run_stream(const std::vector<std::string>& events, const std::vector<Setting>& settings) {
+    size_t raw = 0;
+    for (const auto& event : events) raw += event.size();
+    std::cout << "GET /events, " << events.size() << " events flushed one by one: " << raw << " B uncompressed"
+              << std::endl;
+    for (const auto& setting : settings) {
+        size_t encoded = 0;
+        auto count = [&encoded](const char*, size_t size) {
+            encoded += size;
+            return true;
+        };
+        auto start = std::chrono::steady_clock::now();
+        auto compressor = make_compressor(setting.coding, setting.level);
+        for (const auto& event : events) {
+            compressor->compress(event.data(), event.size(), false, count);
+        }
+        compressor->compress(nullptr, 0, true, count);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        report(std::string(coding_name(setting.coding)) + "-" + std::to_string(setting.level), raw, encoded, ms);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::vector<Setting> settings = {{ContentCoding::Gzip, 1}, {ContentCoding::Gzip, 6}, {ContentCoding::Gzip, 9}};
+    if (zstd_available()) {
+        settings.insert(settings.end(), {{ContentCoding::Zstd, 1}, {ContentCoding::Zstd, 3}, {ContentCoding::Zstd, 6},
+                                         {ContentCoding::Zstd, 9}});
+    } else {
+        std::cout << "(built without libzstd: gzip only)" << std::endl;
+    }
+
+    run_body("GET /jobs/, " + std::to_string(JOBS) + " jobs", job_listing(), settings);
+    run_body("GET /engines/, " + std::to_string(ENGINES) + " engines", engine_listing(), settings);
+    run_stream(event_stream(), settings);
+    return 0;
+}
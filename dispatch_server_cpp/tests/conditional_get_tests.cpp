@@ -0,0 +1,180 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../engine_handlers.h"
+#include "../job_events.h"
+#include "../job_handlers.h"
+#include "../repositories.h"
+#include "../resource_versions.h"
+#include "http_test_utils.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const std::string JOB_ID = "123e4567-e89b-12d3-a456-426614174000";
+
+// Counts reads so the tests can tell a 304 never reached the repository
+class CountingJobRepository : public InMemoryJobRepository {
+public:
+    nlohmann::json get_job(const std::string& job_id) override {
+        reads++;
+        return InMemoryJobRepository::get_job(job_id);
+    }
+    std::atomic<int> reads{0};
+};
+
+class CountingEngineRepository : public InMemoryEngineRepository {
+public:
+    std::vector<nlohmann::json> get_all_engines() override {
+        reads++;
+        return InMemoryEngineRepository::get_all_engines();
+    }
+    std::atomic<int> reads{0};
+};
+
+httplib::Request get(const std::string& path, const std::string& if_none_match = "") {
+    httplib::Request req;
+    req.method = "GET";
+    req.path = path;
+    req.headers.emplace("X-API-Key", "test_key");
+    if (!if_none_match.empty()) {
+        req.headers.emplace("If-None-Match", if_none_match);
+    }
+    req.path_params.emplace("job_id", JOB_ID);
+    return req;
+}
+
+} // namespace
+
+TEST(ConditionalGetTest, JobStatusAnswersAMatchingTagWithoutReadingTheRepository) {
+    auto versions = std::make_shared<ResourceVersions>();
+    auto inner = std::make_shared<CountingJobRepository>();
+    auto job_repo = std::make_shared<PublishingJobRepository>(
+        inner, std::make_shared<JobEventBus>(16, 16, 1), versions);
+    job_repo->save_job(JOB_ID, {{"job_id", JOB_ID}, {"status", "pending"}});
+    JobStatusHandler handler(std::make_shared<AuthMiddleware>("test_key"), job_repo, versions);
+
+    httplib::Response first;
+    handler.handle(get("/jobs/" + JOB_ID), first);
+    ASSERT_EQ(first.status, 200);
+    std::string etag = first.get_header_value("ETag");
+    ASSERT_FALSE(etag.empty());
+    EXPECT_EQ(inner->reads.load(), 1);
+
+    httplib::Response unchanged;
+    handler.handle(get("/jobs/" + JOB_ID, etag), unchanged);
+    EXPECT_EQ(unchanged.status, 304);
+    EXPECT_TRUE(unchanged.body.empty());
+    EXPECT_EQ(unchanged.get_header_value("ETag"), etag);
+    EXPECT_EQ(inner->reads.load(), 1);
+
+    // Any write through the decorator moves the tag
+    job_repo->update_job_progress(JOB_ID, 40, "");
+    httplib::Response changed;
+    handler.handle(get("/jobs/" + JOB_ID, etag), changed);
+    EXPECT_EQ(changed.status, 200);
+    EXPECT_NE(changed.get_header_value("ETag"), etag);
+    EXPECT_EQ(inner->reads.load(), 3); // Including the progress publish
+}
+
+TEST(ConditionalGetTest, EngineListTagMovesWithEngineWrites) {
+    auto versions = std::make_shared<ResourceVersions>();
+    auto inner = std::make_shared<CountingEngineRepository>();
+    auto engine_repo = std::make_shared<VersionedEngineRepository>(inner, versions);
+    engine_repo->save_engine("engine-1", {{"engine_id", "engine-1"}, {"status", "idle"}});
+    EngineListHandler handler(std::make_shared<AuthMiddleware>("test_key"), engine_repo, versions);
+
+    httplib::Response first;
+    handler.handle(get("/engines/"), first);
+    std::string etag = first.get_header_value("ETag");
+    ASSERT_FALSE(etag.empty());
+
+    httplib::Response unchanged;
+    handler.handle(get("/engines/", "W/" + etag), unchanged);
+    EXPECT_EQ(unchanged.status, 304);
+    EXPECT_EQ(inner->reads.load(), 1);
+
+    engine_repo->remove_engine("engine-1");
+    httplib::Response changed;
+    handler.handle(get("/engines/", etag), changed);
+    EXPECT_EQ(changed.status, 200);
+    EXPECT_EQ(changed.body, "[]");
+    EXPECT_NE(changed.get_header_value("ETag"), etag);
+}
+
+TEST(ConditionalGetTest, TagsFromAnotherProcessOrAClearedRepositoryNeverMatch) {
+    ResourceVersions before_restart;
+    ResourceVersions after_restart;
+    // Neither has seen a write to the job: both at version 0, different epochs
+    EXPECT_NE(before_restart.job_etag(JOB_ID), after_restart.job_etag(JOB_ID));
+
+    std::string untouched = after_restart.job_etag(JOB_ID);
+    after_restart.job_changed("another-job");
+    EXPECT_EQ(after_restart.job_etag(JOB_ID), untouched);
+    after_restart.all_jobs_changed();
+    EXPECT_NE(after_restart.job_etag(JOB_ID), untouched);
+    EXPECT_EQ(after_restart.tracked_jobs(), 0u);
+}
+
+TEST(ConditionalGetTest, IfNoneMatchAcceptsListsWeakTagsAndWildcards) {
+    const std::string etag = "\"abc-3\"";
+    auto with = [](const std::string& value) {
+        httplib::Request req;
+        req.headers.emplace("If-None-Match", value);
+        return req;
+    };
+    EXPECT_TRUE(etag_matches(with("\"abc-3\""), etag));
+    EXPECT_TRUE(etag_matches(with("\"x-1\", W/\"abc-3\""), etag));
+    EXPECT_TRUE(etag_matches(with("*"), etag));
+    EXPECT_FALSE(etag_matches(with("\"abc-2\""), etag));
+    EXPECT_FALSE(etag_matches(with("abc-3"), etag));
+    EXPECT_FALSE(etag_matches(httplib::Request(), etag));
+}
+
+TEST(ConditionalGetTest, DispatchServerTagsPolledResources) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    DispatchServer server(job_repo, engine_repo, "test_key");
+    server.set_event_loop(EventLoopOptions{});
+    server.start(0, false);
+
+    httplib::Client client("127.0.0.1", server.get_port());
+    httplib::Headers headers = {{"X-API-Key", "test_key"}};
+    nlohmann::json job = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"}};
+    auto submit = with_connect_retry([&] { return client.Post("/jobs/", headers, job.dump(), "application/json"); });
+    ASSERT_TRUE(submit);
+    auto job_id = nlohmann::json::parse(submit->body)["job_id"].get<std::string>();
+
+    auto status = with_connect_retry([&] { return client.Get("/jobs/" + job_id, headers); });
+    ASSERT_TRUE(status);
+    std::string etag = status->get_header_value("ETag");
+    ASSERT_FALSE(etag.empty());
+
+    httplib::Headers revalidate = {{"X-API-Key", "test_key"}, {"If-None-Match", etag}};
+    auto not_modified = with_connect_retry([&] { return client.Get("/jobs/" + job_id, revalidate); });
+    ASSERT_TRUE(not_modified);
+    EXPECT_EQ(not_modified->status, 304);
+
+    auto heartbeat = with_connect_retry([&] {
+        return client.Post("/engines/heartbeat", headers, R"({"engine_id": "engine-1"})", "application/json");
+    });
+    ASSERT_TRUE(heartbeat);
+    auto engines = with_connect_retry([&] { return client.Get("/engines/", headers); });
+    ASSERT_TRUE(engines);
+    std::string engines_etag = engines->get_header_value("ETag");
+    httplib::Headers revalidate_engines = {{"X-API-Key", "test_key"}, {"If-None-Match", engines_etag}};
+    auto engines_unchanged = with_connect_retry([&] { return client.Get("/engines/", revalidate_engines); });
+    ASSERT_TRUE(engines_unchanged);
+    EXPECT_EQ(engines_unchanged->status, 304);
+    server.stop();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
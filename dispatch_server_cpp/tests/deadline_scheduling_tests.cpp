@@ -0,0 +1,166 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../deadline_monitor.h"
+#include "../job_handlers.h"
+#include "../repositories.h"
+#include "../runtime_estimator.h"
+#include "../scheduler_stats_handler.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+
+class DeadlineSchedulingTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<RuntimeEstimator> estimator = std::make_shared<RuntimeEstimator>(1);
+    std::shared_ptr<DeadlineMonitor> deadlines =
+        std::make_shared<DeadlineMonitor>(job_repo, engine_repo, estimator);
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void SetUp() override {
+        // One single-slot engine; h264 jobs take a minute
+        engine_repo->save_engine("engine-1", {{"engine_id", "engine-1"}, {"status", "idle"}});
+        estimator->record({{"target_codec", "h264"}}, 60000);
+    }
+
+    httplib::Response submit(JobSubmissionHandler& handler, const nlohmann::json& deadline, int priority = 0) {
+        nlohmann::json body = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"},
+                               {"priority", priority}, {"deadline", deadline}};
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST(ParseDeadlineTest, AcceptsEpochMillisecondsAndIso8601) {
+    int64_t ms = 0;
+    ASSERT_TRUE(parse_deadline(1777658400000LL, ms));
+    EXPECT_EQ(ms, 1777658400000LL);
+    ASSERT_TRUE(parse_deadline("2026-05-01T18:00:00Z", ms));
+    EXPECT_EQ(ms, 1777658400000LL);
+    ASSERT_TRUE(parse_deadline("2026-05-01T18:00:00.250Z", ms));
+    EXPECT_EQ(ms, 1777658400250LL);
+    ASSERT_TRUE(parse_deadline("2026-05-01T20:00:00+02:00", ms));
+    EXPECT_EQ(ms, 1777658400000LL);
+
+    EXPECT_FALSE(parse_deadline("tomorrow", ms));
+    EXPECT_FALSE(parse_deadline("2026-13-01T00:00:00Z", ms));
+    EXPECT_FALSE(parse_deadline("2026-05-01T18:00:00Zulu", ms));
+    EXPECT_FALSE(parse_deadline(12.5, ms));
+    EXPECT_FALSE(parse_deadline(-1, ms));
+}
+
+TEST(RuntimeEstimatorTest, ScalesCodecRatePerMegabyte) {
+    RuntimeEstimator estimator(1);
+    estimator.record({{"target_codec", "av1"}, {"job_size", 100.0}}, 10000);
+
+    int64_t runtime = 0;
+    ASSERT_TRUE(estimator.predict({{"target_codec", "av1"}, {"job_size", 50.0}}, runtime));
+    EXPECT_EQ(runtime, 5000);
+    ASSERT_TRUE(estimator.predict({{"target_codec", "av1"}}, runtime)); // No size: the codec median
+    EXPECT_EQ(runtime, 10000);
+    EXPECT_FALSE(estimator.predict({{"target_codec", "vp9"}}, runtime));
+}
+
+TEST_F(DeadlineSchedulingTest, EarliestLatestStartIsClaimedFirstWithinPriority) {
+    JobSubmissionHandler handler(auth, job_repo, nullptr, nullptr, deadlines);
+    int64_t now = now_ms();
+    auto relaxed = nlohmann::json::parse(submit(handler, now + 3600000).body);
+    auto tight = nlohmann::json::parse(submit(handler, now + 600000).body);
+    EXPECT_EQ(tight["latest_start"], tight["deadline"].get<int64_t>() - 60000);
+
+    auto urgent_body = nlohmann::json{{"source_url", "http://example.com/u.mp4"}, {"target_codec", "h264"},
+                                      {"priority", 2}};
+    httplib::Request req;
+    req.headers.emplace("X-API-Key", "test_key");
+    req.body = urgent_body.dump();
+    httplib::Response res;
+    handler.handle(req, res);
+    auto urgent = nlohmann::json::parse(res.body);
+
+    auto pending = job_repo->get_pending_jobs(10);
+    ASSERT_EQ(pending.size(), 3u);
+    EXPECT_EQ(pending[0]["job_id"], urgent["job_id"]); // Priority still comes first
+    EXPECT_EQ(pending[1]["job_id"], tight["job_id"]);
+    EXPECT_EQ(pending[2]["job_id"], relaxed["job_id"]);
+}
+
+TEST_F(DeadlineSchedulingTest, SubmissionFlagsJobForecastToMissItsDeadline) {
+    JobSubmissionHandler handler(auth, job_repo, nullptr, nullptr, deadlines);
+    int64_t now = now_ms();
+    // A running job holds the only slot for another minute, so 90s is not enough
+    job_repo->save_job("running", {{"job_id", "running"}, {"status", "assigned"}, {"target_codec", "h264"},
+                                   {"assigned_engine", "engine-1"}, {"assigned_at", now}});
+
+    auto res = submit(handler, now + 90000);
+    ASSERT_EQ(res.status, 200);
+    auto job = nlohmann::json::parse(res.body);
+    EXPECT_TRUE(job["sla"]["at_risk"].get<bool>());
+    EXPECT_GE(job["sla"]["predicted_finish_at"].get<int64_t>(), now + 120000);
+    EXPECT_LT(job["sla"]["slack_ms"].get<int64_t>(), 0);
+
+    auto safe = nlohmann::json::parse(submit(handler, now + 3600000).body);
+    EXPECT_FALSE(safe["sla"]["at_risk"].get<bool>());
+
+    AtRiskJobsHandler at_risk(auth, deadlines);
+    httplib::Request req;
+    req.headers.emplace("X-API-Key", "test_key");
+    httplib::Response listing;
+    at_risk.handle(req, listing);
+    ASSERT_EQ(listing.status, 200);
+    auto body = nlohmann::json::parse(listing.body);
+    ASSERT_EQ(body["count"], 1);
+    EXPECT_EQ(body["jobs"][0]["job_id"], job["job_id"]);
+    EXPECT_EQ(deadlines->metrics()["flagged_at_submission"], 1);
+}
+
+TEST_F(DeadlineSchedulingTest, ScanClearsFlagOnceCapacityFreesUp) {
+    JobSubmissionHandler handler(auth, job_repo, nullptr, nullptr, deadlines);
+    int64_t now = now_ms();
+    job_repo->save_job("running", {{"job_id", "running"}, {"status", "assigned"}, {"target_codec", "h264"},
+                                   {"assigned_engine", "engine-1"}, {"assigned_at", now}});
+    auto job = nlohmann::json::parse(submit(handler, now + 90000).body);
+    ASSERT_TRUE(job["sla"]["at_risk"].get<bool>());
+
+    deadlines->scan(now);
+    EXPECT_EQ(deadlines->at_risk()["count"], 1);
+
+    // A second engine registers: the job can start right away
+    engine_repo->save_engine("engine-2", {{"engine_id", "engine-2"}, {"status", "idle"}});
+    deadlines->scan(now);
+    EXPECT_EQ(deadlines->at_risk()["count"], 0);
+    EXPECT_FALSE(job_repo->get_job(job["job_id"])["sla"]["at_risk"].get<bool>());
+    EXPECT_EQ(deadlines->metrics()["tracked"], 1);
+}
+
+TEST_F(DeadlineSchedulingTest, NoEnginesMeansEveryDeadlineIsAtRisk) {
+    engine_repo->clear_all_engines();
+    JobSubmissionHandler handler(auth, job_repo, nullptr, nullptr, deadlines);
+    auto job = nlohmann::json::parse(submit(handler, now_ms() + 3600000).body);
+    EXPECT_TRUE(job["sla"]["at_risk"].get<bool>());
+    EXPECT_TRUE(job["sla"]["predicted_finish_at"].is_null());
+}
+
+TEST_F(DeadlineSchedulingTest, RejectsMalformedDeadline) {
+    JobSubmissionHandler handler(auth, job_repo, nullptr, nullptr, deadlines);
+    auto res = submit(handler, "next tuesday");
+    EXPECT_EQ(res.status, 400);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["error_type"], "validation_error");
+    EXPECT_TRUE(job_repo->get_all_jobs().empty());
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../engine_channel_handler.h"
+#include "../repositories.h"
+#include <memory>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const std::string kRunningJob = "11111111-1111-1111-1111-111111111111";
+const std::string kPendingJob = "22222222-2222-2222-2222-222222222222";
+
+} // namespace
+
+class EngineChannelTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::unique_ptr<EngineChannelHandler> handler;
+
+    void SetUp() override {
+        handler = std::make_unique<EngineChannelHandler>(std::make_shared<AuthMiddleware>("test_key"),
+                                                         job_repo, engine_repo);
+        engine_repo->save_engine("engine-1", {{"engine_id", "engine-1"}, {"status", "busy"},
+                                              {"current_job_id", kRunningJob}});
+        job_repo->save_job(kRunningJob, {{"job_id", kRunningJob}, {"status", "assigned"},
+                                         {"assigned_engine", "engine-1"}, {"created_at", 1}});
+    }
+
+    nlohmann::json exchange(const nlohmann::json& body) {
+        httplib::Request req;
+        req.method = "POST";
+        req.path = "/engines/channel";
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = body.dump();
+        httplib::Response res;
+        handler->handle(req, res);
+        EXPECT_EQ(res.status, 200) << res.body;
+        return nlohmann::json::parse(res.body)["frames"];
+    }
+};
+
+TEST_F(EngineChannelTest, BatchCompletesBeforeAssigningNextJob) {
+    job_repo->save_job(kPendingJob, {{"job_id", kPendingJob}, {"status", "pending"},
+                                     {"target_codec", "h264"}, {"created_at", 2}});
+
+    auto frames = exchange({
+        {"engine_id", "engine-1"},
+        {"frames", {
+            {{"type", "assign"}},
+            {{"type", "heartbeat"}, {"body", {{"status", "idle"}}}},
+            {{"type", "progress"}, {"job_id", kRunningJob}, {"body", {{"progress", 100}}}},
+            {{"type", "complete"}, {"job_id", kRunningJob}, {"body", {{"output_url", "http://out/1.mp4"}}}},
+        }},
+    });
+
+    ASSERT_EQ(frames.size(), 4u);
+    EXPECT_EQ(frames[0]["frame"], "heartbeat");
+    EXPECT_EQ(frames[0]["status"], 200);
+    EXPECT_EQ(frames[1]["frame"], "progress");
+    EXPECT_EQ(frames[1]["status"], 200);
+    EXPECT_EQ(frames[2]["frame"], "complete");
+    EXPECT_EQ(frames[2]["index"], 3);
+    EXPECT_EQ(frames[3]["type"], "assignment");
+    EXPECT_EQ(frames[3]["job"]["job_id"], kPendingJob);
+
+    EXPECT_EQ(job_repo->get_job(kRunningJob)["status"], "completed");
+    EXPECT_EQ(job_repo->get_job(kPendingJob)["assigned_engine"], "engine-1");
+    EXPECT_TRUE(engine_repo->get_engine("engine-1").contains("last_heartbeat"));
+}
+
+TEST_F(EngineChannelTest, ReturnsCancelForCancelledActiveJobs) {
+    auto job = job_repo->get_job(kRunningJob);
+    job["status"] = "cancelled";
+    job_repo->save_job(kRunningJob, job);
+
+    auto frames = exchange({{"engine_id", "engine-1"}, {"active_jobs", {kRunningJob}}});
+
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0]["type"], "cancel");
+    EXPECT_EQ(frames[0]["job_id"], kRunningJob);
+    EXPECT_EQ(frames[0]["reason"], "cancelled");
+}
+
+TEST_F(EngineChannelTest, RejectsMalformedFramesIndividually) {
+    auto frames = exchange({
+        {"engine_id", "engine-1"},
+        {"frames", {
+            {{"type", "reboot"}},
+            {{"type", "complete"}, {"job_id", "../engines"}},
+            {{"type", "heartbeat"}},
+        }},
+    });
+
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0]["status"], 400);
+    EXPECT_EQ(frames[1]["status"], 404);
+    EXPECT_EQ(frames[2]["status"], 200);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../job_action_handlers.h"
+#include "../engine_health.h"
+#include "../repositories.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::string job_id(int n) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08d-0000-0000-0000-000000000000", n);
+    return id;
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+EngineHealthPolicy test_policy() {
+    EngineHealthPolicy policy;
+    policy.window = 10;
+    policy.min_samples = 4;
+    policy.max_failure_rate = 0.5;
+    policy.quarantine = 1000ms;
+    policy.max_quarantine = 3000ms;
+    return policy;
+}
+
+nlohmann::json job_with_id(const std::string& id) {
+    return {{"job_id", id}};
+}
+
+} // namespace
+
+TEST(EngineHealthTest, QuarantinesOnceTheFailureRateIsReached) {
+    EngineHealth health(test_policy());
+    health.record_success("engine-0", job_with_id("a"), 0);
+    health.record_failure("engine-0", job_with_id("b"), "FFmpeg transcoding failed", 0);
+    health.record_failure("engine-0", job_with_id("c"), "FFmpeg transcoding failed", 0);
+    EXPECT_TRUE(health.may_assign("engine-0", 0)); // Three samples are too few to judge
+
+    health.record_success("engine-0", job_with_id("d"), 0);
+    health.record_failure("engine-0", job_with_id("e"), "timeout", 10);
+    EXPECT_EQ(health.state("engine-0", 10), CircuitState::Open);
+    EXPECT_FALSE(health.may_assign("engine-0", 500));
+    EXPECT_TRUE(health.may_assign("engine-1", 500));
+
+    auto metrics = health.metrics(500);
+    EXPECT_EQ(metrics["quarantined"], 1);
+    EXPECT_EQ(metrics["engines"]["engine-0"]["state"], "quarantined");
+    EXPECT_EQ(metrics["engines"]["engine-0"]["quarantined_until"], 1010);
+    EXPECT_EQ(metrics["engines"]["engine-0"]["failure_reasons"]["FFmpeg transcoding failed"], 2);
+    EXPECT_EQ(metrics["engines"]["engine-0"]["failure_reasons"]["timeout"], 1);
+    EXPECT_DOUBLE_EQ(metrics["engines"]["engine-0"]["success_rate"].get<double>(), 0.4);
+}
+
+TEST(EngineHealthTest, SingleProbeClosesTheCircuitOnSuccess) {
+    EngineHealth health(test_policy());
+    for (int i = 0; i < 4; ++i) health.record_failure("engine-0", job_with_id("f" + std::to_string(i)), "boom", 0);
+    ASSERT_EQ(health.state("engine-0", 0), CircuitState::Open);
+
+    bool probe = false;
+    ASSERT_TRUE(health.may_assign("engine-0", 1000, &probe));
+    EXPECT_TRUE(probe);
+    health.on_claimed("engine-0", "probe-job", 1000);
+    EXPECT_FALSE(health.may_assign("engine-0", 1100)); // One probe at a time
+    EXPECT_EQ(health.metrics(1100)["engines"]["engine-0"]["state"], "probing");
+
+    health.record_success("engine-0", job_with_id("probe-job"), 1200);
+    EXPECT_EQ(health.state("engine-0", 1200), CircuitState::Closed);
+    ASSERT_TRUE(health.may_assign("engine-0", 1200, &probe));
+    EXPECT_FALSE(probe);
+    EXPECT_EQ(health.metrics(1200)["engines"]["engine-0"]["samples"], 1);
+}
+
+TEST(EngineHealthTest, FailedProbeDoublesTheQuarantine) {
+    EngineHealth health(test_policy());
+    for (int i = 0; i < 4; ++i) health.record_failure("engine-0", job_with_id("f" + std::to_string(i)), "boom", 0);
+
+    ASSERT_TRUE(health.may_assign("engine-0", 1000));
+    health.on_claimed("engine-0", "probe-1", 1000);
+    health.record_failure("engine-0", job_with_id("probe-1"), "boom", 1100);
+    EXPECT_FALSE(health.may_assign("engine-0", 2900));
+    ASSERT_TRUE(health.may_assign("engine-0", 3100));
+
+    health.on_claimed("engine-0", "probe-2", 3100);
+    health.record_failure("engine-0", job_with_id("probe-2"), "boom", 3100);
+    EXPECT_FALSE(health.may_assign("engine-0", 6000)); // Capped at max_quarantine
+    EXPECT_TRUE(health.may_assign("engine-0", 6100));
+    EXPECT_EQ(health.metrics(6100)["quarantines_total"], 3);
+}
+
+TEST(EngineHealthTest, ReportsThroughputOfCompletedJobs) {
+    EngineHealth health(test_policy());
+    health.record_success("engine-0", {{"job_id", "a"}, {"job_size", 100.0}, {"assigned_at", 0}}, 10000);
+    health.record_success("engine-0", {{"job_id", "b"}, {"job_size", 50.0}, {"assigned_at", 10000}}, 20000);
+    auto engine = health.metrics(20000)["engines"]["engine-0"];
+    EXPECT_DOUBLE_EQ(engine["throughput_mb_per_s"].get<double>(), 7.5);
+    EXPECT_DOUBLE_EQ(engine["success_rate"].get<double>(), 1.0);
+}
+
+class EngineHealthHandlerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::shared_ptr<EngineHealth> health = std::make_shared<EngineHealth>(test_policy());
+    int next_job = 0;
+
+    void SetUp() override {
+        for (const char* engine_id : {"engine-0", "engine-1"}) {
+            engine_repo->save_engine(engine_id, {{"engine_id", engine_id}, {"status", "idle"}});
+        }
+    }
+
+    std::string add_job() {
+        int n = next_job++;
+        job_repo->save_job(job_id(n), {{"job_id", job_id(n)}, {"status", "pending"}, {"priority", 0},
+                                       {"created_at", n}});
+        return job_id(n);
+    }
+
+    httplib::Response claim(const std::string& engine_id) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, nullptr, nullptr, nullptr, health);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", engine_id}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+
+    void fail(const std::string& id, const std::string& engine_id) {
+        JobFailureHandler handler(auth, job_repo, engine_repo, nullptr, health);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.path = "/jobs/" + id + "/fail";
+        req.path_params.emplace("job_id", id);
+        req.body = nlohmann::json{{"engine_id", engine_id}, {"error_message", "FFmpeg transcoding failed"}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+    }
+};
+
+TEST_F(EngineHealthHandlerTest, FailingEngineIsQuarantinedWhileOthersKeepClaiming) {
+    for (int i = 0; i < 4; ++i) {
+        std::string id = add_job();
+        ASSERT_EQ(claim("engine-0").status, 200);
+        fail(id, "engine-0");
+    }
+    EXPECT_EQ(health->state("engine-0", now_ms()), CircuitState::Open);
+
+    std::string id = add_job();
+    EXPECT_EQ(claim("engine-0").status, 204);
+    auto res = claim("engine-1");
+    ASSERT_EQ(res.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["job_id"], id);
+}
+
+TEST_F(EngineHealthHandlerTest, RetriedJobAvoidsTheEngineThatFailedIt) {
+    std::string id = add_job();
+    ASSERT_EQ(claim("engine-0").status, 200);
+    fail(id, "engine-0");
+
+    // Requeued by hand, as POST /jobs/{id}/retry does
+    auto job = job_repo->get_job(id);
+    EXPECT_EQ(job["avoid_engine"], "engine-0");
+    job["status"] = "pending";
+    job["assigned_engine"] = nullptr;
+    job_repo->save_job(id, job);
+
+    EXPECT_EQ(claim("engine-0").status, 204);
+    auto res = claim("engine-1");
+    ASSERT_EQ(res.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["job_id"], id);
+
+    // Once the window has passed the engine may take it again
+    EXPECT_FALSE(avoids_engine(job, "engine-0", job["avoid_until"].get<int64_t>()));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
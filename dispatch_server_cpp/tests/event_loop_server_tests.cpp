@@ -0,0 +1,487 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../event_loop_server.h"
+#include "../http_router.h"
+#include "../repositories.h"
+#include "http_test_utils.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+const std::string JOB_ID = "123e4567-e89b-12d3-a456-426614174000";
+
+// Runs an EventLoopServer over `router` on an ephemeral port for one test
+class RunningServer {
+public:
+    RunningServer(const HttpRouter& router, EventLoopOptions options = {},
+                  std::shared_ptr<EndpointPools> pools = nullptr)
+        : server_(router, options, pools) {
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        thread_ = std::thread([this]() { server_.listen_after_bind(); });
+    }
+    ~RunningServer() {
+        server_.stop();
+        thread_.join();
+    }
+
+    int port() const { return port_; }
+    EventLoopServer& server() { return server_; }
+
+private:
+    EventLoopServer server_;
+    int port_ = -1;
+    std::thread thread_;
+};
+
+int connect_raw(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+void send_all(int fd, const std::string& data) {
+    ASSERT_EQ(send(fd, data.data(), data.size(), MSG_NOSIGNAL), static_cast<ssize_t>(data.size()));
+}
+
+// Reads from a raw connection until `responses` complete Content-Length framed responses are in
+std::string read_responses(int fd, size_t responses) {
+    std::string data;
+    char buffer[4096];
+    size_t complete = 0;
+    while (complete < responses) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) break;
+        data.append(buffer, static_cast<size_t>(received));
+
+        complete = 0;
+        size_t pos = 0;
+        while (true) {
+            auto header_end = data.find("\r\n\r\n", pos);
+            if (header_end == std::string::npos) break;
+            auto length_at = data.find("Content-Length: ", pos);
+            size_t length = length_at < header_end ? std::stoul(data.substr(length_at + 16)) : 0;
+            if (data.size() < header_end + 4 + length) break;
+            pos = header_end + 4 + length;
+            ++complete;
+        }
+    }
+    return data;
+}
+
+// Pool counters move just after a response is handed back, so poll for them
+template <typename Predicate>
+bool eventually(Predicate predicate) {
+    for (int i = 0; i < 200 && !predicate(); ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    return predicate();
+}
+
+size_t thread_count() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::stoul(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+HttpRouter echo_router() {
+    HttpRouter router;
+    router.Get("/jobs/{job_id:uuid}", [](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(req.path_params.at("job_id") + " " + req.get_param_value("view"), "text/plain");
+    });
+    router.Post("/echo", [](const httplib::Request& req, httplib::Response& res) {
+        res.set_content(req.body, "text/plain");
+    });
+    return router;
+}
+
+} // namespace
+
+TEST(WorkerPoolTest, RecordsQueueTimeAndRefusesWorkBeyondTheQueue) {
+    WorkerPool pool("test", {1, 1});
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> ran{0};
+
+    ASSERT_TRUE(pool.submit([&]() { released.wait(); ran++; }));
+    for (int i = 0; i < 100 && pool.metrics()["active"] == 0; ++i) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_TRUE(pool.submit([&]() { ran++; }));
+    EXPECT_FALSE(pool.submit([&]() { ran++; }));
+
+    std::this_thread::sleep_for(30ms);
+    release.set_value();
+    pool.shutdown();
+
+    auto metrics = pool.metrics();
+    EXPECT_EQ(ran.load(), 2);
+    EXPECT_EQ(metrics["served"], 2);
+    EXPECT_EQ(metrics["rejected"], 1);
+    EXPECT_EQ(metrics["queued"], 0);
+    // The second task waited behind the first for at least 30 ms; its bucket
+    // bound is clamped to the largest wait seen
+    EXPECT_GE(metrics["queue_ms"]["max"].get<double>(), 30.0);
+    EXPECT_DOUBLE_EQ(metrics["queue_ms"]["p99"].get<double>(), metrics["queue_ms"]["max"].get<double>());
+    EXPECT_LT(metrics["queue_ms"]["p50"].get<double>(), 30.0);
+}
+
+TEST(EventLoopServerTest, RoutesCapturesQueryParametersAndBodies) {
+    auto router = echo_router();
+    RunningServer running(router);
+    ASSERT_GT(running.port(), 0);
+
+    httplib::Client client("127.0.0.1", running.port());
+    auto get = with_connect_retry([&] { return client.Get("/jobs/" + JOB_ID + "?view=full"); });
+    ASSERT_TRUE(get);
+    EXPECT_EQ(get->status, 200);
+    EXPECT_EQ(get->body, JOB_ID + " full");
+
+    auto post = with_connect_retry([&] { return client.Post("/echo", "{\"a\":1}", "application/json"); });
+    ASSERT_TRUE(post);
+    EXPECT_EQ(post->body, "{\"a\":1}");
+
+    auto missing = with_connect_retry([&] { return client.Get("/jobs/not-a-uuid"); });
+    ASSERT_TRUE(missing);
+    EXPECT_EQ(missing->status, 404);
+    auto wrong_method = with_connect_retry([&] { return client.Delete("/echo"); });
+    ASSERT_TRUE(wrong_method);
+    EXPECT_EQ(wrong_method->status, 404);
+}
+
+TEST(EventLoopServerTest, KeepAliveConnectionServesManyRequests) {
+    auto router = echo_router();
+    RunningServer running(router);
+
+    httplib::Client client("127.0.0.1", running.port());
+    client.set_keep_alive(true);
+    for (int i = 0; i < 5; ++i) {
+        auto res = with_connect_retry([&] { return client.Post("/echo", std::to_string(i), "text/plain"); });
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res->body, std::to_string(i));
+    }
+    EXPECT_EQ(running.server().stats().connections, 1u);
+    EXPECT_EQ(running.server().stats().requests, 5u);
+}
+
+TEST(EventLoopServerTest, AnswersPipelinedRequestsInOrder) {
+    auto router = echo_router();
+    RunningServer running(router);
+
+    int fd = connect_raw(running.port());
+    ASSERT_GE(fd, 0);
+    send_all(fd, "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Length: 5\r\n\r\nfirst"
+                 "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Length: 6\r\n\r\nsecond");
+    auto data = read_responses(fd, 2);
+    close(fd);
+
+    auto first = data.find("\r\n\r\nfirst");
+    auto second = data.find("\r\n\r\nsecond");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    EXPECT_LT(first, second);
+}
+
+TEST(EventLoopServerTest, DecodesChunkedRequestBodies) {
+    auto router = echo_router();
+    RunningServer running(router);
+
+    int fd = connect_raw(running.port());
+    ASSERT_GE(fd, 0);
+    send_all(fd, "POST /echo HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n"
+                 "5\r\nhello\r\n");
+    std::this_thread::sleep_for(50ms);
+    send_all(fd, "7\r\n, world\r\n0\r\n\r\n");
+    auto data = read_responses(fd, 1);
+    close(fd);
+
+    EXPECT_NE(data.find("HTTP/1.1 200 OK"), std::string::npos);
+    EXPECT_NE(data.find("\r\n\r\nhello, world"), std::string::npos);
+}
+
+TEST(EventLoopServerTest, RefusesOversizedBodies) {
+    auto router = echo_router();
+    EventLoopOptions options;
+    options.max_body_bytes = 16;
+    RunningServer running(router, options);
+
+    httplib::Client client("127.0.0.1", running.port());
+    auto res = with_connect_retry([&] { return client.Post("/echo", std::string(32, 'x'), "text/plain"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 413);
+}
+
+TEST(EventLoopServerTest, IdleConnectionsHoldNoThreads) {
+    auto router = echo_router();
+    EventLoopOptions options;
+    options.io_threads = 2;
+    options.pools.fill({1, 16});
+    RunningServer running(router, options);
+
+    httplib::Client client("127.0.0.1", running.port());
+    ASSERT_TRUE(with_connect_retry([&] { return client.Post("/echo", "warm", "text/plain"); }));
+    size_t threads_before = thread_count();
+
+    std::vector<int> idle;
+    for (int i = 0; i < 2000; ++i) {
+        int fd = connect_raw(running.port());
+        ASSERT_GE(fd, 0);
+        idle.push_back(fd);
+    }
+    for (int i = 0; i < 50 && running.server().stats().connections < idle.size(); ++i) {
+        std::this_thread::sleep_for(20ms);
+    }
+    EXPECT_GE(running.server().stats().connections, idle.size());
+    EXPECT_EQ(thread_count(), threads_before);
+
+    // One worker per class still answers promptly with 2000 connections parked
+    auto res = with_connect_retry([&] { return client.Post("/echo", "still serving", "text/plain"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->body, "still serving");
+
+    for (int fd : idle) {
+        close(fd);
+    }
+}
+
+TEST(EventLoopServerTest, RejectsWith503WhenTheWorkerQueueIsFull) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> entered{0};
+    HttpRouter router;
+    router.Get("/slow", [released, &entered](const httplib::Request&, httplib::Response& res) {
+        entered++;
+        released.wait();
+        res.set_content("done", "text/plain");
+    });
+    EventLoopOptions options;
+    options.pools[static_cast<size_t>(EndpointClass::Query)] = {1, 1};
+    RunningServer running(router, options);
+
+    std::vector<int> fds;
+    for (int i = 0; i < 3; ++i) {
+        int fd = connect_raw(running.port());
+        ASSERT_GE(fd, 0);
+        send_all(fd, "GET /slow HTTP/1.1\r\nHost: x\r\n\r\n");
+        fds.push_back(fd);
+        // The first request occupies the worker before the others queue
+        for (int wait = 0; i == 0 && wait < 100 && entered.load() == 0; ++wait) {
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+
+    for (int i = 0; i < 100 && running.server().stats().rejected == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(running.server().stats().rejected, 1u);
+    auto rejected = read_responses(fds[2], 1);
+    EXPECT_NE(rejected.find("HTTP/1.1 503"), std::string::npos);
+    EXPECT_NE(rejected.find("Retry-After: 1"), std::string::npos);
+
+    release.set_value();
+    EXPECT_NE(read_responses(fds[0], 1).find("\r\n\r\ndone"), std::string::npos);
+    EXPECT_NE(read_responses(fds[1], 1).find("\r\n\r\ndone"), std::string::npos);
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+TEST(EventLoopServerTest, QueryFloodCannotStarveTheControlPlane) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<int> entered{0};
+    HttpRouter router;
+    router.Get("/jobs/", [released, &entered](const httplib::Request&, httplib::Response& res) {
+        entered++;
+        released.wait();
+        res.set_content("[]", "application/json");
+    });
+    router.Post("/engines/heartbeat", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content("ok", "text/plain");
+    }, EndpointClass::Control);
+    auto pools = std::make_shared<EndpointPools>();
+    EventLoopOptions options;
+    options.pools[static_cast<size_t>(EndpointClass::Query)] = {2, 2};
+    RunningServer running(router, options, pools);
+
+    // Every query worker is stuck and the query queue is full
+    std::vector<int> scans;
+    for (int i = 0; i < 5; ++i) {
+        int fd = connect_raw(running.port());
+        ASSERT_GE(fd, 0);
+        send_all(fd, "GET /jobs/ HTTP/1.1\r\nHost: x\r\n\r\n");
+        scans.push_back(fd);
+        // The first two take both workers before the rest queue
+        if (i < 2) {
+            ASSERT_TRUE(eventually([&] { return entered.load() == i + 1; }));
+        }
+    }
+    for (int i = 0; i < 100 && running.server().stats().rejected == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(running.server().stats().rejected, 1u);
+
+    httplib::Client engine("127.0.0.1", running.port());
+    auto started = std::chrono::steady_clock::now();
+    auto heartbeat = with_connect_retry([&] { return engine.Post("/engines/heartbeat", "{}", "application/json"); });
+    ASSERT_TRUE(heartbeat);
+    EXPECT_EQ(heartbeat->status, 200);
+    EXPECT_LT(std::chrono::steady_clock::now() - started, 1s);
+
+    EXPECT_TRUE(eventually([&] { return pools->metrics()["control"]["served"] == 1; }));
+    auto metrics = pools->metrics();
+    EXPECT_EQ(metrics["query"]["active"], 2);
+    EXPECT_EQ(metrics["query"]["queued"], 2);
+    EXPECT_EQ(metrics["query"]["rejected"], 1);
+    EXPECT_EQ(metrics["control"]["rejected"], 0);
+
+    release.set_value();
+    for (int fd : scans) {
+        close(fd);
+    }
+}
+
+TEST(EventLoopServerTest, StreamsChunkedResponsesAndClosesAfterwards) {
+    HttpRouter router;
+    router.Get("/stream", [](const httplib::Request&, httplib::Response& res) {
+        auto sent = std::make_shared<int>(0);
+        res.set_chunked_content_provider("text/plain", [sent](size_t, httplib::DataSink& sink) {
+            if (*sent == 3) {
+                sink.done();
+                return true;
+            }
+            std::string chunk = "part" + std::to_string((*sent)++) + ";";
+            return sink.write(chunk.data(), chunk.size());
+        });
+    });
+    RunningServer running(router);
+
+    httplib::Client client("127.0.0.1", running.port());
+    auto res = with_connect_retry([&] { return client.Get("/stream"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 200);
+    EXPECT_EQ(res->body, "part0;part1;part2;");
+    EXPECT_EQ(res->get_header_value("Connection"), "close");
+}
+
+TEST(EventLoopServerTest, ClosesIdleKeepAliveConnections) {
+    auto router = echo_router();
+    EventLoopOptions options;
+    options.idle_timeout = 1s;
+    RunningServer running(router, options);
+
+    int fd = connect_raw(running.port());
+    ASSERT_GE(fd, 0);
+    char byte;
+    // The sweep runs once a second, so the close lands within about two seconds
+    EXPECT_EQ(recv(fd, &byte, 1, 0), 0);
+    close(fd);
+    EXPECT_EQ(running.server().stats().connections, 0u);
+}
+
+TEST(EventLoopServerTest, DrainFinishesInFlightRequestsAndClosesIdleConnections) {
+    auto router = echo_router();
+    std::promise<void> started;
+    router.Get("/slow", [&started](const httplib::Request&, httplib::Response& res) {
+        started.set_value();
+        std::this_thread::sleep_for(300ms);
+        res.set_content("done", "text/plain");
+    });
+    RunningServer running(router);
+
+    int idle = connect_raw(running.port());
+    ASSERT_GE(idle, 0);
+    send_all(idle, "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Length: 2\r\n\r\nhi");
+    ASSERT_NE(read_responses(idle, 1).find("\r\n\r\nhi"), std::string::npos);
+
+    int busy = connect_raw(running.port());
+    ASSERT_GE(busy, 0);
+    send_all(busy, "GET /slow HTTP/1.1\r\nHost: x\r\n\r\n");
+    ASSERT_EQ(started.get_future().wait_for(5s), std::future_status::ready);
+
+    auto drained = std::async(std::launch::async, [&running]() { running.server().drain(5s); });
+    char byte;
+    EXPECT_EQ(recv(idle, &byte, 1, 0), 0);
+
+    // The request in flight is answered, then its connection closes too
+    std::string response = read_responses(busy, 1);
+    EXPECT_NE(response.find("Connection: close"), std::string::npos);
+    EXPECT_NE(response.find("\r\n\r\ndone"), std::string::npos);
+    EXPECT_EQ(recv(busy, &byte, 1, 0), 0);
+    EXPECT_EQ(drained.wait_for(5s), std::future_status::ready);
+    close(idle);
+    close(busy);
+    EXPECT_EQ(running.server().stats().connections, 0u);
+}
+
+TEST(EventLoopServerTest, DispatchServerServesItsApiThroughTheEventLoop) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    DispatchServer server(job_repo, engine_repo, "test_key");
+    server.set_event_loop(EventLoopOptions{});
+    server.start(0, false);
+
+    httplib::Client client("127.0.0.1", server.get_port());
+    httplib::Headers headers = {{"X-API-Key", "test_key"}};
+    nlohmann::json job = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"}};
+    auto submit = with_connect_retry([&] {
+        return client.Post("/jobs/", headers, job.dump(), "application/json");
+    });
+    ASSERT_TRUE(submit);
+    ASSERT_EQ(submit->status, 200);
+    auto job_id = nlohmann::json::parse(submit->body)["job_id"].get<std::string>();
+
+    auto status = with_connect_retry([&] { return client.Get("/jobs/" + job_id, headers); });
+    ASSERT_TRUE(status);
+    EXPECT_EQ(status->status, 200);
+    EXPECT_EQ(nlohmann::json::parse(status->body)["status"], "pending");
+
+    auto unauthorized = with_connect_retry([&] { return client.Get("/jobs/" + job_id); });
+    ASSERT_TRUE(unauthorized);
+    EXPECT_EQ(unauthorized->status, 401);
+
+    nlohmann::json pools;
+    EXPECT_TRUE(eventually([&] {
+        auto stats = with_connect_retry([&] { return client.Get("/scheduler/stats", headers); });
+        pools = stats ? nlohmann::json::parse(stats->body)["endpoint_pools"] : nlohmann::json();
+        return pools["query"]["served"] >= 2;
+    }));
+    EXPECT_EQ(pools["submission"]["served"], 1);
+    EXPECT_EQ(pools["query"]["active"], 1); // This stats request
+    EXPECT_EQ(pools["control"]["served"], 0);
+    EXPECT_TRUE(pools["control"].contains("queue_ms"));
+    server.stop();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
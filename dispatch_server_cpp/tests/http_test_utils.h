@@ -0,0 +1,21 @@
+#ifndef DISPATCH_SERVER_HTTP_TEST_UTILS_H
+#define DISPATCH_SERVER_HTTP_TEST_UTILS_H
+
+#include "httplib.h"
+#include <chrono>
+#include <thread>
+
+// httplib resolves every new connection through getaddrinfo_a, which reports
+// EAI_ALLDONE when the lookup finishes before gai_suspend() is reached; retry
+// those spurious connection failures instead of failing the test.
+template <typename Request>
+inline httplib::Result with_connect_retry(Request request) {
+    auto result = request();
+    for (int attempt = 0; !result && result.error() == httplib::Error::Connection && attempt < 10; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        result = request();
+    }
+    return result;
+}
+
+#endif // DISPATCH_SERVER_HTTP_TEST_UTILS_H
@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../repositories.h"
+#include "../resource_packing.h"
+#include "../size_lanes.h"
+#include "../dispatch_server_constants.h"
+#include <memory>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+std::string job_id(int n) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08d-0000-0000-0000-000000000000", n);
+    return id;
+}
+
+} // namespace
+
+class JobBatchingTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    int next_job = 0;
+
+    void SetUp() override {
+        engine_repo->save_engine("engine-0", {{"engine_id", "engine-0"}, {"status", "idle"}});
+    }
+
+    std::string add_job(double size_mb, const std::string& codec = "vp9", int priority = 0) {
+        int n = next_job++;
+        nlohmann::json job = {{"job_id", job_id(n)}, {"status", "pending"}, {"priority", priority},
+                              {"job_size", size_mb}, {"target_codec", codec},
+                              {"size_class", size_class_name(classify_job_size(size_mb))}, {"created_at", n}};
+        job_repo->save_job(job_id(n), job);
+        return job_id(n);
+    }
+
+    httplib::Response poll(const nlohmann::json& body) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(JobBatchingTest, PacksSmallJobsOfTheSameCodec) {
+    std::string first = add_job(5);
+    add_job(5, "h264");
+    std::string second = add_job(8);
+    add_job(500); // Large jobs are never batched
+    std::string third = add_job(2);
+
+    auto res = poll({{"engine_id", "engine-0"}, {"max_batch", 8}});
+    ASSERT_EQ(res.status, 200);
+    auto batch = nlohmann::json::parse(res.body);
+    EXPECT_EQ(batch["type"], "batch");
+    EXPECT_EQ(batch["target_codec"], "vp9");
+    ASSERT_EQ(batch["jobs"].size(), 3u);
+    EXPECT_EQ(batch["jobs"][0]["job_id"], first);
+    EXPECT_EQ(batch["jobs"][1]["job_id"], second);
+    EXPECT_EQ(batch["jobs"][2]["job_id"], third);
+
+    for (const auto& id : {first, second, third}) {
+        auto job = job_repo->get_job(id);
+        EXPECT_EQ(job["status"], "assigned");
+        EXPECT_EQ(job["assigned_engine"], "engine-0");
+        EXPECT_EQ(job["batch_id"], batch["batch_id"]);
+    }
+    EXPECT_EQ(job_repo->get_pending_jobs(10).size(), 2u);
+}
+
+TEST_F(JobBatchingTest, BatchIsCappedByTheEngineAndTheServer) {
+    for (int i = 0; i < 40; ++i) add_job(1);
+
+    auto batch = nlohmann::json::parse(poll({{"engine_id", "engine-0"}, {"max_batch", 3}}).body);
+    EXPECT_EQ(batch["jobs"].size(), 3u);
+
+    batch = nlohmann::json::parse(poll({{"engine_id", "engine-0"}, {"max_batch", 1000}}).body);
+    EXPECT_EQ(batch["jobs"].size(), Constants::BATCH_MAX_ITEMS);
+}
+
+TEST_F(JobBatchingTest, EnginesWithoutMaxBatchGetSingleJobs) {
+    std::string first = add_job(5);
+    add_job(5);
+
+    auto job = nlohmann::json::parse(poll({{"engine_id", "engine-0"}}).body);
+    EXPECT_EQ(job["job_id"], first);
+    EXPECT_FALSE(job.contains("batch_id"));
+
+    // A medium job at the head is handed out alone even to batching engines
+    job_repo->clear_all_jobs();
+    std::string medium = add_job(60);
+    add_job(5);
+    job = nlohmann::json::parse(poll({{"engine_id", "engine-0"}, {"max_batch", 8}}).body);
+    EXPECT_EQ(job["job_id"], medium);
+    EXPECT_FALSE(job.contains("jobs"));
+}
+
+TEST_F(JobBatchingTest, RejectsInvalidMaxBatch) {
+    add_job(5);
+    EXPECT_EQ(poll({{"engine_id", "engine-0"}, {"max_batch", 0}}).status, 400);
+    EXPECT_EQ(poll({{"engine_id", "engine-0"}, {"max_batch", "4"}}).status, 400);
+}
+
+TEST_F(JobBatchingTest, BatchTakesOneSlotOfDeclaredCapacity) {
+    engine_repo->save_engine("engine-0", {{"engine_id", "engine-0"}, {"status", "idle"},
+                                          {"capacity", {{"slots", 2}}}});
+    for (int i = 0; i < 6; ++i) add_job(1);
+
+    auto batch = nlohmann::json::parse(poll({{"engine_id", "engine-0"}, {"max_batch", 4}}).body);
+    ASSERT_EQ(batch["jobs"].size(), 4u);
+
+    auto engine = engine_repo->get_engine("engine-0");
+    auto running = jobs_running_on(*job_repo, "engine-0");
+    EXPECT_EQ(running.size(), 4u);
+    EXPECT_DOUBLE_EQ(free_capacity(engine, running).slots, 1.0);
+
+    // The second slot takes the rest; then the engine is full
+    EXPECT_EQ(nlohmann::json::parse(poll({{"engine_id", "engine-0"}, {"max_batch", 4}}).body)["jobs"].size(), 2u);
+    add_job(1);
+    EXPECT_EQ(poll({{"engine_id", "engine-0"}, {"max_batch", 4}}).status, 204);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../job_events.h"
+#include "../repositories.h"
+#include "http_test_utils.h"
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<JobEvent> drain(JobEventBus& bus, const std::shared_ptr<JobEventBus::Subscriber>& subscriber) {
+    std::vector<JobEvent> events;
+    bus.next(subscriber, std::chrono::steady_clock::now() + 50ms, events);
+    return events;
+}
+
+} // namespace
+
+TEST(JobEventBusTest, FiltersByJobStatusAndTenant) {
+    JobEventBus bus(16, 16, 4);
+    JobEventFilter filter;
+    filter.statuses = {"completed"};
+    filter.tenant = "acme";
+    auto subscriber = bus.subscribe(filter);
+    ASSERT_TRUE(subscriber);
+
+    bus.publish("job", {{"job_id", "a"}, {"status", "completed"}, {"tenant", "other"}});
+    bus.publish("job", {{"job_id", "b"}, {"status", "pending"}, {"tenant", "acme"}});
+    bus.publish("job", {{"job_id", "c"}, {"status", "completed"}, {"tenant", "acme"}});
+
+    auto events = drain(bus, subscriber);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].data["job_id"], "c");
+    EXPECT_EQ(events[0].id, 3u);
+}
+
+TEST(JobEventBusTest, ResumesFromLastEventId) {
+    JobEventBus bus(2, 16, 4);
+    for (int i = 1; i <= 3; ++i) {
+        bus.publish("job", {{"job_id", "job-" + std::to_string(i)}, {"status", "pending"}});
+    }
+
+    // History keeps the newest two events; id 1 has aged out
+    auto subscriber = bus.subscribe({}, 1);
+    auto events = drain(bus, subscriber);
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].id, 2u);
+    EXPECT_EQ(events[1].id, 3u);
+}
+
+TEST(JobEventBusTest, DropsSubscriberThatFallsBehind) {
+    JobEventBus bus(16, 2, 4);
+    auto subscriber = bus.subscribe({});
+    for (int i = 0; i < 3; ++i) {
+        bus.publish("job", {{"job_id", "job"}, {"status", "pending"}});
+    }
+
+    std::vector<JobEvent> events;
+    EXPECT_FALSE(bus.next(subscriber, std::chrono::steady_clock::now() + 50ms, events));
+    EXPECT_TRUE(events.empty());
+}
+
+TEST(JobEventBusTest, RefusesSubscribersBeyondCapacity) {
+    JobEventBus bus(16, 16, 1);
+    auto first = bus.subscribe({});
+    EXPECT_TRUE(first);
+    EXPECT_FALSE(bus.subscribe({}));
+    bus.unsubscribe(first);
+    EXPECT_TRUE(bus.subscribe({}));
+}
+
+TEST(PublishingJobRepositoryTest, PublishesWritesAndProgress) {
+    auto events = std::make_shared<JobEventBus>(16, 16, 4);
+    PublishingJobRepository repo(std::make_shared<InMemoryJobRepository>(), events);
+    auto subscriber = events->subscribe({});
+
+    repo.save_job("job-1", {{"job_id", "job-1"}, {"status", "pending"}, {"source_url", "http://a/b"}});
+    repo.update_job_progress("job-1", 40, "encoding");
+    repo.get_job("job-1");
+
+    auto received = drain(*events, subscriber);
+    ASSERT_EQ(received.size(), 2u);
+    EXPECT_EQ(received[0].type, "job");
+    EXPECT_FALSE(received[0].data.contains("source_url"));
+    EXPECT_EQ(received[1].type, "progress");
+    EXPECT_EQ(received[1].data["progress"], 40);
+}
+
+TEST(JobEventStreamTest, StreamsSubmittedJobOverSse) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    DispatchServer server(job_repo, engine_repo, "test_key");
+    server.start(0, false);
+    std::this_thread::sleep_for(200ms);
+
+    httplib::Headers headers = {{"X-API-Key", "test_key"}};
+    auto streamed = std::async(std::launch::async, [&] {
+        httplib::Client client("127.0.0.1", server.get_port());
+        client.set_read_timeout(5, 0);
+        std::string body;
+        with_connect_retry([&] {
+            return client.Get("/events?status=pending&tenant=acme", headers,
+                              [&](const char* data, size_t length) {
+                                  body.append(data, length);
+                                  return body.find("event: job") == std::string::npos;
+                              });
+        });
+        return body;
+    });
+
+    std::this_thread::sleep_for(300ms);
+    httplib::Client submitter("127.0.0.1", server.get_port());
+    nlohmann::json job = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"}, {"tenant", "acme"}};
+    auto submit = with_connect_retry([&] {
+        return submitter.Post("/jobs/", headers, job.dump(), "application/json");
+    });
+    ASSERT_TRUE(submit);
+
+    ASSERT_EQ(streamed.wait_for(5s), std::future_status::ready);
+    std::string body = streamed.get();
+    EXPECT_NE(body.find("retry: "), std::string::npos);
+    EXPECT_NE(body.find("id: 1\nevent: job\ndata: "), std::string::npos);
+    EXPECT_NE(body.find(nlohmann::json::parse(submit->body)["job_id"].get<std::string>()), std::string::npos);
+    server.stop();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
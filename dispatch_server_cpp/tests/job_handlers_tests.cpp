@@ -8,7 +8,6 @@
 #include "assignment_handler.h"
 #include "assignment_handler.h"
 #include "repositories.h"
-#include <regex>
 
 using namespace distconv::DispatchServer;
 
@@ -16,14 +15,8 @@ using namespace distconv::DispatchServer;
 static httplib::Request make_request(const std::string& job_id) {
     httplib::Request req;
     req.path = "/jobs/" + job_id;
-    // Simulate regex match results - httplib populates this when using regex routes
-    // We need to manually set it for testing
-    std::smatch m;
-    std::string path = req.path;
-    std::regex pattern(R"(/jobs/(.+))");
-    if (std::regex_match(path, m, pattern)) {
-        req.matches = m;
-    }
+    // The router fills this from the route's {job_id:uuid} capture
+    req.path_params.emplace("job_id", job_id);
     return req;
 }
 
@@ -114,36 +107,17 @@ TEST(JobHandlersTest, JobCompletionValid) {
     JobCompletionHandler handler(auth);
     httplib::Response res;
     
-    // Create request with regex match
+    // Create request with the job_id capture
     httplib::Request req;
     req.path = "/jobs/" + job_id + "/complete";
-    req.matches = std::smatch(); // Mock matches
-    // We need to manually construct matches since we can't easily mock std::smatch with specific values
-    // In a real unit test we might need a better way, but for now we rely on the handler parsing req.matches[1]
-    // Actually, std::smatch is hard to mock. We might need to refactor handler to take job_id or use a different approach.
-    // However, for this test environment, we can rely on integration tests for path parsing, 
-    // OR we can try to populate matches if possible.
-    // Since we can't easily populate std::smatch, let's skip the unit test for handlers that rely heavily on regex matches
-    // and rely on integration tests for those specific parts, OR we can refactor the handler to be more testable.
-    // BUT, wait! I can use std::regex_match to populate it like in the helper function!
+    req.path_params.emplace("job_id", job_id);
 }
 
 // Helper to create a request with path match for completion
 static httplib::Request make_completion_request(const std::string& job_id) {
     httplib::Request req;
     req.path = "/jobs/" + job_id + "/complete";
-    std::smatch m;
-    std::string path = req.path;
-    std::regex pattern(R"(/jobs/([a-fA-F0-9\\-]{36})/complete)");
-    // Note: The regex in handler is R"(/jobs/([a-fA-F0-9\\-]{36})/complete)"
-    // We need to match that.
-    // Let's use a simpler regex for testing if the handler uses the one passed in server.
-    // Actually the handler doesn't know the regex, it just uses req.matches.
-    // So we can use any regex that produces matches.
-    std::regex test_pattern(R"(/jobs/(.+)/complete)");
-    if (std::regex_match(path, m, test_pattern)) {
-        req.matches = m;
-    }
+    req.path_params.emplace("job_id", job_id);
     return req;
 }
 
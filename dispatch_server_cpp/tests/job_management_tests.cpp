@@ -124,9 +124,8 @@ TEST_F(JobManagementTest, ManualRetry) {
     };
     
     httplib::Request req;
-    std::string path = "/jobs/job1/retry";
-    std::regex re(R"(/jobs/(.+)/retry)");
-    std::regex_match(path, req.matches, re);
+    req.path = "/jobs/job1/retry";
+    req.path_params.emplace("job_id", "job1");
     
     req.headers.emplace("X-API-Key", "test-key");
     httplib::Response res;
@@ -149,9 +148,8 @@ TEST_F(JobManagementTest, CancelJob) {
     };
     
     httplib::Request req;
-    std::string path = "/jobs/job1/cancel";
-    std::regex re(R"(/jobs/(.+)/cancel)");
-    std::regex_match(path, req.matches, re);
+    req.path = "/jobs/job1/cancel";
+    req.path_params.emplace("job_id", "job1");
     
     req.headers.emplace("X-API-Key", "test-key");
     httplib::Response res;
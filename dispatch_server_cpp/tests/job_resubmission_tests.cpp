@@ -101,7 +101,9 @@ TEST_F(ApiTest, FailedJobIsRequeued) {
     auto res_get_job = client->Get(("/jobs/" + job_id).c_str(), admin_headers);
     ASSERT_EQ(res_get_job->status, 200);
     nlohmann::json job_json = nlohmann::json::parse(res_get_job->body);
-    ASSERT_EQ(job_json["status"], "pending");
+    // Requeued by the background worker once the jittered retry_after passes
+    ASSERT_EQ(job_json["status"], "failed_retry");
+    ASSERT_TRUE(job_json.contains("retry_after"));
 }
 
 TEST_F(ApiTest, FailedJobBecomesPermanentlyFailed) {
@@ -144,6 +146,10 @@ TEST_F(ApiTest, FailedJobBecomesPermanentlyFailed) {
     auto res_fail = client->Post("/jobs/" + job_id + "/fail", admin_headers, fail_payload.dump(), "application/json");
     ASSERT_EQ(res_fail->status, 200);
 
+    // The one retry max_retries allows fails as well
+    res_fail = client->Post("/jobs/" + job_id + "/fail", admin_headers, fail_payload.dump(), "application/json");
+    ASSERT_EQ(res_fail->status, 200);
+
     // 5. Check the job's status
     auto res_get_job = client->Get(("/jobs/" + job_id).c_str(), admin_headers);
     ASSERT_EQ(res_get_job->status, 200);
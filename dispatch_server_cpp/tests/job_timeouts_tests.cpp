@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+#include "../job_timeouts.h"
+#include "../repositories.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+JobTimeoutPolicy test_policy() {
+    JobTimeoutPolicy policy;
+    policy.safety_factor = 3.0;
+    policy.min_timeout = 1000ms;
+    policy.max_timeout = 3600000ms;
+    policy.fallback = 1800000ms;
+    policy.progress_stall = 60000ms;
+    return policy;
+}
+
+// h264 history of 600 ms per MB
+std::shared_ptr<RuntimeEstimator> h264_history() {
+    auto estimator = std::make_shared<RuntimeEstimator>(1);
+    for (int i = 0; i < 3; ++i) {
+        estimator->record({{"target_codec", "h264"}, {"job_size", 100.0}}, 60000);
+    }
+    return estimator;
+}
+
+// 100 MB jobs at 10, 5 and 2.5 MB/s; the cluster median is 5 MB/s
+std::shared_ptr<EngineHealth> engine_history() {
+    auto health = std::make_shared<EngineHealth>();
+    health->record_success("engine-fast", {{"job_id", "a"}, {"job_size", 100.0}, {"assigned_at", 0}}, 10000);
+    health->record_success("engine-mid", {{"job_id", "b"}, {"job_size", 100.0}, {"assigned_at", 0}}, 20000);
+    health->record_success("engine-slow", {{"job_id", "c"}, {"job_size", 100.0}, {"assigned_at", 0}}, 40000);
+    return health;
+}
+
+nlohmann::json running_job(const std::string& engine_id, double size_mb, int64_t assigned_at) {
+    return {{"job_id", "job-1"}, {"status", "assigned"}, {"target_codec", "h264"}, {"job_size", size_mb},
+            {"assigned_engine", engine_id}, {"assigned_at", assigned_at}};
+}
+
+} // namespace
+
+TEST(JobTimeoutsTest, FallsBackWithoutHistory) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), std::make_shared<RuntimeEstimator>(1),
+                         std::make_shared<EngineHealth>(), test_policy());
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-0", 200.0, 0)), 1800000);
+}
+
+TEST(JobTimeoutsTest, ScalesPredictedRuntimeBySafetyFactorWithinBounds) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), h264_history(),
+                         std::make_shared<EngineHealth>(), test_policy());
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-0", 200.0, 0)), 360000); // 120 s predicted
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-0", 0.1, 0)), 1000);     // Clamped to the minimum
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-0", 5000.0, 0)), 3600000); // Clamped to the maximum
+}
+
+TEST(JobTimeoutsTest, SlowEnginesGetLongerTimeouts) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), h264_history(), engine_history(),
+                         test_policy());
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-mid", 200.0, 0)), 360000);
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-slow", 200.0, 0)), 720000);
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-fast", 200.0, 0)), 180000);
+}
+
+TEST(JobTimeoutsTest, UsesEngineThroughputWithoutCodecHistory) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), std::make_shared<RuntimeEstimator>(1),
+                         engine_history(), test_policy());
+    // 200 MB at 2.5 MB/s is 80 s
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-slow", 200.0, 0)), 240000);
+    EXPECT_EQ(timeouts.timeout_ms(running_job("engine-new", 200.0, 0)), 1800000);
+}
+
+TEST(JobTimeoutsTest, ExcludesSuspendedTimeFromRunTime) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), h264_history(),
+                         std::make_shared<EngineHealth>(), test_policy());
+    nlohmann::json job = running_job("engine-0", 200.0, 0);
+    EXPECT_EQ(timeouts.check(job, 360000), "");
+    EXPECT_EQ(timeouts.check(job, 360001), "timeout");
+
+    job["preemption"] = {{"suspended_ms", 100000}, {"resumed_at", 300000}};
+    EXPECT_EQ(timeouts.check(job, 400000), "");
+    EXPECT_EQ(timeouts.check(job, 460001), "timeout");
+}
+
+TEST(JobTimeoutsTest, FailsFastWhenProgressStops) {
+    JobTimeouts timeouts(std::make_shared<InMemoryJobRepository>(), std::make_shared<RuntimeEstimator>(1),
+                         std::make_shared<EngineHealth>(), test_policy());
+    nlohmann::json job = running_job("engine-0", 200.0, 1000);
+    EXPECT_EQ(timeouts.check(job, 200000), ""); // No report yet: only the run-time limit applies
+
+    job["progress_at"] = 50000;
+    EXPECT_EQ(timeouts.check(job, 110000), "");
+    EXPECT_EQ(timeouts.check(job, 110001), "stalled");
+
+    // A report from before this assignment does not arm the rule
+    job["assigned_at"] = 100000;
+    EXPECT_EQ(timeouts.check(job, 200000), "");
+}
+
+TEST(JobTimeoutsTest, ExpiredListsRunningJobsPastTheirAllowance) {
+    auto repo = std::make_shared<InMemoryJobRepository>();
+    JobTimeouts timeouts(repo, std::make_shared<RuntimeEstimator>(1), std::make_shared<EngineHealth>(), test_policy());
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    nlohmann::json overdue = running_job("engine-0", 10.0, now_ms - 1800001);
+    overdue["job_id"] = "overdue";
+    repo->save_job("overdue", overdue);
+
+    nlohmann::json fresh = running_job("engine-1", 10.0, now_ms - 1000);
+    fresh["job_id"] = "fresh";
+    fresh["status"] = "processing";
+    repo->save_job("fresh", fresh);
+
+    nlohmann::json pending = running_job("", 10.0, now_ms - 1800001);
+    pending["job_id"] = "pending";
+    pending["status"] = "pending";
+    repo->save_job("pending", pending);
+
+    auto expired = timeouts.expired(now_ms);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].first["job_id"], "overdue");
+    EXPECT_EQ(expired[0].second, "timeout");
+
+    repo->update_job_progress("fresh", 10, "");
+    EXPECT_TRUE(timeouts.expired(now_ms + 1000).size() == 1u);
+    EXPECT_EQ(timeouts.expired(now_ms + 70000).size(), 2u); // fresh stalled after its report
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,263 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../job_tracing.h"
+#include "../metrics.h"
+#include "../repositories.h"
+#include "http_test_utils.h"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const std::string TRACE_ID = "4bf92f3577b34da6a3ce929d0e0e4736";
+const std::string PARENT_ID = "00f067aa0ba902b7";
+
+// Spans of every export request in an OTLP JSON lines file
+std::vector<nlohmann::json> read_spans(const std::string& path) {
+    std::vector<nlohmann::json> spans;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        nlohmann::json request = nlohmann::json::parse(line);
+        for (const auto& resource : request["resourceSpans"]) {
+            for (const auto& scope : resource["scopeSpans"]) {
+                for (const auto& span : scope["spans"]) spans.push_back(span);
+            }
+        }
+    }
+    return spans;
+}
+
+std::map<std::string, nlohmann::json> by_name(const std::vector<nlohmann::json>& spans) {
+    std::map<std::string, nlohmann::json> named;
+    for (const auto& span : spans) named[span["name"]] = span;
+    return named;
+}
+
+nlohmann::json phase_report(int64_t download, int64_t transcode, int64_t upload, int64_t end) {
+    return {{"phases", {{"download", {{"start_ms", download}, {"end_ms", transcode}}},
+                        {"transcode", {{"start_ms", transcode}, {"end_ms", upload}}},
+                        {"upload", {{"start_ms", upload}, {"end_ms", end}}}}}};
+}
+
+uint64_t phase_count(MetricsRegistry& registry, const std::string& phase) {
+    return registry.histogram("dispatch_job_phase_seconds", "", phase_buckets(), {{"phase", phase}}).snapshot().count;
+}
+
+} // namespace
+
+TEST(JobTracingTest, ContinuesAValidTraceparent) {
+    std::string trace_id;
+    std::string parent;
+    EXPECT_TRUE(parse_traceparent("00-" + TRACE_ID + "-" + PARENT_ID + "-01", trace_id, parent));
+    EXPECT_EQ(trace_id, TRACE_ID);
+    EXPECT_EQ(parent, PARENT_ID);
+    // A later version may carry more fields
+    EXPECT_TRUE(parse_traceparent("01-" + TRACE_ID + "-" + PARENT_ID + "-00-extra", trace_id, parent));
+
+    for (const std::string& bad : {std::string(""), "00-" + TRACE_ID + "-" + PARENT_ID + "-01-extra",
+                                   "ff-" + TRACE_ID + "-" + PARENT_ID + "-01",
+                                   "00-" + std::string(32, '0') + "-" + PARENT_ID + "-01",
+                                   "00-" + TRACE_ID + "-" + std::string(16, '0') + "-01",
+                                   "00-4BF92F3577B34DA6A3CE929D0E0E4736-" + PARENT_ID + "-01"}) {
+        EXPECT_FALSE(parse_traceparent(bad, trace_id, parent)) << bad;
+    }
+
+    nlohmann::json continued = {{"trace", start_job_trace("00-" + TRACE_ID + "-" + PARENT_ID + "-01")}};
+    EXPECT_EQ(continued["trace"]["trace_id"], TRACE_ID);
+    EXPECT_EQ(continued["trace"]["parent_span_id"], PARENT_ID);
+    EXPECT_EQ(job_traceparent(continued), "00-" + TRACE_ID + "-" + continued["trace"]["span_id"].get<std::string>() + "-01");
+
+    nlohmann::json fresh = {{"trace", start_job_trace("garbage")}};
+    EXPECT_EQ(fresh["trace"]["trace_id"].get<std::string>().size(), 32u);
+    EXPECT_EQ(fresh["trace"]["span_id"].get<std::string>().size(), 16u);
+    EXPECT_FALSE(fresh["trace"].contains("parent_span_id"));
+    EXPECT_TRUE(parse_traceparent(job_traceparent(fresh), trace_id, parent));
+    EXPECT_EQ(job_traceparent(nlohmann::json::object()), "");
+}
+
+TEST(JobTracingTest, SplitsAttemptsIntoPhasesAndExportsSpans) {
+    const std::string path = "job_tracing_test_spans.jsonl";
+    std::filesystem::remove(path);
+    auto registry = std::make_shared<MetricsRegistry>();
+    JobTracer tracer(registry);
+    auto exporter = std::make_shared<SpanExporter>(TraceExportOptions{path, ""}, registry);
+    tracer.set_exporter(exporter);
+
+    nlohmann::json job = {{"job_id", "job-1"}, {"created_at", 1000}, {"assigned_at", 5000},
+                          {"assigned_engine", "engine-1"}, {"status", "failed_retry"},
+                          {"error_message", "Failed to download source video"},
+                          {"trace", start_job_trace("00-" + TRACE_ID + "-" + PARENT_ID + "-01")}};
+    std::string root = job["trace"]["span_id"];
+
+    // First attempt fails downloading and is scheduled for a retry
+    nlohmann::json failed = {{"phases", {{"download", {{"start_ms", 5200}, {"end_ms", 5900}}}}}};
+    tracer.end_attempt(job, failed, 6000, "download");
+    EXPECT_EQ(job["trace"]["queued_since"], 6000);
+
+    // The retry runs on the next assignment; the engine's clock runs a little behind
+    job["assigned_at"] = 8000;
+    job["status"] = "completed";
+    tracer.end_attempt(job, phase_report(7990, 8500, 12000, 12500), 12600);
+    EXPECT_FALSE(job["trace"].contains("queued_since"));
+    EXPECT_EQ(job["trace"]["attempts"], 2);
+
+    std::vector<std::tuple<std::string, int, int64_t, int64_t>> expected = {
+        {"queued", 1, 1000, 5000}, {"assignment", 1, 5000, 5200}, {"download", 1, 5200, 5900},
+        {"report", 1, 5900, 6000}, {"queued", 2, 6000, 8000}, {"assignment", 2, 8000, 8000},
+        {"download", 2, 7990, 8500}, {"transcode", 2, 8500, 12000}, {"upload", 2, 12000, 12500},
+        {"report", 2, 12500, 12600}};
+    const auto& phases = job["trace"]["phases"];
+    ASSERT_EQ(phases.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(phases[i]["name"], std::get<0>(expected[i]));
+        EXPECT_EQ(phases[i]["attempt"], std::get<1>(expected[i]));
+        EXPECT_EQ(phases[i]["start_ms"], std::get<2>(expected[i]));
+        EXPECT_EQ(phases[i]["end_ms"], std::get<3>(expected[i]));
+    }
+    EXPECT_EQ(phase_count(*registry, "queued"), 2u);
+    EXPECT_EQ(phase_count(*registry, "transcode"), 1u);
+    EXPECT_NEAR(registry->histogram("dispatch_job_phase_seconds", "", phase_buckets(), {{"phase", "transcode"}})
+                    .snapshot().sum, 3.5, 1e-6);
+
+    exporter->flush();
+    auto spans = read_spans(path);
+    ASSERT_EQ(spans.size(), expected.size() + 1);
+    size_t errors = 0;
+    for (const auto& span : spans) {
+        EXPECT_EQ(span["traceId"], TRACE_ID);
+        EXPECT_EQ(span["kind"], 1);
+        if (span["name"] == "job") continue;
+        EXPECT_EQ(span["parentSpanId"], root);
+        EXPECT_NE(span["spanId"], root);
+        errors += span["status"]["code"] == 2;
+    }
+    EXPECT_EQ(errors, 1u);
+    auto named = by_name(spans);
+    EXPECT_EQ(named["job"]["spanId"], root);
+    EXPECT_EQ(named["job"]["parentSpanId"], PARENT_ID);
+    EXPECT_EQ(named["job"]["startTimeUnixNano"], "1000000000");
+    EXPECT_EQ(named["job"]["endTimeUnixNano"], "12600000000");
+    EXPECT_EQ(named["job"]["status"]["code"], 1);
+    EXPECT_EQ(named["transcode"]["startTimeUnixNano"], "8500000000");
+    std::filesystem::remove(path);
+}
+
+TEST(JobTracingTest, PostsToACollector) {
+    std::mutex mutex;
+    std::vector<nlohmann::json> received;
+    httplib::Server collector;
+    collector.Post("/v1/traces", [&](const httplib::Request& req, httplib::Response& res) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(nlohmann::json::parse(req.body));
+        res.set_content("{}", "application/json");
+    });
+    int port = collector.bind_to_any_port("127.0.0.1");
+    std::thread collector_thread([&]() { collector.listen_after_bind(); });
+    collector.wait_until_ready();
+
+    {
+        auto exporter = std::make_shared<SpanExporter>(TraceExportOptions{"", "http://127.0.0.1:" + std::to_string(port)});
+        JobTracer tracer;
+        tracer.set_exporter(exporter);
+        nlohmann::json job = {{"job_id", "job-2"}, {"created_at", 1000}, {"assigned_at", 2000},
+                              {"status", "completed"}, {"trace", start_job_trace("")}};
+        tracer.end_attempt(job, nlohmann::json::object(), 4000);
+        exporter->flush();
+    }
+
+    collector.stop();
+    collector_thread.join();
+    ASSERT_EQ(received.size(), 1u);
+    const auto& resource = received[0]["resourceSpans"][0];
+    EXPECT_EQ(resource["resource"]["attributes"][0]["value"]["stringValue"], "distconv-dispatcher");
+    // Without engine phases the attempt is queued, then one "engine" phase
+    auto named = by_name(resource["scopeSpans"][0]["spans"].get<std::vector<nlohmann::json>>());
+    EXPECT_EQ(named.size(), 3u);
+    EXPECT_EQ(named["engine"]["endTimeUnixNano"], "4000000000");
+    EXPECT_FALSE(named["job"].contains("parentSpanId"));
+}
+
+TEST(JobTracingTest, DispatchServerTracesAJobFromSubmissionToCompletion) {
+    const std::string path = "job_tracing_server_spans.jsonl";
+    std::filesystem::remove(path);
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    {
+        DispatchServer server(job_repo, engine_repo, "test_key");
+        server.set_trace_export({path, ""});
+        server.start(0, false);
+
+        httplib::Client client("127.0.0.1", server.get_port());
+        httplib::Headers auth = {{"X-API-Key", "test_key"}};
+        httplib::Headers traced = {{"X-API-Key", "test_key"}, {"traceparent", "00-" + TRACE_ID + "-" + PARENT_ID + "-01"}};
+        auto submitted = with_connect_retry([&] {
+            return client.Post("/jobs/", traced, R"({"source_url":"http://example.com/a.mp4","target_codec":"h264"})",
+                               "application/json");
+        });
+        ASSERT_TRUE(submitted);
+        ASSERT_EQ(submitted->status, 200);
+        auto job = nlohmann::json::parse(submitted->body);
+        EXPECT_EQ(job["trace"]["trace_id"], TRACE_ID);
+        EXPECT_EQ(submitted->get_header_value("traceparent"), job_traceparent(job));
+        std::string job_id = job["job_id"];
+
+        with_connect_retry([&] {
+            return client.Post("/engines/heartbeat", auth,
+                               R"({"engine_id":"engine-1","hostname":"host","status":"idle","storage_capacity_gb":100})",
+                               "application/json");
+        });
+        auto assigned = with_connect_retry([&] {
+            return client.Post("/assign_job/", auth, R"({"engine_id":"engine-1"})", "application/json");
+        });
+        ASSERT_TRUE(assigned);
+        ASSERT_EQ(assigned->status, 200);
+        auto assignment = nlohmann::json::parse(assigned->body);
+        // The engine continues the trace from the assignment
+        EXPECT_EQ(job_traceparent(assignment), job_traceparent(job));
+
+        int64_t at = assignment["assigned_at"];
+        nlohmann::json report = phase_report(at + 1, at + 2, at + 3, at + 4);
+        report["engine_id"] = "engine-1";
+        report["output_url"] = "http://example.com/out.mp4";
+        auto completed = with_connect_retry([&] {
+            return client.Post("/jobs/" + job_id + "/complete", auth, report.dump(), "application/json");
+        });
+        ASSERT_TRUE(completed);
+        ASSERT_EQ(completed->status, 200);
+
+        auto status = with_connect_retry([&] { return client.Get("/jobs/" + job_id, auth); });
+        ASSERT_TRUE(status);
+        auto stored = nlohmann::json::parse(status->body);
+        ASSERT_EQ(stored["trace"]["phases"].size(), 6u);
+        EXPECT_EQ(stored["trace"]["phases"][3]["name"], "transcode");
+
+        auto metrics = with_connect_retry([&] { return client.Get("/metrics"); });
+        ASSERT_TRUE(metrics);
+        EXPECT_NE(metrics->body.find("dispatch_job_phase_seconds_count{phase=\"upload\"}"), std::string::npos);
+        server.stop();
+    }
+
+    // Destroying the server flushes its exporter
+    auto named = by_name(read_spans(path));
+    EXPECT_EQ(named.size(), 7u);
+    EXPECT_EQ(named["job"]["traceId"], TRACE_ID);
+    EXPECT_EQ(named["job"]["parentSpanId"], PARENT_ID);
+    std::filesystem::remove(path);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -184,10 +184,6 @@ void run_concurrent_benchmark(int num_job_threads, int job_requests_per_thread,
 }
 
 int main() {
-    // Disable I/O to focus on Mutex Contention
-    mock_save_state_enabled = true;
-    mock_load_state_enabled = true;
-
     // Start Server
     server = new DispatchServer();
     server->set_api_key(api_key);
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_waiters.h"
+#include "../dispatch_server_core.h"
+#include "../repositories.h"
+#include "http_test_utils.h"
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+TEST(AssignmentWaiterRegistryTest, WakesOnlyOneMatchingWaiter) {
+    AssignmentWaiterRegistry registry(4);
+    auto vp9_waiter = registry.register_waiter({"vp9"});
+    auto h264_first = registry.register_waiter({"h264"});
+    auto h264_second = registry.register_waiter({"h264", "h265"});
+    ASSERT_TRUE(vp9_waiter && h264_first && h264_second);
+
+    nlohmann::json job = {{"job_id", "job-1"}, {"target_codec", "h264"}};
+    EXPECT_TRUE(registry.notify_job_available(job));
+
+    auto deadline = std::chrono::steady_clock::now() + 50ms;
+    EXPECT_TRUE(registry.wait(h264_first, deadline));
+    EXPECT_FALSE(registry.wait(h264_second, deadline));
+    EXPECT_FALSE(registry.wait(vp9_waiter, deadline));
+}
+
+TEST(AssignmentWaiterRegistryTest, RefusesWaitersBeyondCapacity) {
+    AssignmentWaiterRegistry registry(2);
+    auto first = registry.register_waiter({});
+    auto second = registry.register_waiter({});
+    EXPECT_TRUE(first);
+    EXPECT_TRUE(second);
+    EXPECT_FALSE(registry.register_waiter({}));
+
+    registry.unregister_waiter(first);
+    EXPECT_TRUE(registry.register_waiter({}));
+    EXPECT_EQ(registry.waiter_count(), 2u);
+}
+
+TEST(AssignmentWaiterRegistryTest, CloseReleasesParkedWaiters) {
+    AssignmentWaiterRegistry registry(1);
+    auto waiter = registry.register_waiter({});
+    auto parked = std::async(std::launch::async, [&] {
+        return registry.wait(waiter, std::chrono::steady_clock::now() + 10s);
+    });
+    std::this_thread::sleep_for(50ms);
+    registry.close();
+    ASSERT_EQ(parked.wait_for(2s), std::future_status::ready);
+    EXPECT_FALSE(parked.get());
+    EXPECT_FALSE(registry.register_waiter({}));
+}
+
+TEST(LongPollWaitParsingTest, AcceptsUnitsAndClamps) {
+    EXPECT_EQ(parse_long_poll_wait("30s", 60s), 30s);
+    EXPECT_EQ(parse_long_poll_wait("30", 60s), 30s);
+    EXPECT_EQ(parse_long_poll_wait("250ms", 60s), 250ms);
+    EXPECT_EQ(parse_long_poll_wait("5m", 60s), 60s);
+    EXPECT_EQ(parse_long_poll_wait("abc", 60s), 0ms);
+    EXPECT_EQ(parse_long_poll_wait("10h", 60s), 0ms);
+}
+
+class LongPollAssignmentTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo;
+    std::shared_ptr<InMemoryEngineRepository> engine_repo;
+    std::unique_ptr<DispatchServer> server;
+    std::unique_ptr<httplib::Client> client;
+    httplib::Headers headers = {{"X-API-Key", "test_key"}};
+
+    void SetUp() override {
+        job_repo = std::make_shared<InMemoryJobRepository>();
+        engine_repo = std::make_shared<InMemoryEngineRepository>();
+        engine_repo->save_engine("engine-1", {{"engine_id", "engine-1"}, {"status", "idle"}});
+
+        server = std::make_unique<DispatchServer>(job_repo, engine_repo, "test_key");
+        server->start(0, false);
+        std::this_thread::sleep_for(200ms);
+        client = std::make_unique<httplib::Client>("127.0.0.1", server->get_port());
+        client->set_read_timeout(10, 0);
+    }
+
+    void TearDown() override {
+        if (server) server->stop();
+    }
+
+    httplib::Result long_poll(const std::string& wait) {
+        nlohmann::json body = {{"engine_id", "engine-1"}, {"capabilities", {"h264"}}};
+        return with_connect_retry([&] {
+            return client->Post("/assign_job/?wait=" + wait, headers, body.dump(), "application/json");
+        });
+    }
+};
+
+TEST_F(LongPollAssignmentTest, SubmissionWakesParkedEngine) {
+    auto started = std::chrono::steady_clock::now();
+    auto parked = std::async(std::launch::async, [this] { return long_poll("5s"); });
+
+    std::this_thread::sleep_for(200ms);
+    httplib::Client submitter("127.0.0.1", server->get_port());
+    nlohmann::json job = {{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"}};
+    auto submit = with_connect_retry([&] {
+        return submitter.Post("/jobs/", headers, job.dump(), "application/json");
+    });
+    ASSERT_TRUE(submit);
+    ASSERT_EQ(submit->status, 200);
+
+    auto res = parked.get();
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    ASSERT_TRUE(res);
+    ASSERT_EQ(res->status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res->body)["assigned_engine"], "engine-1");
+    EXPECT_LT(elapsed, 3s);
+}
+
+TEST_F(LongPollAssignmentTest, ReturnsNoContentAfterWaitExpires) {
+    auto started = std::chrono::steady_clock::now();
+    auto res = long_poll("300ms");
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 204);
+    EXPECT_GE(elapsed, 300ms);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,230 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../http_router.h"
+#include "../memory_message_queue.h"
+#include "../metrics.h"
+#include "../repositories.h"
+#include "../status_subscriber.h"
+#include "http_test_utils.h"
+#include <sqlite3.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+uint64_t sqlite_waits(const char* name, const std::string& label, const std::string& value) {
+    return default_metrics_registry()->histogram(name, "", wait_buckets(), {{label, value}}).snapshot().count;
+}
+
+} // namespace
+
+TEST(MetricsTest, CountersAndHistogramsSumEveryThreadsShard) {
+    Counter counter;
+    Histogram histogram({0.001, 0.01, 0.1});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; ++i) {
+                counter.inc();
+                histogram.observe(0.005);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(counter.value(), 80000u);
+
+    // Bounds are inclusive; anything past the last lands in +Inf
+    histogram.observe(0.001);
+    histogram.observe(std::chrono::milliseconds(250));
+    auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.buckets, (std::vector<uint64_t>{1, 80000, 0, 1}));
+    EXPECT_EQ(snapshot.count, 80002u);
+    EXPECT_NEAR(snapshot.sum, 80000 * 0.005 + 0.251, 1e-6);
+}
+
+TEST(MetricsTest, RendersPrometheusTextFormat) {
+    MetricsRegistry registry;
+    registry.counter("requests_total", "Requests", {{"path", "/a\"b\\"}}).inc(3);
+    registry.gauge("temperature", "Line one\nline two").set(21.5);
+    auto& histogram = registry.histogram("latency_seconds", "Latency", {0.1, 1}, {{"route", "/x"}});
+    histogram.observe(0.05);
+    histogram.observe(0.5);
+    histogram.observe(5);
+    uint64_t collector = registry.add_collector("queue_depth", "Queue depth", []() {
+        return std::vector<MetricsRegistry::Sample>{{{{"status", "pending"}}, 7}};
+    });
+    uint64_t dropped = registry.add_counter_collector("records_dropped_total", "Dropped records", []() {
+        return std::vector<MetricsRegistry::Sample>{{{}, 12}};
+    });
+
+    EXPECT_EQ(registry.render(),
+              "# HELP latency_seconds Latency\n"
+              "# TYPE latency_seconds histogram\n"
+              "latency_seconds_bucket{route=\"/x\",le=\"0.1\"} 1\n"
+              "latency_seconds_bucket{route=\"/x\",le=\"1\"} 2\n"
+              "latency_seconds_bucket{route=\"/x\",le=\"+Inf\"} 3\n"
+              "latency_seconds_sum{route=\"/x\"} 5.55\n"
+              "latency_seconds_count{route=\"/x\"} 3\n"
+              "# HELP queue_depth Queue depth\n"
+              "# TYPE queue_depth gauge\n"
+              "queue_depth{status=\"pending\"} 7\n"
+              "# HELP records_dropped_total Dropped records\n"
+              "# TYPE records_dropped_total counter\n"
+              "records_dropped_total 12\n"
+              "# HELP requests_total Requests\n"
+              "# TYPE requests_total counter\n"
+              "requests_total{path=\"/a\\\"b\\\\\"} 3\n"
+              "# HELP temperature Line one\\nline two\n"
+              "# TYPE temperature gauge\n"
+              "temperature 21.5\n");
+
+    // Lookups hand back the same series; a name keeps its type
+    EXPECT_EQ(&registry.counter("requests_total", "Requests", {{"path", "/a\"b\\"}}),
+              &registry.counter("requests_total", "Requests", {{"path", "/a\"b\\"}}));
+    EXPECT_THROW(registry.gauge("requests_total", "Requests"), std::logic_error);
+
+    registry.remove_collector(collector);
+    registry.remove_collector(dropped);
+    EXPECT_FALSE(contains(registry.render(), "queue_depth"));
+}
+
+TEST(MetricsTest, RouterTimesHandlersAndCountsStatusCodes) {
+    auto registry = std::make_shared<MetricsRegistry>();
+    HttpRouter router(nullptr, registry);
+    router.Get("/jobs/{job_id:uuid}", [](const httplib::Request& req, httplib::Response& res) {
+        if (req.path_params.at("job_id")[0] == '0') res.status = 404;
+    });
+
+    for (const char* id : {"00000000-0000-0000-0000-000000000000", "10000000-0000-0000-0000-000000000000",
+                           "20000000-0000-0000-0000-000000000000"}) {
+        httplib::Request req;
+        req.method = "GET";
+        req.path = std::string("/jobs/") + id;
+        httplib::Response res;
+        ASSERT_TRUE(router.route(req, res));
+    }
+
+    MetricLabels labels{{"method", "GET"}, {"route", "/jobs/{job_id:uuid}"}};
+    auto code = [&](const char* value) {
+        MetricLabels with_code = labels;
+        with_code.emplace_back("code", value);
+        return registry->counter("dispatch_http_responses_total", "", with_code).value();
+    };
+    EXPECT_EQ(code("200"), 2u);
+    EXPECT_EQ(code("404"), 1u);
+    EXPECT_EQ(registry->histogram("dispatch_http_request_duration_seconds", "", latency_buckets(), labels)
+                  .snapshot().count, 3u);
+}
+
+TEST(MetricsTest, SqliteRepositoryRecordsBusyAndLockWaits) {
+    const std::string db_path = "metrics_test_jobs.db";
+    std::filesystem::remove(db_path);
+    {
+        SqliteJobRepository repo(db_path);
+        uint64_t busy_before = sqlite_waits("dispatch_sqlite_busy_wait_seconds", "database", "jobs");
+        uint64_t lock_before = sqlite_waits("dispatch_repository_lock_wait_seconds", "repository", "jobs");
+
+        // Another connection holds the write lock, so the save backs off
+        // while holding the repository mutex, and a read queues behind it
+        sqlite3* other = nullptr;
+        ASSERT_EQ(sqlite3_open(db_path.c_str(), &other), SQLITE_OK);
+        ASSERT_EQ(sqlite3_exec(other, "BEGIN EXCLUSIVE", nullptr, nullptr, nullptr), SQLITE_OK);
+
+        std::thread writer([&]() { repo.save_job("job-1", {{"job_id", "job-1"}, {"status", "pending"}}); });
+        for (int i = 0; i < 200 && sqlite_waits("dispatch_sqlite_busy_wait_seconds", "database", "jobs") == busy_before;
+             ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::thread reader([&]() { repo.job_exists("job-1"); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        sqlite3_exec(other, "COMMIT", nullptr, nullptr, nullptr);
+        sqlite3_close(other);
+        writer.join();
+        reader.join();
+
+        EXPECT_TRUE(repo.job_exists("job-1"));
+        EXPECT_GT(sqlite_waits("dispatch_sqlite_busy_wait_seconds", "database", "jobs"), busy_before);
+        EXPECT_GT(sqlite_waits("dispatch_repository_lock_wait_seconds", "repository", "jobs"), lock_before);
+    }
+    std::filesystem::remove(db_path);
+}
+
+TEST(MetricsTest, StatusSubscriberReportsQueueLag) {
+    distconv::MemoryMessageQueueFactory factory;
+    auto producer = factory.createProducer();
+    producer->publish("status", R"({"job_id":"job-1","status":"completed"})");
+
+    distconv::StatusSubscriber subscriber(factory.createConsumer("group"));
+    std::vector<std::chrono::milliseconds> lags;
+    subscriber.setLagObserver([&lags](std::chrono::milliseconds lag) { lags.push_back(lag); });
+    int updates = 0;
+    subscriber.subscribeToStatusUpdates([&updates](const std::string&) { ++updates; });
+
+    EXPECT_EQ(updates, 1);
+    ASSERT_EQ(lags.size(), 1u);
+    EXPECT_GE(lags[0].count(), 0);
+    EXPECT_LT(lags[0].count(), 5000);
+}
+
+TEST(MetricsTest, DispatchServerServesMetricsWithoutAuthentication) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    DispatchServer server(job_repo, engine_repo, "test_key");
+    server.start(0, false);
+
+    httplib::Client client("127.0.0.1", server.get_port());
+    httplib::Headers auth = {{"X-API-Key", "test_key"}};
+    auto submitted = with_connect_retry([&] {
+        return client.Post("/jobs/", auth, R"({"source_url":"http://example.com/a.mp4","target_codec":"h264","job_size":10})",
+                           "application/json");
+    });
+    ASSERT_TRUE(submitted);
+    ASSERT_EQ(submitted->status, 200);
+    with_connect_retry([&] {
+        return client.Post("/jobs/", auth, R"({"source_url":"http://example.com/b.mp4","target_codec":"h264","job_size":10})",
+                           "application/json");
+    });
+    with_connect_retry([&] {
+        return client.Post("/engines/heartbeat", auth,
+                           R"({"engine_id":"engine-1","hostname":"host","status":"idle","storage_capacity_gb":100})",
+                           "application/json");
+    });
+    auto assigned = with_connect_retry([&] {
+        return client.Post("/assign_job/", auth, R"({"engine_id":"engine-1"})", "application/json");
+    });
+    ASSERT_TRUE(assigned);
+    ASSERT_EQ(assigned->status, 200);
+
+    auto res = with_connect_retry([&] { return client.Get("/metrics"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 200);
+    EXPECT_EQ(res->get_header_value("Content-Type"), METRICS_CONTENT_TYPE);
+    const std::string& body = res->body;
+    EXPECT_TRUE(contains(body, "dispatch_jobs{status=\"pending\"} 1\n"));
+    EXPECT_TRUE(contains(body, "dispatch_jobs{status=\"assigned\"} 1\n"));
+    EXPECT_TRUE(contains(body, "dispatch_http_responses_total{method=\"POST\",route=\"/jobs/\",code=\"200\"}"));
+    EXPECT_TRUE(contains(body, "dispatch_http_request_duration_seconds_count{method=\"POST\",route=\"/assign_job/\"}"));
+    EXPECT_TRUE(contains(body, "dispatch_repository_operation_seconds_count{repository=\"jobs\",operation=\"save_job\"}"));
+    EXPECT_TRUE(contains(body, "dispatch_assignment_seconds_count"));
+    EXPECT_TRUE(contains(body, "dispatch_job_queue_wait_seconds_count"));
+    EXPECT_TRUE(contains(body, "# TYPE dispatch_log_records_dropped_total counter\ndispatch_log_records_dropped_total "));
+    server.stop();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,196 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../engine_channel_handler.h"
+#include "../engine_handlers.h"
+#include "../job_action_handlers.h"
+#include "../preemption.h"
+#include "../repositories.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+const std::string kUrgent = "77777777-7777-7777-7777-777777777777";
+const std::string kNormal = "88888888-8888-8888-8888-888888888888";
+const std::string kHigh = "99999999-9999-9999-9999-999999999999";
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+class PreemptionTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::shared_ptr<PreemptionCoordinator> preemption =
+        std::make_shared<PreemptionCoordinator>(job_repo, engine_repo, 10s, 1min);
+
+    void SetUp() override {
+        int64_t now = now_ms();
+        add_engine("engine-normal", true);
+        add_engine("engine-high", true);
+        add_engine("engine-pinned", false);
+        add_running_job(kNormal, "engine-normal", 0, now - 60000);
+        add_running_job(kHigh, "engine-high", 1, now - 1000);
+        add_running_job("aaaaaaaa-aaaa-aaaa-aaaa-aaaaaaaaaaaa", "engine-pinned", 0, now - 500);
+        job_repo->save_job(kUrgent, {{"job_id", kUrgent}, {"status", "pending"}, {"priority", 2},
+                                     {"created_at", now - 20000}});
+    }
+
+    void add_engine(const std::string& engine_id, bool preemptible) {
+        engine_repo->save_engine(engine_id, {{"engine_id", engine_id}, {"status", "idle"},
+                                             {"preemptible", preemptible}});
+    }
+
+    void add_running_job(const std::string& job_id, const std::string& engine, int priority, int64_t assigned_at) {
+        job_repo->save_job(job_id, {{"job_id", job_id}, {"status", "processing"}, {"priority", priority},
+                                    {"assigned_engine", engine}, {"assigned_at", assigned_at}, {"created_at", 1}});
+    }
+
+    httplib::Response claim(const std::string& engine_id) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, nullptr, preemption);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", engine_id}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+
+    httplib::Response report(IRequestHandler& handler, const std::string& job_id, const std::string& action,
+                             const nlohmann::json& body) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.path = "/jobs/" + job_id + "/" + action;
+        req.path_params.emplace("job_id", job_id);
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(PreemptionTest, UrgentJobSuspendsLowestPriorityWorkAndItResumesAfterwards) {
+    preemption->scan(now_ms());
+
+    auto directive = preemption->directive_for("engine-normal");
+    ASSERT_FALSE(directive.is_null());
+    EXPECT_EQ(directive["job_id"], kNormal);
+    EXPECT_EQ(directive["for"], kUrgent);
+    EXPECT_TRUE(preemption->directive_for("engine-high").is_null());
+    EXPECT_TRUE(preemption->directive_for("engine-pinned").is_null());
+    EXPECT_EQ(job_repo->get_job(kUrgent)["reserved_for"], "engine-normal");
+
+    // The directive rides on the heartbeat response
+    EngineHeartbeatHandler heartbeat(auth, engine_repo, nullptr, preemption);
+    httplib::Request hb;
+    hb.headers.emplace("X-API-Key", "test_key");
+    hb.body = nlohmann::json{{"engine_id", "engine-normal"}, {"status", "busy"}, {"preemptible", true}}.dump();
+    httplib::Response hb_res;
+    heartbeat.handle(hb, hb_res);
+    EXPECT_EQ(hb_res.get_header_value("X-Preempt-Job"), kNormal);
+    EXPECT_EQ(hb_res.get_header_value("X-Preempt-For"), kUrgent);
+
+    // Nobody else may take the reserved job
+    EXPECT_EQ(claim("engine-pinned").status, 204);
+
+    JobSuspendHandler suspend(auth, job_repo, preemption);
+    nlohmann::json checkpoint = {{"stage", "transcode"}, {"segment", 3}};
+    ASSERT_EQ(report(suspend, kNormal, "suspend", {{"engine_id", "engine-normal"}, {"checkpoint", checkpoint}}).status,
+              200);
+    auto suspended = job_repo->get_job(kNormal);
+    EXPECT_EQ(suspended["status"], "suspended");
+    EXPECT_EQ(suspended["preemption"]["checkpoint"], checkpoint);
+    EXPECT_TRUE(preemption->directive_for("engine-normal").is_null());
+
+    auto res = claim("engine-normal");
+    ASSERT_EQ(res.status, 200);
+    auto urgent = nlohmann::json::parse(res.body);
+    EXPECT_EQ(urgent["job_id"], kUrgent);
+    EXPECT_FALSE(urgent.contains("reserved_for"));
+
+    JobResumeHandler resume(auth, job_repo, preemption);
+    ASSERT_EQ(report(resume, kNormal, "resume", {{"engine_id", "engine-normal"}}).status, 200);
+    EXPECT_EQ(job_repo->get_job(kNormal)["status"], "processing");
+    EXPECT_EQ(job_repo->get_job(kNormal)["preemption"]["state"], "resumed");
+
+    auto metrics = preemption->metrics();
+    EXPECT_EQ(metrics["requested"], 1);
+    EXPECT_EQ(metrics["suspended"], 1);
+    EXPECT_EQ(metrics["resumed"], 1);
+    EXPECT_EQ(metrics["pending_requests"], 0);
+}
+
+TEST_F(PreemptionTest, ReportsFromOtherEnginesAreRefused) {
+    preemption->scan(now_ms());
+
+    JobSuspendHandler suspend(auth, job_repo, preemption);
+    EXPECT_EQ(report(suspend, kNormal, "suspend", {{"engine_id", "engine-high"}}).status, 409);
+    EXPECT_EQ(report(suspend, kNormal, "suspend", nlohmann::json::object()).status, 400);
+
+    JobResumeHandler resume(auth, job_repo, preemption);
+    EXPECT_EQ(report(resume, kNormal, "resume", {{"engine_id", "engine-normal"}}).status, 409);
+    EXPECT_EQ(job_repo->get_job(kNormal)["status"], "processing");
+}
+
+TEST_F(PreemptionTest, NothingIsPreemptedWithinGraceOrWhileAnEngineIsFree) {
+    PreemptionCoordinator patient(job_repo, engine_repo, 1min, 1min);
+    patient.scan(now_ms());
+    EXPECT_TRUE(patient.directive_for("engine-normal").is_null());
+
+    add_engine("engine-free", true);
+    preemption->scan(now_ms());
+    EXPECT_EQ(preemption->metrics()["requested"], 0);
+}
+
+TEST_F(PreemptionTest, UnansweredRequestExpiresAndMovesToTheNextVictim) {
+    int64_t now = now_ms();
+    preemption->scan(now);
+    ASSERT_FALSE(preemption->directive_for("engine-normal").is_null());
+
+    preemption->scan(now + 61000);
+    EXPECT_EQ(job_repo->get_job(kNormal)["preemption"]["state"], "expired");
+    EXPECT_TRUE(preemption->directive_for("engine-normal").is_null());
+    EXPECT_EQ(job_repo->get_job(kUrgent)["reserved_for"], "engine-high");
+    EXPECT_EQ(preemption->metrics()["expired"], 1);
+}
+
+TEST_F(PreemptionTest, ChannelCarriesDirectiveAndSuspendFrames) {
+    preemption->scan(now_ms());
+
+    EngineChannelHandler channel(auth, job_repo, engine_repo, nullptr, nullptr, nullptr, preemption);
+    auto exchange = [&](const nlohmann::json& frames) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", "engine-normal"}, {"frames", frames}}.dump();
+        httplib::Response res;
+        channel.handle(req, res);
+        return nlohmann::json::parse(res.body)["frames"];
+    };
+
+    auto frames = exchange(nlohmann::json::array());
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0]["type"], "preempt");
+    EXPECT_EQ(frames[0]["job_id"], kNormal);
+
+    frames = exchange({{{"type", "suspend"}, {"job_id", kNormal}, {"body", {{"checkpoint", {{"segment", 1}}}}}},
+                       {{"type", "assign"}}});
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0]["status"], 200);
+    EXPECT_EQ(frames[1]["type"], "assignment");
+    EXPECT_EQ(frames[1]["job"]["job_id"], kUrgent);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../job_handlers.h"
+#include "../preemption.h"
+#include "../repositories.h"
+#include "../resource_packing.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string job_id(int n) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08d-0000-0000-0000-000000000000", n);
+    return id;
+}
+
+} // namespace
+
+class ResourcePackingTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+
+    void add_engine(const std::string& engine_id, const nlohmann::json& capacity, bool preemptible = false) {
+        nlohmann::json engine = {{"engine_id", engine_id}, {"status", "idle"}, {"preemptible", preemptible}};
+        if (!capacity.is_null()) {
+            engine["capacity"] = capacity;
+        }
+        engine_repo->save_engine(engine_id, engine);
+    }
+
+    void add_job(int n, const std::string& status, const nlohmann::json& requirements, int priority = 0,
+                 const std::string& engine = "") {
+        nlohmann::json job = {{"job_id", job_id(n)}, {"status", status}, {"priority", priority},
+                              {"resource_requirements", requirements}, {"created_at", n}};
+        job["assigned_engine"] = engine.empty() ? nlohmann::json(nullptr) : nlohmann::json(engine);
+        job_repo->save_job(job_id(n), job);
+    }
+
+    httplib::Response claim(const std::string& engine_id) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", engine_id}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(ResourcePackingTest, MultiSlotEngineTakesJobsUntilItsCapacityIsUsed) {
+    add_engine("engine-big", {{"slots", 3}, {"cpu_cores", 8}, {"memory_gb", 32}});
+    for (int n = 1; n <= 4; ++n) {
+        add_job(n, "pending", {{"cpu_cores", 4}, {"memory_gb", 8}});
+    }
+
+    EXPECT_EQ(claim("engine-big").status, 200);
+    EXPECT_EQ(claim("engine-big").status, 200);
+    // A slot is left, but no cores
+    EXPECT_EQ(claim("engine-big").status, 204);
+    EXPECT_EQ(jobs_running_on(*job_repo, "engine-big").size(), 2u);
+
+    job_repo->update_job(job_id(1), {{"status", "completed"}});
+    EXPECT_EQ(claim("engine-big").status, 200);
+}
+
+TEST_F(ResourcePackingTest, TightestFitWithinTheTopPriorityBandIsChosen) {
+    add_engine("engine-big", {{"slots", 4}, {"cpu_cores", 16}});
+    add_job(1, "processing", {{"cpu_cores", 10}}, 0, "engine-big");
+    add_job(2, "pending", {{"cpu_cores", 8}}, 2);  // Higher priority, but does not fit in the 6 free cores
+    add_job(3, "pending", {{"cpu_cores", 2}}, 1);
+    add_job(4, "pending", {{"cpu_cores", 6}}, 1);
+    add_job(5, "pending", {{"cpu_cores", 1}}, 0);
+
+    auto res = claim("engine-big");
+    ASSERT_EQ(res.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["job_id"], job_id(4));
+}
+
+TEST_F(ResourcePackingTest, EnginesWithoutCapacityKeepOneJobPerPoll) {
+    add_engine("engine-plain", nullptr);
+    add_job(1, "processing", {{"cpu_cores", 64}}, 0, "engine-plain");
+    add_job(2, "pending", {{"cpu_cores", 64}, {"memory_gb", 512}});
+
+    EXPECT_EQ(claim("engine-plain").status, 200);
+}
+
+TEST_F(ResourcePackingTest, SubmissionRejectsMalformedRequirements) {
+    JobSubmissionHandler handler(auth, job_repo);
+    auto submit = [&](const nlohmann::json& requirements) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"source_url", "http://example.com/in.mp4"}, {"target_codec", "h264"},
+                                  {"resource_requirements", requirements}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res.status;
+    };
+
+    EXPECT_EQ(submit({{"cpu_cores", 2}, {"memory_gb", 4.5}}), 200);
+    EXPECT_EQ(submit({{"memory_gb", -1}}), 400);
+    EXPECT_EQ(submit({{"scratch_gb", "lots"}}), 400);
+    EXPECT_EQ(submit(nlohmann::json::array()), 400);
+}
+
+TEST_F(ResourcePackingTest, PreemptionOnlyPicksVictimsThatFreeEnoughCapacity) {
+    int64_t now = now_ms();
+    add_engine("engine-packed", {{"slots", 2}, {"cpu_cores", 8}}, true);
+    add_engine("engine-roomy", {{"slots", 1}, {"cpu_cores", 16}}, true);
+    add_job(1, "processing", {{"cpu_cores", 4}}, 0, "engine-packed");
+    add_job(2, "processing", {{"cpu_cores", 4}}, 0, "engine-packed");
+    add_job(3, "processing", {{"cpu_cores", 16}}, 1, "engine-roomy");
+    job_repo->update_job(job_id(1), {{"assigned_at", now - 1000}});
+    job_repo->save_job(job_id(9), {{"job_id", job_id(9)}, {"status", "pending"}, {"priority", 2},
+                                   {"resource_requirements", {{"cpu_cores", 8}}}, {"created_at", now - 60000}});
+
+    PreemptionCoordinator preemption(job_repo, engine_repo, 10s, 1min);
+    preemption.scan(now);
+
+    // Suspending one of the packed engine's jobs would free only 4 cores
+    EXPECT_TRUE(preemption.directive_for("engine-packed").is_null());
+    auto directive = preemption.directive_for("engine-roomy");
+    ASSERT_FALSE(directive.is_null());
+    EXPECT_EQ(directive["job_id"], job_id(3));
+}
+
+TEST(ResourceAccountingTest, MissingDimensionsAreUnboundedAndJobsTakeOneSlot) {
+    Resources total = engine_capacity({{"capacity", {{"slots", 2}, {"memory_gb", 16}}}});
+    EXPECT_EQ(total.slots, 2);
+    EXPECT_TRUE(total.covers(job_demand({{"resource_requirements", {{"cpu_cores", 1000}, {"memory_gb", 16}}}})));
+    EXPECT_FALSE(total.covers(job_demand({{"resource_requirements", {{"memory_gb", 17}}}})));
+    EXPECT_EQ(engine_capacity(nlohmann::json::object()).slots, 1);
+    EXPECT_EQ(job_demand(nlohmann::json::object()).slots, 1);
+
+    Resources free = total;
+    free -= job_demand({{"resource_requirements", {{"memory_gb", 12}}}});
+    EXPECT_LT(packing_score(job_demand({{"resource_requirements", {{"memory_gb", 4}}}}), free, total),
+              packing_score(job_demand({{"resource_requirements", {{"memory_gb", 1}}}}), free, total));
+    EXPECT_LT(packing_score(job_demand({{"resource_requirements", {{"memory_gb", 5}}}}), free, total), 0);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
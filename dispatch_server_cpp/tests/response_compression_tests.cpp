@@ -0,0 +1,263 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../event_loop_server.h"
+#include "../http_router.h"
+#include "../repositories.h"
+#include "../response_compression.h"
+#include "http_test_utils.h"
+#include <zlib.h>
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+#include <zstd.h>
+#endif
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+// Inflates as much of a gzip stream as has arrived, finished or not
+std::string gunzip(const std::string& in) {
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 15 + 16) != Z_OK) return "";
+    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    strm.avail_in = static_cast<uInt>(in.size());
+    std::string out;
+    char buffer[4096];
+    int ret;
+    do {
+        strm.next_out = reinterpret_cast<Bytef*>(buffer);
+        strm.avail_out = sizeof(buffer);
+        ret = inflate(&strm, Z_SYNC_FLUSH);
+        out.append(buffer, sizeof(buffer) - strm.avail_out);
+    } while (ret == Z_OK && strm.avail_out == 0);
+    inflateEnd(&strm);
+    return out;
+}
+
+std::string decode(const std::string& in, const std::string& coding) {
+#ifdef DISPATCH_SERVER_HAS_ZSTD
+    if (coding == "zstd") {
+        std::string out(ZSTD_getFrameContentSize(in.data(), in.size()), '\0');
+        size_t size = ZSTD_decompress(&out[0], out.size(), in.data(), in.size());
+        return ZSTD_isError(size) ? "" : out.substr(0, size);
+    }
+#endif
+    return coding == "gzip" ? gunzip(in) : in;
+}
+
+std::string jobs_json(size_t count) {
+    nlohmann::json jobs = nlohmann::json::array();
+    for (size_t i = 0; i < count; ++i) {
+        jobs.push_back({{"job_id", "job-" + std::to_string(i)},
+                        {"status", i % 3 == 0 ? "failed" : "completed"},
+                        {"source_url", "https://storage.example.com/inputs/video-" + std::to_string(i) + ".mp4"},
+                        {"target_codec", "h264"},
+                        {"job_size", 120.5},
+                        {"retries", 0},
+                        {"max_retries", 3}});
+    }
+    return jobs.dump();
+}
+
+httplib::Request accepting(const std::string& accept_encoding) {
+    httplib::Request req;
+    req.method = "GET";
+    if (!accept_encoding.empty()) req.headers.emplace("Accept-Encoding", accept_encoding);
+    return req;
+}
+
+} // namespace
+
+TEST(ResponseCompressionTest, NegotiatesByQValue) {
+    const ContentCoding preferred = zstd_available() ? ContentCoding::Zstd : ContentCoding::Gzip;
+    EXPECT_EQ(negotiate_coding(""), ContentCoding::Identity);
+    EXPECT_EQ(negotiate_coding("identity"), ContentCoding::Identity);
+    EXPECT_EQ(negotiate_coding("gzip"), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("x-gzip, deflate"), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("gzip;q=0"), ContentCoding::Identity);
+    EXPECT_EQ(negotiate_coding("br, *;q=0.5"), preferred);
+    EXPECT_EQ(negotiate_coding("GZIP ; q=0.8, zstd;q=0.9"), preferred);
+    EXPECT_EQ(negotiate_coding("gzip, zstd;q=0.5"), ContentCoding::Gzip);
+    EXPECT_EQ(negotiate_coding("zstd;q=0, *"), ContentCoding::Gzip);
+}
+
+TEST(ResponseCompressionTest, CompressesLargeJsonBodiesAndWeakensTheirETag) {
+    ResponseCompression compression;
+    const std::string body = jobs_json(200);
+    const std::string coding = zstd_available() ? "zstd" : "gzip";
+
+    for (const std::string& accept : {std::string("gzip"), std::string("gzip, zstd")}) {
+        SCOPED_TRACE(accept);
+        httplib::Response res;
+        res.status = 200;
+        res.set_content(body, "application/json");
+        res.set_header("ETag", "\"abc-1\"");
+        compression.apply(accepting(accept), res);
+
+        const std::string expected = accept == "gzip" ? "gzip" : coding;
+        EXPECT_EQ(res.get_header_value("Content-Encoding"), expected);
+        EXPECT_EQ(res.get_header_value("Vary"), "Accept-Encoding");
+        EXPECT_EQ(res.get_header_value("ETag"), "W/\"abc-1\"");
+        EXPECT_LT(res.body.size(), body.size() / 4);
+        EXPECT_EQ(decode(res.body, expected), body);
+    }
+
+    httplib::Response identity;
+    identity.status = 200;
+    identity.set_content(body, "application/json");
+    compression.apply(accepting(""), identity);
+    EXPECT_FALSE(identity.has_header("Content-Encoding"));
+    EXPECT_EQ(identity.get_header_value("Vary"), "Accept-Encoding");
+    EXPECT_EQ(identity.body, body);
+}
+
+TEST(ResponseCompressionTest, LeavesSmallOpaqueAndNotModifiedResponsesAlone) {
+    const std::string body = jobs_json(50);
+    auto untouched = [&](ResponseCompression& compression, httplib::Request req, const std::string& content,
+                         const std::string& type, int status) {
+        httplib::Response res;
+        res.set_content(content, type);
+        res.status = status;
+        compression.apply(req, res);
+        return !res.has_header("Content-Encoding") && res.body == content;
+    };
+
+    ResponseCompression compression;
+    EXPECT_TRUE(untouched(compression, accepting("gzip"), R"({"status":"ok"})", "application/json", 200));
+    EXPECT_TRUE(untouched(compression, accepting("gzip"), body, "video/mp4", 200));
+    EXPECT_TRUE(untouched(compression, accepting("gzip"), body, "application/json", 304));
+    httplib::Request head = accepting("gzip");
+    head.method = "HEAD";
+    EXPECT_TRUE(untouched(compression, head, body, "application/json", 200));
+
+    compression.set_options({0, 0});
+    EXPECT_TRUE(untouched(compression, accepting("gzip"), body, "application/json", 200));
+    compression.set_options({1, body.size() + 1});
+    EXPECT_TRUE(untouched(compression, accepting("gzip"), body, "application/json", 200));
+    compression.set_options({1, 0});
+    EXPECT_FALSE(untouched(compression, accepting("gzip"), body, "application/json", 200));
+}
+
+TEST(ResponseCompressionTest, FlushesEveryPieceOfAChunkedStream) {
+    ResponseCompression compression;
+    httplib::Response res;
+    res.status = 200;
+    auto sent = std::make_shared<int>(0);
+    res.set_chunked_content_provider("text/event-stream", [sent](size_t, httplib::DataSink& sink) {
+        if (*sent == 3) {
+            sink.done();
+            return true;
+        }
+        std::string event = "data: " + std::to_string((*sent)++) + "\n\n";
+        return sink.write(event.data(), event.size());
+    });
+    compression.apply(accepting("gzip"), res);
+    ASSERT_EQ(res.get_header_value("Content-Encoding"), "gzip");
+
+    std::string wire;
+    bool finished = false;
+    httplib::DataSink sink;
+    sink.write = [&](const char* data, size_t size) {
+        wire.append(data, size);
+        return true;
+    };
+    sink.is_writable = []() { return true; };
+    sink.done = [&]() { finished = true; };
+
+    // Each event decodes as soon as its piece is written, before the stream ends
+    std::string expected;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(res.content_provider_(0, 0, sink));
+        expected += "data: " + std::to_string(i) + "\n\n";
+        EXPECT_EQ(gunzip(wire), expected);
+    }
+    ASSERT_TRUE(res.content_provider_(0, 0, sink));
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(gunzip(wire), expected);
+}
+
+TEST(ResponseCompressionTest, BothFrontEndsCompressStreams) {
+    HttpRouter::Handler stream = [](const httplib::Request&, httplib::Response& res) {
+        auto sent = std::make_shared<int>(0);
+        res.set_chunked_content_provider("text/event-stream", [sent](size_t, httplib::DataSink& sink) {
+            if (*sent == 3) {
+                sink.done();
+                return true;
+            }
+            std::string event = "data: " + std::to_string((*sent)++) + "\n\n";
+            return sink.write(event.data(), event.size());
+        });
+    };
+    auto compression = std::make_shared<ResponseCompression>();
+    auto hook = [compression](const httplib::Request& req, httplib::Response& res) { compression->apply(req, res); };
+
+    httplib::Server svr;
+    HttpRouter router(&svr);
+    router.Get("/events", stream);
+    svr.set_post_routing_handler(hook);
+    int httplib_port = svr.bind_to_any_port("127.0.0.1");
+    std::thread httplib_thread([&]() { svr.listen_after_bind(); });
+
+    EventLoopServer event_loop(router);
+    event_loop.set_post_routing_handler(hook);
+    int event_loop_port = event_loop.bind_to_any_port("127.0.0.1");
+    std::thread event_loop_thread([&]() { event_loop.listen_after_bind(); });
+
+    for (int port : {httplib_port, event_loop_port}) {
+        httplib::Client client("127.0.0.1", port);
+        client.set_decompress(false);
+        auto res = with_connect_retry([&] { return client.Get("/events", {{"Accept-Encoding", "gzip"}}); });
+        ASSERT_TRUE(res);
+        EXPECT_EQ(res->get_header_value("Content-Encoding"), "gzip");
+        EXPECT_EQ(gunzip(res->body), "data: 0\n\ndata: 1\n\ndata: 2\n\n");
+    }
+
+    svr.stop();
+    event_loop.stop();
+    httplib_thread.join();
+    event_loop_thread.join();
+}
+
+TEST(ResponseCompressionTest, DispatchServerCompressesJobListings) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    for (const auto& job : nlohmann::json::parse(jobs_json(300))) {
+        job_repo->save_job(job["job_id"], job);
+    }
+
+    for (bool event_loop : {false, true}) {
+        SCOPED_TRACE(event_loop ? "event loop" : "httplib");
+        DispatchServer server(job_repo, engine_repo, "test_key");
+        if (event_loop) server.set_event_loop(EventLoopOptions{});
+        server.start(0, false);
+
+        httplib::Client client("127.0.0.1", server.get_port());
+        client.set_decompress(false);
+        auto plain = with_connect_retry([&] { return client.Get("/jobs/", {{"X-API-Key", "test_key"}}); });
+        ASSERT_TRUE(plain);
+        EXPECT_FALSE(plain->has_header("Content-Encoding"));
+
+        auto gzipped = with_connect_retry([&] {
+            return client.Get("/jobs/", {{"X-API-Key", "test_key"}, {"Accept-Encoding", "gzip"}});
+        });
+        ASSERT_TRUE(gzipped);
+        EXPECT_EQ(gzipped->status, 200);
+        EXPECT_EQ(gzipped->get_header_value("Content-Encoding"), "gzip");
+        EXPECT_EQ(gzipped->get_header_value("Content-Length"), std::to_string(gzipped->body.size()));
+        EXPECT_LT(gzipped->body.size(), plain->body.size() / 4);
+        EXPECT_EQ(gunzip(gzipped->body), plain->body);
+        server.stop();
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../job_action_handlers.h"
+#include "../retry_policy.h"
+#include "../repositories.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint64_t SEED = 42;
+
+nlohmann::json failed_job(int max_retries) {
+    return {{"job_id", "job-1"}, {"status", "processing"}, {"retries", 0}, {"max_retries", max_retries}};
+}
+
+} // namespace
+
+TEST(RetryPolicyTest, ClassifiesFailureReports) {
+    EXPECT_EQ(classify_failure(nlohmann::json::object(), "Failed to download source video"), "download");
+    EXPECT_EQ(classify_failure(nlohmann::json::object(), "Failed to upload transcoded video"), "upload");
+    EXPECT_EQ(classify_failure(nlohmann::json::object(), "FFmpeg transcoding failed"), "transcode");
+    EXPECT_EQ(classify_failure(nlohmann::json::object(), "Disk full"), "other");
+    EXPECT_EQ(classify_failure({{"error_class", "upload"}}, "Disk full"), "upload");
+    EXPECT_EQ(classify_failure({{"error_class", "cosmic_rays"}}, "FFmpeg failed"), "transcode");
+}
+
+TEST(RetryPolicyTest, BackoffIsFullJitterUnderTheExponentialCeiling) {
+    RetryPolicy policy;
+    policy.classes["download"] = {5, 1000ms, 8000ms};
+    RetryScheduler retries(policy, SEED);
+    for (int attempt = 0; attempt < 6; ++attempt) {
+        int64_t ceiling = std::min<int64_t>(1000LL << attempt, 8000);
+        int64_t lowest = ceiling, highest = 0;
+        for (int i = 0; i < 500; ++i) {
+            int64_t delay = retries.backoff_ms("download", attempt);
+            ASSERT_GE(delay, 0);
+            ASSERT_LE(delay, ceiling);
+            lowest = std::min(lowest, delay);
+            highest = std::max(highest, delay);
+        }
+        EXPECT_LT(lowest, ceiling / 10) << "attempt " << attempt;
+        EXPECT_GT(highest, ceiling * 9 / 10) << "attempt " << attempt;
+    }
+}
+
+TEST(RetryPolicyTest, SpreadsASimultaneousOutageOverTheBackoffWindow) {
+    RetryScheduler retries(RetryPolicy{}, SEED);
+    std::map<int64_t, int> per_second;
+    for (int i = 0; i < 300; ++i) {
+        nlohmann::json job = failed_job(3);
+        ASSERT_TRUE(retries.schedule(job, "download", "Failed to download source video", 0));
+        ++per_second[job["retry_after"].get<int64_t>() / 1000];
+    }
+    // The first retry waits up to RETRY_DELAY_BASE_SECONDS, not all at the same second
+    EXPECT_GE(per_second.size(), 25u);
+    for (const auto& [second, count] : per_second) {
+        EXPECT_LE(count, 30) << "second " << second;
+    }
+}
+
+TEST(RetryPolicyTest, JobAndClassLimitsEndRetries) {
+    RetryScheduler retries(RetryPolicy{}, SEED);
+
+    // Storage failures retry up to the job's own max_retries
+    nlohmann::json job = failed_job(3);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(retries.schedule(job, "download", "Failed to download source video", 1000));
+        EXPECT_EQ(job["status"], "failed_retry");
+        EXPECT_GE(job["retry_after"].get<int64_t>(), 1000);
+    }
+    EXPECT_EQ(job["retries"], 3);
+    EXPECT_EQ(job["retry_counts"]["download"], 3);
+    EXPECT_FALSE(retries.schedule(job, "download", "Failed to download source video", 1000));
+    EXPECT_EQ(job["status"], "failed_permanently");
+    EXPECT_EQ(job["error_message"], "Failed to download source video");
+
+    // A transcode failure gets one retry however many the job allows
+    nlohmann::json broken = failed_job(5);
+    ASSERT_TRUE(retries.schedule(broken, "transcode", "FFmpeg transcoding failed", 1000));
+    EXPECT_FALSE(retries.schedule(broken, "transcode", "FFmpeg transcoding failed", 1000));
+    EXPECT_EQ(broken["status"], "failed_permanently");
+    EXPECT_EQ(broken["failure_class"], "transcode");
+
+    auto metrics = retries.metrics();
+    EXPECT_EQ(metrics["scheduled"]["download"], 3);
+    EXPECT_EQ(metrics["scheduled"]["transcode"], 1);
+    EXPECT_EQ(metrics["exhausted"], 2);
+}
+
+TEST(RetryPolicyTest, BudgetLimitsHowFastRetriesReturnToTheQueue) {
+    RetryPolicy policy;
+    policy.budget_per_minute = 60;
+    policy.budget_burst = 2;
+    RetryScheduler retries(policy, SEED);
+    EXPECT_TRUE(retries.try_release(0));
+    EXPECT_TRUE(retries.try_release(0));
+    EXPECT_FALSE(retries.try_release(0));
+    EXPECT_FALSE(retries.try_release(500));
+    EXPECT_TRUE(retries.try_release(1000)); // One token a second
+    EXPECT_FALSE(retries.try_release(1000));
+    EXPECT_TRUE(retries.try_release(60000));
+    EXPECT_TRUE(retries.try_release(60000)); // Refills to the burst size, no further
+    EXPECT_FALSE(retries.try_release(60000));
+    EXPECT_EQ(retries.metrics()["deferred"], 4);
+
+    policy.budget_per_minute = 0;
+    retries.set_policy(policy);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(retries.try_release(60000));
+    }
+}
+
+TEST(RetryPolicyTest, ReleasesDueRetriesOldestFirstWithinTheBudget) {
+    RetryPolicy policy;
+    policy.budget_per_minute = 60;
+    policy.budget_burst = 2;
+    RetryScheduler retries(policy, SEED);
+    InMemoryJobRepository repo;
+    for (int i = 0; i < 4; ++i) {
+        std::string id = "job-" + std::to_string(i);
+        repo.save_job(id, {{"job_id", id}, {"status", "failed_retry"}, {"retry_after", 1000 - i * 100}});
+    }
+    repo.save_job("later", {{"job_id", "later"}, {"status", "failed_retry"}, {"retry_after", 5000}});
+
+    auto released = retries.release_due(repo, 1000);
+    ASSERT_EQ(released.size(), 2u);
+    EXPECT_EQ(released[0]["job_id"], "job-3");
+    EXPECT_EQ(released[1]["job_id"], "job-2");
+    EXPECT_EQ(repo.get_job("job-3")["status"], "pending");
+    EXPECT_EQ(repo.get_job("job-1")["status"], "failed_retry");
+
+    EXPECT_EQ(retries.release_due(repo, 3000).size(), 2u);
+    EXPECT_EQ(repo.get_job("later")["status"], "failed_retry"); // Not due yet
+}
+
+class RetryFailureHandlerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::shared_ptr<RetryScheduler> retries = std::make_shared<RetryScheduler>(RetryPolicy{}, SEED);
+    const std::string id = "00000001-0000-0000-0000-000000000000";
+
+    void SetUp() override {
+        job_repo->save_job(id, {{"job_id", id}, {"status", "processing"}, {"assigned_engine", "engine-0"},
+                                {"retries", 0}, {"max_retries", 3}});
+    }
+
+    nlohmann::json fail(const nlohmann::json& body, std::shared_ptr<RetryScheduler> scheduler) {
+        JobFailureHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, scheduler);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.path = "/jobs/" + id + "/fail";
+        req.path_params.emplace("job_id", id);
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        EXPECT_EQ(res.status, 200);
+        return job_repo->get_job(id);
+    }
+};
+
+TEST_F(RetryFailureHandlerTest, ReportedFailureIsScheduledByItsClass) {
+    auto job = fail({{"engine_id", "engine-0"}, {"error_message", "Failed to download source video"}}, retries);
+    EXPECT_EQ(job["status"], "failed_retry");
+    EXPECT_EQ(job["failure_class"], "download");
+    EXPECT_EQ(job["retries"], 1);
+    EXPECT_TRUE(job.contains("retry_after"));
+    EXPECT_EQ(job["error_message"], "Failed to download source video");
+
+    job = fail({{"engine_id", "engine-0"}, {"error_message", "No space left"}, {"error_class", "upload"}}, retries);
+    EXPECT_EQ(job["failure_class"], "upload");
+    EXPECT_EQ(job["retry_counts"]["upload"], 1);
+    EXPECT_EQ(job["retries"], 2);
+}
+
+TEST_F(RetryFailureHandlerTest, WithoutASchedulerFailuresArePermanent) {
+    auto job = fail({{"engine_id", "engine-0"}, {"error_message", "Failed to download source video"}}, nullptr);
+    EXPECT_EQ(job["status"], "failed_permanently");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
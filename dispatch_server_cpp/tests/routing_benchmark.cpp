@@ -0,0 +1,146 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+#include "http_router.h"
+#include "response_utils.h"
+
+using namespace distconv::DispatchServer;
+
+// Request routing and output URL validation, before and after the path trie:
+// the former route table was a list of std::regex patterns tried in order
+// (httplib's dispatch), and URL validation built a std::regex on every call.
+// The route table and request mix follow DispatchServer's endpoints, weighted
+// towards engine traffic.
+
+namespace {
+
+constexpr int ITERATIONS = 200000;
+const std::string JOB = "123e4567-e89b-12d3-a456-426614174000";
+const std::string UUID = R"(([a-fA-F0-9\-]{36}))";
+
+struct RouteShape {
+    const char* method;
+    std::string pattern;
+    std::string former_regex;
+};
+
+const std::vector<RouteShape> ROUTES = {
+    {"GET", "/", "/"},
+    {"GET", "/health", "/health"},
+    {"GET", "/scheduler/stats", "/scheduler/stats"},
+    {"POST", "/jobs/", "/jobs/"},
+    {"GET", "/jobs/{job_id:uuid}", "/jobs/" + UUID},
+    {"GET", "/jobs/at_risk", "/jobs/at_risk"},
+    {"GET", "/jobs/", "/jobs/"},
+    {"GET", "/events", "/events"},
+    {"POST", "/jobs/{job_id:uuid}/complete", "/jobs/" + UUID + "/complete"},
+    {"POST", "/jobs/{job_id:uuid}/fail", "/jobs/" + UUID + "/fail"},
+    {"POST", "/jobs/{job_id:uuid}/suspend", "/jobs/" + UUID + "/suspend"},
+    {"POST", "/jobs/{job_id:uuid}/resume", "/jobs/" + UUID + "/resume"},
+    {"POST", "/jobs/{job_id:uuid}/retry", "/jobs/" + UUID + "/retry"},
+    {"POST", "/jobs/{job_id:uuid}/cancel", "/jobs/" + UUID + "/cancel"},
+    {"PUT", "/jobs/{job_id:uuid}", "/jobs/" + UUID},
+    {"POST", "/jobs/{job_id:uuid}/progress", "/jobs/" + UUID + "/progress"},
+    {"POST", "/engines/heartbeat", "/engines/heartbeat"},
+    {"GET", "/engines/", "/engines/"},
+    {"POST", "/assign_job/", "/assign_job/"},
+    {"POST", "/engines/benchmark_result", "/engines/benchmark_result"},
+    {"POST", "/engines/channel", "/engines/channel"},
+    {"POST", "/storage_pools/", "/storage_pools/"},
+    {"GET", "/storage_pools/", "/storage_pools/"},
+    {"GET", "/tdarr/status", "/tdarr/status"},
+    {"POST", "/tdarr/submit", "/tdarr/submit"},
+    {"POST", "/api/v1/jobs", "/api/v1/jobs"},
+    {"GET", "/api/v1/jobs/{job_id:uuid}", "/api/v1/jobs/" + UUID},
+    {"GET", "/api/v1/status", "/api/v1/status"},
+    {"DELETE", "/api/v1/engines/{engine_id}", R"(/api/v1/engines/([a-zA-Z0-9\-_]+))"},
+};
+
+// Engines dominate: heartbeats, progress and claims, then completions,
+// submissions and a little polling of job status
+const std::vector<std::pair<std::string, std::string>> REQUESTS = {
+    {"POST", "/engines/heartbeat"},       {"POST", "/jobs/" + JOB + "/progress"},
+    {"POST", "/engines/heartbeat"},       {"POST", "/jobs/" + JOB + "/progress"},
+    {"POST", "/assign_job/"},             {"POST", "/jobs/" + JOB + "/complete"},
+    {"POST", "/jobs/"},                   {"GET", "/jobs/" + JOB},
+    {"GET", "/jobs/"},                    {"DELETE", "/api/v1/engines/engine-42"},
+};
+
+const std::vector<std::string> URLS = {
+    "https://storage.example.com/outputs/" + JOB + ".mp4", "http://10.0.0.5:9000/bucket/out.mkv",
+    "ftp://example.com/out.mp4", "example.com/out.mp4"};
+
+struct FormerRoute {
+    std::string method;
+    std::regex regex;
+};
+
+bool former_is_valid_url(const std::string& url) {
+    if (url.empty()) return false;
+    std::regex url_regex(R"(^https?://[^\s/$.?#].[^\s]*$)", std::regex_constants::icase);
+    return std::regex_match(url, url_regex);
+}
+
+template <typename Body>
+double ns_per_op(Body body) {
+    auto start = std::chrono::steady_clock::now();
+    size_t matched = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        matched += body(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (matched == 0) std::cout << "(nothing matched)" << std::endl;
+    return elapsed / ITERATIONS;
+}
+
+void report(const std::string& name, double before, const std::string& replacement, double after) {
+    std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(0)
+              << " std::regex " << std::setw(7) << before << " ns/op   "
+              << std::left << std::setw(12) << replacement << std::right << std::setw(5) << after << " ns/op"
+              << std::setprecision(1) << "   (" << before / after << "x)" << std::endl;
+}
+
+} // namespace
+
+int main() {
+    HttpRouter router;
+    std::vector<FormerRoute> former;
+    auto noop = [](const httplib::Request&, httplib::Response&) {};
+    for (const auto& route : ROUTES) {
+        std::string method = route.method;
+        if (method == "GET") router.Get(route.pattern, noop);
+        else if (method == "POST") router.Post(route.pattern, noop);
+        else if (method == "PUT") router.Put(route.pattern, noop);
+        else router.Delete(route.pattern, noop);
+        former.push_back({method, std::regex(route.former_regex)});
+    }
+
+    std::vector<httplib::Request> requests(REQUESTS.size());
+    for (size_t i = 0; i < REQUESTS.size(); ++i) {
+        requests[i].method = REQUESTS[i].first;
+        requests[i].path = REQUESTS[i].second;
+    }
+
+    double regex_routing = ns_per_op([&](int i) {
+        httplib::Request& req = requests[i % requests.size()];
+        for (const auto& route : former) {
+            if (route.method == req.method && std::regex_match(req.path, req.matches, route.regex)) return 1;
+        }
+        return 0;
+    });
+    double trie_routing = ns_per_op([&](int i) {
+        HttpRouter::Match match;
+        return router.match(requests[i % requests.size()], match) ? 1 : 0;
+    });
+    double regex_urls = ns_per_op([&](int i) { return former_is_valid_url(URLS[i % URLS.size()]) ? 1 : 0; });
+    double hand_urls = ns_per_op([&](int i) { return ResponseUtils::is_valid_url(URLS[i % URLS.size()]) ? 1 : 0; });
+
+    std::cout << ROUTES.size() << " routes, " << REQUESTS.size() << " request shapes, " << ITERATIONS
+              << " iterations each" << std::endl;
+    report("route match", regex_routing, "path trie", trie_routing);
+    report("output_url check", regex_urls, "hand-written", hand_urls);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "../http_router.h"
+#include "../response_utils.h"
+#include "http_test_utils.h"
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const std::string JOB_ID = "123e4567-e89b-12d3-a456-426614174000";
+
+HttpRouter::Handler reply(const std::string& name) {
+    return [name](const httplib::Request& req, httplib::Response& res) {
+        std::string body = name;
+        for (const auto& param : req.path_params) {
+            body += " " + param.first + "=" + param.second;
+        }
+        res.set_content(body, "text/plain");
+    };
+}
+
+// Routes `method path` and returns the handler's body, or "" when nothing matched
+std::string routed(const HttpRouter& router, const std::string& method, const std::string& path) {
+    httplib::Request req;
+    req.method = method;
+    req.path = path;
+    httplib::Response res;
+    return router.route(req, res) ? res.body : "";
+}
+
+} // namespace
+
+TEST(HttpRouterTest, MatchesLiteralsAndTypedCaptures) {
+    HttpRouter router;
+    router.Get("/", reply("root"));
+    router.Get("/jobs/", reply("list"));
+    router.Post("/jobs/", reply("submit"), EndpointClass::Submission);
+    router.Get("/jobs/{job_id:uuid}", reply("status"));
+    router.Get("/jobs/at_risk", reply("at_risk"));
+    router.Post("/jobs/{job_id:uuid}/complete", reply("complete"), EndpointClass::Control);
+    router.Delete("/api/v1/engines/{engine_id}", reply("deregister"));
+
+    EXPECT_EQ(routed(router, "GET", "/"), "root");
+    EXPECT_EQ(routed(router, "GET", "/jobs/"), "list");
+    EXPECT_EQ(routed(router, "POST", "/jobs/"), "submit");
+    EXPECT_EQ(routed(router, "GET", "/jobs/" + JOB_ID), "status job_id=" + JOB_ID);
+    EXPECT_EQ(routed(router, "HEAD", "/jobs/" + JOB_ID), "status job_id=" + JOB_ID);
+    EXPECT_EQ(routed(router, "GET", "/jobs/at_risk"), "at_risk");
+    EXPECT_EQ(routed(router, "POST", "/jobs/" + JOB_ID + "/complete"), "complete job_id=" + JOB_ID);
+    EXPECT_EQ(routed(router, "DELETE", "/api/v1/engines/engine_7-a"), "deregister engine_id=engine_7-a");
+
+    // Wrong type, method, shape or trailing slash
+    EXPECT_EQ(routed(router, "GET", "/jobs/not-a-job-id"), "");
+    EXPECT_EQ(routed(router, "PUT", "/jobs/" + JOB_ID), "");
+    EXPECT_EQ(routed(router, "GET", "/jobs"), "");
+    EXPECT_EQ(routed(router, "POST", "/jobs/" + JOB_ID + "/complete/"), "");
+    EXPECT_EQ(routed(router, "DELETE", "/api/v1/engines/bad.id"), "");
+    EXPECT_EQ(routed(router, "DELETE", "/api/v1/engines/"), "");
+
+    httplib::Request req;
+    req.method = "POST";
+    req.path = "/jobs/" + JOB_ID + "/complete";
+    HttpRouter::Match match;
+    ASSERT_TRUE(router.match(req, match));
+    EXPECT_EQ(match.endpoint_class, EndpointClass::Control);
+    EXPECT_EQ(req.matched_route, "/jobs/{job_id:uuid}/complete");
+}
+
+TEST(HttpRouterTest, FallsBackToCapturesWhenALiteralBranchDeadEnds) {
+    HttpRouter router;
+    router.Get("/pools/default/usage", reply("usage"));
+    router.Get("/pools/{pool_id}/jobs", reply("jobs"));
+    router.Get("/pools/{pool_id:uuid}/jobs", reply("uuid_jobs"));
+
+    EXPECT_EQ(routed(router, "GET", "/pools/default/usage"), "usage");
+    EXPECT_EQ(routed(router, "GET", "/pools/default/jobs"), "jobs pool_id=default");
+    EXPECT_EQ(routed(router, "GET", "/pools/" + JOB_ID + "/jobs"), "uuid_jobs pool_id=" + JOB_ID);
+}
+
+TEST(HttpRouterTest, RejectsMalformedPatterns) {
+    HttpRouter router;
+    EXPECT_THROW(router.Get("jobs/", reply("x")), std::invalid_argument);
+    EXPECT_THROW(router.Get("/jobs/{job_id", reply("x")), std::invalid_argument);
+    EXPECT_THROW(router.Get("/jobs/{job_id:int}", reply("x")), std::invalid_argument);
+    EXPECT_THROW(router.Get("/jobs/{}", reply("x")), std::invalid_argument);
+    EXPECT_EQ(router.size(), 0u);
+}
+
+TEST(HttpRouterTest, MirroredHttplibRoutesReceiveTheSameCaptures) {
+    httplib::Server svr;
+    HttpRouter router(&svr);
+    router.Get("/jobs/{job_id:uuid}", reply("status"));
+    router.Get("/jobs/at_risk", reply("at_risk"));
+
+    int port = svr.bind_to_any_port("127.0.0.1");
+    ASSERT_GT(port, 0);
+    std::thread thread([&]() { svr.listen_after_bind(); });
+
+    httplib::Client client("127.0.0.1", port);
+    auto status = with_connect_retry([&] { return client.Get("/jobs/" + JOB_ID); });
+    ASSERT_TRUE(status);
+    EXPECT_EQ(status->body, "status job_id=" + JOB_ID);
+    auto at_risk = with_connect_retry([&] { return client.Get("/jobs/at_risk"); });
+    ASSERT_TRUE(at_risk);
+    EXPECT_EQ(at_risk->body, "at_risk");
+    auto missing = with_connect_retry([&] { return client.Get("/jobs/not-a-job-id"); });
+    ASSERT_TRUE(missing);
+    EXPECT_EQ(missing->status, 404);
+
+    svr.stop();
+    thread.join();
+}
+
+TEST(UrlValidationTest, AgreesWithTheFormerRegex) {
+    const std::regex former(R"(^https?://[^\s/$.?#].[^\s]*$)", std::regex_constants::icase);
+    const std::vector<std::string> urls = {
+        "http://example.com/output.mp4", "https://example.com", "HTTPS://EXAMPLE.COM/a?b=c#d",
+        "http://a.b", "http://ab", "https://10.0.0.1:8080/out", "http://a", "http://", "https://",
+        "example.com/output.mp4", "ftp://example.com/output.mp4", "http:/example.com", "http//example.com",
+        "http:///path", "http://.example.com", "http://?q", "http://#x", "http://$x", "http://exa mple.com",
+        "http://example.com/\t", " http://example.com", "http://example.com\n", "", "h", "httpx://a.b"};
+    for (const auto& url : urls) {
+        EXPECT_EQ(ResponseUtils::is_valid_url(url), std::regex_match(url, former)) << url;
+    }
+    // Stricter where the regex let any character through in the second position
+    EXPECT_FALSE(ResponseUtils::is_valid_url("http://a b"));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
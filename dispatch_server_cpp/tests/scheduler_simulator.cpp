@@ -0,0 +1,631 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "admission_control.h"
+#include "assignment_handler.h"
+#include "engine_health.h"
+#include "job_action_handlers.h"
+#include "job_handlers.h"
+#include "job_timeouts.h"
+#include "repositories.h"
+#include "retry_policy.h"
+#include "runtime_estimator.h"
+#include "size_lanes.h"
+#include "wall_clock.h"
+#include "nlohmann/json.hpp"
+
+using namespace distconv::DispatchServer;
+
+// Discrete-event simulator for the scheduling policies. Jobs are submitted
+// through JobSubmissionHandler, claimed through JobAssignmentHandler and
+// reported through the completion and failure handlers, against an
+// InMemoryJobRepository whose clock (set_wall_clock_source) is the
+// simulation's. Synthetic engines poll like real ones: again right after a
+// job ends, when work arrives (as a long-poll would wake them), and every few
+// seconds while idle. The background sweep (retry requeue, job timeouts) runs
+// on the server's interval.
+//
+// Workloads are a JSONL trace, each line a POST /jobs/ body plus "submit_at"
+// (seconds from the start) and optionally "runtime_s" (runtime on a speed 1.0
+// engine), or a generated mix (--jobs). The same seed gives the same run.
+//
+// Reports makespan, queue latency (submit to first assignment) percentiles,
+// slot utilization and fairness: Jain's index over the tenants' mean slowdown
+// (completion latency over runtime on a speed 1.0 engine).
+
+namespace {
+
+constexpr int64_t EPOCH_MS = 1700000000000;       // Virtual time zero
+constexpr double REFERENCE_MB_PER_S = 5.0;        // Speed 1.0 engine
+constexpr int64_t JOB_OVERHEAD_MS = 2000;         // Per ffmpeg run: download, probe, upload
+constexpr int64_t IDLE_POLL_MS = 5000;
+constexpr int64_t MAX_DRAIN_MS = 7LL * 24 * 3600 * 1000; // After the last arrival; jobs still open are unfinished
+const std::vector<std::string> CODECS = {"h264", "h265", "vp9", "av1"};
+
+int64_t virtual_now_ms = EPOCH_MS;
+
+int64_t virtual_clock() {
+    return virtual_now_ms;
+}
+
+struct Options {
+    std::string trace_path;
+    size_t jobs = 1000;
+    double arrivals_per_minute = 6.0;
+    uint64_t seed = 42;
+    std::string engines_path;
+    int engine_count = 8;
+    double failure_rate = 0.01;
+    bool lanes = false;
+    bool health = false;
+    size_t batch = 1;
+    size_t retry_budget = Constants::RETRY_BUDGET_PER_MINUTE;
+    size_t max_pending = 0;
+    bool json = false;
+};
+
+struct Submission {
+    int64_t at_ms = 0;
+    nlohmann::json body;
+    int64_t reference_ms = 0; // Runtime on a speed 1.0 engine
+};
+
+struct SimEngine {
+    std::string id;
+    double speed = 1.0;
+    double failure_rate = 0.0;
+    std::set<std::string> codecs; // Empty: every codec
+    int slots = 1;
+    nlohmann::json capacity;      // Declared to the claim path when set
+    int running = 0;
+    int64_t busy_ms = 0;
+    uint64_t poll_token = 0;
+    int64_t next_poll_ms = -1;
+};
+
+struct JobRecord {
+    int64_t submitted_ms = 0;
+    int64_t first_assigned_ms = -1;
+    int64_t finished_ms = -1;
+    int64_t reference_ms = 0;
+    std::string tenant;
+};
+
+enum class EventType { Arrival, Finish, Poll, Sweep };
+
+struct Event {
+    int64_t at_ms;
+    uint64_t seq;
+    EventType type;
+    size_t index;                     // Submission or engine
+    uint64_t token = 0;               // Poll: stale unless it matches the engine's
+    std::vector<std::string> job_ids; // Finish: the jobs of one slot
+    std::vector<std::string> errors;  // Finish: per job, empty on success
+    bool operator>(const Event& other) const {
+        return at_ms != other.at_ms ? at_ms > other.at_ms : seq > other.seq;
+    }
+};
+
+int64_t percentile(std::vector<int64_t> samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+int64_t reference_runtime_ms(double size_mb) {
+    return JOB_OVERHEAD_MS + static_cast<int64_t>(size_mb / REFERENCE_MB_PER_S * 1000.0);
+}
+
+std::vector<Submission> load_trace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open trace " + path);
+    }
+    std::vector<Submission> submissions;
+    std::string line;
+    double at_s = 0;
+    size_t n = 0;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        nlohmann::json body = nlohmann::json::parse(line);
+        if (!body.is_object()) continue;
+        at_s = body.value("submit_at", at_s); // Lines without one arrive with the previous line
+        Submission submission;
+        submission.at_ms = static_cast<int64_t>(at_s * 1000.0);
+        double size_mb = body.value("job_size", 0.0);
+        submission.reference_ms = body.contains("runtime_s")
+                                      ? static_cast<int64_t>(body["runtime_s"].get<double>() * 1000.0)
+                                      : reference_runtime_ms(size_mb);
+        body.erase("submit_at");
+        body.erase("runtime_s");
+        if (!body.contains("source_url")) body["source_url"] = "http://storage.example.com/sim/" + std::to_string(n) + ".mp4";
+        if (!body.contains("target_codec")) body["target_codec"] = "h264";
+        submission.body = body;
+        submissions.push_back(submission);
+        ++n;
+    }
+    return submissions;
+}
+
+// Poisson arrivals; mostly short clips with a tail of large masters, spread
+// over four tenants, codecs and a few urgent jobs
+std::vector<Submission> generate_workload(const Options& options, std::mt19937_64& rng) {
+    std::exponential_distribution<double> gap_s(options.arrivals_per_minute / 60.0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::discrete_distribution<int> codec({50, 25, 15, 10});
+    std::vector<Submission> submissions;
+    double at_s = 0;
+    for (size_t n = 0; n < options.jobs; ++n) {
+        at_s += gap_s(rng);
+        double roll = unit(rng);
+        double size_mb = roll < 0.7 ? 5.0 + 45.0 * unit(rng)
+                       : roll < 0.9 ? 50.0 + 50.0 * unit(rng)
+                                    : 100.0 + 4900.0 * unit(rng);
+        Submission submission;
+        submission.at_ms = static_cast<int64_t>(at_s * 1000.0);
+        submission.reference_ms = reference_runtime_ms(size_mb);
+        submission.body = {{"source_url", "http://storage.example.com/sim/" + std::to_string(n) + ".mp4"},
+                           {"target_codec", CODECS[codec(rng)]},
+                           {"job_size", size_mb},
+                           {"tenant", "tenant-" + std::to_string(n % 4)},
+                           {"priority", unit(rng) < 0.05 ? Constants::PRIORITY_HIGH : Constants::PRIORITY_NORMAL}};
+        submissions.push_back(submission);
+    }
+    return submissions;
+}
+
+std::vector<SimEngine> load_engines(const Options& options) {
+    nlohmann::json groups = nlohmann::json::array();
+    if (!options.engines_path.empty()) {
+        std::ifstream in(options.engines_path);
+        if (!in) {
+            throw std::runtime_error("cannot open engine file " + options.engines_path);
+        }
+        groups = nlohmann::json::parse(in);
+    } else {
+        groups.push_back({{"count", options.engine_count}, {"failure_rate", options.failure_rate}});
+    }
+
+    std::vector<SimEngine> engines;
+    for (const auto& group : groups) {
+        for (int i = 0; i < group.value("count", 1); ++i) {
+            SimEngine engine;
+            engine.id = "engine-" + std::to_string(engines.size());
+            engine.speed = group.value("speed", 1.0);
+            engine.failure_rate = group.value("failure_rate", 0.0);
+            for (const auto& codec : group.value("codecs", nlohmann::json::array())) {
+                engine.codecs.insert(codec.get<std::string>());
+            }
+            engine.capacity = group.value("capacity", nlohmann::json());
+            engine.slots = group.value("slots", engine.capacity.is_object() ? engine.capacity.value("slots", 1) : 1);
+            if (engine.slots > 1 && !engine.capacity.is_object()) {
+                engine.capacity = {{"slots", engine.slots}};
+            }
+            engines.push_back(engine);
+        }
+    }
+    return engines;
+}
+
+class Simulation {
+public:
+    Simulation(const Options& options, std::vector<Submission> submissions, std::vector<SimEngine> engines)
+        : options_(options), rng_(options.seed), submissions_(std::move(submissions)), engines_(std::move(engines)) {
+        // Distinct submit times keep the queue order independent of job IDs
+        for (size_t i = 1; i < submissions_.size(); ++i) {
+            submissions_[i].at_ms = std::max(submissions_[i].at_ms, submissions_[i - 1].at_ms + 1);
+        }
+
+        auto admission = std::make_shared<AdmissionController>(job_repo_);
+        admission->set_policy({options.max_pending, 0, false});
+        submit_handler_ = std::make_shared<JobSubmissionHandler>(auth_, job_repo_, nullptr,
+                                                                 options.max_pending ? admission : nullptr);
+        auto lanes = options.lanes ? std::make_shared<SizeLanes>(job_repo_, engine_repo_, SizeLanePolicy{},
+                                                                 std::chrono::milliseconds(0))
+                                   : nullptr;
+        health_ = options.health ? std::make_shared<EngineHealth>() : nullptr;
+        RetryPolicy retry_policy;
+        retry_policy.budget_per_minute = options.retry_budget;
+        retries_ = std::make_shared<RetryScheduler>(retry_policy, options.seed);
+        timeouts_ = std::make_shared<JobTimeouts>(job_repo_, estimator_, health_);
+        claim_handler_ = std::make_shared<JobAssignmentHandler>(auth_, job_repo_, engine_repo_, nullptr, nullptr,
+                                                                nullptr, nullptr, lanes, health_);
+        complete_handler_ = std::make_shared<JobCompletionHandler>(auth_, job_repo_, engine_repo_, nullptr, health_);
+        fail_handler_ = std::make_shared<JobFailureHandler>(auth_, job_repo_, engine_repo_, nullptr, health_, retries_);
+    }
+
+    nlohmann::json run() {
+        set_wall_clock_source(virtual_clock);
+        for (auto& engine : engines_) {
+            nlohmann::json record = {{"engine_id", engine.id}, {"status", "idle"}, {"last_heartbeat", EPOCH_MS}};
+            if (!engine.codecs.empty()) record["supported_codecs"] = engine.codecs;
+            if (engine.capacity.is_object()) record["capacity"] = engine.capacity;
+            engine_repo_->save_engine(engine.id, record);
+        }
+        for (size_t i = 0; i < submissions_.size(); ++i) {
+            push({submissions_[i].at_ms, 0, EventType::Arrival, i});
+        }
+        for (size_t i = 0; i < engines_.size(); ++i) {
+            schedule_poll(i, 0);
+        }
+        push({sweep_interval_ms(), 0, EventType::Sweep, 0});
+
+        int64_t give_up_ms = (submissions_.empty() ? 0 : submissions_.back().at_ms) + MAX_DRAIN_MS;
+        while (!events_.empty() && !finished() && events_.top().at_ms <= give_up_ms) {
+            Event event = events_.top();
+            events_.pop();
+            virtual_now_ms = EPOCH_MS + event.at_ms;
+            switch (event.type) {
+            case EventType::Arrival: arrive(event.index); break;
+            case EventType::Finish: finish(event); break;
+            case EventType::Poll:
+                if (event.token == engines_[event.index].poll_token) poll(event.index);
+                break;
+            case EventType::Sweep:
+                sweep();
+                push({event.at_ms + sweep_interval_ms(), 0, EventType::Sweep, 0});
+                break;
+            }
+        }
+        set_wall_clock_source(nullptr);
+        return report();
+    }
+
+private:
+    static int64_t sweep_interval_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Constants::BACKGROUND_WORKER_INTERVAL).count();
+    }
+
+    int64_t now() const { return virtual_now_ms - EPOCH_MS; }
+
+    void push(Event event) {
+        event.seq = next_seq_++;
+        events_.push(std::move(event));
+    }
+
+    bool finished() const {
+        return next_arrival_ == submissions_.size() && open_jobs_ == 0;
+    }
+
+    void schedule_poll(size_t index, int64_t at_ms) {
+        SimEngine& engine = engines_[index];
+        if (engine.running >= engine.slots) return;
+        if (engine.next_poll_ms >= 0 && engine.next_poll_ms <= at_ms) return; // An earlier poll is due
+        engine.next_poll_ms = at_ms;
+        push({at_ms, 0, EventType::Poll, index, ++engine.poll_token});
+    }
+
+    void wake_idle_engines() {
+        for (size_t i = 0; i < engines_.size(); ++i) {
+            schedule_poll(i, now());
+        }
+    }
+
+    httplib::Response call(IRequestHandler& handler, const std::string& path, const nlohmann::json& body) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "sim");
+        req.path = path;
+        if (path.rfind("/jobs/", 0) == 0) {
+            req.path_params.emplace("job_id", path.substr(6, 36));
+        }
+        req.body = body.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+
+    void arrive(size_t index) {
+        next_arrival_ = index + 1;
+        const Submission& submission = submissions_[index];
+        auto res = call(*submit_handler_, "/jobs/", submission.body);
+        if (res.status != 200) {
+            ++rejected_;
+            return;
+        }
+        std::string job_id = nlohmann::json::parse(res.body)["job_id"];
+        jobs_[job_id] = {now(), -1, -1, submission.reference_ms, submission.body.value("tenant", "")};
+        arrival_order_.push_back(job_id);
+        ++open_jobs_;
+        wake_idle_engines();
+    }
+
+    void poll(size_t index) {
+        SimEngine& engine = engines_[index];
+        engine.next_poll_ms = -1;
+        while (engine.running < engine.slots) {
+            nlohmann::json body = {{"engine_id", engine.id}};
+            if (options_.batch > 1) body["max_batch"] = options_.batch;
+            auto res = call(*claim_handler_, "/assign_job/", body);
+            if (res.status != 200) {
+                schedule_poll(index, now() + IDLE_POLL_MS);
+                return;
+            }
+            nlohmann::json assignment = nlohmann::json::parse(res.body);
+            std::vector<nlohmann::json> items;
+            if (assignment.value("type", "") == "batch") {
+                items = assignment["jobs"].get<std::vector<nlohmann::json>>();
+            } else {
+                items.push_back(assignment);
+            }
+            start(index, items);
+        }
+    }
+
+    // One slot runs the items in one ffmpeg process: the overhead is paid once
+    void start(size_t index, const std::vector<nlohmann::json>& items) {
+        SimEngine& engine = engines_[index];
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::discrete_distribution<int> kind({2, 1, 1});
+        Event finish{0, 0, EventType::Finish, index};
+        int64_t reference_ms = JOB_OVERHEAD_MS;
+        double fail_at = 1.0;
+        for (const auto& item : items) {
+            std::string job_id = item["job_id"];
+            JobRecord& record = jobs_[job_id];
+            if (record.first_assigned_ms < 0) record.first_assigned_ms = now();
+            reference_ms += std::max<int64_t>(0, record.reference_ms - JOB_OVERHEAD_MS);
+            ++assignments_;
+
+            std::string error;
+            if (!engine.codecs.empty() && !engine.codecs.count(item.value("target_codec", ""))) {
+                error = "FFmpeg transcoding failed: encoder not available";
+            } else if (unit(rng_) < engine.failure_rate) {
+                static const char* messages[] = {"FFmpeg transcoding failed", "Failed to download source video",
+                                                 "Failed to upload transcoded video"};
+                error = messages[kind(rng_)];
+                fail_at = std::min(fail_at, unit(rng_));
+            }
+            finish.job_ids.push_back(job_id);
+            finish.errors.push_back(error);
+        }
+        int64_t runtime_ms = static_cast<int64_t>(reference_ms / std::max(engine.speed, 0.01));
+        if (items.size() == 1 && !finish.errors.front().empty()) {
+            runtime_ms = static_cast<int64_t>(runtime_ms * fail_at); // Failed part-way through
+        }
+        finish.at_ms = now() + std::max<int64_t>(runtime_ms, 1);
+        engine.running += 1;
+        engine.busy_ms += finish.at_ms - now();
+        push(std::move(finish));
+    }
+
+    void finish(const Event& event) {
+        SimEngine& engine = engines_[event.index];
+        engine.running -= 1;
+        for (size_t i = 0; i < event.job_ids.size(); ++i) {
+            const std::string& job_id = event.job_ids[i];
+            nlohmann::json job = job_repo_->get_job(job_id);
+            // Timed out and handed elsewhere meanwhile: the work is wasted
+            if (job.value("status", "") != "assigned" || job.value("assigned_engine", "") != engine.id) {
+                ++abandoned_;
+                continue;
+            }
+            std::string path = "/jobs/" + job_id;
+            if (event.errors[i].empty()) {
+                estimator_->record(job, virtual_now_ms - job.value("assigned_at", virtual_now_ms));
+                call(*complete_handler_, path + "/complete", {{"engine_id", engine.id}, {"output_url", "sim://" + job_id}});
+            } else {
+                call(*fail_handler_, path + "/fail", {{"engine_id", engine.id}, {"error_message", event.errors[i]}});
+            }
+            settle(job_id);
+        }
+        schedule_poll(event.index, now());
+    }
+
+    // Counts the job out once it reaches a final state
+    void settle(const std::string& job_id) {
+        std::string status = job_repo_->get_job(job_id).value("status", "");
+        if (status == "completed" || status == "failed_permanently") {
+            jobs_[job_id].finished_ms = now();
+            --open_jobs_;
+            if (status == "failed_permanently") ++failed_;
+        }
+    }
+
+    // The server's background worker: job timeouts, then the retry requeue
+    void sweep() {
+        for (auto& [job, reason] : timeouts_->expired(virtual_now_ms)) {
+            if (health_ && job["assigned_engine"].is_string()) {
+                health_->record_failure(job["assigned_engine"], job, reason, virtual_now_ms);
+            }
+            if (job["assigned_engine"].is_string()) {
+                mark_retry_anti_affinity(job, job["assigned_engine"], virtual_now_ms);
+            }
+            retries_->schedule(job, "timeout", "Job timed out and exceeded max retries", virtual_now_ms);
+            job_repo_->save_job(job["job_id"], job);
+            ++timeouts_seen_;
+            settle(job["job_id"]);
+        }
+        if (!retries_->release_due(*job_repo_, virtual_now_ms).empty()) {
+            wake_idle_engines();
+        }
+    }
+
+    nlohmann::json report() const {
+        std::vector<int64_t> queue_ms, completion_ms;
+        std::map<std::string, std::pair<double, int>> slowdown; // tenant -> sum, count
+        int64_t first_submit = -1, last_finish = 0;
+        size_t completed = 0;
+        for (const auto& job_id : arrival_order_) { // Not by job ID, which is random
+            const JobRecord& record = jobs_.at(job_id);
+            if (first_submit < 0 || record.submitted_ms < first_submit) first_submit = record.submitted_ms;
+            last_finish = std::max(last_finish, record.finished_ms);
+            if (record.first_assigned_ms >= 0) queue_ms.push_back(record.first_assigned_ms - record.submitted_ms);
+            if (record.finished_ms < 0) continue;
+            int64_t latency = record.finished_ms - record.submitted_ms;
+            completion_ms.push_back(latency);
+            auto& tenant = slowdown[record.tenant];
+            tenant.first += static_cast<double>(latency) / std::max<int64_t>(record.reference_ms, 1);
+            tenant.second += 1;
+            ++completed;
+        }
+        completed -= failed_;
+
+        int64_t makespan = first_submit < 0 ? 0 : last_finish - first_submit;
+        int64_t busy = 0, slots = 0;
+        for (const auto& engine : engines_) {
+            busy += engine.busy_ms;
+            slots += engine.slots;
+        }
+        double sum = 0, sum_squares = 0;
+        for (const auto& [tenant, totals] : slowdown) {
+            double mean = totals.first / totals.second;
+            sum += mean;
+            sum_squares += mean * mean;
+        }
+
+        return {
+            {"seed", options_.seed},
+            {"policies", {{"size_lanes", options_.lanes}, {"engine_health", options_.health},
+                          {"max_batch", options_.batch}, {"retry_budget_per_minute", options_.retry_budget},
+                          {"max_pending", options_.max_pending}}},
+            {"engines", engines_.size()},
+            {"jobs", {{"submitted", jobs_.size()}, {"rejected", rejected_}, {"completed", completed},
+                      {"failed_permanently", failed_}, {"unfinished", open_jobs_}, {"assignments", assignments_},
+                      {"timeouts", timeouts_seen_}, {"abandoned_runs", abandoned_}}},
+            {"makespan_s", makespan / 1000.0},
+            {"queue_latency_s", {{"p50", percentile(queue_ms, 0.50) / 1000.0},
+                                 {"p90", percentile(queue_ms, 0.90) / 1000.0},
+                                 {"p99", percentile(queue_ms, 0.99) / 1000.0},
+                                 {"max", percentile(queue_ms, 1.0) / 1000.0}}},
+            {"completion_latency_s", {{"p50", percentile(completion_ms, 0.50) / 1000.0},
+                                      {"p99", percentile(completion_ms, 0.99) / 1000.0}}},
+            {"utilization", makespan > 0 ? static_cast<double>(busy) / (static_cast<double>(slots) * makespan) : 0.0},
+            {"fairness_jain", sum_squares > 0 ? sum * sum / (slowdown.size() * sum_squares) : 1.0},
+            {"retries", retries_->metrics()},
+            {"engine_health", health_ ? health_->metrics(virtual_now_ms) : nlohmann::json()}
+        };
+    }
+
+    const Options options_;
+    std::mt19937_64 rng_;
+    std::vector<Submission> submissions_;
+    std::vector<SimEngine> engines_;
+
+    std::shared_ptr<InMemoryJobRepository> job_repo_ = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo_ = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth_ = std::make_shared<AuthMiddleware>("sim");
+    std::shared_ptr<RuntimeEstimator> estimator_ = std::make_shared<RuntimeEstimator>();
+    std::shared_ptr<EngineHealth> health_;
+    std::shared_ptr<RetryScheduler> retries_;
+    std::shared_ptr<JobTimeouts> timeouts_;
+    std::shared_ptr<JobSubmissionHandler> submit_handler_;
+    std::shared_ptr<JobAssignmentHandler> claim_handler_;
+    std::shared_ptr<JobCompletionHandler> complete_handler_;
+    std::shared_ptr<JobFailureHandler> fail_handler_;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events_;
+    uint64_t next_seq_ = 0;
+    size_t next_arrival_ = 0;
+    std::map<std::string, JobRecord> jobs_;
+    std::vector<std::string> arrival_order_;
+    size_t open_jobs_ = 0;
+    size_t rejected_ = 0;
+    size_t failed_ = 0;
+    size_t assignments_ = 0;
+    size_t timeouts_seen_ = 0;
+    size_t abandoned_ = 0;
+};
+
+void print_report(const nlohmann::json& report) {
+    const auto& jobs = report["jobs"];
+    std::cout << std::fixed << std::setprecision(1)
+              << "engines " << report["engines"] << ", seed " << report["seed"] << ", policies "
+              << report["policies"].dump() << std::endl
+              << "  jobs        " << jobs["submitted"] << " submitted, " << jobs["completed"] << " completed, "
+              << jobs["failed_permanently"] << " failed, " << jobs["rejected"] << " rejected, "
+              << jobs["unfinished"] << " unfinished" << std::endl
+              << "  attempts    " << jobs["assignments"] << " assignments, " << jobs["timeouts"] << " timeouts, "
+              << jobs["abandoned_runs"] << " abandoned runs" << std::endl
+              << "  makespan    " << report["makespan_s"].get<double>() << " s" << std::endl
+              << "  queue       p50 " << report["queue_latency_s"]["p50"].get<double>()
+              << " s  p90 " << report["queue_latency_s"]["p90"].get<double>()
+              << " s  p99 " << report["queue_latency_s"]["p99"].get<double>()
+              << " s  max " << report["queue_latency_s"]["max"].get<double>() << " s" << std::endl
+              << "  completion  p50 " << report["completion_latency_s"]["p50"].get<double>()
+              << " s  p99 " << report["completion_latency_s"]["p99"].get<double>() << " s" << std::endl
+              << std::setprecision(3)
+              << "  utilization " << report["utilization"].get<double>() << std::endl
+              << "  fairness    " << report["fairness_jain"].get<double>() << " (Jain, tenant mean slowdown)"
+              << std::endl;
+}
+
+void usage(const char* program) {
+    std::cout << "Usage: " << program << " [--trace FILE | --jobs N] [OPTIONS]" << std::endl
+              << "  --trace FILE          JSONL of POST /jobs/ bodies with submit_at (s) and optional runtime_s" << std::endl
+              << "  --jobs N              Generated workload size (default: 1000)" << std::endl
+              << "  --arrival-rate R      Generated arrivals per minute (default: 6)" << std::endl
+              << "  --seed S              Random seed (default: 42)" << std::endl
+              << "  --engines FILE        JSON array of {count, speed, failure_rate, codecs, slots, capacity}" << std::endl
+              << "  --engine-count N      Speed 1.0 engines when no file is given (default: 8)" << std::endl
+              << "  --failure-rate F      Their failure rate (default: 0.01)" << std::endl
+              << "  --lanes               Size-class lanes" << std::endl
+              << "  --health              Engine health and quarantine" << std::endl
+              << "  --batch N             Engines ask for batches of up to N small jobs" << std::endl
+              << "  --retry-budget N      Retries requeued per minute (default: 60; 0 = unlimited)" << std::endl
+              << "  --max-pending N       Admission control pending limit" << std::endl
+              << "  --json                Print the report as JSON" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        try {
+            if (arg == "--trace" && has_value) options.trace_path = argv[++i];
+            else if (arg == "--jobs" && has_value) options.jobs = std::stoul(argv[++i]);
+            else if (arg == "--arrival-rate" && has_value) options.arrivals_per_minute = std::stod(argv[++i]);
+            else if (arg == "--seed" && has_value) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--engines" && has_value) options.engines_path = argv[++i];
+            else if (arg == "--engine-count" && has_value) options.engine_count = std::stoi(argv[++i]);
+            else if (arg == "--failure-rate" && has_value) options.failure_rate = std::stod(argv[++i]);
+            else if (arg == "--lanes") options.lanes = true;
+            else if (arg == "--health") options.health = true;
+            else if (arg == "--batch" && has_value) options.batch = std::stoul(argv[++i]);
+            else if (arg == "--retry-budget" && has_value) options.retry_budget = std::stoul(argv[++i]);
+            else if (arg == "--max-pending" && has_value) options.max_pending = std::stoul(argv[++i]);
+            else if (arg == "--json") options.json = true;
+            else {
+                usage(argv[0]);
+                return arg == "--help" ? 0 : 1;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (options.arrivals_per_minute <= 0) {
+        std::cerr << "--arrival-rate must be positive" << std::endl;
+        return 1;
+    }
+
+    try {
+        std::mt19937_64 workload_rng(options.seed);
+        auto submissions = options.trace_path.empty() ? generate_workload(options, workload_rng)
+                                                      : load_trace(options.trace_path);
+        Simulation simulation(options, std::move(submissions), load_engines(options));
+        nlohmann::json report = simulation.run();
+        if (options.json) {
+            std::cout << report.dump(2) << std::endl;
+        } else {
+            print_report(report);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Simulation failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -62,3 +62,205 @@ TEST(ServerConfigTest, HandlesMissingValues) {
     // Should remain default because check fails
     EXPECT_EQ(config.port, 8080);
 }
+
+TEST(ServerConfigTest, ParsesAdmissionLimits) {
+    std::vector<std::string> args = {"program", "--max-pending", "5000", "--max-pending-per-tenant", "500",
+                                     "--soft-admission"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.max_pending_jobs, 5000u);
+    EXPECT_EQ(config.max_pending_jobs_per_tenant, 500u);
+    EXPECT_TRUE(config.soft_admission_limits);
+}
+
+TEST(ServerConfigTest, RejectsNegativeAdmissionLimit) {
+    std::vector<std::string> args = {"program", "--max-pending", "-1"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_TRUE(config.parse_error);
+}
+
+TEST(ServerConfigTest, ParsesSizeLaneReserves) {
+    std::vector<std::string> args = {"program", "--small-lane-reserve", "0.3", "--large-lane-reserve", "0"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_DOUBLE_EQ(config.small_lane_reserve, 0.3);
+    EXPECT_DOUBLE_EQ(config.large_lane_reserve, 0.0);
+
+    std::vector<std::string> bad = {"program", "--small-lane-reserve", "1.5"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesQuarantineFailureRate) {
+    std::vector<std::string> args = {"program", "--quarantine-failure-rate", "0.25"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_DOUBLE_EQ(config.quarantine_failure_rate, 0.25);
+
+    std::vector<std::string> bad = {"program", "--quarantine-failure-rate", "0"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesProgressStallTimeout) {
+    std::vector<std::string> args = {"program", "--progress-stall-timeout", "90"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.progress_stall_seconds, 90);
+
+    std::vector<std::string> bad = {"program", "--progress-stall-timeout", "-1"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesRetryBudget) {
+    std::vector<std::string> args = {"program", "--retry-budget", "0"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.retry_budget_per_minute, 0u);
+
+    std::vector<std::string> bad = {"program", "--retry-budget", "many"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesIoThreads) {
+    std::vector<std::string> args = {"program", "--io-threads", "0"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.io_threads, 0u);
+
+    std::vector<std::string> bad = {"program", "--io-threads", "-2"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesCompressionSettings) {
+    std::vector<std::string> args = {"program", "--compression-level", "0", "--compression-min-bytes", "4096"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.compression_level, 0);
+    EXPECT_EQ(config.compression_min_bytes, 4096u);
+
+    std::vector<std::string> bad = {"program", "--compression-level", "12"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesTraceExport) {
+    std::vector<std::string> args = {"program", "--trace-file", "/tmp/spans.jsonl",
+                                     "--trace-endpoint", "http://localhost:4318/v1/traces"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+    
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.trace_file, "/tmp/spans.jsonl");
+    EXPECT_EQ(config.trace_endpoint, "http://localhost:4318/v1/traces");
+
+    std::vector<std::string> bad = {"program", "--trace-endpoint", "localhost:4318"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesLogOptions) {
+    std::vector<std::string> args = {"program", "--log-file", "/var/log/dispatch.log", "--log-level", "WARN",
+                                     "--log-modules", "scheduler=debug,redis=off", "--log-max-bytes", "1048576",
+                                     "--log-max-files", "3"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.log.path, "/var/log/dispatch.log");
+    EXPECT_EQ(config.log.level, distconv::logging::Level::Warn);
+    EXPECT_EQ(config.log.module_levels.at("scheduler"), distconv::logging::Level::Debug);
+    EXPECT_EQ(config.log.module_levels.at("redis"), distconv::logging::Level::Off);
+    EXPECT_EQ(config.log.max_file_bytes, 1048576u);
+    EXPECT_EQ(config.log.max_files, 3);
+
+    for (std::vector<std::string> bad : {std::vector<std::string>{"program", "--log-level", "verbose"},
+                                         std::vector<std::string>{"program", "--log-modules", "scheduler"},
+                                         std::vector<std::string>{"program", "--log-max-bytes", "-1"}}) {
+        argv.clear();
+        for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+        EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error) << bad[1];
+    }
+}
+
+TEST(ServerConfigTest, ParsesHandoffOptions) {
+    std::vector<std::string> args = {"program", "--handoff-socket", "/run/distconv/dispatch.sock",
+                                     "--drain-timeout", "10"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.handoff_socket, "/run/distconv/dispatch.sock");
+    EXPECT_EQ(config.drain_timeout_seconds, 10);
+
+    std::vector<std::string> bad = {"program", "--drain-timeout", "-1"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
+
+TEST(ServerConfigTest, ParsesStateSnapshotOptions) {
+    std::vector<std::string> args = {"program", "--state-snapshot", "/var/lib/distconv/dispatch.snapshot",
+                                     "--snapshot-interval", "0"};
+    std::vector<char*> argv;
+    for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+
+    ServerConfig config = parse_arguments(argv.size(), argv.data());
+
+    EXPECT_FALSE(config.parse_error);
+    EXPECT_EQ(config.state_snapshot_path, "/var/lib/distconv/dispatch.snapshot");
+    EXPECT_EQ(config.snapshot_interval_seconds, 0);
+
+    std::vector<std::string> bad = {"program", "--snapshot-interval", "often"};
+    argv.clear();
+    for (const auto& arg : bad) argv.push_back(const_cast<char*>(arg.c_str()));
+    EXPECT_TRUE(parse_arguments(argv.size(), argv.data()).parse_error);
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "assignment_handler.h"
+#include "repositories.h"
+#include "size_lanes.h"
+#include "nlohmann/json.hpp"
+
+using namespace distconv::DispatchServer;
+
+// Mixed workload in simulated time (1 s ticks): short clips arrive steadily
+// while batches of long masters land at the top of each hour. Jobs are claimed
+// through JobAssignmentHandler, with and without size-class lanes, and the
+// completion latency (finish - submit) is reported per lane.
+
+namespace {
+
+constexpr int ENGINES = 16;
+constexpr int64_t HORIZON_S = 4 * 3600;
+constexpr int CLIP_EVERY_S = 10;
+constexpr double CLIP_MB = 10.0;
+constexpr int64_t CLIP_RUNTIME_S = 20;
+constexpr int MASTERS_PER_BATCH = 24;
+constexpr double MASTER_MB = 51200.0;
+constexpr int64_t MASTER_RUNTIME_S = 1800;
+
+struct Running {
+    std::string job_id;
+    int64_t finish = 0;
+};
+
+std::string job_id(int n) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08d-0000-0000-0000-000000000000", n);
+    return id;
+}
+
+int64_t percentile(std::vector<int64_t> samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t index = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+std::map<std::string, std::vector<int64_t>> simulate(bool with_lanes) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    auto auth = std::make_shared<AuthMiddleware>("bench");
+    auto lanes = with_lanes ? std::make_shared<SizeLanes>(job_repo, engine_repo, SizeLanePolicy{},
+                                                          std::chrono::milliseconds(0))
+                            : nullptr;
+    JobAssignmentHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, nullptr, nullptr, lanes);
+
+    std::vector<Running> engines(ENGINES);
+    for (int i = 0; i < ENGINES; ++i) {
+        std::string engine_id = "engine-" + std::to_string(i);
+        engine_repo->save_engine(engine_id, {{"engine_id", engine_id}, {"status", "idle"}});
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> jitter(-CLIP_RUNTIME_S / 4, CLIP_RUNTIME_S / 4);
+    std::map<std::string, int64_t> submitted;
+    std::map<std::string, int64_t> runtime;
+    std::map<std::string, std::vector<int64_t>> latency;
+    int next = 0;
+    auto submit = [&](int64_t t, double size_mb, int64_t runtime_s) {
+        std::string id = job_id(next++);
+        job_repo->save_job(id, {{"job_id", id}, {"status", "pending"}, {"priority", 0}, {"job_size", size_mb},
+                                {"size_class", size_class_name(classify_job_size(size_mb))}, {"created_at", t}});
+        submitted[id] = t;
+        runtime[id] = runtime_s;
+    };
+
+    for (int64_t t = 0; t < HORIZON_S || submitted.size() > 0; ++t) {
+        for (int i = 0; i < ENGINES; ++i) {
+            auto& slot = engines[i];
+            if (!slot.job_id.empty() && slot.finish <= t) {
+                nlohmann::json job = job_repo->get_job(slot.job_id);
+                latency[job["size_class"]].push_back(t - submitted[slot.job_id]);
+                submitted.erase(slot.job_id);
+                job["status"] = "completed";
+                job_repo->save_job(slot.job_id, job);
+                slot.job_id.clear();
+            }
+        }
+        if (t < HORIZON_S) {
+            if (t % 3600 == 0) {
+                for (int m = 0; m < MASTERS_PER_BATCH; ++m) submit(t, MASTER_MB, MASTER_RUNTIME_S);
+            }
+            if (t % CLIP_EVERY_S == 0) {
+                submit(t, CLIP_MB, CLIP_RUNTIME_S + jitter(rng));
+            }
+        }
+        for (int i = 0; i < ENGINES; ++i) {
+            if (!engines[i].job_id.empty()) continue;
+            httplib::Request req;
+            req.headers.emplace("X-API-Key", "bench");
+            req.body = nlohmann::json{{"engine_id", "engine-" + std::to_string(i)}}.dump();
+            httplib::Response res;
+            handler.handle(req, res);
+            if (res.status != 200) break; // Nothing claimable for anyone this tick
+            std::string id = nlohmann::json::parse(res.body)["job_id"];
+            engines[i] = {id, t + runtime[id]};
+        }
+    }
+    return latency;
+}
+
+void report(const std::string& name, const std::map<std::string, std::vector<int64_t>>& latency) {
+    std::cout << name << std::endl;
+    for (const auto& [lane, samples] : latency) {
+        std::cout << "  " << std::left << std::setw(6) << lane << std::right
+                  << " jobs " << std::setw(5) << samples.size()
+                  << "  p50 " << std::setw(6) << percentile(samples, 0.50) << " s"
+                  << "  p99 " << std::setw(6) << percentile(samples, 0.99) << " s" << std::endl;
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << ENGINES << " engines, a clip (" << CLIP_MB << " MB, ~" << CLIP_RUNTIME_S << " s) every "
+              << CLIP_EVERY_S << " s, " << MASTERS_PER_BATCH << " masters (" << MASTER_MB << " MB, "
+              << MASTER_RUNTIME_S << " s) every hour" << std::endl;
+    report("Queue order (no lanes):", simulate(false));
+    report("Size-class lanes (default reserves):", simulate(true));
+    return 0;
+}
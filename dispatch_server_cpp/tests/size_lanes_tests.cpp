@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../repositories.h"
+#include "../size_lanes.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::string job_id(int n) {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08d-0000-0000-0000-000000000000", n);
+    return id;
+}
+
+} // namespace
+
+class SizeLanesTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::shared_ptr<SizeLanes> lanes = std::make_shared<SizeLanes>(job_repo, engine_repo, SizeLanePolicy{}, 0ms);
+    int next_job = 0;
+
+    void add_engines(int count) {
+        for (int i = 0; i < count; ++i) {
+            std::string engine_id = "engine-" + std::to_string(i);
+            engine_repo->save_engine(engine_id, {{"engine_id", engine_id}, {"status", "idle"}});
+        }
+    }
+
+    std::string add_job(double size_mb, const std::string& status = "pending") {
+        int n = next_job++;
+        nlohmann::json job = {{"job_id", job_id(n)}, {"status", status}, {"priority", 0}, {"job_size", size_mb},
+                              {"size_class", size_class_name(classify_job_size(size_mb))}, {"created_at", n}};
+        job_repo->save_job(job_id(n), job);
+        return job_id(n);
+    }
+
+    nlohmann::json claim(std::shared_ptr<SizeLanes> size_lanes) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, nullptr, nullptr, size_lanes);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", "engine-0"}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res.status == 200 ? nlohmann::json::parse(res.body) : nlohmann::json(nullptr);
+    }
+};
+
+TEST_F(SizeLanesTest, ClassifiesByJobSizeThresholds) {
+    EXPECT_EQ(classify_job_size(10), SizeClass::Small);
+    EXPECT_EQ(classify_job_size(50), SizeClass::Medium);
+    EXPECT_EQ(classify_job_size(0), SizeClass::Medium); // No size given
+    EXPECT_EQ(classify_job_size(51200), SizeClass::Large);
+    EXPECT_EQ(size_class_of({{"job_size", 10.0}}), SizeClass::Small);
+    EXPECT_EQ(size_class_of({{"job_size", 10.0}, {"size_class", "large"}}), SizeClass::Large);
+}
+
+TEST_F(SizeLanesTest, SmallJobPassesQueuedMastersForItsReservedSlot) {
+    add_engines(5);
+    for (int i = 0; i < 4; ++i) add_job(51200, "assigned");
+    for (int i = 0; i < 40; ++i) add_job(51200); // Deeper than the claim path's scan window
+    std::string clip = add_job(10);
+
+    auto job = claim(lanes);
+    ASSERT_FALSE(job.is_null());
+    EXPECT_EQ(job["job_id"], clip);
+
+    // Without lanes the queue head wins
+    EXPECT_EQ(claim(nullptr)["size_class"], "large");
+}
+
+TEST_F(SizeLanesTest, IdleLaneReservationIsStolen) {
+    add_engines(5);
+    for (int i = 0; i < 4; ++i) add_job(51200, "assigned");
+    std::string master = add_job(51200);
+
+    EXPECT_EQ(claim(lanes)["job_id"], master);
+}
+
+TEST_F(SizeLanesTest, MastersKeepTheirShareUnderAClipFlood) {
+    add_engines(5);
+    for (int i = 0; i < 4; ++i) add_job(10, "assigned");
+    for (int i = 0; i < 100; ++i) add_job(10);
+    std::string master = add_job(51200);
+
+    EXPECT_EQ(claim(lanes)["job_id"], master);
+    EXPECT_EQ(lanes->metrics(0)["large"]["claimed"], 1);
+}
+
+TEST_F(SizeLanesTest, OversizedReservationsFallBackToQueueOrder) {
+    add_engines(1);
+    lanes->set_policy({{0.5, 0.0, 0.5}});
+    std::string master = add_job(51200);
+    add_job(10);
+
+    LaneSet open = lanes->open_lanes(0);
+    EXPECT_FALSE(open.restricted);
+    EXPECT_EQ(claim(lanes)["job_id"], master);
+}
+
+TEST_F(SizeLanesTest, RepositoryListsPendingJobsOfAClassInQueueOrder) {
+    std::string first = add_job(10);
+    add_job(51200);
+    add_job(10, "assigned");
+    std::string second = add_job(20);
+
+    auto small = job_repo->get_pending_jobs_by_size_class("small", 10);
+    ASSERT_EQ(small.size(), 2u);
+    EXPECT_EQ(small[0]["job_id"], first);
+    EXPECT_EQ(small[1]["job_id"], second);
+    EXPECT_EQ(job_repo->get_pending_jobs_by_size_class("small", 1).size(), 1u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "../dispatch_server_core.h"
+#include "../repositories.h"
+#include "../socket_handoff.h"
+#include "http_test_utils.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+template <typename Predicate>
+bool eventually(Predicate predicate) {
+    for (int i = 0; i < 400 && !predicate(); ++i) {
+        std::this_thread::sleep_for(5ms);
+    }
+    return predicate();
+}
+
+class SocketHandoffTest : public ::testing::Test {
+protected:
+    void SetUp() override { std::filesystem::remove(path_); }
+    void TearDown() override { std::filesystem::remove(path_); }
+
+    std::unique_ptr<DispatchServer> make_server() {
+        auto server = std::make_unique<DispatchServer>(job_repo_, engine_repo_, "test_key");
+        server->set_event_loop({});
+        return server;
+    }
+
+    const std::string path_ = "socket_handoff_test.sock";
+    std::shared_ptr<InMemoryJobRepository> job_repo_ = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo_ = std::make_shared<InMemoryEngineRepository>();
+};
+
+} // namespace
+
+TEST_F(SocketHandoffTest, NoPredecessorIsNotAnError) {
+    EXPECT_EQ(take_listen_socket(path_).listen_fd, -1);
+
+    // A socket file left by a process that is gone
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, path_.c_str());
+    ASSERT_EQ(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    close(fd);
+    ASSERT_TRUE(std::filesystem::exists(path_));
+    EXPECT_EQ(take_listen_socket(path_).listen_fd, -1);
+}
+
+TEST_F(SocketHandoffTest, SuccessorServesTheSamePortBeforeThePredecessorDrains) {
+    auto predecessor = make_server();
+    predecessor->start(0, false);
+    const int port = predecessor->get_port();
+    ASSERT_GT(port, 0);
+
+    std::atomic<bool> handed_off{false};
+    auto offer = std::make_unique<HandoffListener>(path_, predecessor->listen_socket(),
+                                                   [&handed_off]() { handed_off = true; });
+    ASSERT_TRUE(offer->listening());
+
+    HandoffTakeover takeover = take_listen_socket(path_);
+    ASSERT_GE(takeover.listen_fd, 0);
+    auto successor = make_server();
+    successor->set_listen_socket(takeover.listen_fd);
+    successor->start(0, false);
+    EXPECT_EQ(successor->get_port(), port);
+
+    EXPECT_FALSE(handed_off.load());
+    ASSERT_TRUE(confirm_handoff(takeover));
+    ASSERT_TRUE(eventually([&]() { return handed_off.load(); }));
+
+    predecessor->drain(5s);
+    offer.reset();
+    HandoffListener next(path_, successor->listen_socket(), nullptr);
+    EXPECT_TRUE(next.listening());
+
+    // The port never stopped accepting; the successor answers on it now
+    httplib::Client client("127.0.0.1", port);
+    auto res = with_connect_retry([&] { return client.Get("/health"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 200);
+    successor->stop();
+}
+
+TEST_F(SocketHandoffTest, UnconfirmedTakeoverLeavesThePredecessorServing) {
+    auto predecessor = make_server();
+    predecessor->start(0, false);
+
+    std::atomic<bool> handed_off{false};
+    {
+        HandoffListener offer(path_, predecessor->listen_socket(), [&handed_off]() { handed_off = true; });
+
+        // A successor that dies before serving
+        HandoffTakeover takeover = take_listen_socket(path_);
+        ASSERT_GE(takeover.listen_fd, 0);
+        close(takeover.listen_fd);
+        close(takeover.channel_fd);
+
+        // The offer stands for the next attempt
+        HandoffTakeover retry = take_listen_socket(path_);
+        ASSERT_GE(retry.listen_fd, 0);
+        close(retry.listen_fd);
+        close(retry.channel_fd);
+        EXPECT_FALSE(offer.handed_off());
+    }
+    EXPECT_FALSE(handed_off.load());
+    // Without a handoff the listener cleans up after itself
+    EXPECT_FALSE(std::filesystem::exists(path_));
+
+    httplib::Client client("127.0.0.1", predecessor->get_port());
+    auto res = with_connect_retry([&] { return client.Get("/health"); });
+    ASSERT_TRUE(res);
+    EXPECT_EQ(res->status, 200);
+    predecessor->stop();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../engine_handlers.h"
+#include "../repositories.h"
+#include "../source_cache_index.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+using namespace distconv::DispatchServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Builds a heartbeat "source_cache" summary the way engines do
+nlohmann::json make_summary(const std::vector<std::string>& urls, uint32_t m = 512, uint32_t k = 4) {
+    std::vector<uint8_t> bits((m + 7) / 8, 0);
+    for (const auto& url : urls) {
+        uint64_t hash = source_url_hash(url);
+        uint64_t h1 = hash & 0xffffffffULL;
+        uint64_t h2 = (hash >> 32) | 1;
+        for (uint32_t i = 0; i < k; ++i) {
+            uint64_t bit = (h1 + i * h2) % m;
+            bits[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+        }
+    }
+    std::string hex;
+    char buf[3];
+    for (uint8_t byte : bits) {
+        std::snprintf(buf, sizeof(buf), "%02x", byte);
+        hex += buf;
+    }
+    return {{"m", m}, {"k", k}, {"bits", hex}};
+}
+
+const std::string kLocalJob = "33333333-3333-3333-3333-333333333333";
+const std::string kOtherJob = "44444444-4444-4444-4444-444444444444";
+
+} // namespace
+
+TEST(SourceCacheFilterTest, MatchesAdvertisedUrlsAndRejectsMalformedSummaries) {
+    auto filter = SourceCacheFilter::from_json(make_summary({"http://media/a.mkv", "http://media/b.mkv"}));
+    ASSERT_TRUE(filter);
+    EXPECT_TRUE(filter->might_contain(source_url_hash("http://media/a.mkv")));
+    EXPECT_TRUE(filter->might_contain(source_url_hash("http://media/b.mkv")));
+    EXPECT_FALSE(filter->might_contain(source_url_hash("http://media/c.mkv")));
+
+    auto truncated = make_summary({"http://media/a.mkv"});
+    truncated["bits"] = truncated["bits"].get<std::string>().substr(2);
+    EXPECT_FALSE(SourceCacheFilter::from_json(truncated));
+    EXPECT_FALSE(SourceCacheFilter::from_json({{"m", 0}, {"k", 4}, {"bits", ""}}));
+    EXPECT_FALSE(SourceCacheFilter::from_json(nlohmann::json::object()));
+}
+
+class SourceLocalityTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<SourceCacheIndex> index = std::make_shared<SourceCacheIndex>(200ms, 5min);
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::unique_ptr<JobAssignmentHandler> assigner;
+
+    void SetUp() override {
+        assigner = std::make_unique<JobAssignmentHandler>(auth, job_repo, engine_repo, nullptr, index);
+        for (const char* id : {"engine-1", "engine-2"}) {
+            engine_repo->save_engine(id, {{"engine_id", id}, {"status", "idle"}});
+        }
+        job_repo->save_job(kOtherJob, {{"job_id", kOtherJob}, {"status", "pending"}, {"created_at", 1},
+                                       {"source_url", "http://media/other.mkv"}});
+        job_repo->save_job(kLocalJob, {{"job_id", kLocalJob}, {"status", "pending"}, {"created_at", 2},
+                                       {"source_url", "http://media/local.mkv"}});
+    }
+
+    httplib::Response claim(const std::string& engine_id) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", engine_id}}.dump();
+        httplib::Response res;
+        assigner->handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(SourceLocalityTest, EnginePrefersJobWhoseSourceItCaches) {
+    index->update("engine-2", make_summary({"http://media/local.mkv"}));
+
+    auto res = claim("engine-2");
+    ASSERT_EQ(res.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["job_id"], kLocalJob);
+}
+
+TEST_F(SourceLocalityTest, OtherEnginesWaitBoundedTimeBeforeTakingHeldJob) {
+    index->update("engine-2", make_summary({"http://media/local.mkv"}));
+    job_repo->remove_job(kOtherJob);
+
+    EXPECT_EQ(claim("engine-1").status, 204);
+
+    std::this_thread::sleep_for(250ms);
+    auto res = claim("engine-1");
+    ASSERT_EQ(res.status, 200);
+    EXPECT_EQ(nlohmann::json::parse(res.body)["job_id"], kLocalJob);
+}
+
+TEST_F(SourceLocalityTest, HeartbeatFeedsIndexWithoutStoringFilter) {
+    EngineHeartbeatHandler heartbeat(auth, engine_repo, index);
+    httplib::Request req;
+    req.headers.emplace("X-API-Key", "test_key");
+    req.body = nlohmann::json{{"engine_id", "engine-2"}, {"status", "idle"},
+                              {"source_cache", make_summary({"http://media/local.mkv"})}}.dump();
+    httplib::Response res;
+    heartbeat.handle(req, res);
+
+    EXPECT_TRUE(index->engine_holds("engine-2", "http://media/local.mkv"));
+    EXPECT_TRUE(index->held_elsewhere("engine-1", "http://media/local.mkv"));
+    EXPECT_FALSE(engine_repo->get_engine("engine-2").contains("source_cache"));
+}
+
+TEST(AssignmentWaiterPreferenceTest, WakesCachingEngineAheadOfLongerParkedOne) {
+    auto index = std::make_shared<SourceCacheIndex>(20s, 5min);
+    index->update("engine-2", make_summary({"http://media/local.mkv"}));
+
+    AssignmentWaiterRegistry registry(4);
+    registry.set_preference([index](const std::string& engine_id, const nlohmann::json& job) {
+        return index->engine_holds(engine_id, job.value("source_url", ""));
+    });
+    auto first = registry.register_waiter({}, "engine-1");
+    auto holder = registry.register_waiter({}, "engine-2");
+
+    EXPECT_TRUE(registry.notify_job_available({{"source_url", "http://media/local.mkv"}}));
+    auto deadline = std::chrono::steady_clock::now() + 50ms;
+    EXPECT_TRUE(registry.wait(holder, deadline));
+    EXPECT_FALSE(registry.wait(first, deadline));
+
+    EXPECT_TRUE(registry.notify_job_available({{"source_url", "http://media/uncached.mkv"}}));
+    EXPECT_TRUE(registry.wait(first, std::chrono::steady_clock::now() + 50ms));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../assignment_handler.h"
+#include "../engine_channel_handler.h"
+#include "../job_action_handlers.h"
+#include "../repositories.h"
+#include "../speculation.h"
+#include <chrono>
+#include <memory>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const std::string kStraggler = "55555555-5555-5555-5555-555555555555";
+const std::string kSecondStraggler = "66666666-6666-6666-6666-666666666666";
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+class SpeculationTest : public ::testing::Test {
+protected:
+    std::shared_ptr<InMemoryJobRepository> job_repo = std::make_shared<InMemoryJobRepository>();
+    std::shared_ptr<InMemoryEngineRepository> engine_repo = std::make_shared<InMemoryEngineRepository>();
+    std::shared_ptr<AuthMiddleware> auth = std::make_shared<AuthMiddleware>("test_key");
+    std::shared_ptr<SpeculationManager> speculation;
+
+    void SetUp() override {
+        SpeculationPolicy policy;
+        policy.max_engine_share = 1.0;
+        policy.max_active = 1;
+        speculation = std::make_shared<SpeculationManager>(job_repo, engine_repo, policy);
+
+        // Five h264 jobs took one second each
+        int64_t now = now_ms();
+        for (int i = 0; i < 5; ++i) {
+            nlohmann::json done = {{"job_id", "done-" + std::to_string(i)}, {"target_codec", "h264"},
+                                   {"assigned_at", now - 1000}};
+            speculation->resolve_completion(done, "", now);
+        }
+
+        engine_repo->save_engine("slow", {{"engine_id", "slow"}, {"status", "busy"}, {"benchmark_time", 50.0},
+                                          {"current_job_id", kStraggler}});
+        engine_repo->save_engine("fast", {{"engine_id", "fast"}, {"status", "idle"}, {"benchmark_time", 10.0}});
+        engine_repo->save_engine("slower", {{"engine_id", "slower"}, {"status", "idle"}, {"benchmark_time", 90.0}});
+        add_running_job(kStraggler, "slow", now - 5000, 20);
+    }
+
+    void add_running_job(const std::string& job_id, const std::string& engine, int64_t assigned_at, int progress) {
+        job_repo->save_job(job_id, {{"job_id", job_id}, {"status", "processing"}, {"target_codec", "h264"},
+                                    {"assigned_engine", engine}, {"assigned_at", assigned_at},
+                                    {"progress", progress}, {"created_at", 1}});
+    }
+
+    httplib::Response claim(const std::string& engine_id) {
+        JobAssignmentHandler handler(auth, job_repo, engine_repo, nullptr, nullptr, speculation);
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.body = nlohmann::json{{"engine_id", engine_id}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+
+    httplib::Response report(IRequestHandler& handler, const std::string& action, const std::string& engine_id) {
+        httplib::Request req;
+        req.headers.emplace("X-API-Key", "test_key");
+        req.path = "/jobs/" + kStraggler + "/" + action;
+        req.path_params.emplace("job_id", kStraggler);
+        req.body = nlohmann::json{{"engine_id", engine_id}, {"output_url", "http://out/" + engine_id}}.dump();
+        httplib::Response res;
+        handler.handle(req, res);
+        return res;
+    }
+};
+
+TEST_F(SpeculationTest, StragglerGetsCopyOnlyOnFasterIdleEngine) {
+    speculation->scan(now_ms());
+    EXPECT_EQ(speculation->queued_stragglers(), 1u);
+
+    EXPECT_EQ(claim("slower").status, 204);
+
+    auto res = claim("fast");
+    ASSERT_EQ(res.status, 200);
+    auto copy = nlohmann::json::parse(res.body);
+    EXPECT_EQ(copy["job_id"], kStraggler);
+    EXPECT_TRUE(copy["speculative"].get<bool>());
+
+    auto job = job_repo->get_job(kStraggler);
+    EXPECT_EQ(job["assigned_engine"], "slow");
+    EXPECT_EQ(job["speculation"]["engine"], "fast");
+    EXPECT_EQ(job["speculation"]["state"], "running");
+    EXPECT_EQ(engine_repo->get_engine("fast")["current_job_id"], kStraggler);
+}
+
+TEST_F(SpeculationTest, FirstCompletionWinsAndLoserIsCancelled) {
+    speculation->scan(now_ms());
+    ASSERT_EQ(claim("fast").status, 200);
+
+    JobCompletionHandler complete(auth, job_repo, engine_repo, speculation);
+    EXPECT_EQ(report(complete, "complete", "fast").status, 200);
+    EXPECT_EQ(report(complete, "complete", "slow").status, 409);
+
+    auto job = job_repo->get_job(kStraggler);
+    EXPECT_EQ(job["status"], "completed");
+    EXPECT_EQ(job["output_url"], "http://out/fast");
+    EXPECT_EQ(job["speculation"]["winner"], "fast");
+    EXPECT_EQ(engine_repo->get_engine("fast")["status"], "idle");
+    EXPECT_EQ(engine_repo->get_engine("slow")["status"], "idle");
+
+    EngineChannelHandler channel(auth, job_repo, engine_repo, nullptr, nullptr, speculation);
+    httplib::Request req;
+    req.headers.emplace("X-API-Key", "test_key");
+    req.body = nlohmann::json{{"engine_id", "slow"}, {"active_jobs", {kStraggler}}}.dump();
+    httplib::Response res;
+    channel.handle(req, res);
+    auto frames = nlohmann::json::parse(res.body)["frames"];
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0]["type"], "cancel");
+    EXPECT_EQ(frames[0]["reason"], "completed");
+}
+
+TEST_F(SpeculationTest, FailuresEndOneCopyWithoutFailingTheJob) {
+    speculation->scan(now_ms());
+    ASSERT_EQ(claim("fast").status, 200);
+
+    // The primary gives up: the copy takes over the job
+    JobFailureHandler fail(auth, job_repo, engine_repo, speculation);
+    EXPECT_EQ(report(fail, "fail", "slow").status, 200);
+    auto job = job_repo->get_job(kStraggler);
+    EXPECT_EQ(job["status"], "processing");
+    EXPECT_EQ(job["assigned_engine"], "fast");
+    EXPECT_EQ(job["speculation"]["state"], "promoted");
+    EXPECT_EQ(speculation->active_copies(), 0u);
+
+    // The per-job budget is spent, so no second copy is launched
+    speculation->scan(now_ms());
+    EXPECT_EQ(speculation->queued_stragglers(), 0u);
+}
+
+TEST_F(SpeculationTest, GlobalBudgetCapsRunningCopies) {
+    engine_repo->save_engine("fast-2", {{"engine_id", "fast-2"}, {"status", "idle"}, {"benchmark_time", 10.0}});
+    add_running_job(kSecondStraggler, "slow", now_ms() - 8000, 10);
+
+    speculation->scan(now_ms());
+    EXPECT_EQ(speculation->queued_stragglers(), 2u);
+    ASSERT_EQ(claim("fast").status, 200);
+    EXPECT_EQ(claim("fast-2").status, 204);
+    EXPECT_EQ(speculation->active_copies(), 1u);
+}
+
+TEST_F(SpeculationTest, JobsRunningNearTheMedianAreLeftAlone) {
+    add_running_job(kSecondStraggler, "slow", now_ms() - 1500, 80);
+    job_repo->remove_job(kStraggler);
+
+    speculation->scan(now_ms());
+    EXPECT_EQ(speculation->queued_stragglers(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
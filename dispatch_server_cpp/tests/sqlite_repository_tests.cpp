@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "../repositories.h"
 #include "nlohmann/json.hpp"
+#include <sqlite3.h>
 #include <filesystem>
 #include <vector>
 #include <thread>
@@ -111,6 +112,76 @@ TEST_F(SqliteJobRepositoryTest, GetNextPendingJobPriority) {
     ASSERT_EQ(next["job_id"], "job1");
 }
 
+TEST_F(SqliteJobRepositoryTest, CountJobsByTenant) {
+    repo->save_job("job1", {{"job_id", "job1"}, {"status", "pending"}, {"tenant", "acme"}});
+    repo->save_job("job2", {{"job_id", "job2"}, {"status", "pending"}, {"tenant", "acme"}});
+    repo->save_job("job3", {{"job_id", "job3"}, {"status", "pending"}});
+    repo->save_job("job4", {{"job_id", "job4"}, {"status", "assigned"}, {"tenant", "acme"}});
+
+    auto counts = repo->count_jobs_by_tenant("pending");
+    ASSERT_EQ(counts.size(), 2u);
+    EXPECT_EQ(counts["acme"], 2u);
+    EXPECT_EQ(counts[""], 1u);
+}
+
+TEST_F(SqliteJobRepositoryTest, DeadlineJobsOrderedByLatestStartWithinPriority) {
+    repo->save_job("plain", {{"job_id", "plain"}, {"status", "pending"}, {"priority", 0}});
+    repo->save_job("late", {{"job_id", "late"}, {"status", "pending"}, {"priority", 0}, {"latest_start", 5000}});
+    repo->save_job("early", {{"job_id", "early"}, {"status", "pending"}, {"priority", 0}, {"latest_start", 1000}});
+    repo->save_job("high", {{"job_id", "high"}, {"status", "pending"}, {"priority", 1}});
+
+    auto pending = repo->get_pending_jobs(10);
+    ASSERT_EQ(pending.size(), 4u);
+    EXPECT_EQ(pending[0]["job_id"], "high");
+    EXPECT_EQ(pending[1]["job_id"], "early");
+    EXPECT_EQ(pending[2]["job_id"], "late");
+    EXPECT_EQ(pending[3]["job_id"], "plain");
+    EXPECT_EQ(repo->get_next_pending_job({})["job_id"], "high");
+}
+
+TEST_F(SqliteJobRepositoryTest, AddsLatestStartColumnToOlderDatabases) {
+    delete repo;
+    std::filesystem::remove(db_path);
+    sqlite3* db = nullptr;
+    ASSERT_EQ(sqlite3_open(db_path.c_str(), &db), SQLITE_OK);
+    sqlite3_exec(db, "CREATE TABLE jobs (job_id TEXT PRIMARY KEY, job_data TEXT NOT NULL, status TEXT NOT NULL, "
+                     "priority INTEGER DEFAULT 0, created_at DATETIME DEFAULT CURRENT_TIMESTAMP, "
+                     "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP)", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    repo = new SqliteJobRepository(db_path);
+    repo->save_job("job1", {{"job_id", "job1"}, {"status", "pending"}, {"latest_start", 1000}});
+    EXPECT_EQ(repo->get_next_pending_job({})["job_id"], "job1");
+}
+
+TEST_F(SqliteJobRepositoryTest, PendingJobsBySizeClass) {
+    repo->save_job("clip1", {{"job_id", "clip1"}, {"status", "pending"}, {"size_class", "small"}});
+    repo->save_job("master", {{"job_id", "master"}, {"status", "pending"}, {"size_class", "large"}});
+    repo->save_job("clip2", {{"job_id", "clip2"}, {"status", "pending"}, {"size_class", "small"}, {"priority", 1}});
+    repo->save_job("clip3", {{"job_id", "clip3"}, {"status", "assigned"}, {"size_class", "small"}});
+
+    auto small = repo->get_pending_jobs_by_size_class("small", 10);
+    ASSERT_EQ(small.size(), 2u);
+    EXPECT_EQ(small[0]["job_id"], "clip2");
+    EXPECT_EQ(small[1]["job_id"], "clip1");
+    EXPECT_EQ(repo->get_pending_jobs_by_size_class("large", 10).size(), 1u);
+}
+
+TEST_F(SqliteJobRepositoryTest, JobsUpdatedSinceAWatermark) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    repo->save_job("old", {{"job_id", "old"}, {"status", "completed"}, {"updated_at", now - 5000}});
+    repo->save_job("later", {{"job_id", "later"}, {"status", "pending"}, {"updated_at", now + 20}});
+    repo->save_job("newer", {{"job_id", "newer"}, {"status", "completed"}, {"updated_at", now + 10}});
+    repo->save_job("edge", {{"job_id", "edge"}, {"status", "failed_retry"}, {"updated_at", now}});
+
+    auto changed = repo->get_jobs_updated_since(now);
+    ASSERT_EQ(changed.size(), 2u);
+    EXPECT_EQ(changed[0]["job_id"], "newer");
+    EXPECT_EQ(changed[1]["job_id"], "later");
+    EXPECT_EQ(repo->get_jobs_updated_since(now - 6000).size(), 4u);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
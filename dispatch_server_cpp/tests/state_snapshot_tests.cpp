@@ -0,0 +1,179 @@
+#include "gtest/gtest.h"
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "../dispatch_server_core.h"
+#include "../engine_health.h"
+#include "../repositories.h"
+#include "../retry_policy.h"
+#include "../runtime_estimator.h"
+#include "../state_snapshot.h"
+#include "http_test_utils.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace distconv::DispatchServer;
+
+namespace {
+
+const int64_t NOW = 1700000000000;
+
+// The three components a snapshot carries, built fresh for each "process"
+struct LearnedState {
+    std::shared_ptr<RuntimeEstimator> estimator = std::make_shared<RuntimeEstimator>(1);
+    std::shared_ptr<EngineHealth> health = std::make_shared<EngineHealth>();
+    std::shared_ptr<RetryScheduler> retries = std::make_shared<RetryScheduler>();
+    StateSnapshot snapshot{estimator, health, retries};
+};
+
+class StateSnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override { std::filesystem::remove(path_); }
+    void TearDown() override { std::filesystem::remove(path_); }
+
+    const std::string path_ = "state_snapshot_test.snapshot";
+};
+
+} // namespace
+
+TEST_F(StateSnapshotTest, RestoresWhatTheLastProcessLearned) {
+    LearnedState before;
+    before.estimator->record({{"target_codec", "h264"}, {"job_size", 100.0}}, 60000);
+    for (int i = 0; i < 5; ++i) {
+        before.health->record_failure("flaky", {{"job_id", "job" + std::to_string(i)}}, "ffmpeg crashed", NOW);
+    }
+    before.health->record_success("steady", {{"job_size", 50.0}, {"assigned_at", NOW - 10000}}, NOW);
+    nlohmann::json job = {{"job_id", "retried"}, {"max_retries", 3}, {"retries", 0}};
+    before.retries->schedule(job, "download", "connection reset", NOW);
+    ASSERT_EQ(before.health->state("flaky", NOW), CircuitState::Open);
+    ASSERT_TRUE(before.snapshot.write(path_, NOW));
+
+    LearnedState after;
+    int64_t watermark = 0;
+    ASSERT_TRUE(after.snapshot.load(path_, watermark));
+    EXPECT_EQ(watermark, NOW);
+
+    int64_t runtime_ms = 0;
+    ASSERT_TRUE(after.estimator->predict({{"target_codec", "h264"}, {"job_size", 50.0}}, runtime_ms));
+    EXPECT_EQ(runtime_ms, 30000);
+    // The quarantine keeps its wall-clock end across the restart
+    EXPECT_EQ(after.health->state("flaky", NOW), CircuitState::Open);
+    EXPECT_EQ(after.health->metrics(NOW)["engines"]["flaky"], before.health->metrics(NOW)["engines"]["flaky"]);
+    double throughput = 0;
+    ASSERT_TRUE(after.health->throughput("steady", throughput));
+    EXPECT_DOUBLE_EQ(throughput, 5.0);
+    EXPECT_EQ(after.retries->metrics()["scheduled"], before.retries->metrics()["scheduled"]);
+}
+
+TEST_F(StateSnapshotTest, IgnoresMissingAndDamagedFiles) {
+    LearnedState state;
+    int64_t watermark = 0;
+    EXPECT_FALSE(state.snapshot.load(path_, watermark));
+
+    LearnedState before;
+    before.estimator->record({{"target_codec", "h264"}}, 60000);
+    ASSERT_TRUE(before.snapshot.write(path_, NOW));
+    auto size = std::filesystem::file_size(path_);
+
+    {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(size - 1));
+        file.put('\x7f');
+    }
+    EXPECT_FALSE(state.snapshot.load(path_, watermark));
+
+    std::filesystem::resize_file(path_, size / 2);
+    EXPECT_FALSE(state.snapshot.load(path_, watermark));
+
+    int64_t median = 0;
+    EXPECT_FALSE(state.estimator->median_duration("h264", median));
+}
+
+TEST_F(StateSnapshotTest, ReplaysOnlyJobsWrittenAfterTheWatermark) {
+    LearnedState before;
+    ASSERT_TRUE(before.snapshot.write(path_, NOW));
+
+    InMemoryJobRepository jobs;
+    // Already in the snapshot
+    jobs.save_job("old", {{"job_id", "old"}, {"status", "completed"}, {"target_codec", "h264"},
+                          {"assigned_at", NOW - 90000}, {"updated_at", NOW - 1000}, {"completed_by", "engine-1"}});
+    // Written after it
+    jobs.save_job("done", {{"job_id", "done"}, {"status", "completed"}, {"target_codec", "h264"},
+                           {"assigned_at", NOW - 20000}, {"updated_at", NOW + 40000}, {"completed_by", "engine-1"}});
+    nlohmann::json failed = {{"job_id", "failed"}, {"status", "failed_retry"}, {"error_message", "disk full"},
+                             {"updated_at", NOW + 5000}};
+    mark_retry_anti_affinity(failed, "engine-2", NOW + 5000);
+    jobs.save_job("failed", failed);
+    nlohmann::json failed_earlier = {{"job_id", "earlier"}, {"status", "pending"}, {"error_message", "disk full"},
+                                     {"updated_at", NOW + 6000}};
+    mark_retry_anti_affinity(failed_earlier, "engine-2", NOW - 500);
+    jobs.save_job("earlier", failed_earlier);
+
+    LearnedState after;
+    int64_t watermark = 0;
+    ASSERT_TRUE(after.snapshot.load(path_, watermark));
+    EXPECT_EQ(after.snapshot.replay(jobs, watermark), 3u);
+
+    int64_t median = 0;
+    ASSERT_TRUE(after.estimator->median_duration("h264", median));
+    EXPECT_EQ(median, 60000);
+    auto engines = after.health->metrics(NOW + 50000)["engines"];
+    EXPECT_EQ(engines["engine-1"]["samples"], 1);
+    EXPECT_EQ(engines["engine-1"]["success_rate"], 1.0);
+    EXPECT_EQ(engines["engine-2"]["samples"], 1);
+    EXPECT_EQ(engines["engine-2"]["failure_reasons"]["disk full"], 1);
+}
+
+TEST_F(StateSnapshotTest, DispatchServerWritesTheSnapshotAtShutdown) {
+    auto job_repo = std::make_shared<InMemoryJobRepository>();
+    auto engine_repo = std::make_shared<InMemoryEngineRepository>();
+    {
+        DispatchServer server(job_repo, engine_repo, "test_key");
+        server.set_state_snapshot({path_, std::chrono::seconds(0)});
+        server.start(0, false);
+
+        httplib::Client client("127.0.0.1", server.get_port());
+        httplib::Headers auth = {{"X-API-Key", "test_key"}};
+        auto submitted = with_connect_retry([&] {
+            return client.Post("/jobs/", auth, R"({"source_url":"http://example.com/a.mp4","target_codec":"h264"})",
+                               "application/json");
+        });
+        ASSERT_TRUE(submitted);
+        ASSERT_EQ(submitted->status, 200);
+        std::string job_id = nlohmann::json::parse(submitted->body)["job_id"];
+        with_connect_retry([&] {
+            return client.Post("/engines/heartbeat", auth,
+                               R"({"engine_id":"engine-1","hostname":"host","status":"idle","storage_capacity_gb":100})",
+                               "application/json");
+        });
+        auto assigned = with_connect_retry([&] {
+            return client.Post("/assign_job/", auth, R"({"engine_id":"engine-1"})", "application/json");
+        });
+        ASSERT_TRUE(assigned);
+        ASSERT_EQ(assigned->status, 200);
+        auto completed = with_connect_retry([&] {
+            return client.Post("/jobs/" + job_id + "/complete", auth,
+                               R"({"engine_id":"engine-1","output_url":"http://example.com/out.mp4"})",
+                               "application/json");
+        });
+        ASSERT_TRUE(completed);
+        ASSERT_EQ(completed->status, 200);
+        EXPECT_EQ(job_repo->get_job(job_id)["completed_by"], "engine-1");
+        EXPECT_FALSE(std::filesystem::exists(path_));
+        server.stop();
+        ASSERT_TRUE(std::filesystem::exists(path_));
+    }
+
+    LearnedState restored;
+    int64_t watermark = 0;
+    ASSERT_TRUE(restored.snapshot.load(path_, watermark));
+    EXPECT_EQ(restored.health->metrics(watermark)["engines"]["engine-1"]["samples"], 1);
+    // The completion is older than the watermark, so a restart does not count it twice
+    EXPECT_EQ(restored.snapshot.replay(*job_repo, watermark), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
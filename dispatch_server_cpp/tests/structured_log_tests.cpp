@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+#include "structured_log.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distconv::logging;
+
+namespace {
+
+std::vector<std::string> read_lines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+class StructuredLogTest : public ::testing::Test {
+protected:
+    void SetUp() override { remove_logs(); }
+    void TearDown() override { remove_logs(); }
+
+    void remove_logs() {
+        for (const char* suffix : {"", ".1", ".2", ".3"}) std::filesystem::remove(path_ + suffix);
+    }
+
+    LogOptions options(Level level = Level::Debug) {
+        LogOptions options;
+        options.path = path_;
+        options.level = level;
+        return options;
+    }
+
+    const std::string path_ = "structured_log_test.log";
+};
+
+} // namespace
+
+TEST_F(StructuredLogTest, WritesOneJsonObjectPerRecord) {
+    Logger logger(options(Level::Info));
+    logger.log(Level::Info, "scheduler", "Job timed out", {{"job_id", "job-1"}, {"attempt", 2}});
+    logger.log(Level::Debug, "scheduler", "Below the threshold");
+    logger.log(Level::Error, "redis", "Bad \"quote\"\n");
+    logger.flush();
+
+    auto lines = read_lines(path_);
+    ASSERT_EQ(lines.size(), 2u);
+    // The fixed keys lead, in a stable order, so lines grep and sort well
+    EXPECT_EQ(lines[0].rfind("{\"ts\":\"", 0), 0u);
+    EXPECT_NE(lines[0].find("\",\"level\":\"info\",\"module\":\"scheduler\",\"msg\":\"Job timed out\""),
+              std::string::npos);
+
+    auto first = nlohmann::json::parse(lines[0]);
+    EXPECT_EQ(first["job_id"], "job-1");
+    EXPECT_EQ(first["attempt"], 2);
+    EXPECT_EQ(first["ts"].get<std::string>().size(), std::string("2026-01-01T00:00:00.000Z").size());
+    auto second = nlohmann::json::parse(lines[1]);
+    EXPECT_EQ(second["level"], "error");
+    EXPECT_EQ(second["msg"], "Bad \"quote\"\n");
+}
+
+TEST_F(StructuredLogTest, ModuleLevelsOverrideTheDefault) {
+    LogOptions opts = options(Level::Warn);
+    ASSERT_TRUE(parse_module_levels("scheduler=debug,redis=off", opts.module_levels));
+    Logger logger(opts);
+
+    EXPECT_TRUE(logger.enabled(Level::Debug, "scheduler"));
+    EXPECT_FALSE(logger.enabled(Level::Info, "server"));
+    EXPECT_TRUE(logger.enabled(Level::Warn, "server"));
+    EXPECT_FALSE(logger.enabled(Level::Error, "redis"));
+
+    // Reconfiguring swaps the whole table
+    ASSERT_TRUE(logger.configure(options(Level::Error)));
+    EXPECT_FALSE(logger.enabled(Level::Debug, "scheduler"));
+    EXPECT_TRUE(logger.enabled(Level::Error, "redis"));
+
+    Level level;
+    EXPECT_TRUE(parse_level("WARNING", level));
+    EXPECT_EQ(level, Level::Warn);
+    EXPECT_FALSE(parse_level("verbose", level));
+    std::map<std::string, Level, std::less<>> levels;
+    EXPECT_FALSE(parse_module_levels("=debug", levels));
+}
+
+TEST_F(StructuredLogTest, ConcurrentProducersLoseNothingButOverflow) {
+    // A tiny ring overflows; every record is either written once or counted as dropped
+    Logger logger(options(), 4);
+    const int threads = 4;
+    const int per_thread = 5000;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&logger, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                logger.log(Level::Info, "test", "record", {{"thread", t}, {"seq", i}});
+            }
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    logger.flush();
+
+    auto lines = read_lines(path_);
+    EXPECT_EQ(lines.size() + logger.dropped(), static_cast<size_t>(threads * per_thread));
+    EXPECT_GT(logger.dropped(), 0u);
+
+    // Each producer's records arrive in the order it logged them
+    std::map<int, int> last;
+    for (const auto& line : lines) {
+        auto record = nlohmann::json::parse(line);
+        int thread = record["thread"];
+        int seq = record["seq"];
+        auto it = last.find(thread);
+        if (it != last.end()) EXPECT_GT(seq, it->second);
+        last[thread] = seq;
+    }
+}
+
+TEST_F(StructuredLogTest, RotatesPastTheSizeLimit) {
+    LogOptions opts = options();
+    opts.max_file_bytes = 1000;
+    opts.max_files = 2;
+    {
+        Logger logger(opts);
+        for (int i = 0; i < 100; ++i) logger.log(Level::Info, "test", "rotation", {{"i", i}});
+    } // The destructor writes everything still queued
+
+    ASSERT_TRUE(std::filesystem::exists(path_));
+    ASSERT_TRUE(std::filesystem::exists(path_ + ".1"));
+    ASSERT_TRUE(std::filesystem::exists(path_ + ".2"));
+    EXPECT_FALSE(std::filesystem::exists(path_ + ".3"));
+    for (const char* suffix : {"", ".1", ".2"}) {
+        EXPECT_LE(std::filesystem::file_size(path_ + suffix), 1000u) << suffix;
+    }
+    // The newest records stay in the live file
+    auto lines = read_lines(path_);
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ(nlohmann::json::parse(lines.back())["i"], 99);
+    EXPECT_EQ(nlohmann::json::parse(read_lines(path_ + ".1").back())["i"],
+              nlohmann::json::parse(lines.front())["i"].get<int>() - 1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -39,14 +39,9 @@ protected:
     static int port;
     static std::string api_key;
     static httplib::Headers admin_headers;
-    static std::string persistent_storage_file;
     static bool use_legacy_mode;
 
     static void SetUpTestSuite() {
-        use_async_save = false; // Disable async persistence for tests
-        persistent_storage_file = "dispatch_server_state_" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count()) + ".json";
-        PERSISTENT_STORAGE_FILE = persistent_storage_file;
-
         //clear_db(); // Can't clear yet, server is null
         
         port = find_available_port();
@@ -74,14 +69,10 @@ protected:
         server->stop();
         delete server;
         delete client;
-        std::remove(persistent_storage_file.c_str());
-        PERSISTENT_STORAGE_FILE = "dispatch_server_state.json";
     }
 
     void SetUp() override {
         clear_db();
-        // Restore persistent storage file path in case a previous test changed it
-        PERSISTENT_STORAGE_FILE = persistent_storage_file;
     }
 
     void TearDown() override {
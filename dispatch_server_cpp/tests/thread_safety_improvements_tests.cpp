@@ -13,15 +13,9 @@ class ThreadSafetyImprovementsTest : public ApiTest {
 protected:
     void SetUp() override {
         ApiTest::SetUp();
-        
-        // Enable mocking to avoid file I/O during tests
-        mock_save_state_enabled = true;
-        save_state_call_count = 0;
     }
 
     void TearDown() override {
-        // Disable mocking after each test
-        mock_save_state_enabled = false;
         ApiTest::TearDown();
     }
 };
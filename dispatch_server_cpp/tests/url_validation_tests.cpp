@@ -36,13 +36,8 @@ TEST_F(URLValidationTest, ValidURL) {
     }
     
     httplib::Request req;
-    req.matches = std::smatch(); // We need to fake matches, but httplib::Request matches is not easily settable without regex_match
-    // Workaround: The handler uses req.matches[1] for job_id. 
-    // We can't easily populate std::smatch directly. 
-    // However, we can use the same trick as in other tests: use std::regex_match to populate it.
-    std::string path = "/jobs/" + job_id + "/complete";
-    std::regex re(R"(/jobs/(.+)/complete)");
-    std::regex_match(path, req.matches, re);
+    req.path = "/jobs/" + job_id + "/complete";
+    req.path_params.emplace("job_id", job_id);
     
     nlohmann::json body;
     body["output_url"] = "https://example.com/output.mp4";
@@ -73,9 +68,8 @@ TEST_F(URLValidationTest, InvalidURLNoProtocol) {
     }
     
     httplib::Request req;
-    std::string path = "/jobs/" + job_id + "/complete";
-    std::regex re(R"(/jobs/(.+)/complete)");
-    std::regex_match(path, req.matches, re);
+    req.path = "/jobs/" + job_id + "/complete";
+    req.path_params.emplace("job_id", job_id);
     
     nlohmann::json body;
     body["output_url"] = "example.com/output.mp4"; // Missing https://
@@ -102,9 +96,8 @@ TEST_F(URLValidationTest, InvalidURLFtpProtocol) {
     }
     
     httplib::Request req;
-    std::string path = "/jobs/" + job_id + "/complete";
-    std::regex re(R"(/jobs/(.+)/complete)");
-    std::regex_match(path, req.matches, re);
+    req.path = "/jobs/" + job_id + "/complete";
+    req.path_params.emplace("job_id", job_id);
     
     nlohmann::json body;
     body["output_url"] = "ftp://example.com/output.mp4"; // Wrong protocol
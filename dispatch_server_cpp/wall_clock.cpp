@@ -0,0 +1,27 @@
+#include "wall_clock.h"
+#include <atomic>
+#include <chrono>
+
+namespace distconv {
+namespace DispatchServer {
+
+namespace {
+
+std::atomic<WallClockSource> clock_source{nullptr};
+
+} // namespace
+
+int64_t wall_clock_ms() {
+    if (WallClockSource source = clock_source.load(std::memory_order_acquire)) {
+        return source();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void set_wall_clock_source(WallClockSource source) {
+    clock_source.store(source, std::memory_order_release);
+}
+
+} // namespace DispatchServer
+} // namespace distconv
@@ -0,0 +1,22 @@
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+#include <cstdint>
+
+namespace distconv {
+namespace DispatchServer {
+
+// Milliseconds since the epoch for job and engine timestamps. The dispatcher
+// reads the time through here so that the scheduler simulator can run the
+// claim path on a virtual clock.
+int64_t wall_clock_ms();
+
+// Replaces the clock for the whole process; nullptr restores system_clock.
+// Only the simulator and tests do this, before any handler runs.
+using WallClockSource = int64_t (*)();
+void set_wall_clock_source(WallClockSource source);
+
+} // namespace DispatchServer
+} // namespace distconv
+
+#endif // WALL_CLOCK_H
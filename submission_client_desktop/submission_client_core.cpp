@@ -60,17 +60,7 @@ nlohmann::json ApiClient::submitJob(const std::string& source_url, const std::st
 }
 
 nlohmann::json ApiClient::getJobStatus(const std::string& job_id) {
-    cpr::SslOptions ssl_opts = create_ssl_options();
-
-    cpr::Response r = cpr_api_->Get(cpr::Url{server_url_ + "/jobs/" + job_id},
-                                 cpr::Header{{"X-API-Key", api_key_}},
-                                 ssl_opts);
-
-    if (r.status_code == 200) {
-        return nlohmann::json::parse(r.text);
-    } else {
-        throw std::runtime_error("Error getting job status: " + std::to_string(r.status_code) + " - " + r.text);
-    }
+    return getRevalidated("/jobs/" + job_id, "Error getting job status");
 }
 
 nlohmann::json ApiClient::listAllJobs() {
@@ -88,16 +78,33 @@ nlohmann::json ApiClient::listAllJobs() {
 }
 
 nlohmann::json ApiClient::listAllEngines() {
+    return getRevalidated("/engines/", "Error listing engines");
+}
+
+nlohmann::json ApiClient::getRevalidated(const std::string& path, const std::string& error_context) {
     cpr::SslOptions ssl_opts = create_ssl_options();
 
-    cpr::Response r = cpr_api_->Get(cpr::Url{server_url_ + "/engines/"},
-                                 cpr::Header{{"X-API-Key", api_key_}},
-                                 ssl_opts);
+    cpr::Header header{{"X-API-Key", api_key_}};
+    auto cached = etag_cache_.find(path);
+    if (cached != etag_cache_.end()) {
+        header["If-None-Match"] = cached->second.etag;
+    }
 
-    if (r.status_code == 200) {
-        return nlohmann::json::parse(r.text);
+    cpr::Response r = cpr_api_->Get(cpr::Url{server_url_ + path}, header, ssl_opts);
+
+    if (r.status_code == 304 && cached != etag_cache_.end()) {
+        return cached->second.body;
+    } else if (r.status_code == 200) {
+        nlohmann::json body = nlohmann::json::parse(r.text);
+        auto etag = r.header.find("ETag");
+        if (etag != r.header.end()) {
+            etag_cache_[path] = {etag->second, body};
+        } else {
+            etag_cache_.erase(path);
+        }
+        return body;
     } else {
-        throw std::runtime_error("Error listing engines: " + std::to_string(r.status_code) + " - " + r.text);
+        throw std::runtime_error(error_context + ": " + std::to_string(r.status_code) + " - " + r.text);
     }
 }
 
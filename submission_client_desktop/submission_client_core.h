@@ -1,6 +1,7 @@
 #ifndef SUBMISSION_CLIENT_CORE_H
 #define SUBMISSION_CLIENT_CORE_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include "nlohmann/json.hpp"
@@ -10,15 +11,20 @@
 namespace distconv {
 namespace SubmissionsClient {
 
+// Requests advertise gzip: job and engine listings are compressed by the
+// dispatcher, and curl inflates them before the body reaches the caller
 class CprApi {
 public:
     virtual ~CprApi() = default;
     virtual cpr::Response Post(const cpr::Url& url, const cpr::Header& header, const cpr::Body& body, const cpr::SslOptions& ssl_opts) {
-        return cpr::Post(url, header, body, ssl_opts);
+        return cpr::Post(url, header, body, ssl_opts, accept_encoding());
     }
     virtual cpr::Response Get(const cpr::Url& url, const cpr::Header& header, const cpr::SslOptions& ssl_opts) {
-        return cpr::Get(url, header, ssl_opts);
+        return cpr::Get(url, header, ssl_opts, accept_encoding());
     }
+
+private:
+    static cpr::AcceptEncoding accept_encoding() { return cpr::AcceptEncoding{{cpr::AcceptEncodingMethods::gzip}}; }
 };
 
 class ApiClient {
@@ -31,12 +37,21 @@ public:
     nlohmann::json listAllEngines();
 
 private:
+    struct CachedResponse {
+        std::string etag;
+        nlohmann::json body;
+    };
+
     cpr::SslOptions create_ssl_options();
+    // GET that revalidates with If-None-Match once a response was tagged and
+    // returns the cached body on 304 Not Modified
+    nlohmann::json getRevalidated(const std::string& path, const std::string& error_context);
     std::string server_url_;
     std::string api_key_;
     std::string ca_cert_path_;
     bool ssl_verify_;
     std::unique_ptr<CprApi> cpr_api_;
+    std::map<std::string, CachedResponse> etag_cache_;
 };
 
 // Global configuration (will be set via UI/command line)
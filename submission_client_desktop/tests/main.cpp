@@ -214,6 +214,41 @@ TEST_F(SubmissionClientTest, GetJobStatusHandlesSuccessfulResponse) {
     ASSERT_EQ(result_json["status"], "pending");
 }
 
+TEST_F(SubmissionClientTest, GetJobStatusRevalidatesWithETag) {
+    auto mock_cpr_api = std::make_unique<MockCprApi>();
+
+    cpr::Response tagged;
+    tagged.status_code = 200;
+    tagged.text = R"({"job_id": "test_job_id_123", "status": "pending"})";
+    tagged.header["ETag"] = "\"a1b2-7\"";
+    cpr::Response not_modified;
+    not_modified.status_code = 304;
+
+    std::string job_id = "test_job_id_123";
+    cpr::Header first_header;
+    cpr::Header second_header;
+
+    trompeloeil::sequence seq;
+    REQUIRE_CALL(*mock_cpr_api, Get(cpr::Url{g_dispatchServerUrl + "/jobs/" + job_id}, trompeloeil::_, trompeloeil::_))
+        .IN_SEQUENCE(seq)
+        .LR_SIDE_EFFECT(first_header = _2)
+        .LR_RETURN(tagged);
+    REQUIRE_CALL(*mock_cpr_api, Get(cpr::Url{g_dispatchServerUrl + "/jobs/" + job_id}, trompeloeil::_, trompeloeil::_))
+        .IN_SEQUENCE(seq)
+        .LR_SIDE_EFFECT(second_header = _2)
+        .LR_RETURN(not_modified);
+
+    ApiClient apiClient(g_dispatchServerUrl, g_apiKey, g_caCertPath, true, std::move(mock_cpr_api));
+
+    nlohmann::json first = apiClient.getJobStatus(job_id);
+    nlohmann::json second = apiClient.getJobStatus(job_id);
+
+    ASSERT_EQ(first_header.count("If-None-Match"), 0);
+    ASSERT_EQ(second_header["If-None-Match"], "\"a1b2-7\"");
+    ASSERT_EQ(second, first);
+    ASSERT_EQ(second["status"], "pending");
+}
+
 TEST_F(SubmissionClientTest, GetJobStatusHandlesNotFoundResponse) {
     auto mock_cpr_api = std::make_unique<MockCprApi>();
     
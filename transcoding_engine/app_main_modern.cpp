@@ -7,13 +7,16 @@
 #include <csignal>
 #include <atomic>
 #include <thread>
+#include <algorithm>
 
 using namespace distconv::TranscodingEngine;
 
 std::atomic<bool> should_stop{false};
+std::atomic<int> stop_signal{0};
 
+// Only async-signal-safe work here; main logs the signal once it wakes
 void signal_handler(int signal) {
-    std::cout << "\nReceived signal " << signal << ", shutting down gracefully..." << std::endl;
+    stop_signal.store(signal);
     should_stop.store(true);
 }
 
@@ -27,8 +30,20 @@ void print_usage(const char* program_name) {
               << "  --db-path PATH        Database file path (default: transcoding_jobs.db)\n"
               << "  --engine-id ID        Override engine ID (generated if not specified)\n"
               << "  --storage-gb GB       Storage capacity in GB (default: 500.0)\n"
+              << "  --assign-wait SEC     Long-poll /assign_job/ for up to SEC seconds (default: 0, plain polling)\n"
+              << "  --channel             Batch dispatcher traffic over /engines/channel (REST fallback)\n"
+              << "  --source-cache DIR    Keep downloaded sources in DIR and advertise them for locality\n"
+              << "  --source-cache-entries N  Sources kept in the cache (default: 64)\n"
+              << "  --segment-seconds SEC Transcode in SEC-second segments so jobs can be preempted (default: 0, off)\n"
+              << "  --slots N             Run up to N jobs concurrently (default: 1)\n"
+              << "  --batch N             Accept up to N small jobs per assignment, encoded by one ffmpeg (default: 1)\n"
               << "  --no-streaming        Disable streaming support\n"
               << "  --test-mode           Enable test mode (no background threads)\n"
+              << "  --log-file PATH       Write JSON-lines logs here instead of stderr\n"
+              << "  --log-level LEVEL     debug, info, warn, error or off (default: info)\n"
+              << "  --log-modules SPEC    Per-module levels, e.g. ffmpeg=debug,reports=warn\n"
+              << "  --log-max-bytes N     Rotate the log file past N bytes (default: 67108864; 0 = never)\n"
+              << "  --log-max-files N     Rotated log files kept (default: 5)\n"
               << "  --help                Show this help message\n";
 }
 
@@ -60,10 +75,75 @@ EngineConfig parse_arguments(int argc, char* argv[]) {
                 std::cerr << "Invalid storage capacity: " << argv[i] << std::endl;
                 exit(1);
             }
+        } else if (arg == "--assign-wait" && i + 1 < argc) {
+            try {
+                config.assign_wait_seconds = std::stoi(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid assign wait: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--channel") {
+            config.use_dispatch_channel = true;
+        } else if (arg == "--source-cache" && i + 1 < argc) {
+            config.source_cache_dir = argv[++i];
+        } else if (arg == "--source-cache-entries" && i + 1 < argc) {
+            try {
+                config.source_cache_max_entries = std::stoi(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid source cache size: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--segment-seconds" && i + 1 < argc) {
+            try {
+                config.segment_seconds = std::stoi(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid segment length: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--slots" && i + 1 < argc) {
+            try {
+                config.max_concurrent_jobs = std::max(1, std::stoi(argv[++i]));
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid slot count: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--batch" && i + 1 < argc) {
+            try {
+                config.max_batch_items = std::max(1, std::stoi(argv[++i]));
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid batch size: " << argv[i] << std::endl;
+                exit(1);
+            }
         } else if (arg == "--no-streaming") {
             config.streaming_support = false;
         } else if (arg == "--test-mode") {
             config.test_mode = true;
+        } else if (arg == "--log-file" && i + 1 < argc) {
+            config.log.path = argv[++i];
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            if (!distconv::logging::parse_level(argv[++i], config.log.level)) {
+                std::cerr << "Invalid log level: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--log-modules" && i + 1 < argc) {
+            if (!distconv::logging::parse_module_levels(argv[++i], config.log.module_levels)) {
+                std::cerr << "Invalid module log levels: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--log-max-bytes" && i + 1 < argc) {
+            try {
+                config.log.max_file_bytes = std::stoull(argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid log size limit: " << argv[i] << std::endl;
+                exit(1);
+            }
+        } else if (arg == "--log-max-files" && i + 1 < argc) {
+            try {
+                config.log.max_files = std::max(0, std::stoi(argv[++i]));
+            } catch (const std::exception& e) {
+                std::cerr << "Invalid log file count: " << argv[i] << std::endl;
+                exit(1);
+            }
         } else {
             std::cerr << "Unknown argument: " << arg << std::endl;
             print_usage(argv[0]);
@@ -75,8 +155,6 @@ EngineConfig parse_arguments(int argc, char* argv[]) {
 }
 
 int main(int argc, char* argv[]) {
-    std::cout << "=== Modern Transcoding Engine Starting ===" << std::endl;
-    
     // Install signal handlers
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
@@ -84,6 +162,11 @@ int main(int argc, char* argv[]) {
     try {
         // Parse command line arguments
         auto config = parse_arguments(argc, argv);
+        if (!distconv::logging::logger().configure(config.log)) {
+            std::cerr << "Cannot open log file: " << config.log.path << std::endl;
+            return 1;
+        }
+        distconv::logging::info("engine", "Modern Transcoding Engine starting");
         
         // Create dependencies with dependency injection
         auto http_client = std::make_unique<CprHttpClient>();
@@ -99,23 +182,23 @@ int main(int argc, char* argv[]) {
         
         // Initialize the engine
         if (!engine.initialize(config)) {
-            std::cerr << "Failed to initialize transcoding engine" << std::endl;
+            distconv::logging::error("engine", "Failed to initialize transcoding engine");
             return 1;
         }
         
         // Register with dispatcher
         if (!engine.register_with_dispatcher()) {
-            std::cerr << "Failed to register with dispatcher" << std::endl;
+            distconv::logging::error("engine", "Failed to register with dispatcher");
             return 1;
         }
         
         // Start the engine
         if (!engine.start()) {
-            std::cerr << "Failed to start transcoding engine" << std::endl;
+            distconv::logging::error("engine", "Failed to start transcoding engine");
             return 1;
         }
         
-        std::cout << "Transcoding Engine running. Press Ctrl+C to stop." << std::endl;
+        distconv::logging::info("engine", "Transcoding Engine running");
         
         // Main loop
         while (!should_stop.load() && engine.is_running()) {
@@ -131,17 +214,20 @@ int main(int argc, char* argv[]) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
         
-        std::cout << "Stopping transcoding engine..." << std::endl;
+        if (stop_signal.load() != 0) {
+            distconv::logging::info("engine", "Received signal, shutting down", {{"signal", stop_signal.load()}});
+        }
+        distconv::logging::info("engine", "Stopping transcoding engine");
         engine.stop();
         
-        std::cout << "Transcoding Engine stopped successfully." << std::endl;
+        distconv::logging::info("engine", "Transcoding Engine stopped");
         return 0;
         
     } catch (const std::exception& e) {
-        std::cerr << "Fatal error: " << e.what() << std::endl;
+        distconv::logging::error("engine", "Fatal error", {{"error", e.what()}});
         return 1;
     } catch (...) {
-        std::cerr << "Unknown fatal error occurred" << std::endl;
+        distconv::logging::error("engine", "Unknown fatal error occurred");
         return 1;
     }
 }
@@ -0,0 +1,137 @@
+#include "source_cache.h"
+#include "structured_log.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace distconv {
+namespace TranscodingEngine {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* ENTRY_SUFFIX = ".src";
+
+} // namespace
+
+SourceCache::SourceCache(std::string directory, size_t max_entries)
+    : directory_(std::move(directory)), max_entries_(std::max<size_t>(1, max_entries)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+
+    // Rebuild the index from a previous run; entry names are the hex hash
+    for (const auto& file : fs::directory_iterator(directory_, ec)) {
+        const auto name = file.path().filename().string();
+        if (name.size() != 16 + std::char_traits<char>::length(ENTRY_SUFFIX) ||
+            file.path().extension() != ENTRY_SUFFIX) {
+            continue;
+        }
+        try {
+            entries_.insert(std::stoull(name.substr(0, 16), nullptr, 16));
+        } catch (const std::exception&) {
+        }
+    }
+    evict_locked();
+}
+
+uint64_t SourceCache::url_hash(const std::string& url) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string SourceCache::entry_path(uint64_t hash) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return (fs::path(directory_) / (std::string(name) + ENTRY_SUFFIX)).string();
+}
+
+bool SourceCache::fetch(const std::string& source_url, const std::string& output_path) {
+    uint64_t hash = url_hash(source_url);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!entries_.count(hash)) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::string cached = entry_path(hash);
+    fs::copy_file(cached, output_path, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        entries_.erase(hash);
+        return false;
+    }
+    // Touch so eviction keeps recently used sources
+    fs::last_write_time(cached, fs::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void SourceCache::store(const std::string& source_url, const std::string& path) {
+    uint64_t hash = url_hash(source_url);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::error_code ec;
+    fs::copy_file(path, entry_path(hash), fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+        logging::warn("cache", "Failed to cache source file", {{"path", path}, {"error", ec.message()}});
+        return;
+    }
+    entries_.insert(hash);
+    evict_locked();
+}
+
+void SourceCache::evict_locked() {
+    if (entries_.size() <= max_entries_) {
+        return;
+    }
+
+    std::vector<std::pair<fs::file_time_type, uint64_t>> by_age;
+    for (uint64_t hash : entries_) {
+        std::error_code ec;
+        by_age.emplace_back(fs::last_write_time(entry_path(hash), ec), hash);
+    }
+    std::sort(by_age.begin(), by_age.end());
+
+    for (size_t i = 0; i < by_age.size() - max_entries_; ++i) {
+        std::error_code ec;
+        fs::remove(entry_path(by_age[i].second), ec);
+        entries_.erase(by_age[i].second);
+    }
+}
+
+nlohmann::json SourceCache::summary() const {
+    std::vector<uint8_t> bits(FILTER_BITS / 8, 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint64_t hash : entries_) {
+            uint64_t h1 = hash & 0xffffffffULL;
+            uint64_t h2 = (hash >> 32) | 1;
+            for (uint32_t i = 0; i < FILTER_HASHES; ++i) {
+                uint64_t bit = (h1 + i * h2) % FILTER_BITS;
+                bits[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+            }
+        }
+    }
+
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bits.size() * 2);
+    for (uint8_t byte : bits) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0xf];
+    }
+    return {{"m", FILTER_BITS}, {"k", FILTER_HASHES}, {"bits", hex}};
+}
+
+size_t SourceCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+} // namespace TranscodingEngine
+} // namespace distconv
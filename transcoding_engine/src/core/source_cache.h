@@ -0,0 +1,49 @@
+#ifndef SOURCE_CACHE_H
+#define SOURCE_CACHE_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+
+namespace distconv {
+namespace TranscodingEngine {
+
+// Local cache of downloaded source files, keyed by a hash of the source URL.
+// The dispatcher learns what is cached through a Bloom filter sent with each
+// heartbeat and routes jobs for those sources back to this engine. The hash
+// and probe scheme must match dispatch_server_cpp/source_cache_index.cpp.
+class SourceCache {
+public:
+    static constexpr uint32_t FILTER_BITS = 4096;
+    static constexpr uint32_t FILTER_HASHES = 4;
+
+    SourceCache(std::string directory, size_t max_entries);
+
+    // Copies a cached source to output_path; false on a miss
+    bool fetch(const std::string& source_url, const std::string& output_path);
+    // Keeps a copy of a freshly downloaded source, evicting the oldest entries
+    void store(const std::string& source_url, const std::string& path);
+
+    // {"m": bits, "k": hashes, "bits": hex} for the heartbeat
+    nlohmann::json summary() const;
+    size_t size() const;
+
+    static uint64_t url_hash(const std::string& url);
+
+private:
+    std::string entry_path(uint64_t hash) const;
+    void evict_locked();
+
+    const std::string directory_;
+    const size_t max_entries_;
+    mutable std::mutex mutex_;
+    std::set<uint64_t> entries_;
+};
+
+} // namespace TranscodingEngine
+} // namespace distconv
+
+#endif // SOURCE_CACHE_H
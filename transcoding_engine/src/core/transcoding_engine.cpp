@@ -1,4 +1,5 @@
 #include "transcoding_engine.h"
+#include "structured_log.hpp"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -7,6 +8,8 @@
 #include <unistd.h>
 #include <sstream>
 #include <optional>
+#include <algorithm>
+#include <cmath>
 
 namespace distconv {
 namespace TranscodingEngine {
@@ -42,17 +45,23 @@ bool TranscodingEngine::initialize(const EngineConfig& config) {
     
     // Initialize database
     if (!database_->initialize(config_.database_path)) {
-        std::cerr << "Failed to initialize database" << std::endl;
+        logging::error("engine", "Failed to initialize database");
         return false;
     }
     
     // Configure HTTP client
     http_client_->set_ssl_options(config_.ca_cert_path, !config_.ca_cert_path.empty());
-    http_client_->set_timeout(config_.http_timeout_seconds);
+    // A long-polled /assign_job/ must not time out before the server answers
+    http_client_->set_timeout(std::max(config_.http_timeout_seconds, config_.assign_wait_seconds + 5));
+    
+    if (!config_.source_cache_dir.empty()) {
+        source_cache_ = std::make_unique<SourceCache>(config_.source_cache_dir,
+                                                      static_cast<size_t>(std::max(1, config_.source_cache_max_entries)));
+    }
     
     // Verify ffmpeg is available
     if (!subprocess_runner_->is_executable_available("ffmpeg")) {
-        std::cerr << "FFmpeg not found - transcoding will not work" << std::endl;
+        logging::error("engine", "FFmpeg not found - transcoding will not work");
         if (!config_.test_mode) {
             return false;
         }
@@ -63,7 +72,7 @@ bool TranscodingEngine::initialize(const EngineConfig& config) {
     cached_decoders_ = get_ffmpeg_capabilities("decoders");
     cached_hwaccels_ = get_ffmpeg_hw_accels();
     
-    std::cout << "Transcoding Engine initialized: " << config_.engine_id << std::endl;
+    logging::info("engine", "Transcoding Engine initialized", {{"engine_id", config_.engine_id}});
     return true;
 }
 
@@ -81,7 +90,7 @@ bool TranscodingEngine::start() {
         main_loop_thread_ = std::thread(&TranscodingEngine::main_job_loop, this);
     }
     
-    std::cout << "Transcoding Engine started" << std::endl;
+    logging::info("engine", "Transcoding Engine started");
     return true;
 }
 
@@ -102,9 +111,20 @@ void TranscodingEngine::stop() {
     if (main_loop_thread_.joinable()) {
         main_loop_thread_.join();
     }
+    // Running jobs finish (or reach a checkpoint) before the database closes
+    std::list<Slot> slots;
+    {
+        std::lock_guard<std::mutex> lock(slots_mutex_);
+        slots.swap(slots_);
+    }
+    for (auto& slot : slots) {
+        if (slot.thread.joinable()) {
+            slot.thread.join();
+        }
+    }
     
     database_->close();
-    std::cout << "Transcoding Engine stopped" << std::endl;
+    logging::info("engine", "Transcoding Engine stopped");
 }
 
 bool TranscodingEngine::is_running() const {
@@ -122,7 +142,9 @@ bool TranscodingEngine::register_with_dispatcher() {
         {"storage_capacity_gb", config_.storage_capacity_gb},
         {"streaming_support", config_.streaming_support},
         {"hostname", config_.hostname},
-        {"local_job_queue", queued_jobs}
+        {"local_job_queue", queued_jobs},
+        {"preemptible", config_.segment_seconds > 0},
+        {"capacity", capacity()}
     };
     
     auto headers = create_auth_headers();
@@ -132,28 +154,44 @@ bool TranscodingEngine::register_with_dispatcher() {
     auto response = http_client_->post(url, heartbeat_data.dump(), headers);
     
     if (response.success) {
-        std::cout << "Successfully registered with dispatcher" << std::endl;
+        logging::info("engine", "Registered with dispatcher");
         return true;
     } else {
-        std::cerr << "Failed to register with dispatcher: " << response.error_message << std::endl;
+        logging::error("engine", "Failed to register with dispatcher", {{"error", response.error_message}});
         return false;
     }
 }
 
 std::optional<JobDetails> TranscodingEngine::get_job_from_dispatcher() {
+    if (channel_enabled()) {
+        std::optional<JobDetails> job;
+        bool exchanged = exchange_channel(true, &job);
+        last_poll_waited_ = exchanged && config_.assign_wait_seconds > 0;
+        if (channel_enabled()) {
+            return job;
+        }
+    }
+
     nlohmann::json request_data = {
         {"engine_id", config_.engine_id}
     };
+    if (config_.max_batch_items > 1) {
+        request_data["max_batch"] = config_.max_batch_items;
+    }
     
     auto headers = create_auth_headers();
     headers["Content-Type"] = "application/json";
     
     std::string url = config_.dispatch_server_url + "/assign_job/";
+    if (config_.assign_wait_seconds > 0) {
+        url += "?wait=" + std::to_string(config_.assign_wait_seconds) + "s";
+    }
     auto response = http_client_->post(url, request_data.dump(), headers);
+    last_poll_waited_ = config_.assign_wait_seconds > 0 && response.status_code == 204;
     
     if (!response.success) {
         if (response.status_code != 204) { // 204 = No Content (no jobs available)
-            std::cerr << "Failed to get job from dispatcher: " << response.error_message << std::endl;
+            logging::error("engine", "Failed to get job from dispatcher", {{"error", response.error_message}});
         }
         return std::nullopt;
     }
@@ -163,93 +201,358 @@ std::optional<JobDetails> TranscodingEngine::get_job_from_dispatcher() {
     }
     
     try {
-        auto job_json = nlohmann::json::parse(response.body);
-        
-        JobDetails job;
-        job.job_id = job_json.value("job_id", "");
-        job.source_url = job_json.value("source_url", "");
-        job.target_codec = job_json.value("target_codec", "");
-        job.job_size = job_json.value("job_size", 0.0);
-        
-        // Validate required fields
-        if (job.job_id.empty() || job.source_url.empty() || job.target_codec.empty()) {
-            std::cerr << "Invalid job data received from dispatcher" << std::endl;
+        return job_from_json(nlohmann::json::parse(response.body));
+    } catch (const nlohmann::json::exception& e) {
+        logging::error("engine", "Failed to parse job JSON", {{"error", e.what()}});
+        return std::nullopt;
+    }
+}
+
+std::optional<JobDetails> TranscodingEngine::job_from_json(const nlohmann::json& job_json) {
+    if (job_json.value("type", "") == "batch") {
+        JobDetails batch;
+        batch.job_id = batch.batch_id = job_json.value("batch_id", "");
+        batch.target_codec = job_json.value("target_codec", "");
+        for (const auto& item_json : job_json.value("jobs", nlohmann::json::array())) {
+            auto item = job_from_json(item_json);
+            if (item.has_value()) {
+                batch.items.push_back(*item);
+                batch.job_size += item->job_size;
+            }
+        }
+        if (batch.batch_id.empty() || batch.items.empty()) {
+            logging::error("engine", "Invalid batch data received from dispatcher");
             return std::nullopt;
         }
-        
-        return job;
-    } catch (const nlohmann::json::exception& e) {
-        std::cerr << "Failed to parse job JSON: " << e.what() << std::endl;
+        return batch;
+    }
+    
+    JobDetails job;
+    job.job_id = job_json.value("job_id", "");
+    job.source_url = job_json.value("source_url", "");
+    job.target_codec = job_json.value("target_codec", "");
+    job.job_size = job_json.value("job_size", 0.0);
+    // Continue the dispatcher's trace; a suspended job's checkpoint keeps the header itself
+    job.traceparent = job_json.value("traceparent", "");
+    if (job.traceparent.empty() && job_json.contains("trace") && job_json["trace"].is_object()) {
+        std::string trace_id = job_json["trace"].value("trace_id", "");
+        std::string span_id = job_json["trace"].value("span_id", "");
+        if (!trace_id.empty() && !span_id.empty()) {
+            job.traceparent = "00-" + trace_id + "-" + span_id + "-01";
+        }
+    }
+    
+    // Validate required fields
+    if (job.job_id.empty() || job.source_url.empty() || job.target_codec.empty()) {
+        logging::error("engine", "Invalid job data received from dispatcher");
         return std::nullopt;
     }
+    
+    return job;
 }
 
 bool TranscodingEngine::process_job(const JobDetails& job) {
-    std::cout << "Processing job: " << job.job_id << std::endl;
+    logging::info("jobs", "Processing job", {{"job_id", job.job_id}});
     
     // Add to local queue
     if (!add_job_to_queue(job.job_id)) {
-        std::cerr << "Failed to add job to local queue" << std::endl;
+        logging::error("jobs", "Failed to add job to local queue", {{"job_id", job.job_id}});
         return false;
     }
     
     // Generate temporary file names
-    std::string input_file = generate_unique_filename(job.job_id, ".input.mp4");
-    std::string output_file = generate_unique_filename(job.job_id, ".output.mp4");
+    nlohmann::json checkpoint = {
+        {"stage", "download"},
+        {"input_file", generate_unique_filename(job.job_id, ".input.mp4")},
+        {"output_file", generate_unique_filename(job.job_id, ".output.mp4")},
+        {"segments_done", 0}
+    };
+    return run_job(job, checkpoint);
+}
+
+bool TranscodingEngine::process_batch(const JobDetails& batch) {
+    logging::info("jobs", "Processing batch", {{"batch_id", batch.batch_id}, {"jobs", batch.items.size()}});
+    
+    std::vector<const JobDetails*> ready;
+    std::vector<std::string> input_files;
+    std::vector<std::string> output_files;
+    std::vector<nlohmann::json> phases;
+    for (const auto& item : batch.items) {
+        add_job_to_queue(item.job_id);
+        std::string input_file = generate_unique_filename(item.job_id, ".input.mp4");
+        std::string output_file = generate_unique_filename(item.job_id, ".output.mp4");
+        nlohmann::json item_phases = nlohmann::json::object();
+        int64_t started = epoch_ms();
+        bool downloaded = download_source_file(item.source_url, input_file, item.traceparent);
+        record_phase(item_phases, "download", started);
+        if (!downloaded) {
+            report_job_failure(item.job_id, "Failed to download source video", item_phases);
+            finish_job(item.job_id, {{"input_file", input_file}, {"output_file", output_file}});
+            continue;
+        }
+        ready.push_back(&item);
+        input_files.push_back(input_file);
+        output_files.push_back(output_file);
+        phases.push_back(item_phases);
+    }
+    
+    // One process for the whole batch saves an ffmpeg start-up per job; if any
+    // input trips it up, each job is retried alone so only that one fails
+    int64_t batch_started = epoch_ms();
+    bool batched = !ready.empty() && transcode_batch(input_files, output_files, batch.target_codec);
+    if (batched) {
+        for (auto& item_phases : phases) {
+            record_phase(item_phases, "transcode", batch_started);
+        }
+    }
     
-    std::vector<std::string> temp_files = {input_file, output_file};
+    bool all_completed = ready.size() == batch.items.size();
+    for (size_t i = 0; i < ready.size(); ++i) {
+        const JobDetails& item = *ready[i];
+        nlohmann::json files = {{"input_file", input_files[i]}, {"output_file", output_files[i]}};
+        if (is_job_cancelled(item.job_id)) {
+            logging::info("jobs", "Job cancelled by dispatcher", {{"job_id", item.job_id}});
+            finish_job(item.job_id, files);
+            all_completed = false;
+            continue;
+        }
+        if (!batched) {
+            int64_t started = epoch_ms();
+            bool transcoded = transcode_file(input_files[i], output_files[i], item.target_codec);
+            record_phase(phases[i], "transcode", started);
+            if (!transcoded) {
+                report_job_failure(item.job_id, "FFmpeg transcoding failed", phases[i]);
+                finish_job(item.job_id, files);
+                all_completed = false;
+                continue;
+            }
+        }
+        
+        std::string upload_url = "http://example.com/transcoded/" + item.job_id + ".mp4";
+        int64_t upload_started = epoch_ms();
+        bool uploaded = upload_result_file(output_files[i], upload_url, item.traceparent);
+        record_phase(phases[i], "upload", upload_started);
+        if (!uploaded) {
+            report_job_failure(item.job_id, "Failed to upload transcoded video", phases[i]);
+            finish_job(item.job_id, files);
+            all_completed = false;
+            continue;
+        }
+        if (!report_job_completion(item.job_id, upload_url, phases[i])) {
+            logging::error("jobs", "Failed to report job completion (job completed but not reported)", {{"job_id", item.job_id}});
+        }
+        finish_job(item.job_id, files);
+    }
+    return all_completed;
+}
+
+bool TranscodingEngine::run_job(const JobDetails& job, nlohmann::json checkpoint) {
+    std::string input_file = checkpoint.value("input_file", "");
+    std::string output_file = checkpoint.value("output_file", "");
     
     try {
         // Step 1: Download source file
-        if (!download_source_file(job.source_url, input_file)) {
-            report_job_failure(job.job_id, "Failed to download source video");
-            cleanup_temp_files(temp_files);
-            remove_job_from_queue(job.job_id);
-            return false;
+        if (checkpoint.value("stage", "") == "download") {
+            int64_t started = epoch_ms();
+            bool downloaded = download_source_file(job.source_url, input_file, job.traceparent);
+            record_phase(checkpoint["phases"], "download", started);
+            if (!downloaded) {
+                report_job_failure(job.job_id, "Failed to download source video", checkpoint["phases"]);
+                finish_job(job.job_id, checkpoint);
+                return false;
+            }
+            
+            if (is_job_cancelled(job.job_id)) {
+                logging::info("jobs", "Job cancelled by dispatcher", {{"job_id", job.job_id}});
+                finish_job(job.job_id, checkpoint);
+                return false;
+            }
+            
+            checkpoint["stage"] = "transcode";
+            if (preemption_requested(job.job_id)) {
+                return suspend_job(job, checkpoint);
+            }
         }
         
         // Step 2: Transcode
-        if (!transcode_file(input_file, output_file, job.target_codec)) {
-            report_job_failure(job.job_id, "FFmpeg transcoding failed");
-            cleanup_temp_files(temp_files);
-            remove_job_from_queue(job.job_id);
-            return false;
+        if (checkpoint.value("stage", "") == "transcode") {
+            bool suspended = false;
+            int64_t started = epoch_ms();
+            bool transcoded = config_.segment_seconds > 0
+                ? transcode_segments(job, checkpoint, suspended)
+                : transcode_file(input_file, output_file, job.target_codec);
+            if (suspended) {
+                return suspend_job(job, checkpoint);
+            }
+            // A resumed job's transcode phase covers the run that finished it
+            record_phase(checkpoint["phases"], "transcode", started);
+            
+            if (is_job_cancelled(job.job_id)) {
+                logging::info("jobs", "Job cancelled by dispatcher", {{"job_id", job.job_id}});
+                finish_job(job.job_id, checkpoint);
+                return false;
+            }
+            
+            if (!transcoded) {
+                report_job_failure(job.job_id, "FFmpeg transcoding failed", checkpoint["phases"]);
+                finish_job(job.job_id, checkpoint);
+                return false;
+            }
+            
+            checkpoint["stage"] = "upload";
+            if (preemption_requested(job.job_id)) {
+                return suspend_job(job, checkpoint);
+            }
         }
         
         // Step 3: Upload result
         std::string upload_url = "http://example.com/transcoded/" + job.job_id + ".mp4";
-        if (!upload_result_file(output_file, upload_url)) {
-            report_job_failure(job.job_id, "Failed to upload transcoded video");
-            cleanup_temp_files(temp_files);
-            remove_job_from_queue(job.job_id);
+        int64_t upload_started = epoch_ms();
+        bool uploaded = upload_result_file(output_file, upload_url, job.traceparent);
+        record_phase(checkpoint["phases"], "upload", upload_started);
+        if (!uploaded) {
+            report_job_failure(job.job_id, "Failed to upload transcoded video", checkpoint["phases"]);
+            finish_job(job.job_id, checkpoint);
             return false;
         }
         
         // Step 4: Report completion
-        if (!report_job_completion(job.job_id, upload_url)) {
-            std::cerr << "Failed to report job completion (job completed but not reported)" << std::endl;
+        if (!report_job_completion(job.job_id, upload_url, checkpoint["phases"])) {
+            logging::error("jobs", "Failed to report job completion (job completed but not reported)", {{"job_id", job.job_id}});
         }
         
         // Cleanup
-        cleanup_temp_files(temp_files);
-        remove_job_from_queue(job.job_id);
+        finish_job(job.job_id, checkpoint);
         
-        std::cout << "Successfully processed job: " << job.job_id << std::endl;
+        logging::info("jobs", "Processed job", {{"job_id", job.job_id}});
         return true;
         
     } catch (const std::exception& e) {
         handle_error("process_job", e.what());
-        report_job_failure(job.job_id, std::string("Exception during processing: ") + e.what());
-        cleanup_temp_files(temp_files);
-        remove_job_from_queue(job.job_id);
+        report_job_failure(job.job_id, std::string("Exception during processing: ") + e.what(),
+                           checkpoint.value("phases", nlohmann::json::object()));
+        finish_job(job.job_id, checkpoint);
         return false;
     }
 }
 
-bool TranscodingEngine::report_job_completion(const std::string& job_id, const std::string& output_url) {
+void TranscodingEngine::finish_job(const std::string& job_id, const nlohmann::json& checkpoint) {
+    cleanup_temp_files(checkpoint_files(checkpoint));
+    database_->remove_checkpoint(job_id);
+    remove_job_from_queue(job_id);
+}
+
+std::vector<std::string> TranscodingEngine::checkpoint_files(const nlohmann::json& checkpoint) {
+    std::string output_file = checkpoint.value("output_file", "");
+    std::vector<std::string> files = {checkpoint.value("input_file", ""), output_file,
+                                      output_file + ".segments.txt"};
+    for (int i = 0; i < checkpoint.value("segments", 0); ++i) {
+        files.push_back(output_file + ".part" + std::to_string(i) + ".mp4");
+    }
+    return files;
+}
+
+bool TranscodingEngine::preemption_requested(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    return !preempt_job_id_.empty() && preempt_job_id_ == job_id;
+}
+
+void TranscodingEngine::request_preemption(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    if (preempt_job_id_ != job_id) {
+        logging::info("jobs", "Dispatcher requested preemption", {{"job_id", job_id}});
+        preempt_job_id_ = job_id;
+    }
+}
+
+bool TranscodingEngine::suspend_job(const JobDetails& job, nlohmann::json checkpoint) {
+    checkpoint["job"] = {
+        {"job_id", job.job_id},
+        {"source_url", job.source_url},
+        {"target_codec", job.target_codec},
+        {"job_size", job.job_size},
+        {"traceparent", job.traceparent}
+    };
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        preempt_job_id_.clear();
+    }
+    // Temp files stay on disk; the checkpoint records where to pick up
+    if (!database_->save_checkpoint(job.job_id, checkpoint.dump())) {
+        logging::error("jobs", "Failed to save checkpoint, not suspending", {{"job_id", job.job_id}});
+        return run_job(job, checkpoint);
+    }
+    
+    report_job_suspended(job.job_id, {
+        {"stage", checkpoint.value("stage", "")},
+        {"segments_done", checkpoint.value("segments_done", 0)},
+        {"segments", checkpoint.value("segments", 0)}
+    });
+    poll_before_resume_ = true;
+    logging::info("jobs", "Suspended job", {{"job_id", job.job_id}, {"stage", checkpoint.value("stage", "")}});
+    return true;
+}
+
+bool TranscodingEngine::resume_suspended_job() {
+    auto suspended = take_suspended_job();
+    if (!suspended.has_value()) {
+        return false;
+    }
+    run_job(suspended->first, suspended->second);
+    return true;
+}
+
+std::optional<std::pair<JobDetails, nlohmann::json>> TranscodingEngine::take_suspended_job() {
+    for (const auto& job_id : get_queued_jobs()) {
+        // A resumed job keeps its checkpoint until it finishes
+        if (job_active(job_id)) {
+            continue;
+        }
+        std::string saved = database_->get_checkpoint(job_id);
+        if (saved.empty()) {
+            continue;
+        }
+        
+        auto checkpoint = nlohmann::json::parse(saved, nullptr, false);
+        std::optional<JobDetails> job;
+        if (!checkpoint.is_discarded()) {
+            job = job_from_json(checkpoint.value("job", nlohmann::json::object()));
+        }
+        if (!job.has_value()) {
+            logging::warn("jobs", "Discarding unreadable checkpoint", {{"job_id", job_id}});
+            finish_job(job_id, checkpoint.is_discarded() ? nlohmann::json::object() : checkpoint);
+            continue;
+        }
+        
+        if (!report_job_resumed(job_id)) {
+            // The dispatcher requeued it elsewhere while it was suspended
+            finish_job(job_id, checkpoint);
+            continue;
+        }
+        
+        logging::info("jobs", "Resuming job", {{"job_id", job_id}, {"stage", checkpoint.value("stage", "")}});
+        return std::make_pair(job.value(), checkpoint);
+    }
+    return std::nullopt;
+}
+
+bool TranscodingEngine::report_job_completion(const std::string& job_id, const std::string& output_url,
+                                              const nlohmann::json& phases) {
+    // engine_id lets the dispatcher tell a speculative copy from the primary run
     nlohmann::json completion_data = {
+        {"engine_id", config_.engine_id},
         {"output_url", output_url}
     };
+    if (phases.is_object() && !phases.empty()) {
+        completion_data["phases"] = phases;
+    }
+    
+    if (channel_enabled()) {
+        // Rides along with the next assignment request
+        queue_channel_frame({{"type", "complete"}, {"job_id", job_id}, {"body", completion_data}});
+        logging::info("reports", "Queued job completion", {{"job_id", job_id}});
+        return true;
+    }
     
     auto headers = create_auth_headers();
     headers["Content-Type"] = "application/json";
@@ -258,18 +561,33 @@ bool TranscodingEngine::report_job_completion(const std::string& job_id, const s
     auto response = http_client_->post(url, completion_data.dump(), headers);
     
     if (response.success) {
-        std::cout << "Reported job completion: " << job_id << std::endl;
+        logging::info("reports", "Reported job completion", {{"job_id", job_id}});
+        return true;
+    } else if (response.status_code == 409) {
+        // A speculative copy of this job finished first
+        logging::info("reports", "Job already completed by another engine", {{"job_id", job_id}});
         return true;
     } else {
-        std::cerr << "Failed to report job completion: " << response.error_message << std::endl;
+        logging::error("reports", "Failed to report job completion", {{"job_id", job_id}, {"error", response.error_message}});
         return false;
     }
 }
 
-bool TranscodingEngine::report_job_failure(const std::string& job_id, const std::string& error_message) {
+bool TranscodingEngine::report_job_failure(const std::string& job_id, const std::string& error_message,
+                                           const nlohmann::json& phases) {
     nlohmann::json failure_data = {
+        {"engine_id", config_.engine_id},
         {"error_message", error_message}
     };
+    if (phases.is_object() && !phases.empty()) {
+        failure_data["phases"] = phases;
+    }
+    
+    if (channel_enabled()) {
+        queue_channel_frame({{"type", "fail"}, {"job_id", job_id}, {"body", failure_data}});
+        logging::info("reports", "Queued job failure", {{"job_id", job_id}, {"error", error_message}});
+        return true;
+    }
     
     auto headers = create_auth_headers();
     headers["Content-Type"] = "application/json";
@@ -278,14 +596,89 @@ bool TranscodingEngine::report_job_failure(const std::string& job_id, const std:
     auto response = http_client_->post(url, failure_data.dump(), headers);
     
     if (response.success) {
-        std::cout << "Reported job failure: " << job_id << " - " << error_message << std::endl;
+        logging::info("reports", "Reported job failure", {{"job_id", job_id}, {"error", error_message}});
         return true;
     } else {
-        std::cerr << "Failed to report job failure: " << response.error_message << std::endl;
+        logging::error("reports", "Failed to report job failure", {{"job_id", job_id}, {"error", response.error_message}});
         return false;
     }
 }
 
+bool TranscodingEngine::report_job_progress(const std::string& job_id, int progress, const std::string& message) {
+    nlohmann::json progress_data = {
+        {"engine_id", config_.engine_id},
+        {"progress", progress},
+        {"message", message}
+    };
+    
+    if (channel_enabled()) {
+        queue_channel_frame({{"type", "progress"}, {"job_id", job_id}, {"body", progress_data}});
+        return true;
+    }
+    
+    auto headers = create_auth_headers();
+    headers["Content-Type"] = "application/json";
+    
+    std::string url = config_.dispatch_server_url + "/jobs/" + job_id + "/progress";
+    auto response = http_client_->post(url, progress_data.dump(), headers);
+    if (!response.success) {
+        logging::warn("reports", "Failed to report job progress", {{"job_id", job_id}, {"error", response.error_message}});
+        return false;
+    }
+    return true;
+}
+
+bool TranscodingEngine::report_job_suspended(const std::string& job_id, const nlohmann::json& checkpoint) {
+    nlohmann::json suspend_data = {
+        {"engine_id", config_.engine_id},
+        {"checkpoint", checkpoint}
+    };
+    
+    if (channel_enabled()) {
+        // Sent before the assign frame, so the urgent job is claimed in the same exchange
+        queue_channel_frame({{"type", "suspend"}, {"job_id", job_id}, {"body", suspend_data}});
+        return true;
+    }
+    
+    auto headers = create_auth_headers();
+    headers["Content-Type"] = "application/json";
+    
+    std::string url = config_.dispatch_server_url + "/jobs/" + job_id + "/suspend";
+    auto response = http_client_->post(url, suspend_data.dump(), headers);
+    
+    if (!response.success) {
+        logging::error("reports", "Failed to report job suspension", {{"job_id", job_id}, {"error", response.error_message}});
+    }
+    return response.success;
+}
+
+bool TranscodingEngine::report_job_resumed(const std::string& job_id) {
+    nlohmann::json resume_data = {
+        {"engine_id", config_.engine_id}
+    };
+    
+    if (channel_enabled()) {
+        queue_channel_frame({{"type", "resume"}, {"job_id", job_id}, {"body", resume_data}});
+        return true;
+    }
+    
+    auto headers = create_auth_headers();
+    headers["Content-Type"] = "application/json";
+    
+    std::string url = config_.dispatch_server_url + "/jobs/" + job_id + "/resume";
+    auto response = http_client_->post(url, resume_data.dump(), headers);
+    
+    if (response.status_code == 404 || response.status_code == 409) {
+        logging::warn("reports", "Dispatcher no longer holds suspended job for this engine", {{"job_id", job_id}});
+        return false;
+    }
+    if (!response.success) {
+        // Keep the work; the dispatcher learns about it from the next progress or completion
+        logging::error("reports", "Failed to report job resumption", {{"job_id", job_id}, {"error", response.error_message}});
+    }
+    return true;
+}
+
 std::string TranscodingEngine::get_ffmpeg_capabilities(const std::string& capability_type) {
     // Check cache first
     if (capability_type == "encoders" && !cached_encoders_.empty()) {
@@ -407,6 +800,11 @@ bool TranscodingEngine::send_benchmark_result(double benchmark_time) {
         {"benchmark_time", benchmark_time}
     };
     
+    if (channel_enabled()) {
+        queue_channel_frame({{"type", "benchmark"}, {"body", benchmark_data}});
+        return true;
+    }
+    
     auto headers = create_auth_headers();
     headers["Content-Type"] = "application/json";
     
@@ -421,6 +819,10 @@ bool TranscodingEngine::add_job_to_queue(const std::string& job_id) {
 }
 
 bool TranscodingEngine::remove_job_from_queue(const std::string& job_id) {
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        cancelled_jobs_.erase(job_id);
+    }
     return database_->remove_job(job_id);
 }
 
@@ -441,6 +843,8 @@ nlohmann::json TranscodingEngine::get_status() const {
         {"running", running_.load()},
         {"queued_jobs", queued_jobs},
         {"job_count", queued_jobs.size()},
+        {"slots", config_.max_concurrent_jobs},
+        {"busy_slots", busy_slots()},
         {"database_connected", database_->is_connected()}
     };
 }
@@ -478,9 +882,40 @@ void TranscodingEngine::benchmark_loop() {
 
 void TranscodingEngine::main_job_loop() {
     while (running_.load()) {
+        reap_slots();
+        if (busy_slots() >= static_cast<size_t>(config_.max_concurrent_jobs)) {
+            // Every slot is taken; poll again once one frees up
+            std::unique_lock<std::mutex> lock(slots_mutex_);
+            slot_freed_.wait_for(lock, std::chrono::seconds(1));
+            continue;
+        }
+        
+        // Suspended work continues once the urgent job it yielded to has been claimed
+        if (!poll_before_resume_.load()) {
+            auto suspended = take_suspended_job();
+            if (suspended.has_value()) {
+                JobDetails job = suspended->first;
+                nlohmann::json checkpoint = suspended->second;
+                start_slot(job.job_id, [this, job, checkpoint] { run_job(job, checkpoint); });
+                continue;
+            }
+        }
+        poll_before_resume_ = false;
+        
         auto job = get_job_from_dispatcher();
         if (job.has_value()) {
-            process_job(job.value());
+            JobDetails details = job.value();
+            if (!details.items.empty()) {
+                start_slot(details.job_id, [this, details] { process_batch(details); });
+            } else {
+                start_slot(details.job_id, [this, details] { process_job(details); });
+            }
+            if (busy_slots() < static_cast<size_t>(config_.max_concurrent_jobs)) {
+                continue; // Fill the remaining slots right away
+            }
+        }
+        if (last_poll_waited_) {
+            continue; // The dispatcher already waited for work on our behalf
         }
         
         for (int i = 0; i < config_.job_poll_interval_seconds && running_.load(); ++i) {
@@ -489,13 +924,64 @@ void TranscodingEngine::main_job_loop() {
     }
 }
 
+void TranscodingEngine::start_slot(const std::string& job_id, std::function<void()> work) {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    slots_.push_back({job_id, std::thread(), false});
+    Slot* slot = &slots_.back();
+    slot->thread = std::thread([this, slot, work] {
+        work();
+        std::lock_guard<std::mutex> lock(slots_mutex_);
+        slot->done = true;
+        slot_freed_.notify_all();
+    });
+}
+
+void TranscodingEngine::reap_slots() {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        if (it->done) {
+            it->thread.join(); // Already past its last use of the lock
+            it = slots_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t TranscodingEngine::busy_slots() const {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    return std::count_if(slots_.begin(), slots_.end(), [](const Slot& slot) { return !slot.done; });
+}
+
+bool TranscodingEngine::job_active(const std::string& job_id) const {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    return std::any_of(slots_.begin(), slots_.end(),
+                       [&](const Slot& slot) { return !slot.done && slot.job_id == job_id; });
+}
+
+nlohmann::json TranscodingEngine::capacity() const {
+    nlohmann::json capacity = {
+        {"slots", config_.max_concurrent_jobs},
+        {"scratch_gb", config_.storage_capacity_gb}
+    };
+    if (unsigned cores = std::thread::hardware_concurrency()) {
+        capacity["cpu_cores"] = cores;
+    }
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && page_size > 0) {
+        capacity["memory_gb"] = static_cast<double>(pages) * page_size / (1024.0 * 1024.0 * 1024.0);
+    }
+    return capacity;
+}
+
 bool TranscodingEngine::send_heartbeat() {
     auto queued_jobs = get_queued_jobs();
     
     nlohmann::json heartbeat_data = {
         {"engine_id", config_.engine_id},
         {"engine_type", "transcoder"},
-        {"status", "idle"},
+        {"status", busy_slots() >= static_cast<size_t>(config_.max_concurrent_jobs) ? "busy" : "idle"},
         {"storage_capacity_gb", config_.storage_capacity_gb},
         {"streaming_support", config_.streaming_support},
         {"encoders", get_ffmpeg_capabilities("encoders")},
@@ -503,8 +989,22 @@ bool TranscodingEngine::send_heartbeat() {
         {"hwaccels", get_ffmpeg_hw_accels()},
         {"cpu_temperature", get_cpu_temperature()},
         {"local_job_queue", queued_jobs},
-        {"hostname", config_.hostname}
+        {"hostname", config_.hostname},
+        {"preemptible", config_.segment_seconds > 0},
+        {"capacity", capacity()},
+        // Exposed by the dispatcher as dispatch_engine_log_records_dropped_total
+        {"log_records_dropped", logging::logger().dropped()}
     };
+    if (source_cache_) {
+        // Lets the dispatcher route jobs for these sources back here
+        heartbeat_data["source_cache"] = source_cache_->summary();
+    }
+    
+    if (channel_enabled()) {
+        // Flushes queued progress, benchmark and completion frames too
+        queue_channel_frame({{"type", "heartbeat"}, {"body", heartbeat_data}});
+        return exchange_channel(false);
+    }
     
     auto headers = create_auth_headers();
     headers["Content-Type"] = "application/json";
@@ -512,18 +1012,139 @@ bool TranscodingEngine::send_heartbeat() {
     std::string url = config_.dispatch_server_url + "/engines/heartbeat";
     auto response = http_client_->post(url, heartbeat_data.dump(), headers);
     
+    auto preempt = response.headers.find("X-Preempt-Job");
+    if (response.success && preempt != response.headers.end() && !preempt->second.empty()) {
+        request_preemption(preempt->second);
+    }
     return response.success;
 }
 
-bool TranscodingEngine::download_source_file(const std::string& source_url, const std::string& output_path) {
+bool TranscodingEngine::channel_enabled() const {
+    return config_.use_dispatch_channel && channel_available_.load();
+}
+
+void TranscodingEngine::queue_channel_frame(nlohmann::json frame) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    channel_outbox_.push_back(std::move(frame));
+}
+
+bool TranscodingEngine::is_job_cancelled(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    return cancelled_jobs_.count(job_id) > 0;
+}
+
+bool TranscodingEngine::exchange_channel(bool request_assignment, std::optional<JobDetails>* assignment) {
+    std::vector<nlohmann::json> frames;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        frames.swap(channel_outbox_);
+    }
+    
+    nlohmann::json batch = frames;
+    if (request_assignment) {
+        nlohmann::json assign = {{"type", "assign"}};
+        if (config_.max_batch_items > 1) {
+            assign["body"] = {{"max_batch", config_.max_batch_items}};
+        }
+        batch.push_back(assign);
+    }
+    nlohmann::json request_data = {
+        {"engine_id", config_.engine_id},
+        {"active_jobs", get_queued_jobs()},
+        {"frames", batch}
+    };
+    
+    auto headers = create_auth_headers();
+    headers["Content-Type"] = "application/json";
+    
+    std::string url = config_.dispatch_server_url + "/engines/channel";
+    if (request_assignment && config_.assign_wait_seconds > 0) {
+        url += "?wait=" + std::to_string(config_.assign_wait_seconds) + "s";
+    }
+    auto response = http_client_->post(url, request_data.dump(), headers);
+    
+    if (response.status_code == 404 || response.status_code == 405) {
+        // Older dispatcher: use the REST endpoints from now on
+        logging::warn("channel", "Dispatcher has no /engines/channel, falling back to REST");
+        channel_available_.store(false);
+        for (const auto& frame : frames) {
+            send_frame_via_rest(frame);
+        }
+        return false;
+    }
+    
+    if (!response.success) {
+        logging::error("channel", "Dispatcher channel exchange failed", {{"error", response.error_message}});
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        channel_outbox_.insert(channel_outbox_.begin(), frames.begin(), frames.end());
+        return false;
+    }
+    
+    try {
+        auto downlink = nlohmann::json::parse(response.body).value("frames", nlohmann::json::array());
+        for (const auto& frame : downlink) {
+            std::string type = frame.value("type", "");
+            if (type == "assignment" && assignment) {
+                *assignment = job_from_json(frame.value("job", nlohmann::json::object()));
+            } else if (type == "cancel") {
+                std::lock_guard<std::mutex> lock(channel_mutex_);
+                cancelled_jobs_.insert(frame.value("job_id", ""));
+            } else if (type == "preempt") {
+                request_preemption(frame.value("job_id", ""));
+            } else if (type == "ack" && frame.value("status", 200) >= 400) {
+                logging::warn("channel", "Dispatcher rejected frame",
+                              {{"frame", frame.value("frame", "")}, {"body", frame.value("body", nlohmann::json())}});
+            }
+        }
+    } catch (const nlohmann::json::exception& e) {
+        logging::error("channel", "Failed to parse channel response", {{"error", e.what()}});
+        return false;
+    }
+    return true;
+}
+
+bool TranscodingEngine::send_frame_via_rest(const nlohmann::json& frame) {
+    std::string type = frame.value("type", "");
+    std::string path;
+    if (type == "heartbeat") {
+        path = "/engines/heartbeat";
+    } else if (type == "benchmark") {
+        path = "/engines/benchmark_result";
+    } else if (type == "progress" || type == "complete" || type == "fail" || type == "suspend" ||
+               type == "resume") {
+        path = "/jobs/" + frame.value("job_id", "") + "/" + type;
+    } else {
+        return false;
+    }
+    
     auto headers = create_auth_headers();
+    headers["Content-Type"] = "application/json";
+    
+    auto body = frame.value("body", nlohmann::json::object());
+    return http_client_->post(config_.dispatch_server_url + path, body.dump(), headers).success;
+}
+
+bool TranscodingEngine::download_source_file(const std::string& source_url, const std::string& output_path,
+                                             const std::string& traceparent) {
+    if (source_cache_ && source_cache_->fetch(source_url, output_path)) {
+        logging::debug("transfer", "Using cached source file", {{"path", output_path}});
+        return true;
+    }
+    
+    auto headers = create_auth_headers();
+    if (!traceparent.empty()) {
+        headers["traceparent"] = traceparent;
+    }
     auto response = http_client_->download_file(source_url, output_path, headers);
     
     if (response.success && std::filesystem::exists(output_path)) {
-        std::cout << "Downloaded source file: " << output_path << std::endl;
+        logging::info("transfer", "Downloaded source file", {{"path", output_path}});
+        if (source_cache_) {
+            source_cache_->store(source_url, output_path);
+        }
         return true;
     } else {
-        std::cerr << "Failed to download source file: " << response.error_message << std::endl;
+        logging::error("transfer", "Failed to download source file", {{"url", source_url}, {"error", response.error_message}});
         return false;
     }
 }
@@ -540,27 +1161,149 @@ bool TranscodingEngine::transcode_file(const std::string& input_path, const std:
     auto result = subprocess_runner_->run(command);
     
     if (result.success && std::filesystem::exists(output_path)) {
-        std::cout << "Transcoded file successfully: " << output_path << std::endl;
+        logging::info("ffmpeg", "Transcoded file", {{"path", output_path}});
         return true;
     } else {
-        std::cerr << "FFmpeg transcoding failed: " << result.stderr_output << std::endl;
+        logging::error("ffmpeg", "FFmpeg transcoding failed", {{"stderr", result.stderr_output}});
         return false;
     }
 }
 
-bool TranscodingEngine::upload_result_file(const std::string& file_path, const std::string& upload_url) {
+bool TranscodingEngine::transcode_batch(const std::vector<std::string>& input_paths,
+                                        const std::vector<std::string>& output_paths,
+                                        const std::string& target_codec) {
+    // ffmpeg -y -i a -i b ... -map 0 -c:v codec out_a -map 1 -c:v codec out_b ...
+    std::vector<std::string> command = {"ffmpeg", "-y"};
+    for (const auto& input_path : input_paths) {
+        command.insert(command.end(), {"-i", input_path});
+    }
+    for (size_t i = 0; i < output_paths.size(); ++i) {
+        command.insert(command.end(), {"-map", std::to_string(i), "-c:v", target_codec, output_paths[i]});
+    }
+    
+    auto result = subprocess_runner_->run(command);
+    bool all_written = std::all_of(output_paths.begin(), output_paths.end(),
+                                   [](const std::string& path) { return std::filesystem::exists(path); });
+    if (result.success && all_written) {
+        logging::info("ffmpeg", "Transcoded batch", {{"files", output_paths.size()}});
+        return true;
+    }
+    logging::error("ffmpeg", "FFmpeg batch transcoding failed", {{"stderr", result.stderr_output}});
+    return false;
+}
+
+bool TranscodingEngine::transcode_segments(const JobDetails& job, nlohmann::json& checkpoint, bool& suspended) {
+    std::string input_file = checkpoint.value("input_file", "");
+    std::string output_file = checkpoint.value("output_file", "");
+    
+    if (!checkpoint.contains("segments")) {
+        double duration = probe_duration(input_file);
+        if (duration <= 0) {
+            // Unknown length: fall back to one uninterruptible pass
+            return transcode_file(input_file, output_file, job.target_codec);
+        }
+        checkpoint["segments"] = static_cast<int>(std::ceil(duration / config_.segment_seconds));
+    }
+    
+    int segments = checkpoint.value("segments", 0);
+    for (int i = checkpoint.value("segments_done", 0); i < segments; ++i) {
+        if (is_job_cancelled(job.job_id)) {
+            return false;
+        }
+        if (preemption_requested(job.job_id)) {
+            suspended = true;
+            return false;
+        }
+        
+        std::string part = output_file + ".part" + std::to_string(i) + ".mp4";
+        std::vector<std::string> command = {
+            "ffmpeg", "-y",
+            "-ss", std::to_string(i * config_.segment_seconds),
+            "-t", std::to_string(config_.segment_seconds),
+            "-i", input_file,
+            "-c:v", job.target_codec,
+            part
+        };
+        auto result = subprocess_runner_->run(command);
+        if (!result.success) {
+            logging::error("ffmpeg", "FFmpeg failed on segment", {{"segment", i}, {"stderr", result.stderr_output}});
+            return false;
+        }
+        checkpoint["segments_done"] = i + 1;
+        // 100 is left for the completion report
+        report_job_progress(job.job_id, std::min(99, (i + 1) * 100 / segments),
+                            "Segment " + std::to_string(i + 1) + " of " + std::to_string(segments));
+    }
+    
+    std::string list_file = output_file + ".segments.txt";
+    {
+        std::ofstream list(list_file);
+        for (int i = 0; i < segments; ++i) {
+            list << "file '" << std::filesystem::absolute(output_file + ".part" + std::to_string(i) + ".mp4").string()
+                 << "'\n";
+        }
+    }
+    
+    std::vector<std::string> command = {
+        "ffmpeg", "-y",
+        "-f", "concat", "-safe", "0",
+        "-i", list_file,
+        "-c", "copy",
+        output_file
+    };
+    auto result = subprocess_runner_->run(command);
+    if (result.success && std::filesystem::exists(output_file)) {
+        logging::info("ffmpeg", "Transcoded segments", {{"segments", segments}, {"path", output_file}});
+        return true;
+    }
+    logging::error("ffmpeg", "FFmpeg segment concatenation failed", {{"stderr", result.stderr_output}});
+    return false;
+}
+
+double TranscodingEngine::probe_duration(const std::string& input_path) {
+    std::vector<std::string> command = {
+        "ffprobe", "-v", "error",
+        "-show_entries", "format=duration",
+        "-of", "default=noprint_wrappers=1:nokey=1",
+        input_path
+    };
+    auto result = subprocess_runner_->run(command);
+    if (!result.success) {
+        return 0.0;
+    }
+    try {
+        return std::stod(result.stdout_output);
+    } catch (const std::exception&) {
+        return 0.0;
+    }
+}
+
+bool TranscodingEngine::upload_result_file(const std::string& file_path, const std::string& upload_url,
+                                           const std::string& traceparent) {
     auto headers = create_auth_headers();
+    if (!traceparent.empty()) {
+        headers["traceparent"] = traceparent;
+    }
     auto response = http_client_->upload_file(upload_url, file_path, headers);
     
     if (response.success) {
-        std::cout << "Uploaded result file to: " << upload_url << std::endl;
+        logging::info("transfer", "Uploaded result file", {{"url", upload_url}});
         return true;
     } else {
-        std::cerr << "Failed to upload result file: " << response.error_message << std::endl;
+        logging::error("transfer", "Failed to upload result file", {{"url", upload_url}, {"error", response.error_message}});
         return false;
     }
 }
 
+void TranscodingEngine::record_phase(nlohmann::json& phases, const std::string& name, int64_t start_ms) {
+    phases[name] = {{"start_ms", start_ms}, {"end_ms", epoch_ms()}};
+}
+
+int64_t TranscodingEngine::epoch_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 std::map<std::string, std::string> TranscodingEngine::create_auth_headers() const {
     std::map<std::string, std::string> headers;
     if (!config_.api_key.empty()) {
@@ -581,9 +1324,9 @@ bool TranscodingEngine::cleanup_temp_files(const std::vector<std::string>& file_
         if (std::filesystem::exists(file_path)) {
             try {
                 std::filesystem::remove(file_path);
-                std::cout << "Cleaned up temp file: " << file_path << std::endl;
+                logging::debug("engine", "Cleaned up temp file", {{"path", file_path}});
             } catch (const std::exception& e) {
-                std::cerr << "Failed to cleanup temp file " << file_path << ": " << e.what() << std::endl;
+                logging::warn("engine", "Failed to clean up temp file", {{"path", file_path}, {"error", e.what()}});
                 all_cleaned = false;
             }
         }
@@ -592,7 +1335,7 @@ bool TranscodingEngine::cleanup_temp_files(const std::vector<std::string>& file_
 }
 
 void TranscodingEngine::handle_error(const std::string& context, const std::string& error_message) {
-    std::cerr << "Error in " << context << ": " << error_message << std::endl;
+    logging::error("engine", "Error in " + context, {{"error", error_message}});
 }
 
 bool TranscodingEngine::is_recoverable_error(const std::string& error_message) {
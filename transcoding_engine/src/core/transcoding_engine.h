@@ -4,6 +4,8 @@
 #include "../interfaces/http_client_interface.h"
 #include "../interfaces/database_interface.h"
 #include "../interfaces/subprocess_interface.h"
+#include "source_cache.h"
+#include "structured_log.hpp"
 #include <nlohmann/json.hpp>
 #include <memory>
 #include <string>
@@ -12,6 +14,11 @@
 #include <thread>
 #include <optional>
 #include <fstream>
+#include <mutex>
+#include <set>
+#include <list>
+#include <condition_variable>
+#include <functional>
 
 namespace distconv {
 namespace TranscodingEngine {
@@ -28,8 +35,16 @@ struct EngineConfig {
     int heartbeat_interval_seconds = 5;
     int benchmark_interval_minutes = 5;
     int job_poll_interval_seconds = 1;
+    int assign_wait_seconds = 0; // > 0 parks /assign_job/ server-side instead of polling
+    bool use_dispatch_channel = false; // Batch traffic over POST /engines/channel
+    std::string source_cache_dir; // Keep downloaded sources here and advertise them; empty disables
+    int source_cache_max_entries = 64;
+    int segment_seconds = 0; // > 0 transcodes in segments so a preempted job can stop between them
+    int max_concurrent_jobs = 1; // Slots advertised in the heartbeat "capacity" and run in parallel
+    int max_batch_items = 1; // > 1 accepts batches of small jobs encoded by one ffmpeg process in one slot
     int http_timeout_seconds = 30;
     bool test_mode = false;
+    logging::LogOptions log; // Process-wide JSON-lines logging, applied by main
 };
 
 struct JobDetails {
@@ -37,6 +52,11 @@ struct JobDetails {
     std::string source_url;
     std::string target_codec;
     double job_size = 0.0;
+    // W3C traceparent of the dispatcher's job trace, sent with the download and upload
+    std::string traceparent;
+    // A batched assignment: job_id is the batch_id and items are its jobs
+    std::string batch_id;
+    std::vector<JobDetails> items;
 };
 
 class TranscodingEngine {
@@ -56,8 +76,25 @@ public:
     bool register_with_dispatcher();
     std::optional<JobDetails> get_job_from_dispatcher();
     bool process_job(const JobDetails& job);
-    bool report_job_completion(const std::string& job_id, const std::string& output_url);
-    bool report_job_failure(const std::string& job_id, const std::string& error_message);
+    // Runs a batch's jobs through one ffmpeg invocation and reports each job on its own;
+    // returns true when every job completed
+    bool process_batch(const JobDetails& batch);
+    // phases: {"download"|"transcode"|"upload": {"start_ms", "end_ms"}} for the dispatcher's job trace
+    bool report_job_completion(const std::string& job_id, const std::string& output_url,
+                               const nlohmann::json& phases = nlohmann::json::object());
+    bool report_job_failure(const std::string& job_id, const std::string& error_message,
+                            const nlohmann::json& phases = nlohmann::json::object());
+    // Sent after each segment so the dispatcher can tell a stalled job from a slow one
+    bool report_job_progress(const std::string& job_id, int progress, const std::string& message);
+    
+    // Preemption: the dispatcher asks (channel "preempt" frame or X-Preempt-Job
+    // heartbeat header) to suspend a running job for an urgent one. The job is
+    // checkpointed to the local DB at the next stage or segment boundary and
+    // resumed once the urgent job has been picked up.
+    bool report_job_suspended(const std::string& job_id, const nlohmann::json& checkpoint);
+    bool report_job_resumed(const std::string& job_id);
+    bool resume_suspended_job();
+    void request_preemption(const std::string& job_id);
     
     // System monitoring
     std::string get_ffmpeg_capabilities(const std::string& capability_type);
@@ -72,6 +109,12 @@ public:
     bool remove_job_from_queue(const std::string& job_id);
     std::vector<std::string> get_queued_jobs();
     
+    // Dispatcher channel: queued frames go out with the next exchange. Returns
+    // false when the exchange failed; an assignment, if requested and available,
+    // is returned through `assignment`.
+    bool exchange_channel(bool request_assignment, std::optional<JobDetails>* assignment = nullptr);
+    bool is_job_cancelled(const std::string& job_id);
+    
     // Configuration and status
     const EngineConfig& get_config() const;
     nlohmann::json get_status() const;
@@ -88,22 +131,69 @@ private:
     
     // Threading
     std::atomic<bool> running_{false};
+    bool last_poll_waited_ = false; // Server already held the last empty poll
+    
+    // Dispatcher channel state; falls back to REST when the server lacks it
+    std::atomic<bool> channel_available_{true};
+    std::mutex channel_mutex_;
+    std::vector<nlohmann::json> channel_outbox_;
+    std::set<std::string> cancelled_jobs_;
+    std::string preempt_job_id_;     // Guarded by channel_mutex_
+    std::atomic<bool> poll_before_resume_{false}; // Claim the urgent job before resuming suspended work
+    std::unique_ptr<SourceCache> source_cache_;
     std::thread heartbeat_thread_;
     std::thread benchmark_thread_;
     std::thread main_loop_thread_;
     
+    // Job slots: each running job has its own thread, started by the main loop
+    struct Slot {
+        std::string job_id;
+        std::thread thread;
+        bool done = false;
+    };
+    mutable std::mutex slots_mutex_;
+    std::condition_variable slot_freed_;
+    std::list<Slot> slots_; // Guarded by slots_mutex_
+    
     // Internal methods
     void heartbeat_loop();
     void benchmark_loop();
     void main_job_loop();
+    void start_slot(const std::string& job_id, std::function<void()> work);
+    void reap_slots();
+    size_t busy_slots() const;
+    bool job_active(const std::string& job_id) const;
+    nlohmann::json capacity() const;
     
     std::ifstream thermal_file_;
 
-    // Job processing
-    bool download_source_file(const std::string& source_url, const std::string& output_path);
+    // Job processing; checkpoint holds the stage, temp files and finished segments
+    bool run_job(const JobDetails& job, nlohmann::json checkpoint);
+    bool suspend_job(const JobDetails& job, nlohmann::json checkpoint);
+    // Next suspended job not already running, reported resumed, with its checkpoint
+    std::optional<std::pair<JobDetails, nlohmann::json>> take_suspended_job();
+    bool preemption_requested(const std::string& job_id);
+    void finish_job(const std::string& job_id, const nlohmann::json& checkpoint);
+    bool transcode_segments(const JobDetails& job, nlohmann::json& checkpoint, bool& suspended);
+    double probe_duration(const std::string& input_path);
+    static std::vector<std::string> checkpoint_files(const nlohmann::json& checkpoint);
+    bool download_source_file(const std::string& source_url, const std::string& output_path,
+                              const std::string& traceparent = "");
     bool transcode_file(const std::string& input_path, const std::string& output_path, 
                        const std::string& target_codec);
-    bool upload_result_file(const std::string& file_path, const std::string& upload_url);
+    bool transcode_batch(const std::vector<std::string>& input_paths, const std::vector<std::string>& output_paths,
+                         const std::string& target_codec);
+    bool upload_result_file(const std::string& file_path, const std::string& upload_url,
+                            const std::string& traceparent = "");
+    // Sets phases[name] to {start_ms, now} in epoch milliseconds
+    static void record_phase(nlohmann::json& phases, const std::string& name, int64_t start_ms);
+    static int64_t epoch_ms();
+    
+    // Dispatcher channel helpers
+    bool channel_enabled() const;
+    void queue_channel_frame(nlohmann::json frame);
+    bool send_frame_via_rest(const nlohmann::json& frame);
+    static std::optional<JobDetails> job_from_json(const nlohmann::json& job_json);
     
     // Utility methods
     std::map<std::string, std::string> create_auth_headers() const;
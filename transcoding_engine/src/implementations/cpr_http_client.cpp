@@ -51,6 +51,8 @@ void CprHttpClient::set_timeout(int timeout_seconds) {
 #include <cpr/cpr.h>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 namespace distconv {
 namespace TranscodingEngine {
@@ -60,6 +62,40 @@ public:
     std::string ca_cert_path_;
     bool ssl_verify_ = true;
     int timeout_seconds_ = 30;
+
+    // Idle sessions keep their curl handle, and with it the dispatcher
+    // connection, alive between requests. Each call borrows one so the
+    // heartbeat, benchmark and job loops never share a handle.
+    static constexpr size_t kMaxIdleSessions = 4;
+    std::mutex sessions_mutex_;
+    std::vector<std::unique_ptr<cpr::Session>> idle_sessions_;
+
+    std::unique_ptr<cpr::Session> acquire_session() {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (idle_sessions_.empty()) {
+            return std::make_unique<cpr::Session>();
+        }
+        auto session = std::move(idle_sessions_.back());
+        idle_sessions_.pop_back();
+        return session;
+    }
+
+    void release_session(std::unique_ptr<cpr::Session> session) {
+        std::lock_guard<std::mutex> lock(sessions_mutex_);
+        if (idle_sessions_.size() < kMaxIdleSessions) {
+            idle_sessions_.push_back(std::move(session));
+        }
+    }
+
+    void prepare_session(cpr::Session& session, const std::string& url,
+                         const std::map<std::string, std::string>& headers) {
+        session.SetUrl(cpr::Url{url});
+        session.SetHeader(create_headers(headers));
+        session.SetSslOptions(create_ssl_options());
+        session.SetTimeout(cpr::Timeout{timeout_seconds_ * 1000});
+        // The dispatcher gzips large JSON replies; curl inflates them transparently
+        session.SetAcceptEncoding(cpr::AcceptEncoding{{cpr::AcceptEncodingMethods::gzip}});
+    }
     
     cpr::Header create_headers(const std::map<std::string, std::string>& headers) {
         cpr::Header cpr_headers;
@@ -110,12 +146,10 @@ CprHttpClient::~CprHttpClient() = default;
 HttpResponse CprHttpClient::get(const std::string& url, 
                                const std::map<std::string, std::string>& headers) {
     try {
-        auto response = cpr::Get(
-            cpr::Url{url},
-            pimpl_->create_headers(headers),
-            pimpl_->create_ssl_options(),
-            cpr::Timeout{pimpl_->timeout_seconds_ * 1000}
-        );
+        auto session = pimpl_->acquire_session();
+        pimpl_->prepare_session(*session, url, headers);
+        auto response = session->Get();
+        pimpl_->release_session(std::move(session));
         
         return pimpl_->convert_response(response);
     } catch (const std::exception& e) {
@@ -127,13 +161,11 @@ HttpResponse CprHttpClient::post(const std::string& url,
                                 const std::string& body,
                                 const std::map<std::string, std::string>& headers) {
     try {
-        auto response = cpr::Post(
-            cpr::Url{url},
-            cpr::Body{body},
-            pimpl_->create_headers(headers),
-            pimpl_->create_ssl_options(),
-            cpr::Timeout{pimpl_->timeout_seconds_ * 1000}
-        );
+        auto session = pimpl_->acquire_session();
+        pimpl_->prepare_session(*session, url, headers);
+        session->SetBody(cpr::Body{body});
+        auto response = session->Post();
+        pimpl_->release_session(std::move(session));
         
         return pimpl_->convert_response(response);
     } catch (const std::exception& e) {
@@ -1,5 +1,5 @@
 #include "redis_message_queue.h"
-#include <iostream>
+#include "structured_log.hpp"
 #include <uuid/uuid.h>
 #include <chrono>
 
@@ -17,7 +17,7 @@ bool RedisMessageQueueProducer::publish(const std::string& topic, const std::str
         redis_->xadd(topic, "*", attrs.begin(), attrs.end());
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis publish error: " << e.what() << std::endl;
+        logging::error("redis", "Redis publish error", {{"topic", topic}, {"error", e.what()}});
         return false;
     }
 }
@@ -64,10 +64,10 @@ void RedisMessageQueueConsumer::subscribe(const std::string& topic, std::functio
         // Ignore if group already exists (BUSYGROUP)
         std::string msg = e.what();
         if (msg.find("BUSYGROUP") == std::string::npos) {
-             std::cerr << "Warning creating group: " << e.what() << std::endl;
+             logging::warn("redis", "Could not create consumer group", {{"topic", topic}, {"error", e.what()}});
         }
     } catch (const std::exception& e) {
-         std::cerr << "Error creating group: " << e.what() << std::endl;
+         logging::error("redis", "Could not create consumer group", {{"topic", topic}, {"error", e.what()}});
     }
 
     std::lock_guard<std::mutex> lock(threads_mutex_);
@@ -110,10 +110,10 @@ void RedisMessageQueueConsumer::pollLoop(std::string topic, std::function<void(c
             // Timeout is expected
             continue;
         } catch (const sw::redis::Error& e) {
-             std::cerr << "Redis poll error: " << e.what() << std::endl;
+             logging::error("redis", "Redis poll error", {{"error", e.what()}});
              std::this_thread::sleep_for(std::chrono::seconds(1));
         } catch (const std::exception& e) {
-            std::cerr << "Redis poll exception: " << e.what() << std::endl;
+            logging::error("redis", "Redis poll exception", {{"error", e.what()}});
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
     }
@@ -124,7 +124,7 @@ bool RedisMessageQueueConsumer::ack(const Message& message) {
         redis_->xack(message.topic, group_id_, {message.id});
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis ack error: " << e.what() << std::endl;
+        logging::error("redis", "Redis ack error", {{"topic", message.topic}, {"error", e.what()}});
         return false;
     }
 }
@@ -148,7 +148,7 @@ bool RedisMessageQueueConsumer::nack(const Message& message) {
         
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "Redis nack error: " << e.what() << std::endl;
+        logging::error("redis", "Redis nack error", {{"topic", message.topic}, {"error", e.what()}});
         return false;
     }
 }
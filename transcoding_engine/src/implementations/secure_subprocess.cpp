@@ -83,7 +83,8 @@ private:
         close(stderr_pipe[1]);
         close(stdin_pipe[0]);
         
-        // Change working directory if specified
+        // Change working directory if specified. This is the forked child, where
+        // the logger's writer thread does not exist, so errors go straight to stderr
         if (!working_directory.empty()) {
             if (chdir(working_directory.c_str()) != 0) {
                 std::cerr << "Failed to change directory to: " << working_directory << std::endl;
@@ -1,6 +1,6 @@
 #include "sqlite_database.h"
+#include "structured_log.hpp"
 #include <sqlite3.h>
-#include <iostream>
 #include <filesystem>
 
 namespace distconv {
@@ -35,7 +35,7 @@ public:
             int rc = sqlite3_exec(db_, query.c_str(), callback, results, &error_message);
             
             if (rc != SQLITE_OK) {
-                std::cerr << "SQL error: " << error_message << std::endl;
+                logging::error("database", "SQL error", {{"error", error_message}});
                 sqlite3_free(error_message);
                 return false;
             }
@@ -44,7 +44,7 @@ public:
             int rc = sqlite3_exec(db_, query.c_str(), nullptr, nullptr, &error_message);
             
             if (rc != SQLITE_OK) {
-                std::cerr << "SQL error: " << error_message << std::endl;
+                logging::error("database", "SQL error", {{"error", error_message}});
                 sqlite3_free(error_message);
                 return false;
             }
@@ -58,7 +58,7 @@ public:
         int rc = sqlite3_prepare_v2(db_, query.c_str(), -1, &stmt, nullptr);
         
         if (rc != SQLITE_OK) {
-            std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db_) << std::endl;
+            logging::error("database", "Failed to prepare statement", {{"error", sqlite3_errmsg(db_)}});
             return false;
         }
         
@@ -66,7 +66,7 @@ public:
         for (size_t i = 0; i < params.size(); ++i) {
             rc = sqlite3_bind_text(stmt, static_cast<int>(i + 1), params[i].c_str(), -1, SQLITE_STATIC);
             if (rc != SQLITE_OK) {
-                std::cerr << "Failed to bind parameter " << i << ": " << sqlite3_errmsg(db_) << std::endl;
+                logging::error("database", "Failed to bind parameter", {{"index", i}, {"error", sqlite3_errmsg(db_)}});
                 sqlite3_finalize(stmt);
                 return false;
             }
@@ -76,7 +76,7 @@ public:
         sqlite3_finalize(stmt);
         
         if (rc != SQLITE_DONE) {
-            std::cerr << "Failed to execute statement: " << sqlite3_errmsg(db_) << std::endl;
+            logging::error("database", "Failed to execute statement", {{"error", sqlite3_errmsg(db_)}});
             return false;
         }
         
@@ -97,7 +97,7 @@ bool SqliteDatabase::initialize(const std::string& db_path) {
     
     int rc = sqlite3_open(db_path.c_str(), &pimpl_->db_);
     if (rc != SQLITE_OK) {
-        std::cerr << "Can't open database: " << sqlite3_errmsg(pimpl_->db_) << std::endl;
+        logging::error("database", "Can't open database", {{"path", db_path}, {"error", sqlite3_errmsg(pimpl_->db_)}});
         return false;
     }
     
@@ -111,8 +111,19 @@ bool SqliteDatabase::initialize(const std::string& db_path) {
     if (!pimpl_->execute_query(create_table_query)) {
         return false;
     }
+
+    const std::string create_checkpoints_query =
+        "CREATE TABLE IF NOT EXISTS checkpoints("
+        "job_id TEXT PRIMARY KEY NOT NULL,"
+        "checkpoint TEXT NOT NULL,"
+        "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ");";
+
+    if (!pimpl_->execute_query(create_checkpoints_query)) {
+        return false;
+    }
     
-    std::cout << "SQLite database initialized successfully: " << db_path << std::endl;
+    logging::info("database", "SQLite database initialized", {{"path", db_path}});
     return true;
 }
 
@@ -219,6 +230,57 @@ bool SqliteDatabase::clear_all_jobs() {
     return pimpl_->execute_query(query);
 }
 
+bool SqliteDatabase::save_checkpoint(const std::string& job_id, const std::string& checkpoint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!pimpl_->db_) {
+        return false;
+    }
+    
+    const std::string query = "INSERT OR REPLACE INTO checkpoints (job_id, checkpoint) VALUES (?, ?);";
+    return pimpl_->execute_prepared_statement(query, {job_id, checkpoint});
+}
+
+std::string SqliteDatabase::get_checkpoint(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!pimpl_->db_) {
+        return "";
+    }
+    
+    sqlite3_stmt* stmt;
+    const std::string query = "SELECT checkpoint FROM checkpoints WHERE job_id = ?;";
+    
+    int rc = sqlite3_prepare_v2(pimpl_->db_, query.c_str(), -1, &stmt, nullptr);
+    if (rc != SQLITE_OK) {
+        return "";
+    }
+    
+    sqlite3_bind_text(stmt, 1, job_id.c_str(), -1, SQLITE_STATIC);
+    
+    std::string checkpoint;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text) {
+            checkpoint = reinterpret_cast<const char*>(text);
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    return checkpoint;
+}
+
+bool SqliteDatabase::remove_checkpoint(const std::string& job_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!pimpl_->db_) {
+        return false;
+    }
+    
+    const std::string query = "DELETE FROM checkpoints WHERE job_id = ?;";
+    return pimpl_->execute_prepared_statement(query, {job_id});
+}
+
 void SqliteDatabase::close() {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -20,6 +20,9 @@ public:
     bool job_exists(const std::string& job_id) override;
     size_t get_job_count() override;
     bool clear_all_jobs() override;
+    bool save_checkpoint(const std::string& job_id, const std::string& checkpoint) override;
+    std::string get_checkpoint(const std::string& job_id) override;
+    bool remove_checkpoint(const std::string& job_id) override;
     void close() override;
     bool is_connected() const override;
 
@@ -19,6 +19,11 @@ public:
     virtual bool job_exists(const std::string& job_id) = 0;
     virtual size_t get_job_count() = 0;
     virtual bool clear_all_jobs() = 0;
+
+    // Resume state of jobs suspended for preemption (opaque JSON text)
+    virtual bool save_checkpoint(const std::string& job_id, const std::string& checkpoint) = 0;
+    virtual std::string get_checkpoint(const std::string& job_id) = 0; // "" when none
+    virtual bool remove_checkpoint(const std::string& job_id) = 0;
     virtual void close() = 0;
     virtual bool is_connected() const = 0;
 };
@@ -46,6 +46,20 @@ bool MockDatabase::clear_all_jobs() {
     return true;
 }
 
+bool MockDatabase::save_checkpoint(const std::string& job_id, const std::string& checkpoint) {
+    checkpoints_[job_id] = checkpoint;
+    return true;
+}
+
+std::string MockDatabase::get_checkpoint(const std::string& job_id) {
+    auto it = checkpoints_.find(job_id);
+    return it == checkpoints_.end() ? "" : it->second;
+}
+
+bool MockDatabase::remove_checkpoint(const std::string& job_id) {
+    return checkpoints_.erase(job_id) > 0;
+}
+
 void MockDatabase::close() {
     is_connected_ = false;
 }
@@ -2,6 +2,7 @@
 #define MOCK_DATABASE_H
 
 #include "../interfaces/database_interface.h"
+#include <map>
 #include <set>
 
 namespace distconv {
@@ -24,6 +25,9 @@ public:
     bool job_exists(const std::string& job_id) override;
     size_t get_job_count() override;
     bool clear_all_jobs() override;
+    bool save_checkpoint(const std::string& job_id, const std::string& checkpoint) override;
+    std::string get_checkpoint(const std::string& job_id) override;
+    bool remove_checkpoint(const std::string& job_id) override;
     void close() override;
     bool is_connected() const override;
     
@@ -36,6 +40,7 @@ public:
     // State inspection
     const std::string& get_db_path() const { return db_path_; }
     const std::set<std::string>& get_jobs_set() const { return jobs_; }
+    const std::map<std::string, std::string>& get_checkpoints() const { return checkpoints_; }
     int get_initialize_call_count() const { return initialize_call_count_; }
     int get_add_job_call_count() const { return add_job_call_count_; }
     int get_remove_job_call_count() const { return remove_job_call_count_; }
@@ -50,6 +55,7 @@ public:
 
 private:
     std::set<std::string> jobs_;
+    std::map<std::string, std::string> checkpoints_;
     std::string db_path_;
     bool is_connected_ = false;
     
@@ -24,6 +24,13 @@ SubprocessResult MockSubprocess::run(const std::vector<std::string>& command,
                  file.close();
             }
         }
+        // A multi-output call names each output right after its "-c:v <codec>"
+        for (size_t i = 1; i + 2 < command.size(); ++i) {
+            if (command[i] == "-c:v" && command[i + 2][0] != '-') {
+                std::ofstream file(command[i + 2]);
+                file << "mock output content";
+            }
+        }
     }
 
     return get_result_for_command(command);
@@ -151,6 +151,38 @@ TEST_F(TranscodingEngineTest, PerformTranscodingMockedFileIO) {
     EXPECT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/test-job-123/complete"));
 }
 
+// Test: the job's trace context rides on the download and upload, and the completion reports phase timings
+TEST_F(TranscodingEngineTest, JobReportsPhaseTimingsAndPropagatesTraceparent) {
+    http_client_ptr->set_default_response({200, "", {}, true, ""});
+    subprocess_ptr->set_default_result({0, "transcoding output", "", true, ""});
+    std::string body = R"({"job_id": "traced-job", "source_url": "http://example.com/source.mp4", "target_codec": "h264",
+        "trace": {"trace_id": "4bf92f3577b34da6a3ce929d0e0e4736", "span_id": "00f067aa0ba902b7"}})";
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/assign_job/", {200, body, {}, true, ""});
+
+    auto job = engine->get_job_from_dispatcher();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->traceparent, "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01");
+    EXPECT_TRUE(engine->process_job(*job));
+
+    nlohmann::json completion;
+    for (const auto& call : http_client_ptr->get_call_history()) {
+        if (call.method == "DOWNLOAD" || call.method == "UPLOAD") {
+            EXPECT_EQ(call.headers.at("traceparent"), job->traceparent);
+        }
+        if (call.url == "http://test-dispatcher:8080/jobs/traced-job/complete") {
+            completion = nlohmann::json::parse(call.body);
+        }
+    }
+    ASSERT_TRUE(completion.contains("phases"));
+    int64_t previous_end = 0;
+    for (const char* phase : {"download", "transcode", "upload"}) {
+        ASSERT_TRUE(completion["phases"].contains(phase)) << phase;
+        EXPECT_LE(previous_end, completion["phases"][phase]["start_ms"].get<int64_t>());
+        EXPECT_LE(completion["phases"][phase]["start_ms"].get<int64_t>(), completion["phases"][phase]["end_ms"].get<int64_t>());
+        previous_end = completion["phases"][phase]["end_ms"];
+    }
+}
+
 // Test 128: performTranscoding can be tested without running ffmpeg (mock the subprocess call)
 TEST_F(TranscodingEngineTest, PerformTranscodingMockedFFmpeg) {
     // Mock successful download and upload
@@ -439,3 +471,168 @@ TEST_F(TranscodingEngineTest, GetCpuTemperatureTest) {
     EXPECT_EQ(temp1, temp2);
     EXPECT_EQ(temp1, -1.0);
 }
+
+// Test: with the dispatcher channel enabled, completions ride along with the next assignment request
+TEST_F(TranscodingEngineTest, ChannelBatchesCompletionWithAssignment) {
+    config.use_dispatch_channel = true;
+    ASSERT_TRUE(engine->initialize(config));
+
+    std::string downlink = R"({"frames": [
+        {"type": "ack", "frame": "complete", "status": 200, "index": 0},
+        {"type": "assignment", "job": {"job_id": "chan-job-1", "source_url": "http://example.com/a.mp4", "target_codec": "vp9"}},
+        {"type": "cancel", "job_id": "old-job", "reason": "cancelled"}
+    ]})";
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/engines/channel",
+        {200, downlink, {}, true, ""});
+
+    EXPECT_TRUE(engine->report_job_completion("done-job", "http://example.com/out.mp4"));
+    EXPECT_FALSE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/done-job/complete"));
+
+    auto job = engine->get_job_from_dispatcher();
+    ASSERT_TRUE(job.has_value());
+    EXPECT_EQ(job->job_id, "chan-job-1");
+    EXPECT_TRUE(engine->is_job_cancelled("old-job"));
+
+    auto request = nlohmann::json::parse(http_client_ptr->get_last_call().body);
+    ASSERT_EQ(request["frames"].size(), 2u);
+    EXPECT_EQ(request["frames"][0]["type"], "complete");
+    EXPECT_EQ(request["frames"][0]["job_id"], "done-job");
+    EXPECT_EQ(request["frames"][1]["type"], "assign");
+}
+
+// Test: a dispatcher without /engines/channel makes the engine replay queued frames over REST
+TEST_F(TranscodingEngineTest, ChannelFallsBackToRestWhenUnsupported) {
+    config.use_dispatch_channel = true;
+    ASSERT_TRUE(engine->initialize(config));
+
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/engines/channel",
+        {404, "Not Found", {}, false, ""});
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/assign_job/",
+        {204, "", {}, true, ""});
+
+    EXPECT_TRUE(engine->report_job_failure("failed-job", "FFmpeg transcoding failed"));
+    auto job = engine->get_job_from_dispatcher();
+
+    EXPECT_FALSE(job.has_value());
+    EXPECT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/failed-job/fail"));
+    EXPECT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/assign_job/"));
+}
+
+// Test: with a source cache configured, heartbeats advertise it as a Bloom filter
+TEST_F(TranscodingEngineTest, HeartbeatAdvertisesSourceCache) {
+    auto cache_dir = std::filesystem::temp_directory_path() / "distconv_source_cache_test";
+    std::filesystem::remove_all(cache_dir);
+    config.source_cache_dir = cache_dir.string();
+    ASSERT_TRUE(engine->initialize(config));
+
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/engines/heartbeat",
+        {200, "Heartbeat received", {}, true, ""});
+    EXPECT_TRUE(engine->send_heartbeat());
+
+    auto heartbeat = nlohmann::json::parse(http_client_ptr->get_last_call().body);
+    ASSERT_TRUE(heartbeat.contains("source_cache"));
+    EXPECT_EQ(heartbeat["source_cache"]["m"], SourceCache::FILTER_BITS);
+    EXPECT_EQ(heartbeat["source_cache"]["k"], SourceCache::FILTER_HASHES);
+    EXPECT_EQ(heartbeat["source_cache"]["bits"].get<std::string>().size(), SourceCache::FILTER_BITS / 4);
+
+    std::filesystem::remove_all(cache_dir);
+}
+
+// Test: losing a speculative race is not a reporting failure
+TEST_F(TranscodingEngineTest, CompletionConflictMeansAnotherCopyWon) {
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/jobs/raced-job/complete",
+        {409, R"({"error": "Job already completed by another engine"})", {}, false, ""});
+
+    EXPECT_TRUE(engine->report_job_completion("raced-job", "http://example.com/out.mp4"));
+
+    auto body = nlohmann::json::parse(http_client_ptr->get_last_call().body);
+    EXPECT_EQ(body["engine_id"], "test-engine-123");
+}
+
+// Test: a preempt directive on the heartbeat suspends the job at the next boundary and it resumes from the checkpoint
+TEST_F(TranscodingEngineTest, PreemptedJobIsCheckpointedAndResumed) {
+    config.segment_seconds = 10;
+    ASSERT_TRUE(engine->initialize(config));
+    http_client_ptr->set_default_response({200, "", {}, true, ""});
+    subprocess_ptr->set_default_result({0, "25.0", "", true, ""}); // ffprobe duration: three segments
+
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/engines/heartbeat",
+        {200, "Heartbeat received", {{"X-Preempt-Job", "long-job"}, {"X-Preempt-For", "urgent-job"}}, true, ""});
+    ASSERT_TRUE(engine->send_heartbeat());
+    EXPECT_TRUE(nlohmann::json::parse(http_client_ptr->get_last_call().body)["preemptible"].get<bool>());
+
+    JobDetails job;
+    job.job_id = "long-job";
+    job.source_url = "http://example.com/long.mp4";
+    job.target_codec = "h265";
+    EXPECT_TRUE(engine->process_job(job));
+
+    ASSERT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/long-job/suspend"));
+    EXPECT_FALSE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/long-job/complete"));
+    ASSERT_EQ(database_ptr->get_checkpoints().count("long-job"), 1u);
+    auto checkpoint = nlohmann::json::parse(database_ptr->get_checkpoints().at("long-job"));
+    EXPECT_EQ(checkpoint["stage"], "transcode");
+    EXPECT_TRUE(std::filesystem::exists(checkpoint["input_file"].get<std::string>()));
+
+    EXPECT_TRUE(engine->resume_suspended_job());
+    EXPECT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/long-job/resume"));
+    EXPECT_TRUE(http_client_ptr->was_url_called("http://test-dispatcher:8080/jobs/long-job/complete"));
+    EXPECT_TRUE(database_ptr->get_checkpoints().empty());
+    EXPECT_TRUE(engine->get_queued_jobs().empty());
+    EXPECT_FALSE(std::filesystem::exists(checkpoint["input_file"].get<std::string>()));
+
+    auto concat = subprocess_ptr->get_last_call();
+    EXPECT_EQ(concat.command[3], "concat");
+    EXPECT_FALSE(engine->resume_suspended_job());
+}
+
+// Test: the heartbeat advertises the engine's slots and resources for bin packing
+TEST_F(TranscodingEngineTest, HeartbeatAdvertisesSlotCapacity) {
+    config.max_concurrent_jobs = 4;
+    config.storage_capacity_gb = 250.0;
+    ASSERT_TRUE(engine->initialize(config));
+
+    ASSERT_TRUE(engine->send_heartbeat());
+    auto heartbeat = nlohmann::json::parse(http_client_ptr->get_last_call().body);
+    ASSERT_TRUE(heartbeat.contains("capacity"));
+    EXPECT_EQ(heartbeat["capacity"]["slots"], 4);
+    EXPECT_DOUBLE_EQ(heartbeat["capacity"]["scratch_gb"].get<double>(), 250.0);
+    EXPECT_GT(heartbeat["capacity"].value("memory_gb", 0.0), 0.0);
+    EXPECT_EQ(heartbeat["status"], "idle");
+
+    auto status = engine->get_status();
+    EXPECT_EQ(status["slots"], 4);
+    EXPECT_EQ(status["busy_slots"], 0);
+}
+
+// Test: a batched assignment is encoded by one ffmpeg process and every job is reported on its own
+TEST_F(TranscodingEngineTest, BatchAssignmentRunsOneFfmpeg) {
+    config.max_batch_items = 4;
+    ASSERT_TRUE(engine->initialize(config));
+    http_client_ptr->set_default_response({200, "", {}, true, ""});
+
+    std::string body = R"({"type": "batch", "batch_id": "batch-1", "target_codec": "vp9", "jobs": [
+        {"job_id": "clip-1", "source_url": "http://example.com/1.mp4", "target_codec": "vp9", "job_size": 2.0},
+        {"job_id": "clip-2", "source_url": "http://example.com/2.mp4", "target_codec": "vp9", "job_size": 3.0},
+        {"job_id": "clip-3", "source_url": "http://example.com/3.mp4", "target_codec": "vp9", "job_size": 1.0}
+    ]})";
+    http_client_ptr->set_response_for_url("http://test-dispatcher:8080/assign_job/", {200, body, {}, true, ""});
+
+    auto batch = engine->get_job_from_dispatcher();
+    EXPECT_EQ(nlohmann::json::parse(http_client_ptr->get_last_call().body)["max_batch"], 4);
+    ASSERT_TRUE(batch.has_value());
+    EXPECT_EQ(batch->job_id, "batch-1");
+    ASSERT_EQ(batch->items.size(), 3u);
+
+    size_t calls_before = subprocess_ptr->get_call_count();
+    EXPECT_TRUE(engine->process_batch(*batch));
+    EXPECT_EQ(subprocess_ptr->get_call_count(), calls_before + 1);
+    auto command = subprocess_ptr->get_last_call().command;
+    EXPECT_EQ(std::count(command.begin(), command.end(), "-i"), 3);
+    EXPECT_EQ(std::count(command.begin(), command.end(), "-map"), 3);
+
+    for (const char* job_id : {"clip-1", "clip-2", "clip-3"}) {
+        EXPECT_TRUE(http_client_ptr->was_url_called(std::string("http://test-dispatcher:8080/jobs/") + job_id + "/complete"));
+    }
+    EXPECT_TRUE(engine->get_queued_jobs().empty());
+}